@@ -0,0 +1,432 @@
+// Microbenchmarks for the fader/button control hot path.
+//
+// Usage: control_bench [--filter <substring>] [--min-time-ms <ms>] [--out <file.json>]
+// Results are printed as JSON (to stdout, or to the --out file) so runs can be
+// compared across releases.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "button_actions.h"
+#include "control_model.h"
+#include "wire_format.h"
+#include "peak_meters.h"
+#include "ducking.h"
+#include "gesture_recognizer.h"
+#include "profile.h"
+#include "group_volumes.h"
+#include "app_matcher.h"
+#include "fake_platform.h"
+#include "hotkey_combo.h"
+#include "input_injector.h"
+#include "key_table.h"
+#include "serial_frame.h"
+#include "session_match.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    template <typename T>
+    void DoNotOptimize(const T &value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void *sink;
+        sink = &value;
+#endif
+    }
+
+    struct BenchmarkCase
+    {
+        std::string name;
+        std::function<void()> body; // One operation
+    };
+
+    struct BenchmarkResult
+    {
+        std::string name;
+        uint64_t iterations = 0;
+        double nsPerOpMin = 0.0;
+        double nsPerOpMedian = 0.0;
+    };
+
+    constexpr int SAMPLE_COUNT = 5;
+
+    double RunBatch(const BenchmarkCase &bench, uint64_t iterations)
+    {
+        const auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            bench.body();
+        }
+        const auto elapsed = Clock::now() - start;
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    BenchmarkResult Run(const BenchmarkCase &bench, double minTimeMs)
+    {
+        // Grow the batch until one sample takes at least minTimeMs
+        uint64_t iterations = 1;
+        while (true)
+        {
+            const double ns = RunBatch(bench, iterations);
+            if (ns >= minTimeMs * 1e6 || iterations >= (uint64_t(1) << 32))
+            {
+                break;
+            }
+            const double scale = ns > 0.0 ? (minTimeMs * 1e6 * 1.2) / ns : 10.0;
+            iterations = static_cast<uint64_t>(iterations * std::clamp(scale, 2.0, 100.0));
+        }
+
+        std::vector<double> samples;
+        for (int s = 0; s < SAMPLE_COUNT; ++s)
+        {
+            samples.push_back(RunBatch(bench, iterations) / static_cast<double>(iterations));
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchmarkResult result;
+        result.name = bench.name;
+        result.iterations = iterations;
+        result.nsPerOpMin = samples.front();
+        result.nsPerOpMedian = samples[samples.size() / 2];
+        return result;
+    }
+
+    // Representative config.json (same shape as the shipped one)
+    const char *SAMPLE_CONFIG = R"({
+        "buttonBindings": {"button0": "Copy", "button1": "Play/Pause"},
+        "group_names": {"Group 1": "Media", "Group 2": "Games", "Group 3": "Chat", "Group 4": "Group 4"},
+        "groups": {
+            "Group 1": ["cef_browser_process.exe", "brave.exe", "mstsc.exe", "Spotify.exe", "Microsoft.Media.Player.exe"],
+            "Group 2": ["steam.exe", "WorldOfTanks.exe", "cs2.exe", "steamwebhelper.exe", "PummelParty.exe", "NMS.exe",
+                        "REPO.exe", "ItTakesTwo.exe", "bfv.exe", "Balatro.exe", "RainbowSix.exe", "R6-Extraction_Plus.exe"],
+            "Group 3": ["Telegram.exe", "ms-teams.exe", "msedgewebview2.exe", "WhatsApp.exe", "Discord.exe"],
+            "Group 4": ["Unknown Session"]
+        },
+        "numContainers": 4,
+        "numDropdowns": 8,
+        "theme": "dark"
+    })";
+
+    std::vector<BenchmarkCase> BuildCases()
+    {
+        std::vector<BenchmarkCase> cases;
+
+        // --- Serial frame parsing ---
+        static const std::string frameLine = "512,1023,0,77,0,0,1,0,0,0,0,0\r";
+        cases.push_back({"frame_parse", []
+                         {
+                             ControllerFrame frame;
+                             bool ok = ParseControllerFrame(frameLine, frame);
+                             DoNotOptimize(ok);
+                             DoNotOptimize(frame);
+                         }});
+
+        // --- Slider change detection + volume mapping over a jittery stream ---
+        static std::vector<ControllerFrame> frames = []
+        {
+            std::vector<ControllerFrame> generated(256);
+            for (size_t i = 0; i < generated.size(); ++i)
+            {
+                for (int s = 0; s < EXPECTED_SLIDERS; ++s)
+                {
+                    generated[i].sliders[s] = static_cast<int>((i * 7 + s * 131) % 1024);
+                }
+            }
+            return generated;
+        }();
+        cases.push_back({"slider_filter", []
+                         {
+                             static size_t index = 0;
+                             const ControllerFrame &previous = frames[index % frames.size()];
+                             const ControllerFrame &current = frames[(index + 1) % frames.size()];
+                             ++index;
+                             float volumes[EXPECTED_SLIDERS] = {};
+                             for (int s = 0; s < EXPECTED_SLIDERS; ++s)
+                             {
+                                 if (SliderChanged(previous.sliders[s], current.sliders[s], 3))
+                                 {
+                                     volumes[s] = SliderToVolume(current.sliders[s]);
+                                 }
+                             }
+                             DoNotOptimize(volumes);
+                         }});
+
+        // --- Config lookups ---
+        static const json config = json::parse(SAMPLE_CONFIG);
+        cases.push_back({"config_parse", []
+                         {
+                             json parsed = json::parse(SAMPLE_CONFIG);
+                             DoNotOptimize(parsed);
+                         }});
+        cases.push_back({"config_snapshot_lookup", []
+                         {
+                             std::vector<std::string> groups = GetSliderGroupNames(config);
+                             const json *apps = FindGroupApps(config, groups[2]);
+                             DoNotOptimize(apps);
+                         }});
+
+        // --- App name -> session resolution against fake session tables ---
+        for (size_t sessionCount : {10, 100, 1000})
+        {
+            auto table = std::make_shared<FakeSessionTable>(sessionCount);
+            table->names.back() = L"Discord.exe";
+            const std::string suffix = std::to_string(sessionCount);
+
+            cases.push_back({"session_resolve_hit_" + suffix, [table]
+                             {
+                                 SessionMatchKind kind;
+                                 int index = FindSessionForApp(table->names, L"discord.exe", [](size_t)
+                                                               { return true; },
+                                                               kind);
+                                 table->SetMasterVolume(static_cast<size_t>(index), 0.5f);
+                             }});
+            cases.push_back({"session_resolve_miss_" + suffix, [table]
+                             {
+                                 SessionMatchKind kind;
+                                 int index = FindSessionForApp(table->names, L"NotRunning.exe", [](size_t)
+                                                               { return true; },
+                                                               kind);
+                                 DoNotOptimize(index);
+                             }});
+        }
+
+        // --- New audio session: compiled group rules -> group target volume ---
+        static const std::shared_ptr<const AppMatcher> appMatcher = AppMatcher::Compile(json::parse(
+            R"({"groups":{"Media":["Spotify.exe","brave.exe","display:*Music*"],
+                          "Games":["steam.exe","cs2.exe","*game*","glob:r?-*.exe","re:^eldenring","child:steam.exe"],
+                          "Voice":["Discord.exe","Teams.exe","*zoom*"]}})"));
+        static GroupVolumes groupVolumes;
+        groupVolumes.Rebuild(appMatcher->Groups());
+        groupVolumes.SetTarget("Games", 0.4f);
+        static SessionIdentity exactSession{AppNames().Intern("CS2.exe"), "CS2.exe", "", {}};
+        static SessionIdentity childSession{AppNames().Intern("steamwebhelper.exe"), "steamwebhelper.exe", "",
+                                            {AppNames().Intern("steam.exe"), AppNames().Intern("explorer.exe")}};
+        cases.push_back({"new_session_group_lookup", []
+                         {
+                             float volume = 0.0f;
+                             const int group = appMatcher->Match(exactSession);
+                             DoNotOptimize(groupVolumes.Target(appMatcher->Groups()[group], volume));
+                             DoNotOptimize(volume);
+                         }});
+        cases.push_back({"app_match_child", []
+                         {
+                             GroupMask members;
+                             DoNotOptimize(appMatcher->Match(childSession, &members));
+                             DoNotOptimize(members);
+                         }});
+
+        // --- Interning a name already in the table (once per new session or process) ---
+        static const std::wstring sessionExe = L"Spotify.exe";
+        cases.push_back({"app_name_intern", []
+                         {
+                             DoNotOptimize(AppNames().Intern(sessionExe));
+                         }});
+
+        // --- Key name table (perfect hash) ---
+        cases.push_back({"key_lookup", []
+                         {
+                             const KeyInfo *key = LookupKey("Media_PlayPause");
+                             DoNotOptimize(key);
+                         }});
+
+        // --- Hotkey combo parsing + key-down batch into the recording injector ---
+        static RecordingInputInjector injector;
+        cases.push_back({"hotkey_parse_inject", []
+                         {
+                             HotkeyCombo combo;
+                             ParseHotkeyCombo("Ctrl+Shift+Alt+S", combo);
+                             const KeyChord chord = BuildKeyChord(combo);
+                             KeyInput events[MAX_CHORD_KEYS];
+                             for (int i = 0; i < chord.count && i < MAX_CHORD_KEYS; ++i)
+                             {
+                                 events[i] = {chord.keys[i], false, ((chord.extendedMask >> i) & 1) != 0};
+                             }
+                             injector.Send(events, chord.count);
+                             injector.Clear();
+                         }});
+
+        // --- Button press through the precompiled action table ---
+        static const std::shared_ptr<const ProfileSet> profiles = CompileProfiles(
+            json::parse(R"({"groups":{"Game":[],"Voice":[]},"buttonBindings":{"button0":"Copy","button1":"Play"},
+                            "profiles":{"Gaming":{"sliders":["Game","Voice"]},"Meeting":{"sliders":["Voice"]}}})"),
+            json::parse(R"([{"action":"Copy","combo":"Ctrl+C"},{"action":"Play","combo":"Media_PlayPause"}])"));
+        static const std::shared_ptr<const ButtonActionTable> buttonTable = profiles->profiles[0]->buttons;
+        static BoundedQueue<KeyChord, 64> pressQueue;
+        cases.push_back({"button_press_dispatch", []
+                         {
+                             const ButtonAction &action = buttonTable->Lookup({GestureType::Tap, 0});
+                             KeyChord chord;
+                             pressQueue.TryPush(action.chord);
+                             pressQueue.TryPop(chord);
+                             DoNotOptimize(chord);
+                         }});
+
+        // --- Profile switch: one atomic pointer store, then the next frame's load ---
+        static std::shared_ptr<const ControlProfile> activeProfile = profiles->profiles[0];
+        cases.push_back({"profile_switch", []
+                         {
+                             static size_t next = 0;
+                             next = (next + 1) % profiles->profiles.size();
+                             std::atomic_store(&activeProfile, profiles->profiles[next]);
+                             DoNotOptimize(std::atomic_load(&activeProfile)->sliderGroups.size());
+                         }});
+
+        // --- Gesture recognition: press + release of a button with tap/double/long bound ---
+        static GestureRecognizer gestures([](const GestureEvent &event)
+                                          { DoNotOptimize(event); });
+        static GestureBindings gestureBindings = []
+        {
+            GestureBindings bindings;
+            bindings.buttonMasks[0] = GestureBit(GestureType::Tap) | GestureBit(GestureType::DoubleTap) |
+                                      GestureBit(GestureType::LongPress);
+            return bindings;
+        }();
+        gestures.Configure(gestureBindings);
+        cases.push_back({"gesture_edges", []
+                         {
+                             const auto now = GestureRecognizer::Clock::now();
+                             gestures.OnEdge(0, true, now);
+                             gestures.OnEdge(0, false, now + std::chrono::milliseconds(40));
+                             gestures.OnTimer(now + std::chrono::milliseconds(400));
+                         }});
+
+        // --- /api/get-controller-state payload ---
+        static const std::vector<int> sliders = {512, 1023, 0, 77};
+        static const std::vector<int> buttons = {0, 0, 1, 0, 0, 0, 0, 0};
+        cases.push_back({"controller_state_json", []
+                         {
+                             std::string body = BuildControllerStateJson(sliders, buttons, true, "COM3").dump();
+                             DoNotOptimize(body);
+                         }});
+        // --- One peak meter tick over a full session table ---
+        static FakeMeterSource meterSource;
+        static PeakMeters meters(meterSource);
+        static std::string meterMessage;
+        meterSource.peaks.assign(MAX_METER_SESSIONS, 0.25f);
+        meterSource.groups.assign(MAX_METER_SESSIONS, GroupMask());
+        meterSource.groupCount = 8;
+        for (size_t i = 0; i < MAX_METER_SESSIONS; ++i)
+        {
+            meterSource.groups[i].set(i % 8);
+        }
+        meters.Subscribe([](const MeterFrame &frame)
+                         { EncodeMeterFrame(frame, meterMessage); });
+        cases.push_back({"meter_tick_64_sessions", []
+                         {
+                             meters.Sample();
+                             DoNotOptimize(meterMessage);
+                         }});
+
+        // --- One ducking step: four rules, trigger alternating so the envelopes keep moving ---
+        static DuckingEngine ducking([](size_t, float volume)
+                                     { DoNotOptimize(volume); });
+        static MeterFrame duckFrame;
+        static DuckingEngine::Clock::time_point duckNow;
+        {
+            json duckConfig = {{"groups", {{"Group 1", json::array()}, {"Group 2", json::array()}, {"Group 3", json::array()}, {"Group 4", json::array()}}},
+                               {"ducking", json::array()}};
+            for (int target = 1; target <= 4; ++target)
+            {
+                duckConfig["ducking"].push_back({{"trigger", target == 3 ? "Group 4" : "Group 3"}, {"target", "Group " + std::to_string(target)}});
+            }
+            ducking.SetRules(CompileDuckingRules(duckConfig), AppMatcher::Compile(duckConfig));
+            for (size_t group = 0; group < 4; ++group)
+            {
+                ducking.SetFader(group, 0.8f);
+            }
+            duckFrame.groupCount = 4;
+        }
+        cases.push_back({"ducking_process", []
+                         {
+                             duckNow += std::chrono::milliseconds(50);
+                             duckFrame.groups[2] = duckFrame.groups[2] > 0.5f ? 0.0f : 1.0f;
+                             ducking.Process(duckFrame, duckNow);
+                         }});
+
+        cases.push_back({"controller_state_msgpack", []
+                         {
+                             static std::string body;
+                             EncodeControllerStateCompact(sliders, buttons, true, "COM3", WireFormat::MsgPack, body);
+                             DoNotOptimize(body);
+                         }});
+
+        return cases;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    std::string outPath;
+    double minTimeMs = 100.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc)
+        {
+            minTimeMs = std::stod(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--min-time-ms <ms>] [--out <file.json>]" << std::endl;
+            return 1;
+        }
+    }
+
+    json results = json::array();
+    for (const auto &bench : BuildCases())
+    {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        BenchmarkResult result = Run(bench, minTimeMs);
+        std::cerr << result.name << ": " << result.nsPerOpMedian << " ns/op" << std::endl;
+        results.push_back({{"name", result.name},
+                           {"iterations", result.iterations},
+                           {"ns_per_op_min", result.nsPerOpMin},
+                           {"ns_per_op_median", result.nsPerOpMedian}});
+    }
+
+    json report = {{"suite", "control_hot_path"},
+                   {"samples", SAMPLE_COUNT},
+                   {"min_time_ms", minTimeMs},
+                   {"benchmarks", results}};
+
+    if (outPath.empty())
+    {
+        std::cout << report.dump(2) << std::endl;
+    }
+    else
+    {
+        std::ofstream out(outPath);
+        if (!out.is_open())
+        {
+            std::cerr << "Error: Could not open " << outPath << " for writing" << std::endl;
+            return 1;
+        }
+        out << report.dump(2) << std::endl;
+    }
+    return 0;
+}
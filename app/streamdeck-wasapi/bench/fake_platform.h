@@ -0,0 +1,38 @@
+#ifndef FAKE_PLATFORM_H
+#define FAKE_PLATFORM_H
+
+#include <string>
+#include <vector>
+
+// In-process stand-ins for the Windows pieces of the control path (key injection
+// uses RecordingInputInjector from input_injector.h).
+
+// Session table shaped like g_sessionNames / g_sessionVolumes in wasapi_controller.cpp
+struct FakeSessionTable
+{
+    std::vector<std::wstring> names;
+    std::vector<float> volumes;
+
+    explicit FakeSessionTable(size_t count)
+    {
+        names.reserve(count);
+        volumes.assign(count, 1.0f);
+        for (size_t i = 0; i < count; ++i)
+        {
+            names.push_back(L"BackgroundApp" + std::to_wstring(i) + L".exe");
+        }
+    }
+
+    // Mirrors ISimpleAudioVolume::SetMasterVolume
+    bool SetMasterVolume(size_t index, float volume)
+    {
+        if (index >= volumes.size())
+        {
+            return false;
+        }
+        volumes[index] = volume;
+        return true;
+    }
+};
+
+#endif // FAKE_PLATFORM_H
@@ -16,6 +16,7 @@
 #define IDC_STREAMDECKWASAPI 109
 #define IDM_SETTINGS 110
 #define IDM_OPEN_FRONTEND 111
+#define IDM_DUMP_LATENCY 112
 #define IDC_MYICON 2
 #ifndef IDC_STATIC
 #define IDC_STATIC -1
@@ -29,6 +30,6 @@
 #define _APS_NEXT_RESOURCE_VALUE 129
 #define _APS_NEXT_COMMAND_VALUE 32771
 #define _APS_NEXT_CONTROL_VALUE 1000
-#define _APS_NEXT_SYMED_VALUE 112
+#define _APS_NEXT_SYMED_VALUE 113
 #endif
 #endif
@@ -0,0 +1,394 @@
+#include "app_matcher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <queue>
+
+namespace
+{
+    std::string ToLowerAscii(std::string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return value;
+    }
+
+    bool StartsWith(const std::string &value, const char *prefix, std::string &rest)
+    {
+        const size_t length = std::char_traits<char>::length(prefix);
+        if (value.compare(0, length, prefix) != 0)
+        {
+            return false;
+        }
+        rest = value.substr(length);
+        return true;
+    }
+
+    // Longest run of characters without wildcards: the part every match must contain
+    std::string LongestLiteral(const std::string &glob)
+    {
+        std::string best;
+        size_t start = 0;
+        for (size_t i = 0; i <= glob.size(); ++i)
+        {
+            if (i == glob.size() || glob[i] == '*' || glob[i] == '?')
+            {
+                if (i - start > best.size())
+                {
+                    best = glob.substr(start, i - start);
+                }
+                start = i + 1;
+            }
+        }
+        return best;
+    }
+}
+
+bool GlobMatch(const std::string &pattern, const std::string &text)
+{
+    // Iterative wildcard match: backtrack only to the last '*'
+    size_t p = 0, t = 0;
+    size_t starP = std::string::npos, starT = 0;
+    while (t < text.size())
+    {
+        const char c = static_cast<char>(std::tolower(static_cast<unsigned char>(text[t])));
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == c))
+        {
+            ++p;
+            ++t;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            starP = p++;
+            starT = t;
+        }
+        else if (starP != std::string::npos)
+        {
+            p = starP + 1;
+            t = ++starT;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+    {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+void GlobSet::Add(const std::string &pattern, int group)
+{
+    m_patterns.push_back({pattern, group});
+}
+
+void GlobSet::Build()
+{
+    m_nodes.assign(1, Node());
+    m_alwaysCheck.clear();
+
+    // Trie of each pattern's longest literal
+    for (size_t i = 0; i < m_patterns.size(); ++i)
+    {
+        const std::string key = LongestLiteral(m_patterns[i].glob);
+        if (key.empty())
+        {
+            m_alwaysCheck.push_back(static_cast<int>(i));
+            continue;
+        }
+
+        int node = 0;
+        for (char c : key)
+        {
+            auto found = m_nodes[node].next.find(c);
+            if (found == m_nodes[node].next.end())
+            {
+                m_nodes.push_back(Node());
+                found = m_nodes[node].next.emplace(c, static_cast<int>(m_nodes.size() - 1)).first;
+            }
+            node = found->second;
+        }
+        m_nodes[node].outputs.push_back(static_cast<int>(i));
+    }
+
+    // Failure links, breadth first
+    std::queue<int> pending;
+    for (auto &[c, child] : m_nodes[0].next)
+    {
+        m_nodes[child].fail = 0;
+        pending.push(child);
+    }
+    while (!pending.empty())
+    {
+        const int node = pending.front();
+        pending.pop();
+        for (auto &[c, child] : m_nodes[node].next)
+        {
+            int fail = m_nodes[node].fail;
+            while (fail != 0 && m_nodes[fail].next.find(c) == m_nodes[fail].next.end())
+            {
+                fail = m_nodes[fail].fail;
+            }
+            auto target = m_nodes[fail].next.find(c);
+            m_nodes[child].fail = (target != m_nodes[fail].next.end() && target->second != child) ? target->second : 0;
+
+            const auto &inherited = m_nodes[m_nodes[child].fail].outputs;
+            m_nodes[child].outputs.insert(m_nodes[child].outputs.end(), inherited.begin(), inherited.end());
+            pending.push(child);
+        }
+    }
+}
+
+std::vector<char> GlobSet::Candidates(const std::string &text) const
+{
+    std::vector<char> candidate(m_patterns.size(), 0);
+    for (int index : m_alwaysCheck)
+    {
+        candidate[index] = 1;
+    }
+
+    int node = 0;
+    for (unsigned char raw : text)
+    {
+        const char c = static_cast<char>(std::tolower(raw));
+        while (node != 0 && m_nodes[node].next.find(c) == m_nodes[node].next.end())
+        {
+            node = m_nodes[node].fail;
+        }
+        auto next = m_nodes[node].next.find(c);
+        node = next == m_nodes[node].next.end() ? 0 : next->second;
+        for (int index : m_nodes[node].outputs)
+        {
+            candidate[index] = 1;
+        }
+    }
+    return candidate;
+}
+
+int GlobSet::Match(const std::string &text) const
+{
+    if (m_patterns.empty())
+    {
+        return -1;
+    }
+
+    // Only candidates are checked against the full glob, in the order they were added
+    const std::vector<char> candidate = Candidates(text);
+    for (size_t i = 0; i < m_patterns.size(); ++i)
+    {
+        if (candidate[i] && GlobMatch(m_patterns[i].glob, text))
+        {
+            return m_patterns[i].group;
+        }
+    }
+    return -1;
+}
+
+GroupMask GlobSet::MatchAll(const std::string &text) const
+{
+    GroupMask members;
+    if (m_patterns.empty())
+    {
+        return members;
+    }
+
+    const std::vector<char> candidate = Candidates(text);
+    for (size_t i = 0; i < m_patterns.size(); ++i)
+    {
+        if (candidate[i] && !members.test(m_patterns[i].group) && GlobMatch(m_patterns[i].glob, text))
+        {
+            members.set(m_patterns[i].group);
+        }
+    }
+    return members;
+}
+
+void AppMatcher::AddNameRule(NameRule &rule, int group)
+{
+    if (rule.group < 0)
+    {
+        rule.group = group; // An app listed in several groups is primary in the first one
+    }
+    rule.members.set(group);
+}
+
+std::shared_ptr<const AppMatcher> AppMatcher::Compile(const json &config_data, std::vector<std::string> *problems)
+{
+    auto matcher = std::make_shared<AppMatcher>();
+    auto report = [problems](const std::string &message)
+    {
+        if (problems)
+        {
+            problems->push_back(message);
+        }
+    };
+
+    if (!config_data.is_object() || !config_data.contains("groups") || !config_data["groups"].is_object())
+    {
+        matcher->m_exeGlobs.Build();
+        matcher->m_displayGlobs.Build();
+        return matcher;
+    }
+
+    for (auto &[name, rules] : config_data["groups"].items())
+    {
+        if (!rules.is_array())
+        {
+            continue;
+        }
+
+        if (matcher->m_groups.size() == MAX_GROUPS)
+        {
+            report("Group '" + name + "' ignored: at most " + std::to_string(MAX_GROUPS) + " groups are supported");
+            continue;
+        }
+
+        const int group = static_cast<int>(matcher->m_groups.size());
+        matcher->m_groups.push_back(name);
+        for (const auto &entry : rules)
+        {
+            if (!entry.is_string() || entry.get<std::string>().empty())
+            {
+                report("Group '" + name + "': ignoring rule " + entry.dump());
+                continue;
+            }
+
+            const std::string rule = entry.get<std::string>();
+            std::string rest;
+            if (StartsWith(rule, "re:", rest))
+            {
+                try
+                {
+                    matcher->m_regexes.push_back({std::regex(rest, std::regex::ECMAScript | std::regex::icase | std::regex::optimize), group});
+                }
+                catch (const std::regex_error &e)
+                {
+                    report("Group '" + name + "': invalid regex '" + rest + "': " + e.what());
+                }
+            }
+            else if (StartsWith(rule, "child:", rest))
+            {
+                AddNameRule(matcher->m_children[AppNames().Intern(rest)], group);
+            }
+            else if (StartsWith(rule, "display:", rest))
+            {
+                matcher->m_displayGlobs.Add(ToLowerAscii(rest), group);
+            }
+            else if (StartsWith(rule, "glob:", rest) || rule.find_first_of("*?") != std::string::npos)
+            {
+                matcher->m_exeGlobs.Add(ToLowerAscii(rest.empty() ? rule : rest), group);
+            }
+            else
+            {
+                AddNameRule(matcher->m_exact[AppNames().Intern(rule)], group);
+            }
+        }
+    }
+
+    matcher->m_exeGlobs.Build();
+    matcher->m_displayGlobs.Build();
+    return matcher;
+}
+
+int AppMatcher::Match(const SessionIdentity &session, GroupMask *members) const
+{
+    // Without members the first hit in precedence order is the answer; with
+    // members every rule kind is evaluated and the first hit is the primary group
+    int primary = -1;
+    GroupMask all;
+    auto hit = [&](int group)
+    {
+        if (primary < 0)
+        {
+            primary = group;
+        }
+        all.set(group);
+    };
+
+    if (session.exe != NO_NAME)
+    {
+        auto exact = m_exact.find(session.exe);
+        if (exact != m_exact.end())
+        {
+            hit(exact->second.group);
+            all |= exact->second.members;
+        }
+    }
+
+    if (!session.exeName.empty())
+    {
+        const std::string &exeName = session.exeName;
+        if (primary < 0 || members)
+        {
+            const int glob = m_exeGlobs.Match(exeName);
+            if (glob >= 0)
+            {
+                hit(glob);
+                if (members)
+                {
+                    all |= m_exeGlobs.MatchAll(exeName);
+                }
+            }
+        }
+
+        for (const auto &rule : m_regexes)
+        {
+            if (primary >= 0 && (!members || all.test(rule.group)))
+            {
+                continue;
+            }
+            if (std::regex_search(exeName, rule.regex))
+            {
+                hit(rule.group);
+            }
+        }
+    }
+
+    if (!session.displayName.empty() && (primary < 0 || members))
+    {
+        const int display = m_displayGlobs.Match(session.displayName);
+        if (display >= 0)
+        {
+            hit(display);
+            if (members)
+            {
+                all |= m_displayGlobs.MatchAll(session.displayName);
+            }
+        }
+    }
+
+    // Nearest ancestor with a rule gives the primary group
+    for (NameId ancestor : session.ancestors)
+    {
+        if (primary >= 0 && !members)
+        {
+            break;
+        }
+        auto child = m_children.find(ancestor);
+        if (child != m_children.end())
+        {
+            hit(child->second.group);
+            all |= child->second.members;
+        }
+    }
+
+    if (members)
+    {
+        *members = all;
+    }
+    return primary;
+}
+
+int AppMatcher::FindGroup(const std::string &name) const
+{
+    for (size_t i = 0; i < m_groups.size(); ++i)
+    {
+        if (m_groups[i] == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,155 @@
+#ifndef APP_MATCHER_H
+#define APP_MATCHER_H
+
+#include <bitset>
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "json.hpp"
+#include "name_table.h"
+
+// Compiled group membership rules.
+//
+// Each entry of a config.json group is one rule:
+//
+//   "Spotify.exe"            exact executable name (case-insensitive, ".exe" optional)
+//   "*steam*", "glob:Game?"  case-insensitive glob on the executable name (* and ?)
+//   "re:^r6.*\.exe$"         case-insensitive ECMAScript regex on the executable name
+//   "child:steam.exe"        any process started (directly or not) by that executable
+//   "display:*Teams*"        case-insensitive glob on the session display name
+//
+// Rules are compiled once per config load: exact names into a hash map of interned
+// IDs (see name_table.h), globs into
+// an Aho-Corasick automaton over their longest literal part (a hit is then verified
+// against the whole glob). A session is matched when it appears, never per fader tick.
+// If several rules match, the more specific kind wins (exact, glob, regex, display,
+// child) and within a kind the earlier group; that is the session's primary group.
+// Exact rules compare interned IDs; globs and regexes see the session's own spelling
+// of its executable name, not whichever spelling was interned first.
+// A session is still a member of every group with a matching rule, so an app listed
+// in two groups follows both faders.
+
+using json = nlohmann::json;
+
+// Groups beyond this are ignored with a reported problem
+const size_t MAX_GROUPS = 64;
+
+// Bit i set = member of group i (index in AppMatcher::Groups())
+using GroupMask = std::bitset<MAX_GROUPS>;
+
+struct SessionIdentity
+{
+    NameId exe = NO_NAME;         // Interned executable file name (exact and child rules)
+    std::string exeName;          // UTF-8 executable file name as the session's process has it (globs, regexes)
+    std::string displayName;      // UTF-8 session display name, may be empty
+    std::vector<NameId> ancestors; // Parent first; only needed if NeedsAncestors()
+};
+
+/**
+ * @brief Case-insensitive glob match with * and ? (pattern must already be lower case).
+ */
+bool GlobMatch(const std::string &pattern, const std::string &text);
+
+// A set of globs matched in one pass over the text
+class GlobSet
+{
+public:
+    /**
+     * @brief Adds a lower-case pattern. Patterns are numbered in the order they are added.
+     */
+    void Add(const std::string &pattern, int group);
+
+    /**
+     * @brief Builds the automaton; call once after the last Add.
+     */
+    void Build();
+
+    /**
+     * @brief Group of the first added pattern that matches the whole text, or -1.
+     */
+    int Match(const std::string &text) const;
+
+    /**
+     * @brief Groups of every pattern that matches the whole text.
+     */
+    GroupMask MatchAll(const std::string &text) const;
+
+    bool Empty() const { return m_patterns.empty(); }
+
+private:
+    struct Pattern
+    {
+        std::string glob;
+        int group;
+    };
+
+    // Patterns whose literal occurs in the text (one pass of the automaton)
+    std::vector<char> Candidates(const std::string &text) const;
+
+    struct Node
+    {
+        std::unordered_map<char, int> next;
+        int fail = 0;
+        std::vector<int> outputs; // Patterns whose key ends here (including via fail links)
+    };
+
+    std::vector<Pattern> m_patterns;
+    std::vector<int> m_alwaysCheck; // Patterns without a literal part ("*", "?*")
+    std::vector<Node> m_nodes;
+};
+
+class AppMatcher
+{
+public:
+    /**
+     * @brief Compiles the rules of every group in config.json "groups".
+     * @param problems Optional; receives one message per rule that could not be compiled.
+     * @return The compiled matcher (never null).
+     */
+    static std::shared_ptr<const AppMatcher> Compile(const json &config_data, std::vector<std::string> *problems = nullptr);
+
+    /**
+     * @brief Index (in Groups()) of the session's primary group, or -1.
+     * @param members Optional; receives every group the session is a member of.
+     */
+    int Match(const SessionIdentity &session, GroupMask *members = nullptr) const;
+
+    /**
+     * @brief Index of a group by name, or -1.
+     */
+    int FindGroup(const std::string &name) const;
+
+    const std::vector<std::string> &Groups() const { return m_groups; }
+
+    /**
+     * @brief True if some "child:" rule exists, so callers can skip walking the process tree.
+     */
+    bool NeedsAncestors() const { return !m_children.empty(); }
+
+private:
+    struct RegexRule
+    {
+        std::regex regex;
+        int group;
+    };
+
+    struct NameRule
+    {
+        int group = -1; // First group listing the name
+        GroupMask members;
+    };
+
+    static void AddNameRule(NameRule &rule, int group);
+
+    std::vector<std::string> m_groups;
+
+    std::unordered_map<NameId, NameRule> m_exact;    // Interned name -> groups listing it
+    std::unordered_map<NameId, NameRule> m_children; // Interned ancestor name -> groups
+    GlobSet m_exeGlobs;
+    GlobSet m_displayGlobs;
+    std::vector<RegexRule> m_regexes;
+};
+
+#endif // APP_MATCHER_H
@@ -6,16 +6,14 @@
 #include <string>
 #include <mutex> // Recommended if adding thread-safe getters
 #include <boost/asio.hpp>
+#include "serial_frame.h"
 
 // This header file declares the public interface for retrieving information
 // from an Arduino board via asynchronous serial communication using Boost.Asio.
 
 // --- Configuration Constants ---
-// These define the expected number of inputs from the Arduino.
-// Ensure these match the definitions in the corresponding .cpp file
-// and the Arduino sketch.
-constexpr int EXPECTED_SLIDERS = 4;
-constexpr int EXPECTED_BUTTONS = 8;
+// EXPECTED_SLIDERS / EXPECTED_BUTTONS live in serial_frame.h together with the
+// portable frame parser, so they can be shared with non-Windows builds.
 
 // --- Function Declarations ---
 // Handler for receiving data from Arduino
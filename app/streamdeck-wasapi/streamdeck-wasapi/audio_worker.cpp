@@ -0,0 +1,366 @@
+#include "audio_worker.h"
+
+#include <iostream>
+#include <unordered_map>
+#include <objbase.h>
+
+AudioWorker g_audioWorker;
+
+AudioWorker::~AudioWorker()
+{
+    Stop();
+}
+
+bool AudioWorker::Start(std::function<bool()> initialize, VolumeHandler applyVolume, GroupVolumeHandler applyGroupVolume,
+                        Task shutdown)
+{
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    if (IsRunning())
+    {
+        return true;
+    }
+    if (m_thread.joinable())
+    {
+        m_thread.join(); // A previous start failed before entering the command loop
+    }
+
+    if (!m_wakeEvent)
+    {
+        m_wakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL); // Auto-reset
+        if (!m_wakeEvent)
+        {
+            std::cerr << "AudioWorker: CreateEvent failed, error: " << GetLastError() << std::endl;
+            return false;
+        }
+    }
+
+    m_stopping.store(false);
+    m_applyVolume = std::move(applyVolume);
+    m_applyGroupVolume = std::move(applyGroupVolume);
+    m_shutdown = std::move(shutdown);
+
+    std::promise<bool> started;
+    std::future<bool> startedResult = started.get_future();
+    try
+    {
+        m_thread = std::thread(&AudioWorker::Run, this, std::move(initialize), std::move(started));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "AudioWorker: Failed to start thread: " << e.what() << std::endl;
+        return false;
+    }
+
+    // Wait for COM + initial session enumeration so callers see a ready session table
+    return startedResult.get();
+}
+
+void AudioWorker::Stop()
+{
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    // Once no post is between its check and its push, every accepted command is queued
+    // ahead of the stop command or is drained right after it
+    m_stopping.store(true);
+    while (m_posters.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    Command command;
+    command.stop = true;
+    m_queue.Push(std::move(command));
+    SetEvent(m_wakeEvent);
+
+    m_thread.join();
+
+    // Nothing should be left, but no future is left waiting on a command that never runs
+    Command leftover;
+    while (m_queue.TryPop(leftover))
+    {
+        FailVolumeWrite(leftover);
+    }
+}
+
+bool AudioWorker::Post(Command command)
+{
+    // Sequentially consistent with Stop: either Stop sees this post in flight, or this
+    // post sees m_stopping
+    m_posters.fetch_add(1);
+    if (m_stopping.load())
+    {
+        m_posters.fetch_sub(1);
+        return false;
+    }
+    m_queue.Push(std::move(command));
+    SetEvent(m_wakeEvent);
+    m_posters.fetch_sub(1);
+    return true;
+}
+
+std::future<void> AudioWorker::SetVolume(NameId app, float volume)
+{
+    Command command;
+    command.volumeApp = app;
+    command.volume = volume;
+    return PostVolume(std::move(command));
+}
+
+std::future<void> AudioWorker::SetGroupVolume(const std::string &groupName, float volume)
+{
+    Command command;
+    command.volumeGroup = groupName;
+    command.volume = volume;
+    return PostVolume(std::move(command));
+}
+
+std::future<void> AudioWorker::PostVolume(Command command)
+{
+    command.span = TraceCurrentSpan();
+    command.volumeDone = std::make_shared<std::promise<void>>();
+    std::future<void> done = command.volumeDone->get_future();
+
+    if (!IsRunning())
+    {
+        FailVolumeWrite(command);
+        return done;
+    }
+
+    if (IsWorkerThread())
+    {
+        std::vector<Command> batch;
+        batch.push_back(std::move(command));
+        ExecuteBatch(batch);
+        return done;
+    }
+
+    std::shared_ptr<std::promise<void>> promise = command.volumeDone;
+    if (!Post(std::move(command)))
+    {
+        promise->set_exception(std::make_exception_ptr(std::runtime_error("Audio worker is not running")));
+    }
+    return done;
+}
+
+void AudioWorker::FailVolumeWrite(Command &command)
+{
+    if (command.volumeDone)
+    {
+        command.volumeDone->set_exception(std::make_exception_ptr(std::runtime_error("Audio worker is not running")));
+    }
+}
+
+void AudioWorker::SetTick(std::chrono::milliseconds period, Task tick)
+{
+    if (period.count() <= 0 || !tick)
+    {
+        period = std::chrono::milliseconds(0);
+        tick = nullptr;
+    }
+    Submit([this, period, tick = std::move(tick)]() mutable
+           {
+        m_tick = std::move(tick);
+        m_tickPeriod = period;
+        m_nextTick = std::chrono::steady_clock::now() + period; });
+}
+
+DWORD AudioWorker::TickTimeout() const
+{
+    if (!m_tick)
+    {
+        return INFINITE;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (m_nextTick <= now)
+    {
+        return 0;
+    }
+    // Rounded up, so the wait does not end just before the tick is due
+    return static_cast<DWORD>(std::chrono::ceil<std::chrono::milliseconds>(m_nextTick - now).count());
+}
+
+void AudioWorker::RunTickIfDue()
+{
+    if (!m_tick)
+    {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now < m_nextTick)
+    {
+        return;
+    }
+    m_nextTick += m_tickPeriod;
+    if (m_nextTick <= now)
+    {
+        m_nextTick = now + m_tickPeriod; // Fell behind (e.g. a session refresh); skip the missed ticks
+    }
+
+    try
+    {
+        m_tick();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "AudioWorker: Exception in periodic tick: " << e.what() << std::endl;
+    }
+}
+
+void AudioWorker::Run(std::function<bool()> initialize, std::promise<bool> started)
+{
+    // Published to other threads by the release store to m_running below
+    m_threadId = std::this_thread::get_id();
+
+    // The worker is the only thread that touches WASAPI, so it owns the apartment
+    HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    if (FAILED(hr))
+    {
+        std::cerr << "AudioWorker: CoInitializeEx failed: " << std::hex << hr << std::dec << std::endl;
+        started.set_value(false);
+        return;
+    }
+
+    m_running.store(true, std::memory_order_release);
+    bool initialized = false;
+    try
+    {
+        initialized = initialize();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "AudioWorker: Exception during initialization: " << e.what() << std::endl;
+    }
+    started.set_value(initialized);
+
+    std::vector<Command> batch;
+    bool stopRequested = false;
+    while (!stopRequested)
+    {
+        WaitForSingleObject(m_wakeEvent, TickTimeout());
+
+        // Drain everything queued so far and execute it as one batch
+        Command command;
+        while (m_queue.TryPop(command))
+        {
+            if (command.stop)
+            {
+                stopRequested = true;
+                continue;
+            }
+            batch.push_back(std::move(command));
+        }
+        ExecuteBatch(batch);
+        batch.clear();
+        if (!stopRequested)
+        {
+            RunTickIfDue();
+        }
+    }
+
+    m_running.store(false, std::memory_order_release);
+
+    // Commands queued behind the stop command still get an answer
+    Command leftover;
+    while (m_queue.TryPop(leftover))
+    {
+        if (!leftover.stop)
+        {
+            batch.push_back(std::move(leftover));
+        }
+    }
+    ExecuteBatch(batch);
+
+    if (m_shutdown)
+    {
+        m_shutdown();
+    }
+    CoUninitialize();
+}
+
+void AudioWorker::ExecuteBatch(std::vector<Command> &batch)
+{
+    // Index of the newest volume write per application and per group; older ones are superseded
+    std::unordered_map<NameId, size_t> newestWrite;
+    std::unordered_map<std::string, size_t> newestGroupWrite;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        if (batch[i].task)
+        {
+            continue;
+        }
+        if (batch[i].volumeApp == NO_NAME)
+        {
+            newestGroupWrite[batch[i].volumeGroup] = i;
+        }
+        else
+        {
+            newestWrite[batch[i].volumeApp] = i;
+        }
+    }
+
+    // A superseded write is answered by the write that replaces it, once that one ran
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        Command &command = batch[i];
+        if (command.task)
+        {
+            continue;
+        }
+        const size_t newest = command.volumeApp == NO_NAME ? newestGroupWrite[command.volumeGroup] : newestWrite[command.volumeApp];
+        if (newest != i)
+        {
+            batch[newest].superseded.push_back(std::move(command.volumeDone));
+        }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        Command &command = batch[i];
+        if (!command.task && !command.volumeDone)
+        {
+            continue; // Superseded
+        }
+        try
+        {
+            if (command.task)
+            {
+                command.task();
+                continue;
+            }
+
+            TRACE_SCOPE(command.span);
+            if (command.volumeApp == NO_NAME)
+            {
+                if (m_applyGroupVolume)
+                {
+                    m_applyGroupVolume(command.volumeGroup, command.volume);
+                }
+            }
+            else if (m_applyVolume)
+            {
+                m_applyVolume(command.volumeApp, command.volume);
+            }
+            command.volumeDone->set_value();
+            for (auto &promise : command.superseded)
+            {
+                promise->set_value();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "AudioWorker: Exception while executing command: " << e.what() << std::endl;
+            if (command.volumeDone)
+            {
+                command.volumeDone->set_exception(std::current_exception());
+                for (auto &promise : command.superseded)
+                {
+                    promise->set_exception(std::current_exception());
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#ifndef AUDIO_WORKER_H
+#define AUDIO_WORKER_H
+
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "mpsc_queue.h"
+#include "latency_trace.h"
+#include "name_table.h"
+
+/**
+ * @brief Single thread that owns the COM apartment and the WASAPI session table.
+ *
+ * Every access to WASAPI state goes through this worker: other threads post
+ * commands on a lock-free MPSC queue and get results back through futures.
+ * Queued volume writes for the same application are coalesced, so only the
+ * newest level is sent to WASAPI when the worker falls behind the faders.
+ * An optional periodic tick (peak meters) runs between command batches.
+ */
+class AudioWorker
+{
+public:
+    using Task = std::function<void()>;
+    using VolumeHandler = std::function<void(NameId app, float volume)>;
+    using GroupVolumeHandler = std::function<void(const std::string &groupName, float volume)>;
+
+    AudioWorker() = default;
+    ~AudioWorker();
+
+    AudioWorker(const AudioWorker &) = delete;
+    AudioWorker &operator=(const AudioWorker &) = delete;
+
+    /**
+     * @brief Starts the worker thread (no-op if it is already running).
+     * @param initialize Runs on the worker after COM is initialized; its result is returned.
+     * @param applyVolume Applies one (coalesced) volume write on the worker.
+     * @param applyGroupVolume Applies one (coalesced) group volume write on the worker.
+     * @param shutdown Runs on the worker before COM is uninitialized.
+     * @return The result of initialize, or false if the thread could not start.
+     */
+    bool Start(std::function<bool()> initialize, VolumeHandler applyVolume, GroupVolumeHandler applyGroupVolume,
+               Task shutdown);
+
+    /**
+     * @brief Runs the shutdown handler on the worker and joins the thread. Commands
+     * posted before Stop are still executed; from then on posting fails fast.
+     */
+    void Stop();
+
+    bool IsRunning() const { return m_running.load(std::memory_order_acquire); }
+    bool IsWorkerThread() const { return std::this_thread::get_id() == m_threadId; }
+
+    /**
+     * @brief Queues a volume write. Superseded writes for the same app are dropped.
+     * The calling thread's trace span travels with the command.
+     * @return Future that becomes ready once the write, or the newer write that
+     * superseded it, was applied (or holds that write's exception).
+     */
+    std::future<void> SetVolume(NameId app, float volume);
+
+    /**
+     * @brief Queues a volume write for every session of a group; coalesced per group like SetVolume.
+     */
+    std::future<void> SetGroupVolume(const std::string &groupName, float volume);
+
+    /**
+     * @brief Runs tick on the worker every period, after the commands due by then,
+     * replacing any previous tick. A zero period or empty tick stops it. Ticks that
+     * fall behind are skipped, not run back to back.
+     */
+    void SetTick(std::chrono::milliseconds period, Task tick);
+
+    /**
+     * @brief Runs fn on the worker thread and returns its result through a future.
+     * Called from the worker itself, fn runs inline so waiting on the result cannot deadlock.
+     * If the worker is not running the future holds a std::runtime_error.
+     */
+    template <typename F>
+    auto Submit(F &&fn) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        std::future<Result> result = task->get_future();
+
+        if (!IsRunning())
+        {
+            return NotRunning<Result>();
+        }
+
+        if (IsWorkerThread())
+        {
+            (*task)();
+            return result;
+        }
+
+        Command command;
+        command.task = [task]()
+        { (*task)(); };
+        if (!Post(std::move(command)))
+        {
+            return NotRunning<Result>();
+        }
+        return result;
+    }
+
+private:
+    struct Command
+    {
+        Task task;                // Generic command, or empty for a volume write
+        NameId volumeApp = NO_NAME; // Volume write target
+        std::string volumeGroup;    // Group volume write target (volumeApp is NO_NAME)
+        float volume = 0.0f;      // Volume write level
+        TraceSpan span;           // Trace span of the frame that caused the write
+        std::shared_ptr<std::promise<void>> volumeDone;
+        std::vector<std::shared_ptr<std::promise<void>>> superseded; // Answered along with volumeDone
+        bool stop = false;
+    };
+
+    // Never touch WASAPI from the calling thread; fail fast instead of hanging callers
+    template <typename Result>
+    static std::future<Result> NotRunning()
+    {
+        std::promise<Result> failed;
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("Audio worker is not running")));
+        return failed.get_future();
+    }
+
+    bool Post(Command command); // False, dropping the command, once Stop has begun
+    std::future<void> PostVolume(Command command);
+    void Run(std::function<bool()> initialize, std::promise<bool> started);
+    void ExecuteBatch(std::vector<Command> &batch);
+    static void FailVolumeWrite(Command &command); // Answers a write that will not run
+    DWORD TickTimeout() const;
+    void RunTickIfDue();
+
+    MpscQueue<Command> m_queue;
+    HANDLE m_wakeEvent = nullptr;
+    std::thread m_thread;
+    std::thread::id m_threadId;
+    std::atomic<bool> m_running{false};
+    std::mutex m_lifecycleMutex; // Serializes Start/Stop only
+    std::atomic<bool> m_stopping{false}; // Set by Stop before the stop command; Post refuses from then on
+    std::atomic<int> m_posters{0};       // Posts between their m_stopping check and their push
+    VolumeHandler m_applyVolume;
+    GroupVolumeHandler m_applyGroupVolume;
+    Task m_shutdown;
+
+    // Periodic tick; worker thread only (SetTick posts the change)
+    Task m_tick;
+    std::chrono::milliseconds m_tickPeriod{0};
+    std::chrono::steady_clock::time_point m_nextTick;
+};
+
+// The process-wide audio worker
+extern AudioWorker g_audioWorker;
+
+#endif // AUDIO_WORKER_H
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <sstream> // For reading file into string easily
 #include <optional>
+#include "latency_trace.h" // TraceNowNs
 // No need to include <string>, <mutex>, json.hpp, crow.h again (included via backend_logic.hpp)
 
 // --- Define Global Constants ---
@@ -18,6 +19,38 @@ const int SERVER_PORT = 8080; // Backend server port
 std::mutex config_mutex;
 std::mutex binds_mutex;
 
+// --- Settings documents ---
+namespace
+{
+    AtomicFileWriter g_settingsWriter;
+
+    void RecordSettingsWrite(bool ok)
+    {
+        Metrics().settingsWrites.Increment();
+        if (!ok)
+        {
+            Metrics().settingsWriteFailures.Increment();
+        }
+    }
+
+    WriteBehindDocument g_configFile(CONFIG_FILE, g_settingsWriter, std::chrono::milliseconds(300),
+                                     std::chrono::milliseconds(2000), RecordSettingsWrite);
+    WriteBehindDocument g_bindsFile(BINDS_FILE, g_settingsWriter, std::chrono::milliseconds(300),
+                                    std::chrono::milliseconds(2000), RecordSettingsWrite);
+}
+
+ConfigStore g_configStore(g_configFile, g_bindsFile);
+
+// --- Input Injection ---
+// Key presses are injected on the executor thread, so callers never sleep
+IInputInjector &systemInputInjector()
+{
+    static SendInputInjector injector;
+    return injector;
+}
+
+InputExecutor g_inputExecutor(systemInputInjector());
+
 // --- Function Definitions ---
 
 json readJsonFile(const std::string &filename, std::mutex &file_mutex)
@@ -80,27 +113,34 @@ json readJsonFile(const std::string &filename, std::mutex &file_mutex)
     return data;
 }
 
-bool writeJsonFile(const std::string &filename, const json &data, std::mutex &file_mutex)
+std::string inlineInitialState(const std::string &html, const std::string &stateJson)
 {
-    std::lock_guard<std::mutex> lock(file_mutex);
-    std::ofstream file_stream(filename);
-    if (!file_stream.is_open())
+    std::string script = "<script>window.__BOOTSTRAP__ = ";
+    script.reserve(script.size() + stateJson.size() + 32);
+    for (char c : stateJson)
     {
-        std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
-        return false;
+        // '<' only occurs inside JSON strings, where \u003c means the same
+        if (c == '<')
+        {
+            script += "\\u003c";
+        }
+        else
+        {
+            script += c;
+        }
     }
-    try
+    script += ";</script>\n";
+
+    size_t at = html.find("<script");
+    if (at == std::string::npos)
     {
-        file_stream << data.dump(4); // Pretty-print
-        file_stream.close();
-        return true;
+        at = html.rfind("</body>");
     }
-    catch (const std::exception &e)
+    if (at == std::string::npos)
     {
-        std::cerr << "Error: Failed to write JSON to file " << filename << ". Error: " << e.what() << std::endl;
-        file_stream.close();
-        return false;
+        return html + script;
     }
+    return html.substr(0, at) + script + html.substr(at);
 }
 
 void addCorsHeaders(crow::response &res)
@@ -108,13 +148,63 @@ void addCorsHeaders(crow::response &res)
     // Allow requests from specific origin needed for your frontend
     res.add_header("Access-Control-Allow-Origin", "http://localhost:3000");
     // Specify allowed methods for actual requests
-    res.add_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    res.add_header("Access-Control-Allow-Methods", "GET, POST, PATCH, OPTIONS");
     // Specify allowed headers in actual requests (Content-Type is common)
     res.add_header("Access-Control-Allow-Headers", "Content-Type");
     // Allow credentials if needed (cookies, authorization headers, etc.)
     res.add_header("Access-Control-Allow-Credentials", "true");
 }
 
+WireFormat requestWireFormat(const crow::request &req)
+{
+    return NegotiateWireFormat(req.get_header_value("Accept"));
+}
+
+std::shared_ptr<const CachedResponse> getCachedResponse(ResponseCache &cache, uint64_t version,
+                                                        const ResponseCache::Render &render)
+{
+    bool rendered = false;
+    std::shared_ptr<const CachedResponse> cached = cache.Get(version, render, &rendered);
+    (rendered ? Metrics().responseCacheMisses : Metrics().responseCacheHits).Increment();
+    return cached;
+}
+
+void writeCachedResponse(const crow::request &req, crow::response &res, const CachedResponse &cached,
+                         const char *contentType)
+{
+    writeCachedResponse(req.get_header_value("If-None-Match"), res, cached, contentType);
+}
+
+void writeCachedResponse(const std::string &ifNoneMatch, crow::response &res, const CachedResponse &cached,
+                         const char *contentType)
+{
+    addCorsHeaders(res);
+    res.add_header("ETag", cached.etag);
+    // Cacheable, but revalidated every time, so the browser sends If-None-Match itself
+    res.add_header("Cache-Control", "no-cache");
+    res.add_header("Vary", "Accept");
+    res.add_header("Access-Control-Expose-Headers", "ETag, X-Config-Generation, X-Sessions-Version");
+
+    if (EtagMatches(ifNoneMatch, cached.etag))
+    {
+        Metrics().httpNotModified.Increment();
+        res.code = 304;
+        return;
+    }
+    res.add_header("Content-Type", contentType);
+    res.body = cached.body;
+}
+
+void HttpMetricsMiddleware::before_handle(crow::request & /*req*/, crow::response & /*res*/, context &ctx)
+{
+    ctx.startNs = TraceNowNs();
+}
+
+void HttpMetricsMiddleware::after_handle(crow::request &req, crow::response & /*res*/, context &ctx)
+{
+    RecordHttpRequest(req.url, static_cast<uint64_t>(TraceNowNs() - ctx.startNs));
+}
+
 std::optional<std::string> readFileContent(const std::string &filepath)
 {
     std::ifstream file_stream(filepath);
@@ -160,186 +250,14 @@ const char *getMimeType(const std::string &filepath)
     return "application/octet-stream"; // Default
 }
 
-// Get virtual key code from key name
-int getVirtualKeyCode(const std::string &keyName)
-{
-    // Common keys
-    if (keyName == "A")
-        return 'A';
-    if (keyName == "B")
-        return 'B';
-    if (keyName == "C")
-        return 'C';
-    // Add remaining letters...
-    if (keyName == "Z")
-        return 'Z';
-
-    // Numbers
-    if (keyName == "0")
-        return '0';
-    if (keyName == "1")
-        return '1';
-    // Add remaining numbers...
-    if (keyName == "9")
-        return '9';
-
-    // Function keys
-    if (keyName == "F1")
-        return VK_F1;
-    if (keyName == "F2")
-        return VK_F2;
-    // Add remaining function keys...
-    if (keyName == "F12")
-        return VK_F12;
-
-    // Special keys
-    if (keyName == "Escape" || keyName == "Esc")
-        return VK_ESCAPE;
-    if (keyName == "Tab")
-        return VK_TAB;
-    if (keyName == "CapsLock")
-        return VK_CAPITAL;
-    if (keyName == "Shift")
-        return VK_SHIFT;
-    if (keyName == "Control" || keyName == "Ctrl")
-        return VK_CONTROL;
-    if (keyName == "Alt")
-        return VK_MENU;
-    if (keyName == "Space")
-        return VK_SPACE;
-    if (keyName == "Enter")
-        return VK_RETURN;
-    if (keyName == "Backspace")
-        return VK_BACK;
-
-    // Arrow keys
-    if (keyName == "ArrowUp" || keyName == "Up")
-        return VK_UP;
-    if (keyName == "ArrowDown" || keyName == "Down")
-        return VK_DOWN;
-    if (keyName == "ArrowLeft" || keyName == "Left")
-        return VK_LEFT;
-    if (keyName == "ArrowRight" || keyName == "Right")
-        return VK_RIGHT;
-
-    // Multimedia keys
-    if (keyName == "Media_PlayPause")
-        return VK_MEDIA_PLAY_PAUSE;
-    if (keyName == "Media_NextTrack")
-        return VK_MEDIA_NEXT_TRACK;
-    if (keyName == "Media_PrevTrack")
-        return VK_MEDIA_PREV_TRACK;
-    if (keyName == "Media_Stop")
-        return VK_MEDIA_STOP;
-    if (keyName == "Media_VolumeUp")
-        return VK_VOLUME_UP;
-    if (keyName == "Media_VolumeDown")
-        return VK_VOLUME_DOWN;
-    if (keyName == "Media_VolumeMute")
-        return VK_VOLUME_MUTE;
-
-    // Default: unknown key
-    std::cerr << "Unknown key name: " << keyName << std::endl;
-    return 0;
-}
-
-// Simulate a hotkey combination (key code + modifiers)
-void simulateHotkey(int keyCode, int modifiers)
+// Queue a ready-made chord on the input executor
+bool injectKeyChord(const KeyChord &chord, bool media)
 {
-    try
-    {
-        std::cout << "Simulating hotkey with keyCode: 0x" << std::hex << keyCode
-                  << std::dec << " and modifiers: " << modifiers << std::endl;
-
-        // Array to hold all inputs (modifiers + main key)
-        INPUT inputs[4] = {};
-        int inputCount = 0;
-
-        // Add modifier keys if needed
-        if (modifiers & 1)
-        { // Ctrl
-            inputs[inputCount].type = INPUT_KEYBOARD;
-            inputs[inputCount].ki.wVk = VK_CONTROL;
-            inputCount++;
-        }
-        if (modifiers & 2)
-        { // Shift
-            inputs[inputCount].type = INPUT_KEYBOARD;
-            inputs[inputCount].ki.wVk = VK_SHIFT;
-            inputCount++;
-        }
-        if (modifiers & 4)
-        { // Alt
-            inputs[inputCount].type = INPUT_KEYBOARD;
-            inputs[inputCount].ki.wVk = VK_MENU;
-            inputCount++;
-        }
-
-        // Main key
-        inputs[inputCount].type = INPUT_KEYBOARD;
-        inputs[inputCount].ki.wVk = keyCode;
-        inputCount++;
-
-        // Send key press events
-        UINT uSent = SendInput(inputCount, inputs, sizeof(INPUT));
-        if (uSent != inputCount)
-        {
-            std::cerr << "SendInput failed: " << GetLastError() << std::endl;
-        }
-        else
-        {
-            std::cout << "Key press sent successfully" << std::endl;
-        }
-
-        // Small delay
-        Sleep(50);
-
-        // Release all keys (in reverse order)
-        for (int i = 0; i < inputCount; i++)
-        {
-            inputs[i].ki.dwFlags = KEYEVENTF_KEYUP;
-        }
-
-        // Send key release events
-        uSent = SendInput(inputCount, inputs, sizeof(INPUT));
-        if (uSent != inputCount)
-        {
-            std::cerr << "SendInput (release) failed: " << GetLastError() << std::endl;
-        }
-        else
-        {
-            std::cout << "Key release sent successfully" << std::endl;
-        }
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Exception in simulateHotkey: " << e.what() << std::endl;
-    }
-}
-
-// Simulate a multimedia key press specifically
-bool simulateMediaKey(int mediaKey)
-{
-    try
-    {
-        std::cout << "Simulating media key with code: 0x" << std::hex << mediaKey << std::dec << std::endl;
-
-        // Press key
-        keybd_event(mediaKey, 0xbf, 0, 0);
-
-        // Add a small delay
-        Sleep(50);
-
-        // Release key
-        keybd_event(mediaKey, 0xbf, KEYEVENTF_KEYUP, 0);
-
-        std::cout << "Media key simulation sent." << std::endl;
-
-        return true;
-    }
-    catch (const std::exception &e)
+    (media ? Metrics().mediaKeyInjections : Metrics().hotkeyInjections).Increment();
+    if (!g_inputExecutor.Submit(chord))
     {
-        std::cerr << "Exception in simulateMediaKey: " << e.what() << std::endl;
+        std::cerr << "Input queue full, key press dropped" << std::endl;
         return false;
     }
+    return true;
 }
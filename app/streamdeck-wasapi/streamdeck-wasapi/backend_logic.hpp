@@ -6,6 +6,13 @@
 #include <optional> // Include <optional> to resolve E0135
 #include "json.hpp" // Or path/to/json.hpp - Needed for json type alias
 #include "crow.h"   // Or path/to/crow.h - Needed for crow::response
+#include "metrics.h"
+#include "input_executor.h"
+#include "hotkey_combo.h"
+#include "config_store.h"
+#include "response_cache.h"
+#include "wire_format.h"
+#include "version_waiters.h"
 
 // Use nlohmann/json namespace alias in the header for convenience
 using json = nlohmann::json;
@@ -19,6 +26,19 @@ extern const int SERVER_PORT;
 extern std::mutex config_mutex;
 extern std::mutex binds_mutex;
 
+// --- Settings (defined in .cpp, loaded and started by the application) ---
+// config.json and binds.json in memory, versioned together (see config_store.h);
+// commits reach the disk later on writer threads (see json_persistence.h).
+extern ConfigStore g_configStore;
+
+// --- Input Injection (defined in .cpp, started by the application) ---
+extern InputExecutor g_inputExecutor;
+
+/**
+ * @brief The SendInput-backed injector shared by the input executor and the macro scheduler.
+ */
+IInputInjector &systemInputInjector();
+
 // --- Function Declarations (Prototypes) ---
 
 /**
@@ -44,13 +64,13 @@ const char *getMimeType(const std::string &filepath);
 json readJsonFile(const std::string &filename, std::mutex &file_mutex);
 
 /**
- * @brief Writes JSON data to a specified file.
- * @param filename The path to the JSON file.
- * @param data The nlohmann::json object to write.
- * @param file_mutex A mutex to lock during file access.
- * @return True if writing was successful, false otherwise.
+ * @brief Embeds state in an HTML page as window.__BOOTSTRAP__, just before its first
+ * script tag (or before </body>), so the page can render without an API request.
+ * @param html The page.
+ * @param stateJson A serialized JSON object; '<' is escaped so it cannot end the script element.
+ * @return The page with the state inlined.
  */
-bool writeJsonFile(const std::string &filename, const json &data, std::mutex &file_mutex);
+std::string inlineInitialState(const std::string &html, const std::string &stateJson);
 
 /**
  * @brief Adds standard CORS headers to a Crow response object.
@@ -59,24 +79,71 @@ bool writeJsonFile(const std::string &filename, const json &data, std::mutex &fi
 void addCorsHeaders(crow::response &res);
 
 /**
- * @brief Converts a key name string to Windows virtual key code.
- * @param keyName String representation of the key.
- * @return Windows virtual key code (VK_*) or 0 if unknown.
+ * @brief The encoding a request asked for with its Accept header (see wire_format.h).
+ */
+WireFormat requestWireFormat(const crow::request &req);
+
+/**
+ * @brief The response body for a version from the cache, serialized only on a miss.
+ * @param cache One cache per endpoint.
+ * @param version Config generation or session table version the body is built from.
+ * @param render Serializes the body.
+ * @return The shared, immutable body and its ETag.
  */
-int getVirtualKeyCode(const std::string &keyName);
+std::shared_ptr<const CachedResponse> getCachedResponse(ResponseCache &cache, uint64_t version,
+                                                        const ResponseCache::Render &render);
 
 /**
- * @brief Simulates pressing and releasing a key combination.
- * @param keyCode Windows virtual key code of the main key.
- * @param modifiers Bit flags for modifiers (1=Ctrl, 2=Shift, 4=Alt).
+ * @brief Sends a cached body with its ETag, or 304 Not Modified when the request's
+ * If-None-Match already names it. Adds the CORS headers and Vary: Accept (bodies are
+ * negotiated); the caller ends the response.
+ * @param req The request (for If-None-Match).
+ * @param res The crow::response object to fill.
+ * @param cached The serialized body (see response_cache.h).
+ * @param contentType MIME type of the body.
  */
-void simulateHotkey(int keyCode, int modifiers);
+void writeCachedResponse(const crow::request &req, crow::response &res, const CachedResponse &cached,
+                         const char *contentType);
+
+/**
+ * @brief As above, for a request that is answered later (e.g. a parked long poll).
+ * @param ifNoneMatch The request's If-None-Match value, empty if it had none.
+ */
+void writeCachedResponse(const std::string &ifNoneMatch, crow::response &res, const CachedResponse &cached,
+                         const char *contentType);
+
+/**
+ * @brief Crow middleware recording per-route request counts and handling latency
+ * into the metrics registry (see RegisterHttpRoutes / RecordHttpRequest). Its context
+ * lives as long as the connection, so it also holds the request's parked long poll.
+ */
+struct HttpMetricsMiddleware
+{
+    struct context
+    {
+        int64_t startNs = 0;
+        std::shared_ptr<ParkedReply> parked; // The long poll this request parked, if any
+
+        // The connection is going away: a reply still parked must never reach it
+        ~context()
+        {
+            if (parked)
+            {
+                parked->Close();
+            }
+        }
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx);
+    void after_handle(crow::request &req, crow::response &res, context &ctx);
+};
 
 /**
- * @brief Simulates pressing and releasing a multimedia key.
- * @param mediaKey Windows virtual key code for the media key.
- * @return True if successful, false otherwise.
+ * @brief Queues a precompiled chord on the input executor. No parsing, no allocation.
+ * @param chord The keys to press (see BuildKeyChord).
+ * @param media True for multimedia keys (only affects the injection metrics).
+ * @return True if the press was queued, false if the input queue is full.
  */
-bool simulateMediaKey(int mediaKey);
+bool injectKeyChord(const KeyChord &chord, bool media);
 
 #endif // BACKEND_LOGIC_HPP#include "backend_logic.hpp"
\ No newline at end of file
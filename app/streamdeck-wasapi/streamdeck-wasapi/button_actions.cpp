@@ -0,0 +1,295 @@
+#include "button_actions.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include "hotkey_combo.h"
+
+namespace
+{
+    const ButtonAction NO_ACTION;
+
+    void Report(std::vector<std::string> *problems, const std::string &message)
+    {
+        if (problems)
+        {
+            problems->push_back(message);
+        }
+    }
+
+    // Parses a button index at position, advancing it; -1 if there is none
+    int ParseButtonIndex(const std::string &text, size_t &position)
+    {
+        const size_t start = position;
+        int index = 0;
+        while (position < text.size() && text[position] >= '0' && text[position] <= '9' && index < EXPECTED_BUTTONS)
+        {
+            index = index * 10 + (text[position] - '0');
+            ++position;
+        }
+        return (position == start || index >= EXPECTED_BUTTONS) ? -1 : index;
+    }
+
+    // "button3" / "button3:double" -> button and gesture; false if the key is not a button binding
+    bool ParseButtonKey(const std::string &key, int &button, GestureType &gesture)
+    {
+        const std::string prefix = "button";
+        if (key.compare(0, prefix.size(), prefix) != 0)
+        {
+            return false;
+        }
+
+        size_t position = prefix.size();
+        button = ParseButtonIndex(key, position);
+        if (button < 0)
+        {
+            return false;
+        }
+
+        const std::string suffix = key.substr(position);
+        if (suffix.empty() || suffix == ":tap")
+        {
+            gesture = GestureType::Tap;
+        }
+        else if (suffix == ":double")
+        {
+            gesture = GestureType::DoubleTap;
+        }
+        else if (suffix == ":long")
+        {
+            gesture = GestureType::LongPress;
+        }
+        else if (suffix == ":repeat")
+        {
+            gesture = GestureType::HoldRepeat;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    // "chord:0+1" -> bit mask of two or more distinct buttons, 0 if invalid
+    uint32_t ParseChordKey(const std::string &key)
+    {
+        const std::string prefix = "chord:";
+        if (key.compare(0, prefix.size(), prefix) != 0)
+        {
+            return 0;
+        }
+
+        uint32_t mask = 0;
+        int count = 0;
+        size_t position = prefix.size();
+        while (true)
+        {
+            const int button = ParseButtonIndex(key, position);
+            if (button < 0 || (mask & (1u << button)))
+            {
+                return 0;
+            }
+            mask |= 1u << button;
+            ++count;
+
+            if (position == key.size())
+            {
+                break;
+            }
+            if (key[position] != '+')
+            {
+                return 0;
+            }
+            ++position;
+        }
+        return count >= 2 ? mask : 0;
+    }
+
+    class ActionResolver
+    {
+    public:
+        ActionResolver(const json &binds_data, const std::vector<std::string> &profile_names)
+            : m_profileNames(profile_names)
+        {
+            // Action name -> binding (first binding wins, like the old linear scan)
+            if (binds_data.is_array())
+            {
+                for (const auto &binding : binds_data)
+                {
+                    if (binding.is_object() && binding.contains("action") && binding["action"].is_string())
+                    {
+                        m_bindings.emplace(binding["action"].get<std::string>(), &binding);
+                    }
+                }
+            }
+        }
+
+        bool Resolve(const std::string &bindingKey, const std::string &actionName, ButtonAction &action,
+                     std::vector<std::string> *problems)
+        {
+            auto found = m_bindings.find(actionName);
+            if (found == m_bindings.end())
+            {
+                Report(problems, bindingKey + ": no binding found for action '" + actionName + "'");
+                return false;
+            }
+            const json &binding = *found->second;
+
+            if (binding.contains("profile"))
+            {
+                const json &profile = binding["profile"];
+                auto name = std::find(m_profileNames.begin(), m_profileNames.end(),
+                                      profile.is_string() ? profile.get<std::string>() : std::string());
+                if (name == m_profileNames.end())
+                {
+                    Report(problems, bindingKey + ": action '" + actionName + "' switches to unknown profile " + profile.dump());
+                    return false;
+                }
+                action.type = ButtonActionType::ProfileSwitch;
+                action.profile = static_cast<uint8_t>(name - m_profileNames.begin());
+                return true;
+            }
+
+            if (binding.contains("macro"))
+            {
+                // Macros are compiled once per action, even if several gestures share one
+                auto compiled = m_macros.find(actionName);
+                if (compiled == m_macros.end())
+                {
+                    auto program = std::make_shared<MacroProgram>();
+                    std::string error;
+                    if (!CompileMacro(binding["macro"], *program, error))
+                    {
+                        Report(problems, bindingKey + ": macro '" + actionName + "' " + error);
+                        return false;
+                    }
+                    compiled = m_macros.emplace(actionName, std::move(program)).first;
+                }
+                action.type = ButtonActionType::Macro;
+                action.macro = compiled->second;
+                return true;
+            }
+
+            if (!binding.contains("combo") || !binding["combo"].is_string())
+            {
+                Report(problems, bindingKey + ": action '" + actionName + "' has no combo, macro or profile");
+                return false;
+            }
+
+            const std::string combo = binding["combo"].get<std::string>();
+            HotkeyCombo parsed;
+            if (!ParseHotkeyCombo(combo, parsed))
+            {
+                Report(problems, bindingKey + ": unknown key combo '" + combo + "'");
+                return false;
+            }
+
+            action.type = parsed.IsMedia() ? ButtonActionType::MediaKey : ButtonActionType::Hotkey;
+            action.chord = BuildKeyChord(parsed);
+            return true;
+        }
+
+    private:
+        const std::vector<std::string> &m_profileNames;
+        std::unordered_map<std::string, const json *> m_bindings;
+        std::unordered_map<std::string, std::shared_ptr<const MacroProgram>> m_macros;
+    };
+}
+
+const ButtonAction &ButtonActionTable::Lookup(const GestureEvent &event) const
+{
+    if (event.type == GestureType::Chord)
+    {
+        return event.index < gestures.chordCount ? chords[event.index] : NO_ACTION;
+    }
+    if (event.index >= EXPECTED_BUTTONS)
+    {
+        return NO_ACTION;
+    }
+    return buttons[event.index][static_cast<int>(event.type)];
+}
+
+GestureTiming ReadGestureTiming(const json &config_data)
+{
+    GestureTiming timing;
+    if (!config_data.is_object() || !config_data.contains("gestureTiming") || !config_data["gestureTiming"].is_object())
+    {
+        return timing;
+    }
+
+    const json &settings = config_data["gestureTiming"];
+    auto read = [&settings](const char *name, std::chrono::milliseconds &value)
+    {
+        if (settings.contains(name) && settings[name].is_number_integer() &&
+            settings[name].get<int>() > 0 && settings[name].get<int>() <= 10000)
+        {
+            value = std::chrono::milliseconds(settings[name].get<int>());
+        }
+    };
+    read("doubleTapMs", timing.doubleTapWindow);
+    read("longPressMs", timing.longPress);
+    read("repeatMs", timing.repeatInterval);
+    read("chordMs", timing.chordWindow);
+    return timing;
+}
+
+std::shared_ptr<const ButtonActionTable> CompileButtonActions(const json &button_bindings, const GestureTiming &timing,
+                                                              const json &binds_data,
+                                                              const std::vector<std::string> &profile_names,
+                                                              std::vector<std::string> *problems)
+{
+    auto table = std::make_shared<ButtonActionTable>();
+    table->gestures.timing = timing;
+    if (!button_bindings.is_object())
+    {
+        return table;
+    }
+
+    ActionResolver resolver(binds_data, profile_names);
+    for (const auto &[bindingKey, value] : button_bindings.items())
+    {
+        int button = -1;
+        GestureType gesture = GestureType::Tap;
+        const bool isButton = ParseButtonKey(bindingKey, button, gesture);
+        const uint32_t chordMask = isButton ? 0 : ParseChordKey(bindingKey);
+        if (!isButton && chordMask == 0)
+        {
+            Report(problems, "Ignoring unknown binding key '" + bindingKey + "'");
+            continue;
+        }
+        if (!value.is_string())
+        {
+            Report(problems, bindingKey + ": action name must be a string");
+            continue;
+        }
+
+        const std::string actionName = value.get<std::string>();
+        if (actionName.empty() || actionName == "__none__")
+        {
+            continue; // Disabled on purpose
+        }
+
+        ButtonAction action;
+        if (!resolver.Resolve(bindingKey, actionName, action, problems))
+        {
+            continue; // Left unbound, so it adds no recognition latency
+        }
+
+        GestureBindings &gestures = table->gestures;
+        if (isButton)
+        {
+            table->buttons[button][static_cast<int>(gesture)] = std::move(action);
+            gestures.buttonMasks[button] |= GestureBit(gesture);
+        }
+        else if (gestures.chordCount == MAX_CHORDS)
+        {
+            Report(problems, bindingKey + ": too many chords (at most " + std::to_string(MAX_CHORDS) + ")");
+        }
+        else
+        {
+            table->chords[gestures.chordCount] = std::move(action);
+            gestures.chordMasks[gestures.chordCount++] = chordMask;
+        }
+    }
+
+    return table;
+}
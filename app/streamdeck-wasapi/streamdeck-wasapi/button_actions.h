@@ -0,0 +1,81 @@
+#ifndef BUTTON_ACTIONS_H
+#define BUTTON_ACTIONS_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "input_injector.h"
+#include "macro.h"
+#include "gesture_recognizer.h"
+#include "serial_frame.h" // EXPECTED_BUTTONS
+
+// Button bindings compiled ahead of time.
+//
+// config.json maps binding keys to action names (per profile, see profile.h) and
+// binds.json maps action names to combos, macros or profile switches. Both are
+// resolved whenever either file changes, into a fixed table indexed by button and
+// gesture, so a press is an array index plus a queue push. Binding keys:
+//
+//   "button0"          tap (also "button0:tap")
+//   "button0:double"   double-tap
+//   "button0:long"     long press
+//   "button0:repeat"   hold-to-repeat
+//   "chord:0+1"        buttons 0 and 1 pressed together
+//
+// Gesture timing can be tuned with an optional "gestureTiming" object in config.json:
+// {"doubleTapMs": 250, "longPressMs": 500, "repeatMs": 100, "chordMs": 60}.
+
+using json = nlohmann::json;
+
+enum class ButtonActionType : uint8_t
+{
+    None = 0, // Unbound, disabled ("__none__") or unresolvable
+    Hotkey,   // Inject chord
+    MediaKey, // Inject chord (a single multimedia key)
+    Macro,    // Run macro on the macro scheduler
+    ProfileSwitch, // Activate another profile
+};
+
+struct ButtonAction
+{
+    ButtonActionType type = ButtonActionType::None;
+    KeyChord chord;                            // Ready to hand to the input executor
+    std::shared_ptr<const MacroProgram> macro; // Compiled macro for ButtonActionType::Macro
+    uint8_t profile = 0;                       // Profile index for ButtonActionType::ProfileSwitch
+};
+
+struct ButtonActionTable
+{
+    std::array<std::array<ButtonAction, BUTTON_GESTURE_COUNT>, EXPECTED_BUTTONS> buttons;
+    std::array<ButtonAction, MAX_CHORDS> chords; // Parallel to gestures.chordMasks
+    GestureBindings gestures;                    // What the recognizer has to tell apart
+
+    /**
+     * @brief The action bound to a recognized gesture (ButtonActionType::None if unbound).
+     */
+    const ButtonAction &Lookup(const GestureEvent &event) const;
+};
+
+/**
+ * @brief Reads the optional "gestureTiming" object of config.json (defaults otherwise).
+ */
+GestureTiming ReadGestureTiming(const json &config_data);
+
+/**
+ * @brief Resolves a "buttonBindings" object against the binds.json combos, macros and profile switches.
+ * @param button_bindings Binding key -> action name object (anything else yields an empty table).
+ * @param timing Gesture timing the table is recognized with.
+ * @param binds_data Parsed binds.json array of {action, combo}, {action, macro} or {action, profile}.
+ * @param profile_names Profile names in index order, for {action, profile} bindings.
+ * @param problems Optional; receives one message per binding that could not be compiled.
+ * @return The compiled table (never null). Unresolved bindings are ButtonActionType::None.
+ */
+std::shared_ptr<const ButtonActionTable> CompileButtonActions(const json &button_bindings, const GestureTiming &timing,
+                                                              const json &binds_data,
+                                                              const std::vector<std::string> &profile_names,
+                                                              std::vector<std::string> *problems = nullptr);
+
+#endif // BUTTON_ACTIONS_H
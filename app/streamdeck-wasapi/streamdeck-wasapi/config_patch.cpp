@@ -0,0 +1,588 @@
+#include "config_patch.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    using Pointer = std::vector<std::string>; // Unescaped reference tokens of a JSON Pointer
+
+    bool Fail(ConfigPatchResult &result, std::string error, bool conflict = false)
+    {
+        result.ok = false;
+        result.conflict = conflict;
+        result.error = std::move(error);
+        return false;
+    }
+
+    // RFC 6901: "/a~1b/c~0d" -> {"a/b", "c~d"}
+    bool ParsePointer(const std::string &text, Pointer &tokens)
+    {
+        tokens.clear();
+        if (text.empty())
+        {
+            return true;
+        }
+        if (text[0] != '/')
+        {
+            return false;
+        }
+
+        std::string token;
+        for (size_t i = 1; i <= text.size(); ++i)
+        {
+            if (i == text.size() || text[i] == '/')
+            {
+                tokens.push_back(std::move(token));
+                token.clear();
+            }
+            else if (text[i] == '~')
+            {
+                if (i + 1 >= text.size() || (text[i + 1] != '0' && text[i + 1] != '1'))
+                {
+                    return false;
+                }
+                token += text[i + 1] == '0' ? '~' : '/';
+                ++i;
+            }
+            else
+            {
+                token += text[i];
+            }
+        }
+        return true;
+    }
+
+    bool ParseIndex(const std::string &token, size_t &index)
+    {
+        if (token.empty() || token.size() > 9 || (token.size() > 1 && token[0] == '0') ||
+            !std::all_of(token.begin(), token.end(), [](char c)
+                         { return c >= '0' && c <= '9'; }))
+        {
+            return false;
+        }
+        index = static_cast<size_t>(std::stoul(token));
+        return true;
+    }
+
+    // The value at the first `count` tokens, or null if there is none
+    template <typename Json>
+    Json *Find(Json &document, const Pointer &tokens, size_t count)
+    {
+        Json *current = &document;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (current->is_object())
+            {
+                auto found = current->find(tokens[i]);
+                if (found == current->end())
+                {
+                    return nullptr;
+                }
+                current = &*found;
+            }
+            else if (current->is_array())
+            {
+                size_t index = 0;
+                if (!ParseIndex(tokens[i], index) || index >= current->size())
+                {
+                    return nullptr;
+                }
+                current = &(*current)[index];
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+        return current;
+    }
+
+    bool AddValue(json &document, const Pointer &path, json value)
+    {
+        json *parent = Find(document, path, path.size() - 1);
+        if (!parent)
+        {
+            return false;
+        }
+        if (parent->is_object())
+        {
+            (*parent)[path.back()] = std::move(value);
+            return true;
+        }
+        if (parent->is_array())
+        {
+            size_t index = 0;
+            if (path.back() == "-")
+            {
+                parent->push_back(std::move(value));
+                return true;
+            }
+            if (ParseIndex(path.back(), index) && index <= parent->size())
+            {
+                parent->insert(parent->begin() + static_cast<std::ptrdiff_t>(index), std::move(value));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool RemoveValue(json &document, const Pointer &path)
+    {
+        json *parent = Find(document, path, path.size() - 1);
+        if (!parent)
+        {
+            return false;
+        }
+        if (parent->is_object())
+        {
+            return parent->erase(path.back()) == 1;
+        }
+        size_t index = 0;
+        if (parent->is_array() && ParseIndex(path.back(), index) && index < parent->size())
+        {
+            parent->erase(index);
+            return true;
+        }
+        return false;
+    }
+
+    uint32_t AreaOf(const Pointer &path)
+    {
+        const std::string &key = path[0];
+        if (key == "groups")
+        {
+            return path.size() >= 3 ? CONFIG_AREA_GROUP_MEMBERS : CONFIG_AREA_GROUP_LIST;
+        }
+        if (key == "group_names")
+        {
+            return CONFIG_AREA_GROUP_NAMES;
+        }
+        if (key == "buttonBindings" || key == "profiles" || key == "activeProfile" || key == "autoSwitch")
+        {
+            return CONFIG_AREA_PROFILES;
+        }
+        if (key == "meters" || key == "ducking")
+        {
+            return CONFIG_AREA_METERS;
+        }
+        return CONFIG_AREA_OTHER;
+    }
+
+    bool IsStringArray(const json &value)
+    {
+        return value.is_array() && std::all_of(value.begin(), value.end(), [](const json &item)
+                                               { return item.is_string(); });
+    }
+
+    // Checks the top-level entry a path went through, and below it only the entry it named
+    bool ValidatePath(const json &config, const Pointer &path, ConfigPatchResult &result)
+    {
+        const std::string &key = path[0];
+        auto top = config.find(key);
+
+        if (key == "groups" || key == "group_names" || key == "buttonBindings" || key == "profiles")
+        {
+            if (top == config.end())
+            {
+                return key == "groups" ? Fail(result, "'groups' cannot be removed") : true;
+            }
+            if (!top->is_object())
+            {
+                return Fail(result, "'" + key + "' must be an object");
+            }
+
+            // A group is a list of rules; names and bindings are strings
+            auto valid = [&key](const json &entry)
+            {
+                return key == "groups" ? IsStringArray(entry) : key == "profiles" ? entry.is_object()
+                                                                                  : entry.is_string();
+            };
+            if (path.size() == 1)
+            {
+                for (const auto &entry : *top)
+                {
+                    if (!valid(entry))
+                    {
+                        return Fail(result, "Invalid entry in '" + key + "'");
+                    }
+                }
+                return true;
+            }
+            auto entry = top->find(path[1]);
+            if (entry != top->end() && !valid(*entry))
+            {
+                return Fail(result, "Invalid value for '" + key + "/" + path[1] + "'");
+            }
+        }
+        return true;
+    }
+
+    // A group added or removed gets or loses its display name; nothing else is scanned
+    void SyncGroupName(json &config, const std::string &group)
+    {
+        if (!config.contains("group_names") || !config["group_names"].is_object())
+        {
+            config["group_names"] = json::object();
+        }
+        json &names = config["group_names"];
+        const bool exists = config["groups"].contains(group);
+        if (exists && !names.contains(group))
+        {
+            names[group] = group;
+        }
+        else if (!exists)
+        {
+            names.erase(group);
+        }
+    }
+
+    void SyncAllGroupNames(json &config)
+    {
+        if (!config.contains("group_names") || !config["group_names"].is_object())
+        {
+            config["group_names"] = json::object();
+        }
+        for (auto &[group, rules] : config["groups"].items())
+        {
+            SyncGroupName(config, group);
+        }
+        std::vector<std::string> orphans;
+        for (auto &[group, name] : config["group_names"].items())
+        {
+            if (!config["groups"].contains(group))
+            {
+                orphans.push_back(group);
+            }
+        }
+        for (const auto &group : orphans)
+        {
+            config["group_names"].erase(group);
+        }
+    }
+
+    bool AfterChange(ConfigEdit &edit, const Pointer &path, ConfigPatchResult &result)
+    {
+        result.touched |= AreaOf(path);
+        if (!ValidatePath(edit.Config(), path, result))
+        {
+            return false;
+        }
+        if (path[0] == "groups" && path.size() == 1)
+        {
+            SyncAllGroupNames(edit.MutableConfig());
+        }
+        else if (path[0] == "groups" && path.size() == 2)
+        {
+            SyncGroupName(edit.MutableConfig(), path[1]);
+        }
+        return true;
+    }
+
+    bool ApplyJsonPatchOp(const std::string &name, const json &op, ConfigEdit &edit, ConfigPatchResult &result)
+    {
+        Pointer path;
+        Pointer from;
+        auto pathMember = op.find("path");
+        if (pathMember == op.end() || !pathMember->is_string() || !ParsePointer(pathMember->get<std::string>(), path))
+        {
+            return Fail(result, "'" + name + "' needs a valid 'path'");
+        }
+        if (path.empty())
+        {
+            return Fail(result, "The whole config cannot be patched at once; use /api/save-config");
+        }
+        const bool needsFrom = name == "move" || name == "copy";
+        if (needsFrom)
+        {
+            auto fromMember = op.find("from");
+            if (fromMember == op.end() || !fromMember->is_string() ||
+                !ParsePointer(fromMember->get<std::string>(), from) || from.empty())
+            {
+                return Fail(result, "'" + name + "' needs a valid 'from'");
+            }
+        }
+        const bool needsValue = name == "add" || name == "replace" || name == "test";
+        if (needsValue && !op.contains("value"))
+        {
+            return Fail(result, "'" + name + "' needs a 'value'");
+        }
+        const std::string where = pathMember->get<std::string>();
+
+        if (name == "test")
+        {
+            const json *target = Find(edit.Config(), path, path.size());
+            return target && *target == op["value"] ? true : Fail(result, "Test failed at " + where, true);
+        }
+        if (name == "add")
+        {
+            if (!AddValue(edit.MutableConfig(), path, op["value"]))
+            {
+                return Fail(result, "Cannot add at " + where, true);
+            }
+            return AfterChange(edit, path, result);
+        }
+        if (name == "remove")
+        {
+            if (!Find(edit.Config(), path, path.size()) || !RemoveValue(edit.MutableConfig(), path))
+            {
+                return Fail(result, "Nothing to remove at " + where, true);
+            }
+            return AfterChange(edit, path, result);
+        }
+        if (name == "replace")
+        {
+            if (!Find(edit.Config(), path, path.size()))
+            {
+                return Fail(result, "Nothing to replace at " + where, true);
+            }
+            *Find(edit.MutableConfig(), path, path.size()) = op["value"];
+            return AfterChange(edit, path, result);
+        }
+
+        // move / copy
+        const json *source = Find(edit.Config(), from, from.size());
+        if (!source)
+        {
+            return Fail(result, "Nothing to " + name + " at " + op["from"].get<std::string>(), true);
+        }
+        if (name == "move" && path.size() > from.size() && std::equal(from.begin(), from.end(), path.begin()))
+        {
+            return Fail(result, "Cannot move a value into itself");
+        }
+        json value = *source;
+        if (name == "move" && !RemoveValue(edit.MutableConfig(), from))
+        {
+            return Fail(result, "Nothing to move at " + op["from"].get<std::string>(), true);
+        }
+        if (!AddValue(edit.MutableConfig(), path, std::move(value)))
+        {
+            return Fail(result, "Cannot " + name + " to " + where, true);
+        }
+        if (name == "move" && !AfterChange(edit, from, result))
+        {
+            return false;
+        }
+        return AfterChange(edit, path, result);
+    }
+
+    bool GetString(const json &op, const char *member, std::string &value, ConfigPatchResult &result)
+    {
+        auto found = op.find(member);
+        if (found == op.end() || !found->is_string() || found->get_ref<const std::string &>().empty())
+        {
+            return Fail(result, "'" + op["op"].get<std::string>() + "' needs a string '" + member + "'");
+        }
+        value = found->get<std::string>();
+        return true;
+    }
+
+    const json *FindGroup(const json &config, const std::string &group)
+    {
+        auto groups = config.find("groups");
+        if (groups == config.end() || !groups->is_object())
+        {
+            return nullptr;
+        }
+        auto found = groups->find(group);
+        return found != groups->end() && found->is_array() ? &*found : nullptr;
+    }
+
+    bool Contains(const json &rules, const std::string &app)
+    {
+        return std::find(rules.begin(), rules.end(), app) != rules.end();
+    }
+
+    bool ApplyAppOp(const std::string &name, const json &op, ConfigEdit &edit, ConfigPatchResult &result)
+    {
+        std::string app;
+        std::string from;
+        std::string to;
+        if (!GetString(op, "app", app, result))
+        {
+            return false;
+        }
+        if (name == "moveApp")
+        {
+            if (!GetString(op, "from", from, result) || !GetString(op, "to", to, result))
+            {
+                return false;
+            }
+        }
+        else if (!GetString(op, "group", name == "addApp" ? to : from, result))
+        {
+            return false;
+        }
+
+        const json *source = from.empty() ? nullptr : FindGroup(edit.Config(), from);
+        const json *target = to.empty() ? nullptr : FindGroup(edit.Config(), to);
+        if ((!from.empty() && !source) || (!to.empty() && !target))
+        {
+            return Fail(result, "Unknown group '" + (!from.empty() && !source ? from : to) + "'", true);
+        }
+        if (from == to)
+        {
+            return true;
+        }
+
+        // Already where it should be: no copy, no commit
+        const bool remove = source && Contains(*source, app);
+        const bool add = target && !Contains(*target, app);
+        if (!remove && !add)
+        {
+            return true;
+        }
+
+        json &groups = edit.MutableConfig()["groups"];
+        if (remove)
+        {
+            json &rules = groups[from];
+            rules.erase(std::remove(rules.begin(), rules.end(), app), rules.end());
+        }
+        if (add)
+        {
+            json &rules = groups[to];
+            size_t index = rules.size();
+            if (op.contains("index") && op["index"].is_number_unsigned())
+            {
+                index = (std::min)(op["index"].get<size_t>(), rules.size());
+            }
+            rules.insert(rules.begin() + static_cast<std::ptrdiff_t>(index), app);
+        }
+        result.touched |= CONFIG_AREA_GROUP_MEMBERS;
+        return true;
+    }
+
+    bool ApplyRenameGroup(const json &op, ConfigEdit &edit, ConfigPatchResult &result)
+    {
+        std::string group;
+        std::string displayName;
+        if (!GetString(op, "group", group, result) || !GetString(op, "name", displayName, result))
+        {
+            return false;
+        }
+        if (!FindGroup(edit.Config(), group))
+        {
+            return Fail(result, "Unknown group '" + group + "'", true);
+        }
+
+        auto names = edit.Config().find("group_names");
+        if (names != edit.Config().end() && names->is_object() && names->value(group, std::string()) == displayName)
+        {
+            return true;
+        }
+
+        json &config = edit.MutableConfig();
+        if (!config.contains("group_names") || !config["group_names"].is_object())
+        {
+            config["group_names"] = json::object();
+        }
+        config["group_names"][group] = displayName;
+        result.touched |= CONFIG_AREA_GROUP_NAMES;
+        return true;
+    }
+
+    bool ApplyBindButton(const json &op, ConfigEdit &edit, ConfigPatchResult &result)
+    {
+        std::string button;
+        if (!GetString(op, "button", button, result))
+        {
+            return false;
+        }
+        auto action = op.find("action");
+        if (action == op.end() || !(action->is_string() || action->is_null()))
+        {
+            return Fail(result, "'bindButton' needs an 'action' (a string, or null to unbind)");
+        }
+        const bool unbind = action->is_null() || action->get_ref<const std::string &>().empty();
+
+        // Top-level bindings, or those of one profile
+        Pointer path = {"buttonBindings"};
+        if (op.contains("profile"))
+        {
+            std::string profile;
+            if (!GetString(op, "profile", profile, result))
+            {
+                return false;
+            }
+            const json *source = Find(edit.Config(), Pointer{"profiles", profile}, 2);
+            if (!source || !source->is_object())
+            {
+                return Fail(result, "Unknown profile '" + profile + "'", true);
+            }
+            path = {"profiles", profile, "buttonBindings"};
+        }
+
+        const json *bindings = Find(edit.Config(), path, path.size());
+        if (bindings && !bindings->is_object())
+        {
+            return Fail(result, "Button bindings must be an object");
+        }
+        const bool bound = bindings && bindings->contains(button);
+        if (unbind ? !bound : bound && (*bindings)[button] == *action)
+        {
+            return true;
+        }
+
+        json *target = Find(edit.MutableConfig(), path, path.size() - 1);
+        json &mutableBindings = (*target)[path.back()];
+        if (unbind)
+        {
+            mutableBindings.erase(button);
+        }
+        else
+        {
+            mutableBindings[button] = *action;
+        }
+        result.touched |= CONFIG_AREA_PROFILES;
+        return true;
+    }
+
+    bool ApplyOp(const json &op, ConfigEdit &edit, ConfigPatchResult &result)
+    {
+        if (!op.is_object() || !op.contains("op") || !op["op"].is_string())
+        {
+            return Fail(result, "Every operation needs an 'op'");
+        }
+        const std::string name = op["op"].get<std::string>();
+
+        if (name == "add" || name == "remove" || name == "replace" || name == "move" || name == "copy" || name == "test")
+        {
+            return ApplyJsonPatchOp(name, op, edit, result);
+        }
+        if (name == "addApp" || name == "removeApp" || name == "moveApp")
+        {
+            return ApplyAppOp(name, op, edit, result);
+        }
+        if (name == "renameGroup")
+        {
+            return ApplyRenameGroup(op, edit, result);
+        }
+        if (name == "bindButton")
+        {
+            return ApplyBindButton(op, edit, result);
+        }
+        return Fail(result, "Unknown op '" + name + "'");
+    }
+}
+
+ConfigPatchResult ApplyConfigPatch(const json &patch, ConfigEdit &edit)
+{
+    ConfigPatchResult result;
+    if (!patch.is_array() && !patch.is_object())
+    {
+        Fail(result, "A patch is an operation or an array of operations");
+        return result;
+    }
+
+    const json single = patch.is_object() ? json::array({patch}) : json();
+    for (const auto &op : patch.is_object() ? single : patch)
+    {
+        if (!ApplyOp(op, edit, result))
+        {
+            return result;
+        }
+    }
+    result.ok = true;
+    return result;
+}
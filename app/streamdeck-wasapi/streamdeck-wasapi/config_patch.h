@@ -0,0 +1,67 @@
+#ifndef CONFIG_PATCH_H
+#define CONFIG_PATCH_H
+
+#include <cstdint>
+#include <string>
+#include "json.hpp"
+#include "config_store.h"
+
+// Incremental edits of config.json (PATCH /api/config).
+//
+// The body is one operation or an array of them, applied in order as one commit:
+//
+//   RFC 6902 JSON Patch:
+//     {"op": "add", "path": "/groups/Group 1/-", "value": "spotify.exe"}
+//     {"op": "remove" | "replace" | "move" | "copy" | "test", "path": ..., ...}
+//
+//   Shorthands for what the UI does most:
+//     {"op": "addApp",      "group": "Group 1", "app": "spotify.exe"}
+//     {"op": "removeApp",   "group": "Group 1", "app": "spotify.exe"}
+//     {"op": "moveApp",     "from": "Group 1", "to": "Group 2", "app": "spotify.exe"}
+//     {"op": "renameGroup", "group": "Group 1", "name": "Music"}
+//     {"op": "bindButton",  "button": "button0", "action": "Mute mic"}   (null or "" unbinds;
+//                                                                        optional "profile")
+//
+// Only the values an operation touches are validated, and the result says which
+// parts of the config changed so the caller recompiles just those: moving an app
+// rebuilds the group matcher but not the button tables, renaming a group rebuilds
+// nothing. Adding or removing a group keeps "group_names" in step for that key only.
+// If any operation fails the whole patch is abandoned.
+
+using json = nlohmann::json;
+
+// Parts of config.json an edit touched; each is compiled into something different
+enum ConfigArea : uint32_t
+{
+    CONFIG_AREA_NONE = 0,
+    CONFIG_AREA_GROUP_MEMBERS = 1 << 0, // Apps inside existing groups -> AppMatcher
+    CONFIG_AREA_GROUP_LIST = 1 << 1,    // Groups added/removed -> AppMatcher and slider order
+    CONFIG_AREA_GROUP_NAMES = 1 << 2,   // Display names only; nothing is compiled from them
+    CONFIG_AREA_PROFILES = 1 << 3,      // buttonBindings, profiles, activeProfile, autoSwitch
+    CONFIG_AREA_OTHER = 1 << 4,         // UI state (settings, theme, ...)
+    CONFIG_AREA_METERS = 1 << 5,        // meters, ducking -> sampling rate, ducking rules
+};
+
+struct ConfigPatchResult
+{
+    bool ok = false;
+    bool conflict = false; // Well-formed but does not apply to the current config (HTTP 409)
+    std::string error;
+    uint32_t touched = CONFIG_AREA_NONE;
+
+    bool NeedsMatcher() const { return (touched & (CONFIG_AREA_GROUP_MEMBERS | CONFIG_AREA_GROUP_LIST)) != 0; }
+    bool NeedsProfiles() const { return (touched & (CONFIG_AREA_GROUP_LIST | CONFIG_AREA_PROFILES)) != 0; }
+    // Ducking rules may name groups by display name
+    bool NeedsMeters() const { return (touched & (CONFIG_AREA_METERS | CONFIG_AREA_GROUP_LIST | CONFIG_AREA_GROUP_NAMES)) != 0; }
+};
+
+/**
+ * @brief Applies a patch to the config of a commit. The config is copied only if an
+ * operation actually changes it.
+ * @param patch One operation object or an array of them.
+ * @param edit The commit; abandon it (return false from the change) unless the result is ok.
+ * @return What was touched, or why the patch was rejected.
+ */
+ConfigPatchResult ApplyConfigPatch(const json &patch, ConfigEdit &edit);
+
+#endif // CONFIG_PATCH_H
@@ -0,0 +1,99 @@
+#include "config_store.h"
+
+ConfigEdit::ConfigEdit(const ConfigSnapshot &base)
+    : m_base(base)
+{
+}
+
+json &ConfigEdit::MutableConfig()
+{
+    if (!m_config)
+    {
+        m_config = std::make_shared<json>(*m_base.config);
+    }
+    return *m_config;
+}
+
+json &ConfigEdit::MutableBinds()
+{
+    if (!m_binds)
+    {
+        m_binds = std::make_shared<json>(*m_base.binds);
+    }
+    return *m_binds;
+}
+
+ConfigStore::ConfigStore(WriteBehindDocument &configFile, WriteBehindDocument &bindsFile)
+    : m_configFile(configFile), m_bindsFile(bindsFile)
+{
+    auto empty = std::make_shared<ConfigSnapshot>();
+    empty->config = std::make_shared<const json>(json::object());
+    empty->binds = std::make_shared<const json>(json::array());
+    m_current = empty;
+}
+
+void ConfigStore::Load(json config, json binds)
+{
+    std::lock_guard<std::mutex> lock(m_commitMutex);
+
+    auto snapshot = std::make_shared<ConfigSnapshot>();
+    snapshot->generation = std::atomic_load(&m_current)->generation + 1;
+    snapshot->config = std::make_shared<const json>(config.is_object() ? std::move(config) : json::object());
+    snapshot->binds = std::make_shared<const json>(binds.is_array() ? std::move(binds) : json::array());
+
+    m_configFile.Reset(snapshot->config);
+    m_bindsFile.Reset(snapshot->binds);
+    std::atomic_store(&m_current, std::shared_ptr<const ConfigSnapshot>(snapshot));
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigStore::Current() const
+{
+    return std::atomic_load(&m_current);
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigStore::Commit(const Change &change)
+{
+    std::lock_guard<std::mutex> lock(m_commitMutex);
+
+    std::shared_ptr<const ConfigSnapshot> base = std::atomic_load(&m_current);
+    ConfigEdit edit(*base);
+    if (!change(edit) || (!edit.ConfigChanged() && !edit.BindsChanged()))
+    {
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<ConfigSnapshot>();
+    snapshot->generation = base->generation + 1;
+    snapshot->config = edit.ConfigChanged() ? std::shared_ptr<const json>(std::move(edit.m_config)) : base->config;
+    snapshot->binds = edit.BindsChanged() ? std::shared_ptr<const json>(std::move(edit.m_binds)) : base->binds;
+
+    // Both documents become visible together, then go to disk behind
+    std::atomic_store(&m_current, std::shared_ptr<const ConfigSnapshot>(snapshot));
+    if (snapshot->config != base->config)
+    {
+        m_configFile.Set(snapshot->config);
+    }
+    if (snapshot->binds != base->binds)
+    {
+        m_bindsFile.Set(snapshot->binds);
+    }
+    return snapshot;
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigStore::CommitIfCurrent(uint64_t generation, const Change &change)
+{
+    return Commit([generation, &change](ConfigEdit &edit)
+                  { return edit.BaseGeneration() == generation && change(edit); });
+}
+
+void ConfigStore::Start()
+{
+    m_configFile.Start();
+    m_bindsFile.Start();
+}
+
+void ConfigStore::Stop()
+{
+    m_configFile.Stop();
+    m_bindsFile.Stop();
+}
@@ -0,0 +1,120 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "json.hpp"
+#include "json_persistence.h"
+
+// Versioned settings: config.json and binds.json as one unit.
+//
+// Every commit produces an immutable snapshot of both documents with the next
+// generation number. Readers take the current snapshot with one atomic load and
+// see a config and binds that were committed together; a commit that changes both
+// files is never half visible. Anything derived from the settings (compiled button
+// actions, matchers, serialized responses) remembers the generation it was built
+// from and is stale exactly when that number differs. Untouched documents are
+// shared between snapshots, and only the changed files are scheduled for writing.
+
+using json = nlohmann::json;
+
+struct ConfigSnapshot
+{
+    uint64_t generation = 0;
+    std::shared_ptr<const json> config; // Never null; an object
+    std::shared_ptr<const json> binds;  // Never null; an array
+};
+
+/**
+ * @brief The documents of one commit. Reads see the snapshot the commit started
+ * from; the first Mutable*() call copies that document.
+ */
+class ConfigEdit
+{
+public:
+    explicit ConfigEdit(const ConfigSnapshot &base);
+
+    uint64_t BaseGeneration() const { return m_base.generation; }
+
+    const json &Config() const { return m_config ? *m_config : *m_base.config; }
+    const json &Binds() const { return m_binds ? *m_binds : *m_base.binds; }
+
+    json &MutableConfig();
+    json &MutableBinds();
+
+    void ReplaceConfig(json config) { m_config = std::make_shared<json>(std::move(config)); }
+    void ReplaceBinds(json binds) { m_binds = std::make_shared<json>(std::move(binds)); }
+
+    bool ConfigChanged() const { return m_config != nullptr; }
+    bool BindsChanged() const { return m_binds != nullptr; }
+
+private:
+    friend class ConfigStore;
+
+    const ConfigSnapshot &m_base;
+    std::shared_ptr<json> m_config;
+    std::shared_ptr<json> m_binds;
+};
+
+class ConfigStore
+{
+public:
+    using Change = std::function<bool(ConfigEdit &edit)>;
+
+    /**
+     * @param configFile Persists config.json; the store only calls Reset/Set/Start/Stop on it.
+     * @param bindsFile Persists binds.json.
+     */
+    ConfigStore(WriteBehindDocument &configFile, WriteBehindDocument &bindsFile);
+
+    ConfigStore(const ConfigStore &) = delete;
+    ConfigStore &operator=(const ConfigStore &) = delete;
+
+    /**
+     * @brief Installs the documents read from disk as the first generation (nothing is written).
+     */
+    void Load(json config, json binds);
+
+    /**
+     * @brief The current snapshot (never null). Lock-free.
+     */
+    std::shared_ptr<const ConfigSnapshot> Current() const;
+
+    uint64_t Generation() const { return Current()->generation; }
+
+    /**
+     * @brief Applies a change to both documents as one transaction. Commits are
+     * serialized; readers are never blocked.
+     * @param change Edits the documents; returns false to abandon the commit.
+     * @return The committed snapshot, or null if the change was abandoned or changed nothing.
+     */
+    std::shared_ptr<const ConfigSnapshot> Commit(const Change &change);
+
+    /**
+     * @brief Like Commit, but only if the current snapshot is still of generation, i.e.
+     * the change was derived from it and nobody committed since.
+     * @return Null (and change is not called) if the generation is stale.
+     */
+    std::shared_ptr<const ConfigSnapshot> CommitIfCurrent(uint64_t generation, const Change &change);
+
+    /**
+     * @brief Starts writing committed documents behind.
+     */
+    void Start();
+
+    /**
+     * @brief Stops the writers after flushing what is still pending.
+     */
+    void Stop();
+
+private:
+    WriteBehindDocument &m_configFile;
+    WriteBehindDocument &m_bindsFile;
+
+    std::mutex m_commitMutex;                  // One commit at a time
+    std::shared_ptr<const ConfigSnapshot> m_current; // Swapped with std::atomic_load/atomic_store
+};
+
+#endif // CONFIG_STORE_H
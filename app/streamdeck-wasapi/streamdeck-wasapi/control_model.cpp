@@ -0,0 +1,66 @@
+#include "control_model.h"
+
+std::vector<std::string> GetSliderGroupNames(const json &config_data)
+{
+    std::vector<std::string> groupNames;
+
+    auto groups = config_data.find("groups");
+    if (groups == config_data.end() || !groups->is_object())
+    {
+        return groupNames;
+    }
+
+    // Map sliders to groups in the order they appear in the config
+    for (auto &[name, group] : groups->items())
+    {
+        if (group.is_array())
+        {
+            groupNames.push_back(name);
+        }
+    }
+    return groupNames;
+}
+
+const json *FindGroupApps(const json &config_data, const std::string &group_name)
+{
+    auto groups = config_data.find("groups");
+    if (groups == config_data.end() || !groups->is_object())
+    {
+        return nullptr;
+    }
+
+    auto apps = groups->find(group_name);
+    if (apps == groups->end() || !apps->is_array())
+    {
+        return nullptr;
+    }
+    return &*apps;
+}
+
+json BuildControllerStateJson(const std::vector<int> &sliders, const std::vector<int> &buttons,
+                              bool connected, const std::string &port)
+{
+    json state_data = json::object();
+    json sliders_json = json::array();
+    json buttons_json = json::array();
+
+    for (size_t i = 0; i < sliders.size(); i++)
+    {
+        sliders_json.push_back({{"id", static_cast<int>(i) + 1},
+                                {"value", sliders[i]},
+                                {"label", "Slider " + std::to_string(i + 1)}});
+    }
+
+    for (size_t i = 0; i < buttons.size(); i++)
+    {
+        buttons_json.push_back({{"id", static_cast<int>(i) + 1},
+                                {"pressed", buttons[i] > 0},
+                                {"label", "Button " + std::to_string(i + 1)}});
+    }
+
+    state_data["sliders"] = sliders_json;
+    state_data["buttons"] = buttons_json;
+    state_data["connected"] = connected;
+    state_data["port"] = port;
+    return state_data;
+}
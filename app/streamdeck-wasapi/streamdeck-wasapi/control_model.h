@@ -0,0 +1,38 @@
+#ifndef CONTROL_MODEL_H
+#define CONTROL_MODEL_H
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Portable helpers shared by the control thread and the HTTP handlers:
+// slider -> group mapping from config.json and the controller state payload.
+
+using json = nlohmann::json;
+
+/**
+ * @brief Returns the groups sliders map to, in config order (slider 0 -> first group).
+ * Only groups whose value is an array of apps are mapped.
+ * @param config_data Parsed config.json object.
+ */
+std::vector<std::string> GetSliderGroupNames(const json &config_data);
+
+/**
+ * @brief Looks up the app list of a group.
+ * @param config_data Parsed config.json object.
+ * @param group_name Key of the group in the "groups" object.
+ * @return Pointer to the group's JSON array, or nullptr if missing or malformed.
+ */
+const json *FindGroupApps(const json &config_data, const std::string &group_name);
+
+/**
+ * @brief Builds the /api/get-controller-state response body.
+ * @param sliders Raw slider readings.
+ * @param buttons Button states (non-zero = pressed).
+ * @param connected Whether the serial connection is up.
+ * @param port Selected COM port name.
+ */
+json BuildControllerStateJson(const std::vector<int> &sliders, const std::vector<int> &buttons,
+                              bool connected, const std::string &port);
+
+#endif // CONTROL_MODEL_H
@@ -0,0 +1,284 @@
+#include "ducking.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // A group key as given, or the key whose display name ("group_names") it is
+    std::string ResolveGroupKey(const json &config_data, const std::string &name)
+    {
+        const json &groups = config_data["groups"];
+        if (groups.contains(name))
+        {
+            return name;
+        }
+        if (config_data.contains("group_names") && config_data["group_names"].is_object())
+        {
+            for (auto &[key, display] : config_data["group_names"].items())
+            {
+                if (display.is_string() && display.get<std::string>() == name && groups.contains(key))
+                {
+                    return key;
+                }
+            }
+        }
+        return std::string();
+    }
+
+    // Reads an optional number within [min, max]; false if present but invalid
+    bool ReadNumber(const json &rule, const char *name, double min, double max, double &value)
+    {
+        if (!rule.contains(name))
+        {
+            return true;
+        }
+        if (!rule[name].is_number() || rule[name].get<double>() < min || rule[name].get<double>() > max)
+        {
+            return false;
+        }
+        value = rule[name].get<double>();
+        return true;
+    }
+
+    float DbToGain(float db)
+    {
+        return db >= 0.0f ? 1.0f : std::pow(10.0f, db / 20.0f);
+    }
+}
+
+std::shared_ptr<const DuckingRules> CompileDuckingRules(const json &config_data, std::vector<std::string> *problems)
+{
+    auto compiled = std::make_shared<DuckingRules>();
+    auto report = [problems](const std::string &message)
+    {
+        if (problems)
+        {
+            problems->push_back(message);
+        }
+    };
+
+    if (!config_data.is_object() || !config_data.contains("ducking") || !config_data["ducking"].is_array() ||
+        !config_data.contains("groups") || !config_data["groups"].is_object())
+    {
+        return compiled;
+    }
+
+    for (const auto &entry : config_data["ducking"])
+    {
+        if (!entry.is_object() || !entry.contains("trigger") || !entry["trigger"].is_string() ||
+            !entry.contains("target") || !entry["target"].is_string())
+        {
+            report("Ducking rule " + entry.dump() + " ignored: needs a \"trigger\" and a \"target\" group");
+            continue;
+        }
+
+        DuckRule rule;
+        rule.trigger = ResolveGroupKey(config_data, entry["trigger"].get<std::string>());
+        rule.target = ResolveGroupKey(config_data, entry["target"].get<std::string>());
+        if (rule.trigger.empty() || rule.target.empty())
+        {
+            report("Ducking rule " + entry.dump() + " ignored: unknown group");
+            continue;
+        }
+        if (rule.trigger == rule.target)
+        {
+            report("Ducking rule " + entry.dump() + " ignored: a group cannot duck itself");
+            continue;
+        }
+
+        double threshold = rule.thresholdDb;
+        double depth = rule.depthDb;
+        double attack = static_cast<double>(rule.attack.count());
+        double release = static_cast<double>(rule.release.count());
+        if (!ReadNumber(entry, "thresholdDb", -100, 0, threshold) || !ReadNumber(entry, "depthDb", 0, 96, depth) ||
+            !ReadNumber(entry, "attackMs", 0, 10000, attack) || !ReadNumber(entry, "releaseMs", 0, 60000, release))
+        {
+            report("Ducking rule " + entry.dump() + " ignored: thresholdDb -100..0, depthDb 0..96, attackMs 0..10000, releaseMs 0..60000");
+            continue;
+        }
+        rule.thresholdDb = static_cast<float>(threshold);
+        rule.depthDb = static_cast<float>(depth);
+        rule.attack = std::chrono::milliseconds(static_cast<int64_t>(attack));
+        rule.release = std::chrono::milliseconds(static_cast<int64_t>(release));
+        compiled->rules.push_back(rule);
+    }
+    return compiled;
+}
+
+DuckingEngine::DuckingEngine(Apply apply, float quantum)
+    : m_apply(std::move(apply)), m_quantum(quantum)
+{
+    m_fader.fill(-1.0f);
+}
+
+void DuckingEngine::SetRules(std::shared_ptr<const DuckingRules> rules, std::shared_ptr<const AppMatcher> matcher)
+{
+    if (rules == m_source && matcher == m_matcher)
+    {
+        return;
+    }
+
+    // Per-group state belongs to a group name; a new group list may have moved the indices
+    if (matcher != m_matcher && m_matcher && matcher)
+    {
+        Remap(*m_matcher, *matcher);
+    }
+
+    // Envelopes start over, so nothing stays turned down by a rule that may be gone
+    for (size_t group = 0; group < MAX_GROUPS; ++group)
+    {
+        if (m_targets.test(group) && m_duckDb[group] < 0.0f)
+        {
+            m_duckDb[group] = 0.0f;
+            Write(group);
+        }
+    }
+
+    m_source = std::move(rules);
+    m_matcher = std::move(matcher);
+    m_rules.clear();
+    m_targets.reset();
+    m_started = false;
+    if (!m_source || !m_matcher)
+    {
+        return;
+    }
+
+    for (const auto &rule : m_source->rules)
+    {
+        const int trigger = m_matcher->FindGroup(rule.trigger);
+        const int target = m_matcher->FindGroup(rule.target);
+        if (trigger < 0 || target < 0)
+        {
+            continue;
+        }
+
+        ActiveRule active;
+        active.trigger = static_cast<size_t>(trigger);
+        active.target = static_cast<size_t>(target);
+        active.threshold = std::pow(10.0f, rule.thresholdDb / 20.0f);
+        active.depthDb = rule.depthDb;
+        active.attackDbPerMs = rule.attack.count() > 0 ? rule.depthDb / static_cast<float>(rule.attack.count()) : 0.0f;
+        active.releaseDbPerMs = rule.release.count() > 0 ? rule.depthDb / static_cast<float>(rule.release.count()) : 0.0f;
+        m_rules.push_back(active);
+        m_targets.set(active.target);
+    }
+}
+
+void DuckingEngine::Remap(const AppMatcher &from, const AppMatcher &to)
+{
+    std::array<float, MAX_GROUPS> duckDb{};
+    std::array<float, MAX_GROUPS> fader;
+    std::array<float, MAX_GROUPS> written{};
+    GroupMask targets;
+    fader.fill(-1.0f);
+
+    const std::vector<std::string> &groups = from.Groups();
+    for (size_t group = 0; group < groups.size() && group < MAX_GROUPS; ++group)
+    {
+        const int moved = to.FindGroup(groups[group]);
+        if (moved < 0 || static_cast<size_t>(moved) >= MAX_GROUPS)
+        {
+            continue; // Group is gone, and with it its sessions
+        }
+        duckDb[moved] = m_duckDb[group];
+        fader[moved] = m_fader[group];
+        written[moved] = m_written[group];
+        targets.set(static_cast<size_t>(moved), m_targets.test(group));
+    }
+
+    m_duckDb = duckDb;
+    m_fader = fader;
+    m_written = written;
+    m_targets = targets;
+}
+
+float DuckingEngine::SetFader(size_t group, float level)
+{
+    if (group >= MAX_GROUPS)
+    {
+        return level;
+    }
+    m_fader[group] = level;
+    m_written[group] = level * Gain(group);
+    return m_written[group];
+}
+
+float DuckingEngine::Gain(size_t group) const
+{
+    return group < MAX_GROUPS ? DbToGain(m_duckDb[group]) : 1.0f;
+}
+
+void DuckingEngine::Process(const MeterFrame &frame, Clock::time_point now)
+{
+    if (m_rules.empty())
+    {
+        return;
+    }
+
+    // A long gap (sampling paused, clock jump) moves an envelope at most one second's worth
+    float elapsedMs = 0.0f;
+    if (m_started)
+    {
+        elapsedMs = std::chrono::duration<float, std::milli>(now - m_last).count();
+        elapsedMs = (std::max)(0.0f, (std::min)(1000.0f, elapsedMs));
+    }
+    m_last = now;
+    m_started = true;
+
+    for (auto &rule : m_rules)
+    {
+        const bool over = rule.trigger < frame.groupCount && frame.groups[rule.trigger] > rule.threshold;
+        const float goal = over ? -rule.depthDb : 0.0f;
+        if (rule.envelopeDb > goal)
+        {
+            rule.envelopeDb = rule.attackDbPerMs > 0.0f ? (std::max)(goal, rule.envelopeDb - rule.attackDbPerMs * elapsedMs) : goal;
+        }
+        else if (rule.envelopeDb < goal)
+        {
+            rule.envelopeDb = rule.releaseDbPerMs > 0.0f ? (std::min)(goal, rule.envelopeDb + rule.releaseDbPerMs * elapsedMs) : goal;
+        }
+    }
+
+    const std::array<float, MAX_GROUPS> previous = m_duckDb;
+    for (size_t group = 0; group < MAX_GROUPS; ++group)
+    {
+        if (m_targets.test(group))
+        {
+            m_duckDb[group] = 0.0f;
+        }
+    }
+    for (const auto &rule : m_rules)
+    {
+        m_duckDb[rule.target] = (std::min)(m_duckDb[rule.target], rule.envelopeDb);
+    }
+
+    for (size_t group = 0; group < MAX_GROUPS; ++group)
+    {
+        if (!m_targets.test(group) || m_fader[group] < 0.0f)
+        {
+            continue;
+        }
+        // While the envelope moves, only steps of a quantum; once it settles, the exact level
+        const float change = std::fabs(m_fader[group] * Gain(group) - m_written[group]);
+        const bool settled = m_duckDb[group] == previous[group];
+        if (change > m_quantum || (settled && change > 0.0f))
+        {
+            Write(group);
+        }
+    }
+}
+
+void DuckingEngine::Write(size_t group)
+{
+    if (m_fader[group] < 0.0f)
+    {
+        return;
+    }
+    m_written[group] = m_fader[group] * Gain(group);
+    if (m_apply)
+    {
+        m_apply(group, m_written[group]);
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef DUCKING_H
+#define DUCKING_H
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "app_matcher.h"
+#include "peak_meters.h"
+
+// Automatic ducking: one group is turned down while another one is loud.
+//
+// Rules come from config.json:
+//
+//   "ducking": [
+//     {"trigger": "Chat", "target": "Games", "thresholdDb": -40, "depthDb": 12,
+//      "attackMs": 50, "releaseMs": 600}
+//   ]
+//
+// "When any Chat session peaks above -40 dBFS, attenuate Games by 12 dB." Groups are
+// named by key ("Group 3") or display name. Each rule has an envelope that falls by
+// depthDb over attackMs while the trigger group is over the threshold and recovers
+// over releaseMs once it is not; a group targeted by several rules follows the
+// deepest one. The engine runs on every meter frame (on the audio worker) and writes
+// fader x duck gain to a group only when that output moved by more than a quantum,
+// or settled. Fader moves go through SetFader, so the two always compose. Time is
+// an argument, so the envelopes can be driven by a simulated clock and fake meters.
+
+using json = nlohmann::json;
+
+struct DuckRule
+{
+    std::string trigger; // Group key
+    std::string target;  // Group key
+    float thresholdDb = -40.0f;
+    float depthDb = 12.0f;
+    std::chrono::milliseconds attack{50};
+    std::chrono::milliseconds release{600};
+};
+
+struct DuckingRules
+{
+    std::vector<DuckRule> rules;
+};
+
+/**
+ * @brief Compiles config.json "ducking". Rules naming an unknown group, a group by
+ * itself, or values out of range are left out.
+ * @param problems Optional; receives one message per rule that was left out.
+ * @return Never null; empty if there is no "ducking" array.
+ */
+std::shared_ptr<const DuckingRules> CompileDuckingRules(const json &config_data, std::vector<std::string> *problems = nullptr);
+
+class DuckingEngine
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Apply = std::function<void(size_t group, float volume)>; // Writes one group's volume
+
+    /**
+     * @param apply Called with fader x duck gain of a group whose output changed.
+     * @param quantum Smallest volume change worth a write while an envelope moves.
+     */
+    explicit DuckingEngine(Apply apply, float quantum = 0.01f);
+
+    /**
+     * @brief Uses new rules, with group names resolved against matcher. Same rules
+     * and matcher as before keep the envelopes; otherwise they start over, and groups
+     * that are no longer targets get their fader level back. With a new matcher the
+     * per-group state follows each group by name to its new index; groups that are
+     * gone are forgotten.
+     */
+    void SetRules(std::shared_ptr<const DuckingRules> rules, std::shared_ptr<const AppMatcher> matcher);
+
+    /**
+     * @brief True if there is a rule to run, i.e. the engine needs meter frames.
+     */
+    bool Active() const { return !m_rules.empty(); }
+
+    /**
+     * @brief Records a group's fader level.
+     * @return The level to write: the fader times the group's current duck gain.
+     */
+    float SetFader(size_t group, float level);
+
+    /**
+     * @brief The group's current duck gain (1 when it is not ducked).
+     */
+    float Gain(size_t group) const;
+
+    /**
+     * @brief Advances the envelopes to now with the levels of a frame and writes the
+     * groups whose output changed. Groups whose fader was never set are not written.
+     */
+    void Process(const MeterFrame &frame, Clock::time_point now);
+
+private:
+    struct ActiveRule
+    {
+        size_t trigger;
+        size_t target;
+        float threshold; // Linear peak
+        float depthDb;
+        float attackDbPerMs;  // 0 = instant
+        float releaseDbPerMs; // 0 = instant
+        float envelopeDb = 0.0f; // 0 .. -depthDb
+    };
+
+    void Write(size_t group);
+    void Remap(const AppMatcher &from, const AppMatcher &to); // Moves per-group state to the indices of "to"
+
+    Apply m_apply;
+    const float m_quantum;
+
+    std::shared_ptr<const DuckingRules> m_source;
+    std::shared_ptr<const AppMatcher> m_matcher;
+    std::vector<ActiveRule> m_rules;
+    GroupMask m_targets;
+
+    // Indexed like m_matcher->Groups()
+    std::array<float, MAX_GROUPS> m_duckDb{};  // Deepest envelope per group, <= 0
+    std::array<float, MAX_GROUPS> m_fader{};   // Last fader level, < 0 if unknown
+    std::array<float, MAX_GROUPS> m_written{}; // Last volume written
+    Clock::time_point m_last;
+    bool m_started = false;
+};
+
+#endif // DUCKING_H
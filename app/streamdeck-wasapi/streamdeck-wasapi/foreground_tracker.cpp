@@ -0,0 +1,172 @@
+#include "foreground_tracker.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <iostream>
+
+namespace
+{
+    // WinEvent callbacks carry no context; only the hook thread touches these
+    IForegroundSource::Callback g_hook_callback;
+    DWORD g_hook_last_pid = 0;
+
+    void ReportWindow(HWND window)
+    {
+        DWORD pid = 0;
+        if (!window || !GetWindowThreadProcessId(window, &pid) || pid == 0 || pid == g_hook_last_pid)
+        {
+            return; // Focus moved between windows of the same process
+        }
+        g_hook_last_pid = pid;
+
+        ForegroundApp app;
+        app.pid = pid;
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        if (process)
+        {
+            wchar_t path[MAX_PATH];
+            DWORD size = MAX_PATH;
+            if (QueryFullProcessImageNameW(process, 0, path, &size))
+            {
+                std::wstring fullPath(path, size);
+                const size_t slash = fullPath.find_last_of(L"\\/");
+                app.exeNameW = slash == std::wstring::npos ? fullPath : fullPath.substr(slash + 1);
+                app.exeName = WideToUtf8(app.exeNameW);
+            }
+            CloseHandle(process);
+        }
+
+        if (g_hook_callback)
+        {
+            g_hook_callback(app);
+        }
+    }
+
+    void CALLBACK OnForegroundEvent(HWINEVENTHOOK /*hook*/, DWORD event, HWND window, LONG objectId,
+                                    LONG /*childId*/, DWORD /*thread*/, DWORD /*time*/)
+    {
+        if (event == EVENT_SYSTEM_FOREGROUND && objectId == OBJID_WINDOW)
+        {
+            ReportWindow(window);
+        }
+    }
+}
+
+WinEventForegroundSource::~WinEventForegroundSource()
+{
+    Stop();
+}
+
+bool WinEventForegroundSource::Start(Callback callback)
+{
+    if (m_thread.joinable())
+    {
+        return true;
+    }
+
+    m_callback = std::move(callback);
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    m_thread = std::thread([this, &started]()
+                           { Run(started); });
+
+    if (!result.get())
+    {
+        m_thread.join();
+        return false;
+    }
+    return true;
+}
+
+void WinEventForegroundSource::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    PostThreadMessageW(m_threadId, WM_QUIT, 0, 0);
+    m_thread.join();
+    m_threadId = 0;
+}
+
+void WinEventForegroundSource::Run(std::promise<bool> &started)
+{
+    // Create the message queue before anyone can post WM_QUIT to it
+    MSG msg;
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    m_threadId = GetCurrentThreadId();
+
+    g_hook_callback = m_callback;
+    g_hook_last_pid = 0;
+
+    // Out-of-context hook: events are delivered to this thread's message loop.
+    // Our own windows (tray, console) are skipped so they never count as the focused app.
+    HWINEVENTHOOK hook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, OnForegroundEvent,
+                                         0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    if (!hook)
+    {
+        std::cerr << "SetWinEventHook(EVENT_SYSTEM_FOREGROUND) failed: " << GetLastError() << std::endl;
+        g_hook_callback = nullptr;
+        started.set_value(false);
+        return;
+    }
+    started.set_value(true);
+
+    ReportWindow(GetForegroundWindow()); // Initial state; later changes arrive as events
+
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0)
+    {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+
+    UnhookWinEvent(hook);
+    g_hook_callback = nullptr;
+}
+#endif
+
+ForegroundTracker::ForegroundTracker(IForegroundSource &source)
+    : m_source(source), m_current(std::make_shared<ForegroundApp>())
+{
+}
+
+ForegroundTracker::~ForegroundTracker()
+{
+    Stop();
+}
+
+bool ForegroundTracker::Start(Listener listener)
+{
+    m_listener = std::move(listener);
+    return m_source.Start([this](const ForegroundApp &app)
+                          { OnForeground(app); });
+}
+
+void ForegroundTracker::Stop()
+{
+    m_source.Stop();
+}
+
+std::shared_ptr<const ForegroundApp> ForegroundTracker::Current() const
+{
+    return std::atomic_load(&m_current);
+}
+
+void ForegroundTracker::OnForeground(const ForegroundApp &app)
+{
+    std::shared_ptr<const ForegroundApp> previous = std::atomic_load(&m_current);
+    if (previous->pid == app.pid && previous->exeName == app.exeName)
+    {
+        return;
+    }
+
+    auto current = std::make_shared<ForegroundApp>(app);
+    current->exeId = AppNames().Intern(app.exeName);
+    std::atomic_store(&m_current, std::shared_ptr<const ForegroundApp>(current));
+    m_changes.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_listener)
+    {
+        m_listener(*current);
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef FOREGROUND_TRACKER_H
+#define FOREGROUND_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "name_table.h"
+
+// Foreground application tracking.
+//
+// A source reports foreground changes as they happen (a WinEvent hook on Windows,
+// a fake driven by hand elsewhere); the tracker caches the current application so
+// the control path reads it with one atomic load instead of asking the OS per frame.
+
+struct ForegroundApp
+{
+    uint32_t pid = 0;
+    std::string exeName;   // Executable file name, UTF-8 ("" if unknown)
+    std::wstring exeNameW; // Same name for WASAPI session lookups
+    NameId exeId = NO_NAME; // Interned by the tracker, once per change
+};
+
+class IForegroundSource
+{
+public:
+    using Callback = std::function<void(const ForegroundApp &)>;
+
+    virtual ~IForegroundSource() = default;
+
+    /**
+     * @brief Starts reporting foreground changes, beginning with the current foreground app.
+     * The callback may run on a thread owned by the source.
+     * @return False if the source could not be started.
+     */
+    virtual bool Start(Callback callback) = 0;
+
+    virtual void Stop() = 0;
+};
+
+/**
+ * @brief Fake source: foreground changes are injected with Activate().
+ */
+class FakeForegroundSource : public IForegroundSource
+{
+public:
+    bool Start(Callback callback) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callback = std::move(callback);
+        return true;
+    }
+
+    void Stop() override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_callback = nullptr;
+    }
+
+    void Activate(uint32_t pid, const std::string &exeName)
+    {
+        ForegroundApp app;
+        app.pid = pid;
+        app.exeName = exeName;
+        app.exeNameW.assign(exeName.begin(), exeName.end()); // Fake names are ASCII
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_callback)
+        {
+            m_callback(app);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    Callback m_callback;
+};
+
+#ifdef _WIN32
+/**
+ * @brief Reports EVENT_SYSTEM_FOREGROUND from a hook thread with its own message loop.
+ * The executable is resolved once per change, never per frame.
+ */
+class WinEventForegroundSource : public IForegroundSource
+{
+public:
+    ~WinEventForegroundSource() override;
+
+    bool Start(Callback callback) override;
+    void Stop() override;
+
+private:
+    void Run(std::promise<bool> &started);
+
+    Callback m_callback;
+    std::thread m_thread;
+    std::atomic<unsigned long> m_threadId{0};
+};
+#endif
+
+class ForegroundTracker
+{
+public:
+    using Listener = std::function<void(const ForegroundApp &)>;
+
+    explicit ForegroundTracker(IForegroundSource &source);
+    ~ForegroundTracker();
+
+    ForegroundTracker(const ForegroundTracker &) = delete;
+    ForegroundTracker &operator=(const ForegroundTracker &) = delete;
+
+    /**
+     * @brief Starts the source. The listener is called on every change of foreground
+     * process, after the cached app has been updated.
+     */
+    bool Start(Listener listener);
+    void Stop();
+
+    /**
+     * @brief The cached foreground app (never null; pid 0 before the first report).
+     */
+    std::shared_ptr<const ForegroundApp> Current() const;
+
+    /**
+     * @brief Number of foreground process changes seen.
+     */
+    uint64_t Changes() const { return m_changes.load(std::memory_order_relaxed); }
+
+private:
+    void OnForeground(const ForegroundApp &app);
+
+    IForegroundSource &m_source;
+    Listener m_listener;
+    std::shared_ptr<const ForegroundApp> m_current; // Swapped with std::atomic_load/atomic_store
+    std::atomic<uint64_t> m_changes{0};
+};
+
+#endif // FOREGROUND_TRACKER_H
@@ -0,0 +1,254 @@
+#include "gesture_recognizer.h"
+
+GestureRecognizer::GestureRecognizer(Handler handler)
+    : m_handler(std::move(handler))
+{
+}
+
+void GestureRecognizer::Configure(const GestureBindings &bindings)
+{
+    m_bindings = bindings;
+
+    // A gesture in progress may no longer mean the same thing
+    for (int i = 0; i < EXPECTED_BUTTONS; ++i)
+    {
+        ButtonState &button = m_buttons[i];
+        button.state = (m_downMask & (1u << i)) ? State::Consumed : State::Idle;
+        button.deadline = Clock::time_point::max();
+        button.chordPending = false;
+    }
+}
+
+void GestureRecognizer::Reset()
+{
+    m_buttons = {};
+    m_downMask = 0;
+}
+
+void GestureRecognizer::Emit(GestureType type, int index)
+{
+    if (m_handler)
+    {
+        m_handler({type, static_cast<uint8_t>(index)});
+    }
+}
+
+bool GestureRecognizer::IsChordMember(int button) const
+{
+    for (size_t c = 0; c < m_bindings.chordCount; ++c)
+    {
+        if (m_bindings.chordMasks[c] & (1u << button))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reports a chord once all of its buttons are down and still inside their chord window
+bool GestureRecognizer::TryChord(Clock::time_point /*now*/)
+{
+    for (size_t c = 0; c < m_bindings.chordCount; ++c)
+    {
+        const uint32_t mask = m_bindings.chordMasks[c];
+        if ((m_downMask & mask) != mask)
+        {
+            continue;
+        }
+
+        bool allPending = true;
+        for (int i = 0; i < EXPECTED_BUTTONS && allPending; ++i)
+        {
+            if (mask & (1u << i))
+            {
+                allPending = m_buttons[i].state == State::Down && m_buttons[i].chordPending;
+            }
+        }
+        if (!allPending)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < EXPECTED_BUTTONS; ++i)
+        {
+            if (mask & (1u << i))
+            {
+                m_buttons[i].state = State::Consumed;
+                m_buttons[i].deadline = Clock::time_point::max();
+                m_buttons[i].chordPending = false;
+            }
+        }
+        Emit(GestureType::Chord, static_cast<int>(c));
+        return true;
+    }
+    return false;
+}
+
+// The press is not part of a chord: pick the fastest outcome the bindings allow
+void GestureRecognizer::Decide(int index)
+{
+    ButtonState &button = m_buttons[index];
+    const uint8_t mask = m_bindings.buttonMasks[index];
+    const uint8_t timed = GestureBit(GestureType::LongPress) | GestureBit(GestureType::HoldRepeat);
+
+    if (!(mask & (timed | GestureBit(GestureType::DoubleTap))))
+    {
+        // Only a tap can happen: report it on the press edge
+        Emit(GestureType::Tap, index);
+        button.state = State::Consumed;
+        button.deadline = Clock::time_point::max();
+        return;
+    }
+
+    button.state = State::Down;
+    button.deadline = (mask & timed) ? button.downAt + m_bindings.timing.longPress : Clock::time_point::max();
+}
+
+void GestureRecognizer::OnEdge(int index, bool pressed, Clock::time_point at)
+{
+    if (index < 0 || index >= EXPECTED_BUTTONS)
+    {
+        return;
+    }
+
+    ButtonState &button = m_buttons[index];
+    const uint32_t bit = 1u << index;
+
+    if (pressed)
+    {
+        if (m_downMask & bit)
+        {
+            return; // Duplicate press edge
+        }
+        m_downMask |= bit;
+
+        if (button.state == State::WaitSecond)
+        {
+            button.state = State::SecondDown;
+            button.deadline = Clock::time_point::max();
+            return;
+        }
+
+        button.downAt = at;
+        if (IsChordMember(index))
+        {
+            button.state = State::Down;
+            button.chordPending = true;
+            button.deadline = at + m_bindings.timing.chordWindow;
+            TryChord(at);
+            return;
+        }
+
+        Decide(index);
+        return;
+    }
+
+    if (!(m_downMask & bit))
+    {
+        return; // Duplicate release edge
+    }
+    m_downMask &= ~bit;
+
+    switch (button.state)
+    {
+    case State::Down:
+        button.chordPending = false;
+        if (m_bindings.buttonMasks[index] & GestureBit(GestureType::DoubleTap))
+        {
+            button.state = State::WaitSecond;
+            button.deadline = at + m_bindings.timing.doubleTapWindow;
+        }
+        else
+        {
+            Emit(GestureType::Tap, index);
+            button.state = State::Idle;
+            button.deadline = Clock::time_point::max();
+        }
+        break;
+    case State::SecondDown:
+        Emit(GestureType::DoubleTap, index);
+        button.state = State::Idle;
+        button.deadline = Clock::time_point::max();
+        break;
+    case State::Repeating:
+    case State::Consumed:
+        button.state = State::Idle;
+        button.deadline = Clock::time_point::max();
+        break;
+    case State::Idle:
+    case State::WaitSecond:
+        break;
+    }
+}
+
+void GestureRecognizer::Expire(int index, Clock::time_point now)
+{
+    ButtonState &button = m_buttons[index];
+    const uint8_t mask = m_bindings.buttonMasks[index];
+
+    switch (button.state)
+    {
+    case State::Down:
+        if (button.chordPending)
+        {
+            // Chord window passed without the other buttons
+            button.chordPending = false;
+            Decide(index);
+        }
+        else if (mask & GestureBit(GestureType::HoldRepeat))
+        {
+            // Hold-to-repeat takes precedence over a plain long press
+            Emit(GestureType::HoldRepeat, index);
+            button.state = State::Repeating;
+            button.deadline += m_bindings.timing.repeatInterval;
+        }
+        else
+        {
+            Emit(GestureType::LongPress, index);
+            button.state = State::Consumed;
+            button.deadline = Clock::time_point::max();
+        }
+        break;
+    case State::Repeating:
+        Emit(GestureType::HoldRepeat, index);
+        button.deadline += m_bindings.timing.repeatInterval;
+        if (button.deadline <= now)
+        {
+            button.deadline = now + m_bindings.timing.repeatInterval; // Fell behind; skip missed repeats
+        }
+        break;
+    case State::WaitSecond:
+        // No second tap: it was a single tap after all
+        Emit(GestureType::Tap, index);
+        button.state = State::Idle;
+        button.deadline = Clock::time_point::max();
+        break;
+    default:
+        button.deadline = Clock::time_point::max();
+        break;
+    }
+}
+
+void GestureRecognizer::OnTimer(Clock::time_point now)
+{
+    for (int i = 0; i < EXPECTED_BUTTONS; ++i)
+    {
+        while (m_buttons[i].deadline <= now)
+        {
+            Expire(i, now);
+        }
+    }
+}
+
+GestureRecognizer::Clock::time_point GestureRecognizer::NextDeadline() const
+{
+    Clock::time_point next = Clock::time_point::max();
+    for (const ButtonState &button : m_buttons)
+    {
+        if (button.deadline < next)
+        {
+            next = button.deadline;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,124 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "serial_frame.h" // EXPECTED_BUTTONS
+
+// Per-button gesture recognition from timestamped press/release edges.
+//
+// The recognizer never polls: OnEdge() is called for every button transition and
+// OnTimer() whenever NextDeadline() passes, so a gesture is reported as soon as
+// its definition allows (a plain tap on the press edge, a double-tap on the
+// second release, a long press exactly at its threshold).
+
+enum class GestureType : uint8_t
+{
+    Tap = 0,    // Press (or press + release when other gestures need to be told apart)
+    DoubleTap,  // Two taps within the double-tap window
+    LongPress,  // Held past the long-press threshold
+    HoldRepeat, // Held past the threshold, then repeated every repeat interval
+    Chord,      // All buttons of a chord pressed within the chord window
+};
+
+constexpr int BUTTON_GESTURE_COUNT = 4; // Gestures a single button can bind (all but Chord)
+constexpr size_t MAX_CHORDS = 8;
+
+constexpr uint8_t GestureBit(GestureType type)
+{
+    return static_cast<uint8_t>(1u << static_cast<int>(type));
+}
+
+struct GestureTiming
+{
+    std::chrono::milliseconds doubleTapWindow{250};
+    std::chrono::milliseconds longPress{500};
+    std::chrono::milliseconds repeatInterval{100};
+    std::chrono::milliseconds chordWindow{60};
+};
+
+// Which gestures are bound; unbound gestures cost no latency
+struct GestureBindings
+{
+    std::array<uint8_t, EXPECTED_BUTTONS> buttonMasks{}; // GestureBit() flags per button
+    std::array<uint32_t, MAX_CHORDS> chordMasks{};       // Button bit masks (2+ buttons each)
+    size_t chordCount = 0;
+    GestureTiming timing;
+};
+
+struct GestureEvent
+{
+    GestureType type = GestureType::Tap;
+    uint8_t index = 0; // Button index, or chord index into GestureBindings::chordMasks
+};
+
+class GestureRecognizer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Handler = std::function<void(const GestureEvent &event)>;
+
+    explicit GestureRecognizer(Handler handler);
+
+    /**
+     * @brief Replaces the bindings. Buttons that are down stay consumed until released.
+     */
+    void Configure(const GestureBindings &bindings);
+
+    /**
+     * @brief Forgets all button state (e.g. after the controller reconnects).
+     */
+    void Reset();
+
+    /**
+     * @brief Feeds one button transition.
+     * @param button Button index (0 - EXPECTED_BUTTONS-1).
+     * @param pressed True for the press edge, false for the release edge.
+     * @param at When the edge was received.
+     */
+    void OnEdge(int button, bool pressed, Clock::time_point at);
+
+    /**
+     * @brief Fires every timed gesture due at or before now.
+     */
+    void OnTimer(Clock::time_point now);
+
+    /**
+     * @brief Earliest pending deadline, or Clock::time_point::max() if no timer is needed.
+     */
+    Clock::time_point NextDeadline() const;
+
+private:
+    enum class State : uint8_t
+    {
+        Idle,
+        Down,       // Pressed, outcome not decided yet
+        WaitSecond, // Released after a short press, waiting for a second tap
+        SecondDown, // Second press of a double tap
+        Repeating,  // Hold-to-repeat active
+        Consumed,   // Gesture already reported; ignore until release
+    };
+
+    struct ButtonState
+    {
+        State state = State::Idle;
+        Clock::time_point downAt;
+        Clock::time_point deadline = Clock::time_point::max();
+        bool chordPending = false; // Waiting out the chord window before deciding
+    };
+
+    void Emit(GestureType type, int index);
+    bool TryChord(Clock::time_point now);
+    void Decide(int button);
+    void Expire(int button, Clock::time_point now);
+    bool IsChordMember(int button) const;
+
+    Handler m_handler;
+    GestureBindings m_bindings;
+    std::array<ButtonState, EXPECTED_BUTTONS> m_buttons;
+    uint32_t m_downMask = 0;
+};
+
+#endif // GESTURE_RECOGNIZER_H
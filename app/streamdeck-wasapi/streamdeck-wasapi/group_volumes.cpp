@@ -0,0 +1,53 @@
+#include "group_volumes.h"
+
+void GroupVolumes::Rebuild(const std::vector<std::string> &group_names)
+{
+    std::vector<Group> groups(group_names.size());
+    for (size_t i = 0; i < group_names.size(); ++i)
+    {
+        groups[i].name = group_names[i];
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &group : groups)
+    {
+        for (const auto &previous : m_groups)
+        {
+            if (previous.name == group.name)
+            {
+                group.target = previous.target;
+                group.hasTarget = previous.hasTarget;
+                break;
+            }
+        }
+    }
+    m_groups = std::move(groups);
+}
+
+void GroupVolumes::SetTarget(const std::string &group_name, float volume)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &group : m_groups)
+    {
+        if (group.name == group_name)
+        {
+            group.target = volume;
+            group.hasTarget = true;
+            return;
+        }
+    }
+}
+
+bool GroupVolumes::Target(const std::string &group_name, float &volume) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &group : m_groups)
+    {
+        if (group.name == group_name)
+        {
+            volume = group.target;
+            return group.hasTarget;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,43 @@
+#ifndef GROUP_VOLUMES_H
+#define GROUP_VOLUMES_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The volume each group's fader last asked for. Lets the session tracker give a newly
+// created audio session its group's level right away (group membership itself comes
+// from the compiled rules in app_matcher.h).
+
+class GroupVolumes
+{
+public:
+    /**
+     * @brief Sets the known groups. Targets of groups that still exist are kept.
+     */
+    void Rebuild(const std::vector<std::string> &group_names);
+
+    /**
+     * @brief Records the volume last applied to a group.
+     */
+    void SetTarget(const std::string &group_name, float volume);
+
+    /**
+     * @brief The volume last applied to a group.
+     * @return False if the group is unknown or its fader has not moved yet.
+     */
+    bool Target(const std::string &group_name, float &volume) const;
+
+private:
+    struct Group
+    {
+        std::string name;
+        float target = 0.0f;
+        bool hasTarget = false;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Group> m_groups;
+};
+
+#endif // GROUP_VOLUMES_H
@@ -0,0 +1,61 @@
+#include "hotkey_combo.h"
+
+bool ParseHotkeyCombo(std::string_view combo, HotkeyCombo &out)
+{
+    HotkeyCombo result;
+    size_t position = 0;
+
+    while (position < combo.size())
+    {
+        // Search from the second character so a '+' at the start of a part is the key itself ("Ctrl++")
+        size_t end = combo.find('+', position + 1);
+        if (end == std::string_view::npos)
+        {
+            end = combo.size();
+        }
+
+        const KeyInfo *key = LookupKey(combo.substr(position, end - position));
+        if (!key)
+        {
+            return false;
+        }
+
+        if (end == combo.size())
+        {
+            // The last part is the main key
+            result.keyCode = key->vk;
+            result.keyFlags = key->flags;
+            out = result;
+            return true;
+        }
+
+        if (key->modifier == 0)
+        {
+            return false; // Only modifiers may precede the main key
+        }
+        result.modifiers |= key->modifier;
+        position = end + 1;
+    }
+
+    return false; // Empty combo or trailing '+'
+}
+
+KeyChord BuildKeyChord(const HotkeyCombo &combo)
+{
+    KeyChord chord;
+    if (!combo.IsMedia())
+    {
+        // "Ctrl+!" is Ctrl+Shift+1; Shift is pressed once even if the combo names it too
+        const int modifiers = combo.modifiers | ((combo.keyFlags & KEY_FLAG_SHIFTED) ? HOTKEY_MOD_SHIFT : 0);
+        for (int bit = 1; bit <= HOTKEY_MOD_RWIN; bit <<= 1)
+        {
+            const KeyInfo *modifier = (modifiers & bit) ? ModifierKey(static_cast<uint8_t>(bit)) : nullptr;
+            if (modifier)
+            {
+                chord.Add(modifier->vk, (modifier->flags & KEY_FLAG_EXTENDED) != 0);
+            }
+        }
+    }
+    chord.Add(combo.keyCode, (combo.keyFlags & KEY_FLAG_EXTENDED) != 0);
+    return chord;
+}
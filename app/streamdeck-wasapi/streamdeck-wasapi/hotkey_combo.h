@@ -0,0 +1,41 @@
+#ifndef HOTKEY_COMBO_H
+#define HOTKEY_COMBO_H
+
+#include <cstdint>
+#include <string_view>
+#include "key_table.h"
+#include "input_injector.h"
+
+// Modifier bit flags of HotkeyCombo::modifiers (the KEY_MOD_* flags of the key table)
+constexpr int HOTKEY_MOD_CTRL = KEY_MOD_CTRL;
+constexpr int HOTKEY_MOD_SHIFT = KEY_MOD_SHIFT;
+constexpr int HOTKEY_MOD_ALT = KEY_MOD_ALT;
+constexpr int HOTKEY_MOD_WIN = KEY_MOD_WIN;
+constexpr int HOTKEY_MOD_RWIN = KEY_MOD_RWIN;
+
+// A combo from binds.json compiled down to what the injector needs
+struct HotkeyCombo
+{
+    uint8_t modifiers = 0; // HOTKEY_MOD_* flags
+    uint8_t keyFlags = 0;  // KEY_FLAG_* of the main key
+    uint16_t keyCode = 0;  // Virtual key code of the main key
+
+    bool IsMedia() const { return (keyFlags & KEY_FLAG_MEDIA) != 0; }
+};
+
+/**
+ * @brief Parses a combo string from binds.json (e.g. "Ctrl+Alt+S", "Meta+Shift+F13", "Ctrl++").
+ * Every part but the last must be a modifier; the last part is the main key.
+ * @param combo The combo string.
+ * @param out Receives the compiled combo; left untouched on failure.
+ * @return False if a part is not a known key name or a non-modifier precedes the main key.
+ */
+bool ParseHotkeyCombo(std::string_view combo, HotkeyCombo &out);
+
+/**
+ * @brief Expands a compiled combo into the chord the input executor sends.
+ * Media keys are sent on their own, without modifiers; a shifted symbol adds Shift.
+ */
+KeyChord BuildKeyChord(const HotkeyCombo &combo);
+
+#endif // HOTKEY_COMBO_H
@@ -0,0 +1,210 @@
+#include "input_executor.h"
+
+#include <iostream>
+
+InputExecutor::InputExecutor(IInputInjector &injector, std::chrono::milliseconds holdTime)
+    : m_injector(injector), m_holdTime(holdTime)
+{
+}
+
+InputExecutor::~InputExecutor()
+{
+    Stop();
+}
+
+void InputExecutor::Start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+    m_thread = std::thread(&InputExecutor::Run, this);
+}
+
+void InputExecutor::Stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeRequested = true;
+    }
+    m_wake.notify_one();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+bool InputExecutor::Submit(const KeyChord &chord)
+{
+    if (chord.count == 0 || !m_pending.TryPush(chord))
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeRequested = true;
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void InputExecutor::AppendPress(const KeyChord &chord, KeyInput *batch, unsigned int &count)
+{
+    // A key already down from another chord is pressed again (for the main key that is a
+    // second keystroke), but counted, so the first chord's release does not lift it
+    for (int i = 0; i < chord.count; ++i)
+    {
+        const uint16_t key = chord.keys[i];
+        if (key < m_downCount.size())
+        {
+            ++m_downCount[key];
+        }
+        batch[count++] = {key, false, ((chord.extendedMask >> i) & 1) != 0};
+    }
+}
+
+void InputExecutor::AppendRelease(const KeyChord &chord, KeyInput *batch, unsigned int &count)
+{
+    // Release in reverse order: main key first, modifiers last
+    for (int i = chord.count - 1; i >= 0; --i)
+    {
+        const uint16_t key = chord.keys[i];
+        if (key < m_downCount.size() && m_downCount[key] > 0 && --m_downCount[key] > 0)
+        {
+            continue; // Still held by another chord
+        }
+        batch[count++] = {key, true, ((chord.extendedMask >> i) & 1) != 0};
+    }
+}
+
+InputExecutor::Clock::time_point InputExecutor::ProcessDue(Clock::time_point now)
+{
+    // A full batch may have left chords queued, and the wake that announced them is
+    // already consumed: keep going until the queue runs dry
+    while (InjectBatch(now) == MAX_HELD)
+    {
+    }
+
+    Clock::time_point next = Clock::time_point::max();
+    for (size_t i = 0; i < m_heldCount; ++i)
+    {
+        if (m_held[i].releaseAt < next)
+        {
+            next = m_held[i].releaseAt;
+        }
+    }
+    return next;
+}
+
+size_t InputExecutor::InjectBatch(Clock::time_point now)
+{
+    KeyInput batch[MAX_BATCH];
+    unsigned int count = 0;
+
+    KeyChord incoming[MAX_HELD];
+    size_t incomingCount = 0;
+    while (incomingCount < MAX_HELD && m_pending.TryPop(incoming[incomingCount]))
+    {
+        ++incomingCount;
+    }
+
+    // Key-ups first: chords whose hold time elapsed, or that are pressed again right now
+    size_t kept = 0;
+    for (size_t i = 0; i < m_heldCount; ++i)
+    {
+        bool release = m_held[i].releaseAt <= now;
+        for (size_t j = 0; j < incomingCount && !release; ++j)
+        {
+            release = incoming[j] == m_held[i].chord;
+        }
+
+        if (release)
+        {
+            AppendRelease(m_held[i].chord, batch, count);
+        }
+        else
+        {
+            m_held[kept++] = m_held[i];
+        }
+    }
+    m_heldCount = kept;
+
+    // Then key-downs for the new chords
+    for (size_t j = 0; j < incomingCount; ++j)
+    {
+        const KeyChord &chord = incoming[j];
+        if (m_heldCount == MAX_HELD)
+        {
+            // Out of slots: release the oldest chord early rather than dropping the press
+            AppendRelease(m_held[0].chord, batch, count);
+            for (size_t i = 1; i < m_heldCount; ++i)
+            {
+                m_held[i - 1] = m_held[i];
+            }
+            --m_heldCount;
+        }
+
+        AppendPress(chord, batch, count);
+
+        const auto hold = chord.holdMs > 0 ? std::chrono::milliseconds(chord.holdMs) : m_holdTime;
+        m_held[m_heldCount++] = {chord, now + hold};
+    }
+
+    if (count > 0)
+    {
+        const unsigned int sent = m_injector.Send(batch, count);
+        if (sent != count)
+        {
+            std::cerr << "InputExecutor: injected " << sent << " of " << count << " key events" << std::endl;
+        }
+    }
+    return incomingCount;
+}
+
+void InputExecutor::ReleaseAll()
+{
+    KeyInput batch[MAX_BATCH];
+    unsigned int count = 0;
+    for (size_t i = 0; i < m_heldCount; ++i)
+    {
+        AppendRelease(m_held[i].chord, batch, count);
+    }
+    m_heldCount = 0;
+
+    if (count > 0)
+    {
+        m_injector.Send(batch, count);
+    }
+}
+
+void InputExecutor::Run()
+{
+    while (m_running.load())
+    {
+        const Clock::time_point next = ProcessDue(Clock::now());
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        auto woken = [this]()
+        { return m_wakeRequested; };
+        if (next == Clock::time_point::max())
+        {
+            m_wake.wait(lock, woken);
+        }
+        else
+        {
+            m_wake.wait_until(lock, next, woken);
+        }
+        m_wakeRequested = false;
+    }
+
+    // Never leave keys stuck down
+    ProcessDue(Clock::now());
+    ReleaseAll();
+}
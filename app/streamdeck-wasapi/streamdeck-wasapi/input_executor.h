@@ -0,0 +1,100 @@
+#ifndef INPUT_EXECUTOR_H
+#define INPUT_EXECUTOR_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "bounded_queue.h"
+#include "input_injector.h"
+
+// Asynchronous key press executor.
+//
+// Callers (the control thread) only push a chord onto a preallocated queue.
+// The executor thread presses the keys, schedules the release on a timer instead
+// of sleeping, and merges every event due at the same moment into one Send call.
+// Chords may overlap (Ctrl+C still held when Ctrl+V comes): each key counts the held
+// chords using it and goes up only when the last of them is released.
+
+class InputExecutor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit InputExecutor(IInputInjector &injector,
+                           std::chrono::milliseconds holdTime = std::chrono::milliseconds(50));
+    ~InputExecutor();
+
+    InputExecutor(const InputExecutor &) = delete;
+    InputExecutor &operator=(const InputExecutor &) = delete;
+
+    void Start();
+
+    /**
+     * @brief Releases any held keys and joins the executor thread.
+     */
+    void Stop();
+
+    /**
+     * @brief Queues a chord press. Never allocates and never waits for the executor;
+     * waking it takes a lock held only for a flag write.
+     * @return False if the queue is full (the press is dropped).
+     */
+    bool Submit(const KeyChord &chord);
+
+    /**
+     * @brief One scheduling step: injects the key-ups that are due and the key-downs of
+     * every queued chord, in batches of up to 16 chords. Driven by the executor thread,
+     * or directly by tests with a simulated clock (without calling Start()).
+     * @return The next pending key-up deadline, or Clock::time_point::max() if none.
+     */
+    Clock::time_point ProcessDue(Clock::time_point now);
+
+    /**
+     * @brief Immediately releases every held chord.
+     */
+    void ReleaseAll();
+
+    size_t HeldCount() const { return m_heldCount; }
+
+private:
+    static constexpr size_t MAX_HELD = 16;
+    static constexpr size_t MAX_BATCH = MAX_HELD * MAX_CHORD_KEYS * 2;
+
+    struct HeldChord
+    {
+        KeyChord chord;
+        Clock::time_point releaseAt;
+    };
+
+    void Run();
+
+    /**
+     * @brief Pops up to MAX_HELD queued chords and injects them with the due key-ups.
+     * @return The number of chords popped.
+     */
+    size_t InjectBatch(Clock::time_point now);
+    void AppendPress(const KeyChord &chord, KeyInput *batch, unsigned int &count);
+    void AppendRelease(const KeyChord &chord, KeyInput *batch, unsigned int &count);
+
+    IInputInjector &m_injector;
+    std::chrono::milliseconds m_holdTime;
+
+    BoundedQueue<KeyChord, 64> m_pending;
+
+    // Owned by the executor thread (or the test driving ProcessDue)
+    std::array<HeldChord, MAX_HELD> m_held{};
+    size_t m_heldCount = 0;
+    std::array<uint8_t, 256> m_downCount{}; // Held chords pressing each virtual key
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_wakeRequested = false;
+};
+
+#endif // INPUT_EXECUTOR_H
@@ -0,0 +1,45 @@
+#include "input_injector.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <iostream>
+
+unsigned int SendInputInjector::Send(const KeyInput *inputs, unsigned int count)
+{
+    constexpr unsigned int MAX_BATCH = 64;
+    INPUT batch[MAX_BATCH] = {};
+    unsigned int sent = 0;
+
+    // One SendInput call per batch keeps the events atomic with respect to other input
+    while (sent < count)
+    {
+        const unsigned int chunk = (count - sent) < MAX_BATCH ? (count - sent) : MAX_BATCH;
+        for (unsigned int i = 0; i < chunk; ++i)
+        {
+            const KeyInput &input = inputs[sent + i];
+            batch[i] = {};
+            batch[i].type = INPUT_KEYBOARD;
+            if (input.unicode)
+            {
+                batch[i].ki.wScan = input.keyCode;
+                batch[i].ki.dwFlags = KEYEVENTF_UNICODE | (input.keyUp ? KEYEVENTF_KEYUP : 0);
+            }
+            else
+            {
+                batch[i].ki.wVk = input.keyCode;
+                batch[i].ki.dwFlags = (input.keyUp ? KEYEVENTF_KEYUP : 0) |
+                                      (input.extended ? KEYEVENTF_EXTENDEDKEY : 0);
+            }
+        }
+
+        const UINT result = SendInput(chunk, batch, sizeof(INPUT));
+        sent += result;
+        if (result != chunk)
+        {
+            std::cerr << "SendInput failed: " << GetLastError() << std::endl;
+            break;
+        }
+    }
+    return sent;
+}
+#endif
@@ -0,0 +1,98 @@
+#ifndef INPUT_INJECTOR_H
+#define INPUT_INJECTOR_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Keyboard input injection behind an interface, so the executor that schedules
+// key presses can run against SendInput on Windows and a recording fake elsewhere.
+
+struct KeyInput
+{
+    uint16_t keyCode = 0;  // Windows virtual-key code, or a UTF-16 code unit if unicode is set
+    bool keyUp = false;
+    bool extended = false; // Extended key (media / navigation keys)
+    bool unicode = false;  // Type keyCode as a character (KEYEVENTF_UNICODE), layout independent
+};
+
+constexpr int MAX_CHORD_KEYS = 6;
+
+// One key combination, pressed in order and released in reverse order
+struct KeyChord
+{
+    std::array<uint16_t, MAX_CHORD_KEYS> keys{}; // Modifiers first, main key last
+    uint8_t count = 0;
+    uint8_t extendedMask = 0; // Bit i set: keys[i] is an extended key (arrows, Win, media keys)
+    uint16_t holdMs = 0;      // Time between key-down and key-up, 0 = executor default
+
+    void Add(uint16_t keyCode, bool extended)
+    {
+        if (extended)
+        {
+            extendedMask |= static_cast<uint8_t>(1u << count);
+        }
+        keys[count++] = keyCode;
+    }
+
+    bool operator==(const KeyChord &other) const
+    {
+        return count == other.count && keys == other.keys;
+    }
+};
+
+class IInputInjector
+{
+public:
+    virtual ~IInputInjector() = default;
+
+    /**
+     * @brief Injects the given events in order, as one batch where the platform allows.
+     * @return Number of events actually injected.
+     */
+    virtual unsigned int Send(const KeyInput *inputs, unsigned int count) = 0;
+};
+
+/**
+ * @brief Fake injector that records every batch instead of touching the OS.
+ */
+class RecordingInputInjector : public IInputInjector
+{
+public:
+    unsigned int Send(const KeyInput *inputs, unsigned int count) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batches.emplace_back(inputs, inputs + count);
+        return count;
+    }
+
+    std::vector<std::vector<KeyInput>> Batches() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_batches;
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batches.clear();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::vector<KeyInput>> m_batches;
+};
+
+#ifdef _WIN32
+/**
+ * @brief Injects events with a single SendInput call per batch.
+ */
+class SendInputInjector : public IInputInjector
+{
+public:
+    unsigned int Send(const KeyInput *inputs, unsigned int count) override;
+};
+#endif
+
+#endif // INPUT_INJECTOR_H
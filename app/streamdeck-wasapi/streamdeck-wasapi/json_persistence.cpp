@@ -0,0 +1,259 @@
+#include "json_persistence.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // A failed write is retried after this long, unless a newer save comes first
+    const std::chrono::milliseconds RETRY_DELAY(1000);
+}
+
+#ifdef _WIN32
+bool AtomicFileWriter::WriteAtomically(const std::string &path, const std::string &contents)
+{
+    const std::string temp = path + ".tmp";
+    HANDLE file = CreateFileA(temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Error: Could not create " << temp << ", error: " << GetLastError() << std::endl;
+        return false;
+    }
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, contents.data(), static_cast<DWORD>(contents.size()), &written, NULL) &&
+              written == contents.size() && FlushFileBuffers(file);
+    if (!ok)
+    {
+        std::cerr << "Error: Could not write " << temp << ", error: " << GetLastError() << std::endl;
+    }
+    CloseHandle(file);
+
+    if (ok && !MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        std::cerr << "Error: Could not replace " << path << ", error: " << GetLastError() << std::endl;
+        ok = false;
+    }
+    if (!ok)
+    {
+        DeleteFileA(temp.c_str());
+    }
+    return ok;
+}
+#else
+bool AtomicFileWriter::WriteAtomically(const std::string &path, const std::string &contents)
+{
+    const std::string temp = path + ".tmp";
+    const int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Error: Could not create " << temp << std::endl;
+        return false;
+    }
+
+    size_t offset = 0;
+    while (offset < contents.size())
+    {
+        const ssize_t written = write(fd, contents.data() + offset, contents.size() - offset);
+        if (written <= 0)
+        {
+            break;
+        }
+        offset += static_cast<size_t>(written);
+    }
+    bool ok = offset == contents.size() && fsync(fd) == 0;
+    close(fd);
+
+    if (ok && std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        std::cerr << "Error: Could not replace " << path << std::endl;
+        std::remove(temp.c_str());
+    }
+    return ok;
+}
+#endif
+
+WriteBehindDocument::WriteBehindDocument(std::string path, IFileWriter &writer, std::chrono::milliseconds debounce,
+                                         std::chrono::milliseconds maxDelay, WriteListener onWrite)
+    : m_path(std::move(path)), m_writer(writer), m_debounce(debounce), m_maxDelay(maxDelay),
+      m_onWrite(std::move(onWrite)), m_document(std::make_shared<const json>())
+{
+}
+
+WriteBehindDocument::~WriteBehindDocument()
+{
+    Stop();
+}
+
+void WriteBehindDocument::Reset(json document)
+{
+    Reset(std::make_shared<const json>(std::move(document)));
+}
+
+void WriteBehindDocument::Reset(std::shared_ptr<const json> document)
+{
+    std::atomic_store(&m_document, std::move(document));
+}
+
+std::shared_ptr<const json> WriteBehindDocument::Get() const
+{
+    return std::atomic_load(&m_document);
+}
+
+void WriteBehindDocument::Set(json document, Clock::time_point now)
+{
+    Set(std::make_shared<const json>(std::move(document)), now);
+}
+
+void WriteBehindDocument::Set(std::shared_ptr<const json> shared, Clock::time_point now)
+{
+    std::atomic_store(&m_document, shared);
+    m_saves.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pending)
+        {
+            m_firstSave = now;
+        }
+        m_pending = shared;
+
+        // Trailing debounce, but a steady stream of saves cannot postpone the write forever
+        m_deadline = (std::min)(now + m_debounce, m_firstSave + m_maxDelay);
+    }
+    m_wake.notify_one();
+}
+
+WriteBehindDocument::Clock::time_point WriteBehindDocument::ProcessDue(Clock::time_point now)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pending)
+        {
+            return Clock::time_point::max();
+        }
+        if (now < m_deadline)
+        {
+            return m_deadline;
+        }
+    }
+
+    WritePending();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending ? m_deadline : Clock::time_point::max();
+}
+
+bool WriteBehindDocument::Flush()
+{
+    return WritePending();
+}
+
+bool WriteBehindDocument::WritePending()
+{
+    std::lock_guard<std::mutex> writeLock(m_writeMutex);
+
+    std::shared_ptr<const json> document;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        document = std::move(m_pending);
+        m_pending.reset();
+    }
+    if (!document)
+    {
+        return true;
+    }
+
+    // Serialized outside every lock that readers or Set() take
+    const bool ok = m_writer.WriteAtomically(m_path, document->dump(4));
+    m_writes.fetch_add(1, std::memory_order_relaxed);
+    if (m_onWrite)
+    {
+        m_onWrite(ok);
+    }
+
+    if (!ok)
+    {
+        std::cerr << "Error: Failed to write " << m_path << ", retrying in " << RETRY_DELAY.count() << " ms" << std::endl;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_pending)
+        {
+            // Nothing newer was saved meanwhile: try this one again
+            m_pending = document;
+            m_firstSave = Clock::now();
+            m_deadline = m_firstSave + RETRY_DELAY;
+        }
+    }
+    return ok;
+}
+
+bool WriteBehindDocument::Dirty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending != nullptr;
+}
+
+void WriteBehindDocument::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running)
+    {
+        return;
+    }
+    m_running = true;
+    m_thread = std::thread(&WriteBehindDocument::Run, this);
+}
+
+void WriteBehindDocument::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    // Whatever the debounce was still holding back
+    Flush();
+}
+
+void WriteBehindDocument::Run()
+{
+    Clock::time_point next = Clock::time_point::max();
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (next == Clock::time_point::max())
+            {
+                m_wake.wait(lock, [this]
+                            { return !m_running || m_pending; });
+            }
+            else
+            {
+                m_wake.wait_until(lock, next, [this, next]
+                                  { return !m_running || (m_pending && m_deadline < next); });
+            }
+            if (!m_running)
+            {
+                return;
+            }
+        }
+        next = ProcessDue(Clock::now());
+    }
+}
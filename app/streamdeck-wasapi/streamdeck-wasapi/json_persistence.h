@@ -0,0 +1,160 @@
+#ifndef JSON_PERSISTENCE_H
+#define JSON_PERSISTENCE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "json.hpp"
+
+// Write-behind persistence for the JSON settings files.
+//
+// The document lives in memory and is what every reader sees; saving replaces the
+// in-memory copy at once and only schedules the disk write. Writes are debounced
+// (a burst of saves from the UI becomes one write) and done on a background thread,
+// so HTTP handlers never wait for the disk. Each write goes to a temp file that is
+// flushed to disk and then renamed over the original, so a reader or a crash sees
+// either the old file or the new one, never a truncated one.
+
+using json = nlohmann::json;
+
+class IFileWriter
+{
+public:
+    virtual ~IFileWriter() = default;
+
+    /**
+     * @brief Replaces the file's contents atomically.
+     * @return False if the file was left unchanged.
+     */
+    virtual bool WriteAtomically(const std::string &path, const std::string &contents) = 0;
+};
+
+/**
+ * @brief Writes "<path>.tmp", flushes it to disk (FlushFileBuffers / fsync) and
+ * renames it over path (MoveFileEx with MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH).
+ */
+class AtomicFileWriter : public IFileWriter
+{
+public:
+    bool WriteAtomically(const std::string &path, const std::string &contents) override;
+};
+
+/**
+ * @brief Fake writer: keeps the files in memory and can be told to fail.
+ */
+class FakeFileWriter : public IFileWriter
+{
+public:
+    bool WriteAtomically(const std::string &path, const std::string &contents) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++attempts;
+        if (fail)
+        {
+            return false;
+        }
+        files[path] = contents;
+        return true;
+    }
+
+    std::mutex mutex;
+    std::map<std::string, std::string> files;
+    int attempts = 0;
+    bool fail = false;
+};
+
+class WriteBehindDocument
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using WriteListener = std::function<void(bool ok)>;
+
+    /**
+     * @param path File the document is persisted to.
+     * @param writer Performs the atomic replace.
+     * @param debounce Quiet time after the last save before writing.
+     * @param maxDelay Longest a save waits while saves keep coming.
+     * @param onWrite Optional; told about every write attempt (for metrics).
+     */
+    WriteBehindDocument(std::string path, IFileWriter &writer,
+                        std::chrono::milliseconds debounce = std::chrono::milliseconds(300),
+                        std::chrono::milliseconds maxDelay = std::chrono::milliseconds(2000),
+                        WriteListener onWrite = nullptr);
+    ~WriteBehindDocument();
+
+    WriteBehindDocument(const WriteBehindDocument &) = delete;
+    WriteBehindDocument &operator=(const WriteBehindDocument &) = delete;
+
+    /**
+     * @brief Sets the document without writing it (e.g. after loading the file).
+     */
+    void Reset(json document);
+    void Reset(std::shared_ptr<const json> document);
+
+    /**
+     * @brief The current document. Never null; immutable, so it can be read without locks.
+     */
+    std::shared_ptr<const json> Get() const;
+
+    /**
+     * @brief Replaces the document now and schedules it to be written.
+     */
+    void Set(json document, Clock::time_point now = Clock::now());
+    void Set(std::shared_ptr<const json> document, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Writes the pending document if its debounce has expired.
+     * @return When to call again, or Clock::time_point::max() if nothing is pending.
+     */
+    Clock::time_point ProcessDue(Clock::time_point now);
+
+    /**
+     * @brief Writes the pending document now, if any.
+     * @return False if a write was attempted and failed.
+     */
+    bool Flush();
+
+    void Start();
+
+    /**
+     * @brief Stops the writer thread and flushes what is still pending.
+     */
+    void Stop();
+
+    bool Dirty() const;
+    uint64_t Writes() const { return m_writes.load(std::memory_order_relaxed); }
+    uint64_t Saves() const { return m_saves.load(std::memory_order_relaxed); }
+
+private:
+    bool WritePending();
+    void Run();
+
+    const std::string m_path;
+    IFileWriter &m_writer;
+    const std::chrono::milliseconds m_debounce;
+    const std::chrono::milliseconds m_maxDelay;
+    WriteListener m_onWrite;
+
+    std::shared_ptr<const json> m_document; // Swapped with std::atomic_load/atomic_store
+
+    mutable std::mutex m_mutex; // Guards the fields below
+    std::condition_variable m_wake;
+    std::shared_ptr<const json> m_pending; // Null when nothing is waiting to be written
+    Clock::time_point m_firstSave;         // Oldest unwritten save
+    Clock::time_point m_deadline;
+    bool m_running = false;
+
+    std::mutex m_writeMutex; // One write at a time (thread and Flush)
+    std::thread m_thread;
+    std::atomic<uint64_t> m_writes{0};
+    std::atomic<uint64_t> m_saves{0};
+};
+
+#endif // JSON_PERSISTENCE_H
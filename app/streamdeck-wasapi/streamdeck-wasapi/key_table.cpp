@@ -0,0 +1,395 @@
+#include "key_table.h"
+
+#include <array>
+
+namespace
+{
+    constexpr KeyInfo KEY_ENTRIES[] = {
+    // Letters
+    {"A", 0x41, 0, 0},
+    {"B", 0x42, 0, 0},
+    {"C", 0x43, 0, 0},
+    {"D", 0x44, 0, 0},
+    {"E", 0x45, 0, 0},
+    {"F", 0x46, 0, 0},
+    {"G", 0x47, 0, 0},
+    {"H", 0x48, 0, 0},
+    {"I", 0x49, 0, 0},
+    {"J", 0x4A, 0, 0},
+    {"K", 0x4B, 0, 0},
+    {"L", 0x4C, 0, 0},
+    {"M", 0x4D, 0, 0},
+    {"N", 0x4E, 0, 0},
+    {"O", 0x4F, 0, 0},
+    {"P", 0x50, 0, 0},
+    {"Q", 0x51, 0, 0},
+    {"R", 0x52, 0, 0},
+    {"S", 0x53, 0, 0},
+    {"T", 0x54, 0, 0},
+    {"U", 0x55, 0, 0},
+    {"V", 0x56, 0, 0},
+    {"W", 0x57, 0, 0},
+    {"X", 0x58, 0, 0},
+    {"Y", 0x59, 0, 0},
+    {"Z", 0x5A, 0, 0},
+    // Digits (top row)
+    {"0", 0x30, 0, 0},
+    {"1", 0x31, 0, 0},
+    {"2", 0x32, 0, 0},
+    {"3", 0x33, 0, 0},
+    {"4", 0x34, 0, 0},
+    {"5", 0x35, 0, 0},
+    {"6", 0x36, 0, 0},
+    {"7", 0x37, 0, 0},
+    {"8", 0x38, 0, 0},
+    {"9", 0x39, 0, 0},
+    // Function keys
+    {"F1", 0x70, 0, 0},
+    {"F2", 0x71, 0, 0},
+    {"F3", 0x72, 0, 0},
+    {"F4", 0x73, 0, 0},
+    {"F5", 0x74, 0, 0},
+    {"F6", 0x75, 0, 0},
+    {"F7", 0x76, 0, 0},
+    {"F8", 0x77, 0, 0},
+    {"F9", 0x78, 0, 0},
+    {"F10", 0x79, 0, 0},
+    {"F11", 0x7A, 0, 0},
+    {"F12", 0x7B, 0, 0},
+    {"F13", 0x7C, 0, 0},
+    {"F14", 0x7D, 0, 0},
+    {"F15", 0x7E, 0, 0},
+    {"F16", 0x7F, 0, 0},
+    {"F17", 0x80, 0, 0},
+    {"F18", 0x81, 0, 0},
+    {"F19", 0x82, 0, 0},
+    {"F20", 0x83, 0, 0},
+    {"F21", 0x84, 0, 0},
+    {"F22", 0x85, 0, 0},
+    {"F23", 0x86, 0, 0},
+    {"F24", 0x87, 0, 0},
+    // Numpad
+    {"Numpad0", 0x60, 0, 0},
+    {"Numpad1", 0x61, 0, 0},
+    {"Numpad2", 0x62, 0, 0},
+    {"Numpad3", 0x63, 0, 0},
+    {"Numpad4", 0x64, 0, 0},
+    {"Numpad5", 0x65, 0, 0},
+    {"Numpad6", 0x66, 0, 0},
+    {"Numpad7", 0x67, 0, 0},
+    {"Numpad8", 0x68, 0, 0},
+    {"Numpad9", 0x69, 0, 0},
+    {"NumpadMultiply", 0x6A, 0, 0},
+    {"NumpadAdd", 0x6B, 0, 0},
+    {"NumpadSeparator", 0x6C, 0, 0},
+    {"NumpadSubtract", 0x6D, 0, 0},
+    {"NumpadDecimal", 0x6E, 0, 0},
+    {"NumpadDivide", 0x6F, KEY_FLAG_EXTENDED, 0},
+    {"NumpadEnter", 0x0D, KEY_FLAG_EXTENDED, 0},
+    {"NumLock", 0x90, KEY_FLAG_EXTENDED, 0},
+    // Editing and control
+    {"Escape", 0x1B, 0, 0},
+    {"Esc", 0x1B, 0, 0},
+    {"Tab", 0x09, 0, 0},
+    {"CapsLock", 0x14, 0, 0},
+    {"Space", 0x20, 0, 0},
+    {"Enter", 0x0D, 0, 0},
+    {"Return", 0x0D, 0, 0},
+    {"Backspace", 0x08, 0, 0},
+    {"Insert", 0x2D, KEY_FLAG_EXTENDED, 0},
+    {"Delete", 0x2E, KEY_FLAG_EXTENDED, 0},
+    {"Del", 0x2E, KEY_FLAG_EXTENDED, 0},
+    {"Clear", 0x0C, 0, 0},
+    {"Pause", 0x13, 0, 0},
+    {"ScrollLock", 0x91, 0, 0},
+    {"PrintScreen", 0x2C, KEY_FLAG_EXTENDED, 0},
+    {"ContextMenu", 0x5D, KEY_FLAG_EXTENDED, 0},
+    {"Apps", 0x5D, KEY_FLAG_EXTENDED, 0},
+    {"Sleep", 0x5F, 0, 0},
+    // Navigation
+    {"ArrowUp", 0x26, KEY_FLAG_EXTENDED, 0},
+    {"Up", 0x26, KEY_FLAG_EXTENDED, 0},
+    {"ArrowDown", 0x28, KEY_FLAG_EXTENDED, 0},
+    {"Down", 0x28, KEY_FLAG_EXTENDED, 0},
+    {"ArrowLeft", 0x25, KEY_FLAG_EXTENDED, 0},
+    {"Left", 0x25, KEY_FLAG_EXTENDED, 0},
+    {"ArrowRight", 0x27, KEY_FLAG_EXTENDED, 0},
+    {"Right", 0x27, KEY_FLAG_EXTENDED, 0},
+    {"Home", 0x24, KEY_FLAG_EXTENDED, 0},
+    {"End", 0x23, KEY_FLAG_EXTENDED, 0},
+    {"PageUp", 0x21, KEY_FLAG_EXTENDED, 0},
+    {"PageDown", 0x22, KEY_FLAG_EXTENDED, 0},
+    // Modifiers
+    {"Ctrl", 0x11, 0, KEY_MOD_CTRL},
+    {"Control", 0x11, 0, KEY_MOD_CTRL},
+    {"Shift", 0x10, 0, KEY_MOD_SHIFT},
+    {"Alt", 0x12, 0, KEY_MOD_ALT},
+    {"Win", 0x5B, KEY_FLAG_EXTENDED, KEY_MOD_WIN},
+    {"LWin", 0x5B, KEY_FLAG_EXTENDED, KEY_MOD_WIN},
+    {"Meta", 0x5B, KEY_FLAG_EXTENDED, KEY_MOD_WIN},
+    {"RWin", 0x5C, KEY_FLAG_EXTENDED, KEY_MOD_RWIN},
+    {"LShift", 0xA0, 0, 0},
+    {"RShift", 0xA1, 0, 0},
+    {"LCtrl", 0xA2, 0, 0},
+    {"RCtrl", 0xA3, KEY_FLAG_EXTENDED, 0},
+    {"LAlt", 0xA4, 0, 0},
+    {"RAlt", 0xA5, KEY_FLAG_EXTENDED, 0},
+    {"AltGr", 0xA5, KEY_FLAG_EXTENDED, 0},
+    // Punctuation (US layout; shifted symbols are their base key with Shift held)
+    {";", 0xBA, 0, 0},
+    {"=", 0xBB, 0, 0},
+    {",", 0xBC, 0, 0},
+    {"-", 0xBD, 0, 0},
+    {".", 0xBE, 0, 0},
+    {"/", 0xBF, 0, 0},
+    {"`", 0xC0, 0, 0},
+    {"[", 0xDB, 0, 0},
+    {"\\", 0xDC, 0, 0},
+    {"]", 0xDD, 0, 0},
+    {"'", 0xDE, 0, 0},
+    {":", 0xBA, KEY_FLAG_SHIFTED, 0},
+    {"+", 0xBB, KEY_FLAG_SHIFTED, 0},
+    {"<", 0xBC, KEY_FLAG_SHIFTED, 0},
+    {"_", 0xBD, KEY_FLAG_SHIFTED, 0},
+    {">", 0xBE, KEY_FLAG_SHIFTED, 0},
+    {"?", 0xBF, KEY_FLAG_SHIFTED, 0},
+    {"~", 0xC0, KEY_FLAG_SHIFTED, 0},
+    {"{", 0xDB, KEY_FLAG_SHIFTED, 0},
+    {"|", 0xDC, KEY_FLAG_SHIFTED, 0},
+    {"}", 0xDD, KEY_FLAG_SHIFTED, 0},
+    {"\"", 0xDE, KEY_FLAG_SHIFTED, 0},
+    {"!", 0x31, KEY_FLAG_SHIFTED, 0},
+    {"@", 0x32, KEY_FLAG_SHIFTED, 0},
+    {"#", 0x33, KEY_FLAG_SHIFTED, 0},
+    {"$", 0x34, KEY_FLAG_SHIFTED, 0},
+    {"%", 0x35, KEY_FLAG_SHIFTED, 0},
+    {"^", 0x36, KEY_FLAG_SHIFTED, 0},
+    {"&", 0x37, KEY_FLAG_SHIFTED, 0},
+    {"*", 0x38, KEY_FLAG_SHIFTED, 0},
+    {"(", 0x39, KEY_FLAG_SHIFTED, 0},
+    {")", 0x30, KEY_FLAG_SHIFTED, 0},
+    {"Semicolon", 0xBA, 0, 0},
+    {"Equal", 0xBB, 0, 0},
+    {"Comma", 0xBC, 0, 0},
+    {"Minus", 0xBD, 0, 0},
+    {"Period", 0xBE, 0, 0},
+    {"Slash", 0xBF, 0, 0},
+    {"Backquote", 0xC0, 0, 0},
+    {"BracketLeft", 0xDB, 0, 0},
+    {"Backslash", 0xDC, 0, 0},
+    {"BracketRight", 0xDD, 0, 0},
+    {"Quote", 0xDE, 0, 0},
+    // Browser keys
+    {"BrowserBack", 0xA6, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"BrowserForward", 0xA7, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"BrowserRefresh", 0xA8, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"BrowserStop", 0xA9, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"BrowserSearch", 0xAA, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"BrowserFavorites", 0xAB, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"BrowserHome", 0xAC, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    // Media keys (Media_* as used in binds.json, plus the browser KeyboardEvent.key names)
+    {"Media_PlayPause", 0xB3, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"Media_NextTrack", 0xB0, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"Media_PrevTrack", 0xB1, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"Media_Stop", 0xB2, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"Media_VolumeUp", 0xAF, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"Media_VolumeDown", 0xAE, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"Media_VolumeMute", 0xAD, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"MediaPlayPause", 0xB3, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"MediaTrackNext", 0xB0, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"MediaTrackPrevious", 0xB1, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"MediaStop", 0xB2, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"AudioVolumeUp", 0xAF, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"AudioVolumeDown", 0xAE, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"AudioVolumeMute", 0xAD, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"LaunchMail", 0xB4, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"LaunchMediaPlayer", 0xB5, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"LaunchApplication1", 0xB6, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    {"LaunchApplication2", 0xB7, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED, 0},
+    };
+
+    constexpr size_t KEY_COUNT = sizeof(KEY_ENTRIES) / sizeof(KEY_ENTRIES[0]);
+    constexpr size_t SLOT_COUNT = 512;  // Power of two, ~2.5x the key count
+    constexpr size_t BUCKET_COUNT = 64; // Keys sharing a bucket share one displacement
+    constexpr uint32_t MAX_DISPLACEMENT = 0xFFFF;
+
+    static_assert(KEY_COUNT < SLOT_COUNT, "Key table is larger than its slot array");
+
+    constexpr char ToLowerAscii(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // Case-folded FNV-1a followed by a 64-bit finalizer (splitmix64)
+    constexpr uint64_t HashKeyName(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (char c : name)
+        {
+            hash ^= static_cast<uint8_t>(ToLowerAscii(c));
+            hash *= 1099511628211ULL;
+        }
+        hash ^= hash >> 30;
+        hash *= 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 27;
+        hash *= 0x94D049BB133111EBULL;
+        hash ^= hash >> 31;
+        return hash;
+    }
+
+    constexpr size_t BucketOf(uint64_t hash)
+    {
+        return static_cast<size_t>(hash >> 58) % BUCKET_COUNT;
+    }
+
+    constexpr size_t SlotOf(uint64_t hash, uint32_t displacement)
+    {
+        const uint32_t base = static_cast<uint32_t>(hash);
+        const uint32_t step = static_cast<uint32_t>(hash >> 32) | 1u;
+        return static_cast<size_t>(base + displacement * step) & (SLOT_COUNT - 1);
+    }
+
+    constexpr bool NamesEqual(std::string_view a, std::string_view b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (ToLowerAscii(a[i]) != ToLowerAscii(b[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct PerfectHashTable
+    {
+        std::array<uint16_t, BUCKET_COUNT> displacements{};
+        std::array<int16_t, SLOT_COUNT> slots{}; // Index into KEY_ENTRIES, -1 = empty
+        bool complete = false;
+    };
+
+    // Hash and displace: place the largest buckets first, searching each bucket for a
+    // displacement that sends all of its keys to free, distinct slots.
+    constexpr PerfectHashTable BuildKeyTable()
+    {
+        PerfectHashTable table;
+        for (auto &slot : table.slots)
+        {
+            slot = -1;
+        }
+
+        std::array<uint64_t, KEY_COUNT> hashes{};
+        std::array<size_t, BUCKET_COUNT> bucketSizes{};
+        size_t largestBucket = 0;
+        for (size_t i = 0; i < KEY_COUNT; ++i)
+        {
+            hashes[i] = HashKeyName(KEY_ENTRIES[i].name);
+            const size_t size = ++bucketSizes[BucketOf(hashes[i])];
+            largestBucket = size > largestBucket ? size : largestBucket;
+        }
+
+        for (size_t size = largestBucket; size > 0; --size)
+        {
+            for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+            {
+                if (bucketSizes[bucket] != size)
+                {
+                    continue;
+                }
+
+                bool placed = false;
+                for (uint32_t displacement = 0; displacement <= MAX_DISPLACEMENT && !placed; ++displacement)
+                {
+                    std::array<size_t, KEY_COUNT> chosen{};
+                    size_t chosenCount = 0;
+                    bool fits = true;
+                    for (size_t i = 0; i < KEY_COUNT && fits; ++i)
+                    {
+                        if (BucketOf(hashes[i]) != bucket)
+                        {
+                            continue;
+                        }
+                        const size_t slot = SlotOf(hashes[i], displacement);
+                        fits = table.slots[slot] < 0;
+                        for (size_t j = 0; j < chosenCount && fits; ++j)
+                        {
+                            fits = chosen[j] != slot;
+                        }
+                        chosen[chosenCount++] = slot;
+                    }
+
+                    if (fits)
+                    {
+                        size_t next = 0;
+                        for (size_t i = 0; i < KEY_COUNT; ++i)
+                        {
+                            if (BucketOf(hashes[i]) == bucket)
+                            {
+                                table.slots[chosen[next++]] = static_cast<int16_t>(i);
+                            }
+                        }
+                        table.displacements[bucket] = static_cast<uint16_t>(displacement);
+                        placed = true;
+                    }
+                }
+
+                if (!placed)
+                {
+                    return table; // Incomplete; rejected by the static_assert below
+                }
+            }
+        }
+
+        table.complete = true;
+        return table;
+    }
+
+    constexpr PerfectHashTable KEY_TABLE = BuildKeyTable();
+
+    // Fails on duplicate names (they always collide) or if a bucket could not be placed
+    static_assert(KEY_TABLE.complete, "Key name table has no perfect hash; check for duplicate names");
+
+    constexpr const KeyInfo *FindKey(std::string_view name)
+    {
+        const uint64_t hash = HashKeyName(name);
+        const int16_t index = KEY_TABLE.slots[SlotOf(hash, KEY_TABLE.displacements[BucketOf(hash)])];
+        if (index < 0 || !NamesEqual(KEY_ENTRIES[index].name, name))
+        {
+            return nullptr;
+        }
+        return &KEY_ENTRIES[index];
+    }
+
+    static_assert(FindKey("F24") && FindKey("F24")->vk == 0x87, "Key table lookup is broken");
+    static_assert(FindKey("media_playpause") && FindKey("media_playpause")->vk == 0xB3, "Key table lookup is broken");
+    static_assert(!FindKey("NoSuchKey"), "Key table lookup is broken");
+    static_assert(FindKey("?") && FindKey("?")->vk == 0xBF && (FindKey("?")->flags & KEY_FLAG_SHIFTED), "Key table lookup is broken");
+}
+
+const KeyInfo *LookupKey(std::string_view name)
+{
+    return FindKey(name);
+}
+
+const KeyInfo *ModifierKey(uint8_t modifier)
+{
+    static constexpr KeyInfo MODIFIER_KEYS[] = {
+        {"Ctrl", 0x11, 0, KEY_MOD_CTRL},
+        {"Shift", 0x10, 0, KEY_MOD_SHIFT},
+        {"Alt", 0x12, 0, KEY_MOD_ALT},
+        {"Win", 0x5B, KEY_FLAG_EXTENDED, KEY_MOD_WIN},
+        {"RWin", 0x5C, KEY_FLAG_EXTENDED, KEY_MOD_RWIN},
+    };
+    for (const KeyInfo &key : MODIFIER_KEYS)
+    {
+        if (key.modifier == modifier)
+        {
+            return &key;
+        }
+    }
+    return nullptr;
+}
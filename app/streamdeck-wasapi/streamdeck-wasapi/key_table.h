@@ -0,0 +1,47 @@
+#ifndef KEY_TABLE_H
+#define KEY_TABLE_H
+
+#include <cstdint>
+#include <string_view>
+
+// Portable key name -> Windows virtual key code table.
+//
+// The table is laid out at compile time as a minimal-probe perfect hash
+// (hash and displace), so a lookup is one hash plus one slot compare.
+// Names are matched case-insensitively ("esc", "Esc" and "ESC" are the same key).
+// Virtual key codes are numeric here so the table builds without windows.h.
+
+// --- Key flags ---
+constexpr uint8_t KEY_FLAG_EXTENDED = 1; // Needs KEYEVENTF_EXTENDEDKEY
+constexpr uint8_t KEY_FLAG_MEDIA = 2;    // Multimedia/browser key, injected without modifiers
+constexpr uint8_t KEY_FLAG_SHIFTED = 4;  // Shifted symbol ("!", "?"): its base key with Shift held
+
+// Modifier bit flags (HOTKEY_MOD_* in hotkey_combo.h use the same values)
+constexpr uint8_t KEY_MOD_CTRL = 1;
+constexpr uint8_t KEY_MOD_SHIFT = 2;
+constexpr uint8_t KEY_MOD_ALT = 4;
+constexpr uint8_t KEY_MOD_WIN = 8;
+constexpr uint8_t KEY_MOD_RWIN = 16;
+
+struct KeyInfo
+{
+    const char *name; // Canonical spelling
+    uint16_t vk;      // Windows virtual key code
+    uint8_t flags;    // KEY_FLAG_*
+    uint8_t modifier; // KEY_MOD_* bit if the key can be used as a modifier, 0 otherwise
+};
+
+/**
+ * @brief Looks up a key by name (e.g. "F13", "PageDown", "Numpad5", "Media_PlayPause", ";").
+ * @return The key, or nullptr if the name is unknown.
+ */
+const KeyInfo *LookupKey(std::string_view name);
+
+/**
+ * @brief Virtual key code (plus flags) a modifier bit is injected as.
+ * @param modifier A single KEY_MOD_* bit.
+ * @return The modifier's key, or nullptr for an unknown bit.
+ */
+const KeyInfo *ModifierKey(uint8_t modifier);
+
+#endif // KEY_TABLE_H
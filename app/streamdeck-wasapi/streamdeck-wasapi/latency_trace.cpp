@@ -0,0 +1,294 @@
+#include "latency_trace.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // One histogram per stage plus one for the whole path (bytes received -> volume applied)
+    LatencyHistogram g_stageHistograms[TRACE_STAGE_COUNT];
+    LatencyHistogram g_endToEndHistogram;
+
+#if STREAMDECK_TRACE_ENABLED
+    thread_local TraceSpan *t_currentSpan = nullptr;
+
+    // Start of the latest frame with an end-to-end sample. Every slider a frame moves
+    // carries a copy of its span; only the first of them to apply a volume counts.
+    std::atomic<int64_t> g_lastEndToEndStartNs{0};
+#endif
+
+    int HighestBit(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index = 0;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    const double REPORT_PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+    const char *REPORT_KEYS[] = {"p50_us", "p90_us", "p99_us", "p999_us"};
+
+    nlohmann::json HistogramToJson(const LatencyHistogram &histogram)
+    {
+        nlohmann::json entry = nlohmann::json::object();
+        entry["count"] = histogram.TotalCount();
+        entry["mean_us"] = histogram.Mean() / 1000.0;
+        for (size_t i = 0; i < std::size(REPORT_PERCENTILES); ++i)
+        {
+            entry[REPORT_KEYS[i]] = histogram.ValueAtPercentile(REPORT_PERCENTILES[i]) / 1000.0;
+        }
+        entry["max_us"] = histogram.Max() / 1000.0;
+        return entry;
+    }
+}
+
+const char *TraceStageName(TraceStage stage)
+{
+    switch (stage)
+    {
+    case TraceStage::BytesReceived:
+        return "bytes_received";
+    case TraceStage::FrameDecoded:
+        return "frame_decoded";
+    case TraceStage::Filtered:
+        return "filtered";
+    case TraceStage::Dispatched:
+        return "dispatched";
+    case TraceStage::SessionResolved:
+        return "session_resolved";
+    case TraceStage::VolumeApplied:
+        return "volume_applied";
+    default:
+        return "unknown";
+    }
+}
+
+// --- LatencyHistogram ---
+
+LatencyHistogram::LatencyHistogram()
+    : m_total(0), m_sum(0), m_max(0)
+{
+    for (auto &count : m_counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::BucketIndex(uint64_t value)
+{
+    const uint64_t maxValue = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+    value = (std::min)(value, maxValue);
+
+    if (value < SUB_BUCKET_COUNT)
+    {
+        return static_cast<int>(value);
+    }
+
+    // Keep SUB_BUCKET_BITS + 1 significant bits: the magnitude selects the band,
+    // the bits below the leading one select the linear sub-bucket within it
+    const int msb = HighestBit(value);
+    const int shift = msb - SUB_BUCKET_BITS;
+    const int subBucket = static_cast<int>(value >> shift) - SUB_BUCKET_COUNT;
+    return (shift + 1) * SUB_BUCKET_COUNT + subBucket;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(int index)
+{
+    if (index < SUB_BUCKET_COUNT)
+    {
+        return static_cast<uint64_t>(index);
+    }
+
+    const int shift = index / SUB_BUCKET_COUNT - 1;
+    const uint64_t subBucket = static_cast<uint64_t>(index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t value)
+{
+    m_counts[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (value > currentMax &&
+           !m_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto &count : m_counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_total.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::TotalCount() const
+{
+    return m_total.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Max() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Mean() const
+{
+    const uint64_t total = TotalCount();
+    return total == 0 ? 0.0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) / total;
+}
+
+uint64_t LatencyHistogram::ValueAtPercentile(double percentile) const
+{
+    const uint64_t total = TotalCount();
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    percentile = (std::max)(0.0, (std::min)(100.0, percentile));
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total + 0.5);
+    target = (std::max)(target, uint64_t(1));
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+        {
+            // Never report more than the exact recorded maximum
+            return (std::min)(BucketUpperBound(i), Max());
+        }
+    }
+    return Max();
+}
+
+#if STREAMDECK_TRACE_ENABLED
+// --- TraceSpan ---
+
+void TraceSpan::Begin()
+{
+    startNs = TraceNowNs();
+    lastNs = startNs;
+}
+
+void TraceSpan::Mark(TraceStage stage)
+{
+    if (!Active())
+    {
+        return;
+    }
+
+    const int64_t now = TraceNowNs();
+    g_stageHistograms[static_cast<int>(stage)].Record(static_cast<uint64_t>(now - lastNs));
+    lastNs = now;
+
+    if (stage == TraceStage::VolumeApplied)
+    {
+        int64_t last = g_lastEndToEndStartNs.load(std::memory_order_relaxed);
+        while (last < startNs &&
+               !g_lastEndToEndStartNs.compare_exchange_weak(last, startNs, std::memory_order_relaxed))
+        {
+        }
+        if (last < startNs)
+        {
+            g_endToEndHistogram.Record(static_cast<uint64_t>(now - startNs));
+        }
+    }
+}
+
+ScopedTraceContext::ScopedTraceContext(TraceSpan *span)
+    : m_previous(t_currentSpan)
+{
+    t_currentSpan = span;
+}
+
+ScopedTraceContext::~ScopedTraceContext()
+{
+    t_currentSpan = m_previous;
+}
+
+void TraceMarkCurrent(TraceStage stage)
+{
+    if (t_currentSpan)
+    {
+        t_currentSpan->Mark(stage);
+    }
+}
+
+TraceSpan TraceCurrentSpan()
+{
+    return t_currentSpan ? *t_currentSpan : TraceSpan();
+}
+#endif
+
+// --- Reporting ---
+
+nlohmann::json GetLatencyReport()
+{
+    nlohmann::json report = nlohmann::json::object();
+    report["enabled"] = STREAMDECK_TRACE_ENABLED != 0;
+
+    nlohmann::json stages = nlohmann::json::array();
+    // BytesReceived only starts the span, so there is no time attributed to it
+    for (int i = static_cast<int>(TraceStage::FrameDecoded); i < TRACE_STAGE_COUNT; ++i)
+    {
+        nlohmann::json entry = HistogramToJson(g_stageHistograms[i]);
+        entry["stage"] = TraceStageName(static_cast<TraceStage>(i));
+        stages.push_back(entry);
+    }
+    report["stages"] = stages;
+    report["end_to_end"] = HistogramToJson(g_endToEndHistogram);
+    return report;
+}
+
+std::string FormatLatencyReport()
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Control path latency (microseconds)" << std::endl;
+    out << std::left << std::setw(18) << "stage" << std::right
+        << std::setw(10) << "count" << std::setw(10) << "p50" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+
+    auto writeRow = [&out](const char *name, const LatencyHistogram &histogram)
+    {
+        out << std::left << std::setw(18) << name << std::right << std::setw(10) << histogram.TotalCount();
+        for (double percentile : REPORT_PERCENTILES)
+        {
+            out << std::setw(10) << histogram.ValueAtPercentile(percentile) / 1000.0;
+        }
+        out << std::setw(10) << histogram.Max() / 1000.0 << std::endl;
+    };
+
+    for (int i = static_cast<int>(TraceStage::FrameDecoded); i < TRACE_STAGE_COUNT; ++i)
+    {
+        writeRow(TraceStageName(static_cast<TraceStage>(i)), g_stageHistograms[i]);
+    }
+    writeRow("end_to_end", g_endToEndHistogram);
+    return out.str();
+}
+
+void ResetLatencyStats()
+{
+    for (auto &histogram : g_stageHistograms)
+    {
+        histogram.Reset();
+    }
+    g_endToEndHistogram.Reset();
+}
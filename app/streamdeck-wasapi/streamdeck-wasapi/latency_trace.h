@@ -0,0 +1,175 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "json.hpp"
+
+// Lightweight per-stage latency tracing for the fader -> volume control path.
+//
+// A TraceSpan is started when serial bytes arrive and is marked at every stage
+// boundary. Each mark records the time spent since the previous mark into the
+// stage's histogram, so percentiles show where the time actually goes. The
+// end-to-end histogram gets one sample per frame, however many sliders it moved:
+// the time until its first volume was applied.
+//
+// Define STREAMDECK_TRACE_ENABLED=0 to compile every trace point out entirely:
+// TraceSpan becomes an empty type, so the spans kept with frames and queued commands
+// are never read, copied or marked.
+
+#ifndef STREAMDECK_TRACE_ENABLED
+#define STREAMDECK_TRACE_ENABLED 1
+#endif
+
+// --- Control path stages (in order) ---
+enum class TraceStage : int
+{
+    BytesReceived = 0, // Line read from the serial port (span start)
+    FrameDecoded,      // CSV frame parsed into slider/button values
+    Filtered,          // Change detection decided the frame is relevant
+    Dispatched,        // Slider mapped to a group, volume dispatch started
+    SessionResolved,   // App name matched to a WASAPI session
+    VolumeApplied,     // SetMasterVolume returned
+    Count
+};
+
+constexpr int TRACE_STAGE_COUNT = static_cast<int>(TraceStage::Count);
+
+/**
+ * @brief Returns the display name of a trace stage (e.g. "frame_decoded").
+ */
+const char *TraceStageName(TraceStage stage);
+
+/**
+ * @brief Monotonic timestamp in nanoseconds (steady clock).
+ */
+inline int64_t TraceNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief HDR-style histogram with log2 magnitudes and 32 linear sub-buckets each.
+ * Values are nanoseconds; relative precision is ~3% up to ~18 minutes.
+ * Record() is wait-free (relaxed atomic increments only) and safe from any thread.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 40;
+    static constexpr int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    LatencyHistogram();
+
+    void Record(uint64_t value);
+    void Reset();
+
+    uint64_t TotalCount() const;
+    uint64_t Max() const;
+    double Mean() const;
+
+    /**
+     * @brief Returns the highest value equivalent to the given percentile (0-100).
+     */
+    uint64_t ValueAtPercentile(double percentile) const;
+
+    static int BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(int index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_counts;
+    std::atomic<uint64_t> m_total;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+};
+
+#if STREAMDECK_TRACE_ENABLED
+/**
+ * @brief Timestamps for one frame travelling through the control path.
+ * Copyable so it can be handed from the serial thread to the processing thread.
+ */
+struct TraceSpan
+{
+    int64_t startNs = 0;
+    int64_t lastNs = 0;
+
+    bool Active() const { return startNs != 0; }
+
+    void Begin();
+    void Mark(TraceStage stage);
+};
+
+/**
+ * @brief Makes a span the current one for this thread, so deeper layers
+ * (e.g. SetApplicationVolume) can mark stages without threading it through.
+ */
+class ScopedTraceContext
+{
+public:
+    explicit ScopedTraceContext(TraceSpan *span);
+    ~ScopedTraceContext();
+
+    ScopedTraceContext(const ScopedTraceContext &) = delete;
+    ScopedTraceContext &operator=(const ScopedTraceContext &) = delete;
+
+private:
+    TraceSpan *m_previous;
+};
+
+/**
+ * @brief Marks a stage on the span bound to the calling thread, if any.
+ */
+void TraceMarkCurrent(TraceStage stage);
+
+/**
+ * @brief Returns a copy of the span bound to the calling thread (inactive if none),
+ * so a stage can be handed to another thread together with the work it traces.
+ */
+TraceSpan TraceCurrentSpan();
+#else
+struct TraceSpan
+{
+    bool Active() const { return false; }
+    void Begin() {}
+    void Mark(TraceStage) {}
+};
+
+inline void TraceMarkCurrent(TraceStage) {}
+inline TraceSpan TraceCurrentSpan() { return TraceSpan(); }
+#endif
+
+/**
+ * @brief Per-stage and end-to-end percentiles (p50/p90/p99/p99.9/max, microseconds) as JSON.
+ */
+nlohmann::json GetLatencyReport();
+
+/**
+ * @brief Human readable percentile table, used by the tray "dump" command.
+ */
+std::string FormatLatencyReport();
+
+/**
+ * @brief Clears all stage histograms.
+ */
+void ResetLatencyStats();
+
+#if STREAMDECK_TRACE_ENABLED
+#define TRACE_BEGIN(span) (span).Begin()
+#define TRACE_MARK(span, stage) (span).Mark(stage)
+#define TRACE_MARK_CURRENT(stage) TraceMarkCurrent(stage)
+#define TRACE_SCOPE(span) ScopedTraceContext trace_scope_guard_(&(span))
+#else
+#define TRACE_BEGIN(span) ((void)0)
+#define TRACE_MARK(span, stage) ((void)0)
+#define TRACE_MARK_CURRENT(stage) ((void)0)
+#define TRACE_SCOPE(span) ((void)0)
+#endif
+
+#endif // LATENCY_TRACE_H
@@ -0,0 +1,210 @@
+#include "macro.h"
+
+#include <cmath>
+#include "hotkey_combo.h"
+
+std::u16string Utf8ToUtf16(const std::string &text)
+{
+    std::u16string result;
+    result.reserve(text.size());
+
+    size_t i = 0;
+    while (i < text.size())
+    {
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        uint32_t codePoint = 0xFFFD;
+        size_t length = 1;
+
+        if (lead < 0x80)
+        {
+            codePoint = lead;
+        }
+        else if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+        }
+
+        if (length > 1)
+        {
+            bool valid = i + length <= text.size();
+            for (size_t k = 1; valid && k < length; ++k)
+            {
+                const unsigned char next = static_cast<unsigned char>(text[i + k]);
+                valid = (next & 0xC0) == 0x80;
+                codePoint = (codePoint << 6) | (next & 0x3F);
+            }
+            if (!valid || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+            {
+                codePoint = 0xFFFD;
+                length = 1;
+            }
+        }
+
+        if (codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            result += static_cast<char16_t>(0xD800 + (codePoint >> 10));
+            result += static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+        }
+        else
+        {
+            result += static_cast<char16_t>(codePoint);
+        }
+        i += length;
+    }
+    return result;
+}
+
+namespace
+{
+    bool CompileChordStep(const json &step, const char *field, bool mediaOnly, MacroProgram &program, std::string &error)
+    {
+        if (!step[field].is_string())
+        {
+            error = std::string("'") + field + "' must be a combo string";
+            return false;
+        }
+
+        const std::string combo = step[field].get<std::string>();
+        HotkeyCombo parsed;
+        if (!ParseHotkeyCombo(combo, parsed))
+        {
+            error = "unknown key combo '" + combo + "'";
+            return false;
+        }
+        if (mediaOnly && !parsed.IsMedia())
+        {
+            error = "'" + combo + "' is not a media key";
+            return false;
+        }
+
+        KeyChord chord = BuildKeyChord(parsed);
+        if (step.contains("holdMs"))
+        {
+            if (!step["holdMs"].is_number() || step["holdMs"].get<double>() < 1 || step["holdMs"].get<double>() > 10000)
+            {
+                error = "'holdMs' must be between 1 and 10000";
+                return false;
+            }
+            chord.holdMs = static_cast<uint16_t>(step["holdMs"].get<double>());
+        }
+
+        program.code.push_back({MacroOp::Chord, static_cast<uint32_t>(program.chords.size()), 0.0f});
+        program.chords.push_back(chord);
+        return true;
+    }
+
+    bool CompileStep(const json &step, MacroProgram &program, std::string &error)
+    {
+        if (!step.is_object())
+        {
+            error = "step must be an object";
+            return false;
+        }
+
+        if (step.contains("chord"))
+        {
+            return CompileChordStep(step, "chord", false, program, error);
+        }
+        if (step.contains("combo"))
+        {
+            return CompileChordStep(step, "combo", false, program, error);
+        }
+        if (step.contains("media"))
+        {
+            return CompileChordStep(step, "media", true, program, error);
+        }
+
+        if (step.contains("text"))
+        {
+            if (!step["text"].is_string())
+            {
+                error = "'text' must be a string";
+                return false;
+            }
+            std::u16string text = Utf8ToUtf16(step["text"].get<std::string>());
+            if (text.empty() || text.size() > MACRO_MAX_TEXT_LENGTH)
+            {
+                error = "'text' must hold 1 to " + std::to_string(MACRO_MAX_TEXT_LENGTH) + " characters";
+                return false;
+            }
+            program.code.push_back({MacroOp::Text, static_cast<uint32_t>(program.texts.size()), 0.0f});
+            program.texts.push_back(std::move(text));
+            return true;
+        }
+
+        if (step.contains("delay"))
+        {
+            // Milliseconds, fractions allowed (e.g. 0.5)
+            const json &delay = step["delay"];
+            if (!delay.is_number() || delay.get<double>() < 0 ||
+                delay.get<double>() * 1000.0 > static_cast<double>(MACRO_MAX_DELAY_US))
+            {
+                error = "'delay' must be a number of milliseconds between 0 and 60000";
+                return false;
+            }
+            const uint32_t microseconds = static_cast<uint32_t>(std::llround(delay.get<double>() * 1000.0));
+            program.code.push_back({MacroOp::Delay, microseconds, 0.0f});
+            return true;
+        }
+
+        if (step.contains("volume"))
+        {
+            const json &level = step["volume"];
+            if (!level.is_number() || level.get<double>() < 0.0 || level.get<double>() > 1.0)
+            {
+                error = "'volume' must be a number between 0.0 and 1.0";
+                return false;
+            }
+            if (!step.contains("group") || !step["group"].is_string() || step["group"].get<std::string>().empty())
+            {
+                error = "'volume' step needs a 'group'";
+                return false;
+            }
+            program.code.push_back({MacroOp::Volume, static_cast<uint32_t>(program.volumeGroups.size()), level.get<float>()});
+            program.volumeGroups.push_back(step["group"].get<std::string>());
+            return true;
+        }
+
+        error = "unknown step type (expected chord, media, text, delay or volume)";
+        return false;
+    }
+}
+
+bool CompileMacro(const json &steps, MacroProgram &program, std::string &error)
+{
+    if (!steps.is_array() || steps.empty())
+    {
+        error = "'macro' must be a non-empty array";
+        return false;
+    }
+    if (steps.size() > MACRO_MAX_STEPS)
+    {
+        error = "'macro' has more than " + std::to_string(MACRO_MAX_STEPS) + " steps";
+        return false;
+    }
+
+    MacroProgram compiled;
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        if (!CompileStep(steps[i], compiled, error))
+        {
+            error = "step " + std::to_string(i) + ": " + error;
+            return false;
+        }
+    }
+
+    program = std::move(compiled);
+    return true;
+}
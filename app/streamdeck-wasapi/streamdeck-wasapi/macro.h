@@ -0,0 +1,68 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "input_injector.h"
+
+// Multi-step button actions.
+//
+// A binds.json entry may carry a "macro" array instead of a single "combo":
+//
+//   {"action": "Stream intro", "macro": [
+//       {"chord": "Ctrl+Shift+F13", "holdMs": 30},
+//       {"delay": 250},
+//       {"text": "Hello chat!"},
+//       {"volume": 0.35, "group": "Group 1"},
+//       {"media": "Media_PlayPause"}]}
+//
+// The steps are validated once at config load and compiled into a flat
+// instruction list; the MacroScheduler only interprets the compiled form.
+
+using json = nlohmann::json;
+
+// --- Limits (validated at compile time of the macro) ---
+constexpr size_t MACRO_MAX_STEPS = 256;
+constexpr size_t MACRO_MAX_TEXT_LENGTH = 1024;         // UTF-16 code units per text step
+constexpr uint32_t MACRO_MAX_DELAY_US = 60 * 1000000u; // One minute per delay step
+
+enum class MacroOp : uint8_t
+{
+    Chord,  // Press chords[operand], release after its hold time
+    Text,   // Type texts[operand]
+    Delay,  // Wait operand microseconds
+    Volume, // Set group volumeGroups[operand] to level
+};
+
+struct MacroInstruction
+{
+    MacroOp op = MacroOp::Delay;
+    uint32_t operand = 0; // Pool index, or microseconds for Delay
+    float level = 0.0f;   // Volume level (0.0 - 1.0) for Volume
+};
+
+struct MacroProgram
+{
+    std::vector<MacroInstruction> code;
+    std::vector<KeyChord> chords;
+    std::vector<std::u16string> texts;
+    std::vector<std::string> volumeGroups;
+};
+
+/**
+ * @brief Validates and compiles a "macro" array from binds.json.
+ * @param steps The JSON array of steps.
+ * @param program Receives the compiled macro.
+ * @param error Receives a description of the first invalid step on failure.
+ * @return True on success.
+ */
+bool CompileMacro(const json &steps, MacroProgram &program, std::string &error);
+
+/**
+ * @brief Converts UTF-8 to UTF-16 code units. Invalid sequences become U+FFFD.
+ */
+std::u16string Utf8ToUtf16(const std::string &text);
+
+#endif // MACRO_H
@@ -0,0 +1,280 @@
+#include "macro_scheduler.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace
+{
+    // Sleep until this long before a deadline, then spin
+    constexpr auto SPIN_WINDOW = std::chrono::microseconds(1500);
+
+    // Room for the largest text step (down + up per code unit) plus chords
+    constexpr size_t BATCH_CAPACITY = MACRO_MAX_TEXT_LENGTH * 2 + 256;
+}
+
+MacroScheduler::MacroScheduler(IInputInjector &injector, VolumeHandler setVolume, std::chrono::milliseconds defaultHold)
+    : m_injector(injector), m_setVolume(std::move(setVolume)), m_defaultHold(defaultHold)
+{
+    m_batch.reserve(BATCH_CAPACITY);
+}
+
+MacroScheduler::~MacroScheduler()
+{
+    Stop();
+}
+
+void MacroScheduler::Start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    // 1 ms timer resolution so the coarse sleep lands inside the spin window
+    timeBeginPeriod(1);
+#endif
+    m_thread = std::thread(&MacroScheduler::Run, this);
+}
+
+void MacroScheduler::Stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeRequested = true;
+    }
+    m_wake.notify_one();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+bool MacroScheduler::Trigger(std::shared_ptr<const MacroProgram> program)
+{
+    if (!program || program->code.empty() || !m_triggers.TryPush(program))
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeRequested = true;
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void MacroScheduler::Append(const KeyInput &input)
+{
+    if (m_batch.size() == BATCH_CAPACITY)
+    {
+        Flush();
+    }
+    m_batch.push_back(input);
+}
+
+void MacroScheduler::AppendChord(const KeyChord &chord, bool keyUp)
+{
+    for (int n = 0; n < chord.count; ++n)
+    {
+        // Press in order, release in reverse order
+        const int i = keyUp ? chord.count - 1 - n : n;
+        KeyInput input;
+        input.keyCode = chord.keys[i];
+        input.keyUp = keyUp;
+        input.extended = ((chord.extendedMask >> i) & 1) != 0;
+        Append(input);
+    }
+}
+
+void MacroScheduler::Flush()
+{
+    if (m_batch.empty())
+    {
+        return;
+    }
+
+    const unsigned int count = static_cast<unsigned int>(m_batch.size());
+    const unsigned int sent = m_injector.Send(m_batch.data(), count);
+    if (sent != count)
+    {
+        std::cerr << "MacroScheduler: injected " << sent << " of " << count << " key events" << std::endl;
+    }
+    m_batch.clear();
+}
+
+// Executes one instruction (or pending release); returns false once the macro is finished
+bool MacroScheduler::Step(RunningMacro &macro)
+{
+    if (macro.held)
+    {
+        AppendChord(*macro.held, true);
+        macro.held = nullptr;
+        return true;
+    }
+
+    const MacroProgram &program = *macro.program;
+    if (macro.pc >= program.code.size())
+    {
+        return false;
+    }
+
+    const MacroInstruction &instruction = program.code[macro.pc++];
+    switch (instruction.op)
+    {
+    case MacroOp::Chord:
+    {
+        const KeyChord &chord = program.chords[instruction.operand];
+        AppendChord(chord, false);
+        macro.held = &chord;
+        macro.dueAt += chord.holdMs > 0 ? std::chrono::milliseconds(chord.holdMs) : m_defaultHold;
+        break;
+    }
+    case MacroOp::Text:
+        for (char16_t unit : program.texts[instruction.operand])
+        {
+            KeyInput input;
+            input.keyCode = static_cast<uint16_t>(unit);
+            input.unicode = true;
+            Append(input);
+            input.keyUp = true;
+            Append(input);
+        }
+        break;
+    case MacroOp::Delay:
+        macro.dueAt += std::chrono::microseconds(instruction.operand);
+        break;
+    case MacroOp::Volume:
+        if (m_setVolume)
+        {
+            m_setVolume(program.volumeGroups[instruction.operand], instruction.level);
+        }
+        break;
+    }
+    return true;
+}
+
+MacroScheduler::Clock::time_point MacroScheduler::RunDue(Clock::time_point now)
+{
+    // Start newly triggered macros
+    std::shared_ptr<const MacroProgram> program;
+    while (m_triggers.TryPop(program))
+    {
+        bool alreadyRunning = false;
+        for (size_t i = 0; i < m_runningCount && !alreadyRunning; ++i)
+        {
+            alreadyRunning = m_macros[i].program == program;
+        }
+
+        if (alreadyRunning)
+        {
+            std::cerr << "MacroScheduler: macro already running, trigger ignored" << std::endl;
+        }
+        else if (m_runningCount == MAX_RUNNING)
+        {
+            std::cerr << "MacroScheduler: too many running macros, trigger dropped" << std::endl;
+        }
+        else
+        {
+            RunningMacro &macro = m_macros[m_runningCount++];
+            macro.program = std::move(program);
+            macro.pc = 0;
+            macro.dueAt = now;
+            macro.held = nullptr;
+        }
+        program.reset();
+    }
+
+    // Execute everything that is due; finished macros are compacted out
+    Clock::time_point next = Clock::time_point::max();
+    size_t kept = 0;
+    for (size_t i = 0; i < m_runningCount; ++i)
+    {
+        RunningMacro &macro = m_macros[i];
+        bool alive = true;
+        while (alive && macro.dueAt <= now)
+        {
+            alive = Step(macro);
+        }
+
+        if (alive)
+        {
+            next = macro.dueAt < next ? macro.dueAt : next;
+            if (kept != i)
+            {
+                m_macros[kept] = std::move(macro);
+            }
+            ++kept;
+        }
+    }
+    for (size_t i = kept; i < m_runningCount; ++i)
+    {
+        m_macros[i] = RunningMacro();
+    }
+    m_runningCount = kept;
+
+    Flush();
+    return next;
+}
+
+void MacroScheduler::AbortAll()
+{
+    for (size_t i = 0; i < m_runningCount; ++i)
+    {
+        if (m_macros[i].held)
+        {
+            AppendChord(*m_macros[i].held, true);
+        }
+        m_macros[i] = RunningMacro();
+    }
+    m_runningCount = 0;
+    Flush();
+}
+
+void MacroScheduler::Run()
+{
+    while (m_running.load())
+    {
+        const Clock::time_point next = RunDue(Clock::now());
+
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            auto woken = [this]()
+            { return m_wakeRequested.load(); };
+            if (next == Clock::time_point::max())
+            {
+                m_wake.wait(lock, woken);
+            }
+            else if (Clock::now() < next - SPIN_WINDOW)
+            {
+                m_wake.wait_until(lock, next - SPIN_WINDOW, woken);
+            }
+        }
+
+        // Spin the last stretch; a new trigger ends the spin early
+        while (next != Clock::time_point::max() && !m_wakeRequested.load() && Clock::now() < next)
+        {
+            std::this_thread::yield();
+        }
+        m_wakeRequested = false;
+    }
+
+    // Never leave keys stuck down
+    AbortAll();
+}
@@ -0,0 +1,111 @@
+#ifndef MACRO_SCHEDULER_H
+#define MACRO_SCHEDULER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "input_injector.h"
+#include "macro.h"
+
+/**
+ * @brief Runs compiled macros on a dedicated timer thread.
+ *
+ * Several macros run at once, each with its own program counter and deadline;
+ * a long delay in one never holds up another, and the control thread only
+ * pushes a trigger onto a lock-free queue. Step deadlines are derived from the
+ * previous deadline rather than from the wakeup time, so jitter does not
+ * accumulate, and the thread sleeps until just before a deadline and spins
+ * the remainder for sub-millisecond accuracy.
+ *
+ * RunDue() is the whole scheduling step and takes the current time as an
+ * argument, so tests can drive it with a simulated clock and a
+ * RecordingInputInjector without starting the thread.
+ */
+class MacroScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using VolumeHandler = std::function<void(const std::string &group, float level)>;
+
+    static constexpr size_t MAX_RUNNING = 16;
+
+    /**
+     * @param injector Receives key and text events.
+     * @param setVolume Handles volume steps; called on the scheduler thread, so it must not block.
+     * @param defaultHold Key-down to key-up time for chords without "holdMs".
+     */
+    MacroScheduler(IInputInjector &injector, VolumeHandler setVolume,
+                   std::chrono::milliseconds defaultHold = std::chrono::milliseconds(50));
+    ~MacroScheduler();
+
+    MacroScheduler(const MacroScheduler &) = delete;
+    MacroScheduler &operator=(const MacroScheduler &) = delete;
+
+    void Start();
+
+    /**
+     * @brief Releases keys held by running macros, abandons them and joins the thread.
+     */
+    void Stop();
+
+    /**
+     * @brief Starts a macro. Never blocks. A macro that is already running is not restarted.
+     * @return False if the trigger queue is full.
+     */
+    bool Trigger(std::shared_ptr<const MacroProgram> program);
+
+    /**
+     * @brief Starts triggered macros and executes every step due at or before now.
+     * @return The earliest pending deadline, or Clock::time_point::max() if nothing runs.
+     */
+    Clock::time_point RunDue(Clock::time_point now);
+
+    /**
+     * @brief Releases the keys of every running macro and drops them.
+     */
+    void AbortAll();
+
+    size_t RunningCount() const { return m_runningCount; }
+
+private:
+    struct RunningMacro
+    {
+        std::shared_ptr<const MacroProgram> program;
+        size_t pc = 0;                    // Next instruction
+        Clock::time_point dueAt;          // When the next instruction (or release) is due
+        const KeyChord *held = nullptr;   // Chord pressed and waiting for its release
+    };
+
+    void Run();
+    bool Step(RunningMacro &macro);
+    void Append(const KeyInput &input);
+    void AppendChord(const KeyChord &chord, bool keyUp);
+    void Flush();
+
+    IInputInjector &m_injector;
+    VolumeHandler m_setVolume;
+    std::chrono::milliseconds m_defaultHold;
+
+    BoundedQueue<std::shared_ptr<const MacroProgram>, 32> m_triggers;
+
+    // Owned by the scheduler thread (or the test driving RunDue)
+    std::array<RunningMacro, MAX_RUNNING> m_macros;
+    size_t m_runningCount = 0;
+    std::vector<KeyInput> m_batch; // Preallocated, events of one RunDue call
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_wakeRequested{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+};
+
+#endif // MACRO_SCHEDULER_H
@@ -0,0 +1,300 @@
+#include "metrics.h"
+
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+const uint64_t MetricHistogram::BOUNDS_NS[MetricHistogram::BOUND_COUNT] = {
+    100000ULL,     // 100 us
+    250000ULL,     // 250 us
+    500000ULL,     // 500 us
+    1000000ULL,    // 1 ms
+    2500000ULL,    // 2.5 ms
+    5000000ULL,    // 5 ms
+    10000000ULL,   // 10 ms
+    25000000ULL,   // 25 ms
+    50000000ULL,   // 50 ms
+    100000000ULL,  // 100 ms
+    250000000ULL,  // 250 ms
+    500000000ULL,  // 500 ms
+    1000000000ULL, // 1 s
+    2500000000ULL, // 2.5 s
+};
+
+MetricHistogram::MetricHistogram()
+    : m_sumNs(0)
+{
+    for (auto &bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::ObserveNs(uint64_t nanoseconds)
+{
+    int index = 0;
+    while (index < BOUND_COUNT && nanoseconds > BOUNDS_NS[index])
+    {
+        ++index;
+    }
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+namespace
+{
+    enum class MetricType
+    {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    struct MetricSeries
+    {
+        std::string labelValue;
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    struct MetricFamily
+    {
+        std::string name;
+        std::string help;
+        std::string labelName;
+        MetricType type;
+        std::vector<std::unique_ptr<MetricSeries>> series;
+    };
+
+    std::mutex g_registry_mutex;
+    std::vector<std::unique_ptr<MetricFamily>> g_families; // Registration order = output order
+
+    MetricSeries &RegisterSeries(const std::string &name, const std::string &help, MetricType type,
+                                 const std::string &labelName, const std::string &labelValue)
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+
+        MetricFamily *family = nullptr;
+        for (auto &existing : g_families)
+        {
+            if (existing->name == name)
+            {
+                family = existing.get();
+                break;
+            }
+        }
+        if (!family)
+        {
+            g_families.push_back(std::make_unique<MetricFamily>(MetricFamily{name, help, labelName, type, {}}));
+            family = g_families.back().get();
+        }
+
+        for (auto &series : family->series)
+        {
+            if (series->labelValue == labelValue)
+            {
+                return *series;
+            }
+        }
+
+        auto series = std::make_unique<MetricSeries>();
+        series->labelValue = labelValue;
+        switch (type)
+        {
+        case MetricType::Counter:
+            series->counter = std::make_unique<MetricCounter>();
+            break;
+        case MetricType::Gauge:
+            series->gauge = std::make_unique<MetricGauge>();
+            break;
+        case MetricType::Histogram:
+            series->histogram = std::make_unique<MetricHistogram>();
+            break;
+        }
+        family->series.push_back(std::move(series));
+        return *family->series.back();
+    }
+
+    std::string EscapeLabelValue(const std::string &value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value)
+        {
+            if (c == '\\' || c == '"')
+            {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if (c == '\n')
+            {
+                escaped += "\\n";
+            }
+            else
+            {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    // Builds "{label="value"}" (plus an optional extra label such as le="0.5")
+    std::string FormatLabels(const MetricFamily &family, const MetricSeries &series, const std::string &extra = "")
+    {
+        std::string labels;
+        if (!family.labelName.empty())
+        {
+            labels = family.labelName + "=\"" + EscapeLabelValue(series.labelValue) + "\"";
+        }
+        if (!extra.empty())
+        {
+            labels += labels.empty() ? extra : "," + extra;
+        }
+        return labels.empty() ? "" : "{" + labels + "}";
+    }
+
+    // HTTP route table: filled by RegisterHttpRoutes before the server starts, read-only afterwards
+    struct RouteMetrics
+    {
+        MetricCounter *requests;
+        MetricHistogram *duration;
+    };
+    std::unordered_map<std::string, RouteMetrics> g_route_metrics;
+    RouteMetrics g_other_route_metrics = {nullptr, nullptr};
+
+    RouteMetrics RegisterRoute(const std::string &route)
+    {
+        return {&RegisterCounter("streamdeck_http_requests_total", "HTTP requests handled, by route.", "route", route),
+                &RegisterHistogram("streamdeck_http_request_duration_seconds", "HTTP request handling latency, by route.", "route", route)};
+    }
+}
+
+MetricCounter &RegisterCounter(const std::string &name, const std::string &help,
+                               const std::string &labelName, const std::string &labelValue)
+{
+    return *RegisterSeries(name, help, MetricType::Counter, labelName, labelValue).counter;
+}
+
+MetricGauge &RegisterGauge(const std::string &name, const std::string &help,
+                           const std::string &labelName, const std::string &labelValue)
+{
+    return *RegisterSeries(name, help, MetricType::Gauge, labelName, labelValue).gauge;
+}
+
+MetricHistogram &RegisterHistogram(const std::string &name, const std::string &help,
+                                   const std::string &labelName, const std::string &labelValue)
+{
+    return *RegisterSeries(name, help, MetricType::Histogram, labelName, labelValue).histogram;
+}
+
+std::string RenderPrometheusMetrics()
+{
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+
+    for (const auto &family : g_families)
+    {
+        const char *typeName = family->type == MetricType::Counter ? "counter"
+                               : family->type == MetricType::Gauge ? "gauge"
+                                                                   : "histogram";
+        out << "# HELP " << family->name << " " << family->help << "\n";
+        out << "# TYPE " << family->name << " " << typeName << "\n";
+
+        for (const auto &series : family->series)
+        {
+            switch (family->type)
+            {
+            case MetricType::Counter:
+                out << family->name << FormatLabels(*family, *series) << " " << series->counter->Value() << "\n";
+                break;
+            case MetricType::Gauge:
+                out << family->name << FormatLabels(*family, *series) << " " << series->gauge->Value() << "\n";
+                break;
+            case MetricType::Histogram:
+            {
+                const MetricHistogram &histogram = *series->histogram;
+                uint64_t cumulative = 0;
+                for (int i = 0; i <= MetricHistogram::BOUND_COUNT; ++i)
+                {
+                    cumulative += histogram.BucketCount(i);
+                    std::ostringstream le;
+                    if (i < MetricHistogram::BOUND_COUNT)
+                    {
+                        le << "le=\"" << MetricHistogram::BOUNDS_NS[i] / 1e9 << "\"";
+                    }
+                    else
+                    {
+                        le << "le=\"+Inf\"";
+                    }
+                    out << family->name << "_bucket" << FormatLabels(*family, *series, le.str()) << " " << cumulative << "\n";
+                }
+                out << family->name << "_sum" << FormatLabels(*family, *series) << " " << histogram.SumNs() / 1e9 << "\n";
+                out << family->name << "_count" << FormatLabels(*family, *series) << " " << cumulative << "\n";
+                break;
+            }
+            }
+        }
+    }
+    return out.str();
+}
+
+AppMetrics &Metrics()
+{
+    static AppMetrics metrics = {
+        RegisterCounter("streamdeck_serial_frames_received_total", "Serial lines received from the controller."),
+        RegisterCounter("streamdeck_serial_frames_dropped_total", "Decoded frames superseded before the control thread consumed them."),
+        RegisterCounter("streamdeck_serial_frames_malformed_total", "Serial lines that failed to decode."),
+        RegisterCounter("streamdeck_serial_reconnects_total", "Times the serial port was reopened after the first connection."),
+        RegisterGauge("streamdeck_serial_connected", "1 while the serial port is open."),
+
+        RegisterCounter("streamdeck_volume_writes_total", "SetMasterVolume calls issued."),
+        RegisterCounter("streamdeck_volume_writes_skipped_total", "Volume writes skipped because no usable session matched."),
+        RegisterHistogram("streamdeck_com_call_duration_seconds", "Time spent in WASAPI volume COM calls."),
+
+        RegisterCounter("streamdeck_session_refresh_total", "Audio session table refreshes."),
+        RegisterCounter("streamdeck_session_refresh_shared_total", "Refresh requests that joined one already running."),
+        RegisterHistogram("streamdeck_session_refresh_duration_seconds", "Duration of audio session table refreshes."),
+        RegisterGauge("streamdeck_audio_sessions", "Audio sessions in the session table."),
+        RegisterCounter("streamdeck_new_session_volumes_total", "New audio sessions given their group's volume on creation."),
+        RegisterCounter("streamdeck_expired_sessions_total", "Audio sessions dropped from the table when they expired or were disconnected."),
+        RegisterCounter("streamdeck_process_lookups_total", "Process table snapshots taken to resolve session processes."),
+        RegisterCounter("streamdeck_meter_samples_total", "Peak meter passes over the session table (only while someone listens)."),
+        RegisterCounter("streamdeck_duck_writes_total", "Group volume writes issued by ducking envelopes."),
+
+        RegisterCounter("streamdeck_input_injections_total", "Injected key presses, by kind.", "kind", "hotkey"),
+        RegisterCounter("streamdeck_input_injections_total", "Injected key presses, by kind.", "kind", "media"),
+        RegisterCounter("streamdeck_macro_triggers_total", "Macros started from button presses."),
+        RegisterCounter("streamdeck_profile_switches_total", "Active profile changes."),
+
+        RegisterCounter("streamdeck_settings_writes_total", "config.json / binds.json writes (after debouncing)."),
+        RegisterCounter("streamdeck_settings_write_failures_total", "Settings writes that failed and were retried."),
+
+        RegisterCounter("streamdeck_response_cache_hits_total", "API responses served from an already serialized body."),
+        RegisterCounter("streamdeck_response_cache_misses_total", "API responses that had to be serialized."),
+        RegisterCounter("streamdeck_http_not_modified_total", "Conditional API requests answered with 304."),
+    };
+    return metrics;
+}
+
+void RegisterHttpRoutes(const std::vector<std::string> &routes)
+{
+    for (const auto &route : routes)
+    {
+        g_route_metrics.emplace(route, RegisterRoute(route));
+    }
+    g_other_route_metrics = RegisterRoute("other");
+}
+
+void RecordHttpRequest(const std::string &route, uint64_t durationNs)
+{
+    auto it = g_route_metrics.find(route);
+    const RouteMetrics &metrics = it != g_route_metrics.end() ? it->second : g_other_route_metrics;
+    if (!metrics.requests)
+    {
+        return; // Routes not registered yet
+    }
+    metrics.requests->Increment();
+    metrics.duration->ObserveNs(durationNs);
+}
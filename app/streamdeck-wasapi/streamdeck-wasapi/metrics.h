@@ -0,0 +1,126 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Runtime metrics rendered in the Prometheus text exposition format (GET /metrics).
+//
+// Metrics are registered once (registration takes a lock) and then updated from
+// any thread with relaxed atomics only, so they are safe to touch on the hot path.
+
+class MetricCounter
+{
+public:
+    void Increment(uint64_t amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+class MetricGauge
+{
+public:
+    void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(int64_t amount) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    int64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+/**
+ * @brief Fixed-bucket duration histogram. Observations are nanoseconds and are
+ * exposed in seconds. Observe() costs one bucket increment plus one sum increment.
+ */
+class MetricHistogram
+{
+public:
+    MetricHistogram();
+
+    void ObserveNs(uint64_t nanoseconds);
+
+    static constexpr int BOUND_COUNT = 14;
+    static const uint64_t BOUNDS_NS[BOUND_COUNT]; // Upper bounds; the last bucket is +Inf
+
+    uint64_t BucketCount(int index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    uint64_t SumNs() const { return m_sumNs.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_buckets[BOUND_COUNT + 1];
+    std::atomic<uint64_t> m_sumNs;
+};
+
+/**
+ * @brief Registers (or returns the already registered) metric. Names follow the
+ * Prometheus conventions; an optional single label distinguishes series of one family.
+ * Returned references stay valid for the lifetime of the process.
+ */
+MetricCounter &RegisterCounter(const std::string &name, const std::string &help,
+                               const std::string &labelName = "", const std::string &labelValue = "");
+MetricGauge &RegisterGauge(const std::string &name, const std::string &help,
+                           const std::string &labelName = "", const std::string &labelValue = "");
+MetricHistogram &RegisterHistogram(const std::string &name, const std::string &help,
+                                   const std::string &labelName = "", const std::string &labelValue = "");
+
+/**
+ * @brief Renders every registered metric in the Prometheus text format (version 0.0.4).
+ */
+std::string RenderPrometheusMetrics();
+
+// --- Application metrics used across the control path ---
+struct AppMetrics
+{
+    MetricCounter &framesReceived;
+    MetricCounter &framesDropped;
+    MetricCounter &framesMalformed;
+    MetricCounter &serialReconnects;
+    MetricGauge &serialConnected;
+
+    MetricCounter &volumeWritesIssued;
+    MetricCounter &volumeWritesSkipped;
+    MetricHistogram &comCallDuration;
+
+    MetricCounter &sessionRefreshes;
+    MetricCounter &sessionRefreshesShared;
+    MetricHistogram &sessionRefreshDuration;
+    MetricGauge &audioSessions;
+    MetricCounter &newSessionVolumes;
+    MetricCounter &expiredSessions;
+    MetricCounter &processLookups;
+    MetricCounter &meterSamples;
+    MetricCounter &duckWrites;
+
+    MetricCounter &hotkeyInjections;
+    MetricCounter &mediaKeyInjections;
+    MetricCounter &macroTriggers;
+    MetricCounter &profileSwitches;
+
+    MetricCounter &settingsWrites;
+    MetricCounter &settingsWriteFailures;
+
+    MetricCounter &responseCacheHits;
+    MetricCounter &responseCacheMisses;
+    MetricCounter &httpNotModified;
+};
+
+/**
+ * @brief The application's metric set, registered on first use.
+ */
+AppMetrics &Metrics();
+
+/**
+ * @brief Pre-registers per-route HTTP metrics. Must be called before the server
+ * starts handling requests; the route table is read-only afterwards.
+ */
+void RegisterHttpRoutes(const std::vector<std::string> &routes);
+
+/**
+ * @brief Counts one HTTP request and its latency. Unknown paths are reported as "other".
+ */
+void RecordHttpRequest(const std::string &route, uint64_t durationNs);
+
+#endif // METRICS_H
@@ -0,0 +1,107 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief Unbounded lock-free multi-producer / single-consumer queue
+ * (Dmitry Vyukov's intrusive node queue with a stub node).
+ *
+ * Push() may be called from any thread and never blocks (one atomic exchange).
+ * TryPop() must only be called from the single consumer thread. It can briefly
+ * report "empty" while a producer is between its two steps; the consumer simply
+ * sees that item on its next pop, so callers should pair the queue with a wakeup.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_head(&m_stub), m_tail(&m_stub)
+    {
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue()
+    {
+        T discarded;
+        while (TryPop(discarded))
+        {
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void Push(T value)
+    {
+        Node *node = new Node(std::move(value));
+        PushNode(node);
+    }
+
+    bool TryPop(T &out)
+    {
+        Node *tail = m_tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub)
+        {
+            if (!next)
+            {
+                return false;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next)
+        {
+            m_tail = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+
+        if (tail != m_head.load(std::memory_order_acquire))
+        {
+            return false; // A producer is mid-push; the item will be visible shortly
+        }
+
+        // tail is the last real node: re-insert the stub behind it so it can be detached
+        PushNode(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            m_tail = next;
+            out = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Node
+    {
+        Node() = default;
+        explicit Node(T &&item) : value(std::move(item)) {}
+
+        std::atomic<Node *> next{nullptr};
+        T value{};
+    };
+
+    void PushNode(Node *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    Node m_stub;
+    std::atomic<Node *> m_head; // Producers append here
+    Node *m_tail;               // Consumer pops from here
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,217 @@
+#include "name_table.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace
+{
+    const char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+    void AppendUtf8(std::string &out, char32_t c)
+    {
+        if (c < 0x80)
+        {
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    void AppendWide(std::wstring &out, char32_t c)
+    {
+        if (sizeof(wchar_t) == 2 && c >= 0x10000)
+        {
+            c -= 0x10000;
+            out += static_cast<wchar_t>(0xD800 + (c >> 10));
+            out += static_cast<wchar_t>(0xDC00 + (c & 0x3FF));
+        }
+        else
+        {
+            out += static_cast<wchar_t>(c);
+        }
+    }
+}
+
+std::string NormalizeAppName(const std::string &name)
+{
+    std::string normalized = name;
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+
+    const std::string suffix = ".exe";
+    if (normalized.size() > suffix.size() &&
+        normalized.compare(normalized.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+        normalized.resize(normalized.size() - suffix.size());
+    }
+    return normalized;
+}
+
+std::string WideToUtf8(const std::wstring &value)
+{
+    std::string out;
+    out.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        char32_t c = static_cast<char32_t>(value[i]);
+        if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDFFF)
+        {
+            // Surrogate pair; a lone surrogate cannot be encoded
+            const char32_t low = i + 1 < value.size() ? static_cast<char32_t>(value[i + 1]) : 0;
+            if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+            {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+            else
+            {
+                c = REPLACEMENT_CHARACTER;
+            }
+        }
+        else if (c > 0x10FFFF)
+        {
+            c = REPLACEMENT_CHARACTER;
+        }
+        AppendUtf8(out, c);
+    }
+    return out;
+}
+
+std::wstring Utf8ToWide(const std::string &value)
+{
+    std::wstring out;
+    out.reserve(value.size());
+    size_t i = 0;
+    while (i < value.size())
+    {
+        const unsigned char lead = static_cast<unsigned char>(value[i]);
+        size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        char32_t c = length == 1 ? lead : length == 2 ? (lead & 0x1F) : length == 3 ? (lead & 0x0F) : (lead & 0x07);
+
+        bool valid = length != 0 && i + length <= value.size();
+        for (size_t k = 1; valid && k < length; ++k)
+        {
+            const unsigned char next = static_cast<unsigned char>(value[i + k]);
+            valid = (next & 0xC0) == 0x80;
+            c = (c << 6) | (next & 0x3F);
+        }
+        if (!valid)
+        {
+            AppendWide(out, REPLACEMENT_CHARACTER);
+            ++i;
+            continue;
+        }
+        AppendWide(out, c > 0x10FFFF ? REPLACEMENT_CHARACTER : c);
+        i += length;
+    }
+    return out;
+}
+
+NameTable::NameTable()
+{
+    Add(std::string(), std::string(), std::wstring()); // NO_NAME
+}
+
+NameId NameTable::Intern(const std::string &utf8)
+{
+    if (utf8.empty())
+    {
+        return NO_NAME;
+    }
+
+    std::string key = NormalizeAppName(utf8);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_ids.find(key);
+        if (found != m_ids.end())
+        {
+            return found->second;
+        }
+    }
+    return Add(std::move(key), utf8, Utf8ToWide(utf8));
+}
+
+NameId NameTable::Intern(const std::wstring &wide)
+{
+    if (wide.empty())
+    {
+        return NO_NAME;
+    }
+
+    std::string utf8 = WideToUtf8(wide);
+    std::string key = NormalizeAppName(utf8);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_ids.find(key);
+        if (found != m_ids.end())
+        {
+            return found->second;
+        }
+    }
+    return Add(std::move(key), std::move(utf8), wide);
+}
+
+NameId NameTable::Find(const std::string &utf8) const
+{
+    const std::string key = NormalizeAppName(utf8);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_ids.find(key);
+    return found == m_ids.end() ? NO_NAME : found->second;
+}
+
+NameId NameTable::Add(std::string key, std::string utf8, std::wstring wide)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread may have added it since the caller looked
+    auto found = m_ids.find(key);
+    if (found != m_ids.end())
+    {
+        return found->second;
+    }
+
+    const size_t id = m_size.load(std::memory_order_relaxed);
+    if (id >= CHUNK_SIZE * MAX_CHUNKS)
+    {
+        std::cerr << "App name table is full, not interning '" << utf8 << "'" << std::endl;
+        return NO_NAME;
+    }
+
+    auto &chunk = m_chunks[id / CHUNK_SIZE];
+    if (!chunk)
+    {
+        chunk.reset(new Entry[CHUNK_SIZE]);
+    }
+    Entry &entry = chunk[id % CHUNK_SIZE];
+    entry.utf8 = std::move(utf8);
+    entry.wide = std::move(wide);
+    entry.key = key;
+    m_ids.emplace(std::move(key), static_cast<NameId>(id));
+
+    // Publishes the entry to lock-free readers
+    m_size.store(id + 1, std::memory_order_release);
+    return static_cast<NameId>(id);
+}
+
+NameTable &AppNames()
+{
+    static NameTable names;
+    return names;
+}
@@ -0,0 +1,95 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Interned application names.
+//
+// Every distinct app name (after case folding and dropping ".exe") gets a dense
+// integer ID the first time it is seen, together with its UTF-8 and UTF-16 forms.
+// Config groups, the session table, the process cache and the matchers all refer to
+// names by ID, so comparing two names is an integer compare and nothing converts or
+// lower-cases strings on the control path. IDs are never reused or removed.
+
+using NameId = uint32_t;
+
+// ID of the empty name; also returned for names that could not be interned
+const NameId NO_NAME = 0;
+
+/**
+ * @brief Lower-cases and drops a trailing ".exe", so "Spotify.exe" and "spotify" match.
+ */
+std::string NormalizeAppName(const std::string &name);
+
+/**
+ * @brief UTF-16 (or UTF-32 where wchar_t is 32 bits) to UTF-8. Invalid units become U+FFFD.
+ */
+std::string WideToUtf8(const std::wstring &value);
+
+/**
+ * @brief UTF-8 to UTF-16 (or UTF-32 where wchar_t is 32 bits). Invalid bytes become U+FFFD.
+ */
+std::wstring Utf8ToWide(const std::string &value);
+
+class NameTable
+{
+public:
+    NameTable();
+
+    NameTable(const NameTable &) = delete;
+    NameTable &operator=(const NameTable &) = delete;
+
+    /**
+     * @brief ID of a name, interning it if it is new. The first spelling seen is kept.
+     * @return NO_NAME for an empty name or if the table is full.
+     */
+    NameId Intern(const std::string &utf8);
+    NameId Intern(const std::wstring &wide);
+
+    /**
+     * @brief ID of an already interned name, or NO_NAME.
+     */
+    NameId Find(const std::string &utf8) const;
+
+    // Lock-free: entries never change once their ID has been handed out
+    const std::string &Utf8(NameId id) const { return At(id).utf8; }
+    const std::wstring &Wide(NameId id) const { return At(id).wide; }
+    const std::string &Key(NameId id) const { return At(id).key; } // Normalized form
+
+    size_t Size() const { return m_size.load(std::memory_order_acquire); }
+
+private:
+    static const size_t CHUNK_SIZE = 256;
+    static const size_t MAX_CHUNKS = 256;
+
+    struct Entry
+    {
+        std::string utf8;
+        std::wstring wide;
+        std::string key;
+    };
+
+    const Entry &At(NameId id) const
+    {
+        return id < Size() ? m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE] : m_chunks[0][NO_NAME];
+    }
+
+    NameId Add(std::string key, std::string utf8, std::wstring wide);
+
+    mutable std::mutex m_mutex;                     // Guards interning; reads by ID take no lock
+    std::unordered_map<std::string, NameId> m_ids;  // Normalized name -> ID
+    std::unique_ptr<Entry[]> m_chunks[MAX_CHUNKS];  // Allocated on demand, never moved
+    std::atomic<size_t> m_size{0};
+};
+
+/**
+ * @brief The process-wide app name table.
+ */
+NameTable &AppNames();
+
+#endif // NAME_TABLE_H
@@ -0,0 +1,151 @@
+#include "peak_meters.h"
+
+#include <algorithm>
+#include <cstdio>
+
+MeterSettings ReadMeterSettings(const json &config_data)
+{
+    MeterSettings settings;
+    if (!config_data.is_object() || !config_data.contains("meters") || !config_data["meters"].is_object())
+    {
+        return settings;
+    }
+
+    const json &meters = config_data["meters"];
+    if (meters.contains("rateHz") && meters["rateHz"].is_number() &&
+        meters["rateHz"].get<double>() >= 1 && meters["rateHz"].get<double>() <= 60)
+    {
+        settings.period = std::chrono::milliseconds(static_cast<int>(1000.0 / meters["rateHz"].get<double>() + 0.5));
+    }
+    return settings;
+}
+
+PeakMeters::PeakMeters(MeterSource &source)
+    : m_source(source)
+{
+}
+
+void PeakMeters::SetActivation(Activation activation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_activation = std::move(activation);
+    if (m_activation && !m_subscribers->empty())
+    {
+        m_activation(true);
+    }
+}
+
+uint64_t PeakMeters::Subscribe(Listener listener)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto list = std::make_shared<SubscriberList>(*m_subscribers);
+    const uint64_t id = m_nextId++;
+    list->push_back({id, std::move(listener)});
+    const bool first = list->size() == 1;
+    std::atomic_store(&m_subscribers, std::shared_ptr<const SubscriberList>(list));
+    if (first && m_activation)
+    {
+        m_activation(true);
+    }
+    return id;
+}
+
+void PeakMeters::Unsubscribe(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto list = std::make_shared<SubscriberList>(*m_subscribers);
+    list->erase(std::remove_if(list->begin(), list->end(), [id](const Subscriber &subscriber)
+                               { return subscriber.id == id; }),
+                list->end());
+    if (list->size() == m_subscribers->size())
+    {
+        return;
+    }
+    const bool last = list->empty();
+    std::atomic_store(&m_subscribers, std::shared_ptr<const SubscriberList>(list));
+    if (last && m_activation)
+    {
+        m_activation(false);
+    }
+}
+
+size_t PeakMeters::Subscribers() const
+{
+    return std::atomic_load(&m_subscribers)->size();
+}
+
+bool PeakMeters::Sample()
+{
+    // A listener that unsubscribes meanwhile still gets this frame; it holds the old list
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&m_subscribers);
+    if (subscribers->empty())
+    {
+        return false;
+    }
+
+    const size_t sessionCount = (std::min)(m_source.SessionCount(), MAX_METER_SESSIONS);
+    const size_t groupCount = (std::min)(m_source.GroupCount(), MAX_GROUPS);
+    ++m_frame.tick;
+    m_frame.sessionsVersion = m_source.SessionsVersion();
+    m_frame.sessionCount = static_cast<uint32_t>(sessionCount);
+    m_frame.groupCount = static_cast<uint32_t>(groupCount);
+    std::fill(m_frame.groups.begin(), m_frame.groups.begin() + groupCount, 0.0f);
+
+    for (size_t i = 0; i < sessionCount; ++i)
+    {
+        const float peak = (std::max)(0.0f, (std::min)(1.0f, m_source.Peak(i)));
+        m_frame.sessions[i] = peak;
+
+        const GroupMask &groups = m_source.Groups(i);
+        if (groups.none())
+        {
+            continue;
+        }
+        for (size_t group = 0; group < groupCount; ++group)
+        {
+            if (groups.test(group))
+            {
+                m_frame.groups[group] = (std::max)(m_frame.groups[group], peak);
+            }
+        }
+    }
+
+    for (const auto &subscriber : *subscribers)
+    {
+        subscriber.listener(m_frame);
+    }
+    return true;
+}
+
+namespace
+{
+    void AppendLevels(const float *levels, size_t count, std::string &out)
+    {
+        char number[16];
+        out += '[';
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (i > 0)
+            {
+                out += ',';
+            }
+            const int length = std::snprintf(number, sizeof(number), "%.3f", levels[i]);
+            out.append(number, static_cast<size_t>(length));
+        }
+        out += ']';
+    }
+}
+
+void EncodeMeterFrame(const MeterFrame &frame, std::string &out)
+{
+    out.clear();
+    out += "{\"tick\":";
+    out += std::to_string(frame.tick);
+    out += ",\"sessionsVersion\":";
+    out += std::to_string(frame.sessionsVersion);
+    out += ",\"sessions\":";
+    AppendLevels(frame.sessions.data(), frame.sessionCount, out);
+    out += ",\"groups\":";
+    AppendLevels(frame.groups.data(), frame.groupCount, out);
+    out += '}';
+}
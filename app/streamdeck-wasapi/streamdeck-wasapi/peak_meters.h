@@ -0,0 +1,155 @@
+#ifndef PEAK_METERS_H
+#define PEAK_METERS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "app_matcher.h"
+
+// Peak levels of the audio sessions and of the groups they belong to.
+//
+// The audio worker samples every session's meter in one pass per tick into one
+// fixed-size frame (the loudest member gives a group's level) and hands that frame
+// to each listener; nothing is allocated per sample. Listeners come and go from any
+// thread. When the last one leaves the activation hook stops the tick, so with
+// nobody listening no meter is read at all. The meters themselves come from a
+// MeterSource: IAudioMeterInformation on Windows, FakeMeterSource elsewhere.
+
+using json = nlohmann::json;
+
+const size_t MAX_METER_SESSIONS = 64; // Sessions past this index are not metered
+
+// One tick's levels, indexed like the session table and the group list of AppMatcher
+struct MeterFrame
+{
+    uint64_t tick = 0;            // Samples taken so far
+    uint64_t sessionsVersion = 0; // Session table version the indices belong to (as get-apps reports it)
+    uint32_t sessionCount = 0;
+    uint32_t groupCount = 0;
+    std::array<float, MAX_METER_SESSIONS> sessions{}; // Peak, 0..1
+    std::array<float, MAX_GROUPS> groups{};           // Loudest member's peak, 0..1
+};
+
+// Where the levels come from; called on the sampling thread only
+class MeterSource
+{
+public:
+    virtual ~MeterSource() = default;
+
+    virtual uint64_t SessionsVersion() const = 0;
+    virtual size_t SessionCount() const = 0;
+    virtual size_t GroupCount() const = 0;
+
+    /**
+     * @brief Current peak of a session, 0..1; 0 if it has no meter or the read failed.
+     */
+    virtual float Peak(size_t session) = 0;
+
+    /**
+     * @brief The groups a session belongs to.
+     */
+    virtual const GroupMask &Groups(size_t session) const = 0;
+};
+
+// Levels set by hand, for running the sampler without WASAPI
+class FakeMeterSource : public MeterSource
+{
+public:
+    std::vector<float> peaks;      // Per session
+    std::vector<GroupMask> groups; // Per session, same length as peaks
+    size_t groupCount = 0;
+    uint64_t version = 0;
+    uint64_t reads = 0; // Peak() calls so far
+
+    uint64_t SessionsVersion() const override { return version; }
+    size_t SessionCount() const override { return peaks.size(); }
+    size_t GroupCount() const override { return groupCount; }
+
+    float Peak(size_t session) override
+    {
+        ++reads;
+        return peaks[session];
+    }
+
+    const GroupMask &Groups(size_t session) const override { return groups[session]; }
+};
+
+struct MeterSettings
+{
+    std::chrono::milliseconds period{50}; // 20 samples a second
+};
+
+/**
+ * @brief Reads "meters": {"rateHz": 1..60} from config.json; defaults otherwise.
+ */
+MeterSettings ReadMeterSettings(const json &config_data);
+
+class PeakMeters
+{
+public:
+    using Listener = std::function<void(const MeterFrame &frame)>; // Called on the sampling thread
+    using Activation = std::function<void(bool sampling)>;
+
+    explicit PeakMeters(MeterSource &source);
+
+    PeakMeters(const PeakMeters &) = delete;
+    PeakMeters &operator=(const PeakMeters &) = delete;
+
+    /**
+     * @brief Called with true when the first listener arrives and false when the last
+     * one leaves, to start and stop the tick that calls Sample(). Runs under the
+     * listener lock, so it must only post work, never wait for the sampling thread.
+     * Set again while anyone listens, it is called with true at once (e.g. to restart
+     * the tick at a new rate).
+     */
+    void SetActivation(Activation activation);
+
+    /**
+     * @return Id for Unsubscribe.
+     */
+    uint64_t Subscribe(Listener listener);
+    void Unsubscribe(uint64_t id);
+    size_t Subscribers() const;
+
+    /**
+     * @brief Reads every meter once and passes the frame to each listener.
+     * @return False, without reading any meter, if nobody is listening.
+     */
+    bool Sample();
+
+    /**
+     * @brief The frame of the last Sample(); only valid on the sampling thread.
+     */
+    const MeterFrame &Frame() const { return m_frame; }
+
+private:
+    struct Subscriber
+    {
+        uint64_t id;
+        Listener listener;
+    };
+    using SubscriberList = std::vector<Subscriber>;
+
+    MeterSource &m_source;
+    MeterFrame m_frame; // Sampling thread only
+
+    mutable std::mutex m_mutex; // Serializes Subscribe/Unsubscribe and the activation calls
+    std::shared_ptr<const SubscriberList> m_subscribers = std::make_shared<const SubscriberList>(); // Swapped with std::atomic_load/atomic_store
+    uint64_t m_nextId = 1;
+    Activation m_activation;
+};
+
+/**
+ * @brief A frame as one text message:
+ * {"tick":N,"sessionsVersion":V,"sessions":[0.412,...],"groups":[0.8,...]}
+ * Levels have three decimals. The buffer is cleared first and its capacity reused.
+ */
+void EncodeMeterFrame(const MeterFrame &frame, std::string &out);
+
+#endif // PEAK_METERS_H
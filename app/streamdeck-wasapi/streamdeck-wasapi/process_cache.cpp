@@ -0,0 +1,143 @@
+#include "process_cache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winternl.h>
+#include <iostream>
+
+#pragma comment(lib, "ntdll.lib")
+
+namespace
+{
+    // Documented prefix of SYSTEM_PROCESS_INFORMATION; winternl.h hides the
+    // creation time and parent pid in reserved fields
+    struct ProcessInformation
+    {
+        ULONG NextEntryOffset;
+        ULONG NumberOfThreads;
+        LARGE_INTEGER WorkingSetPrivateSize;
+        ULONG HardFaultCount;
+        ULONG NumberOfThreadsHighWatermark;
+        ULONGLONG CycleTime;
+        LARGE_INTEGER CreateTime;
+        LARGE_INTEGER UserTime;
+        LARGE_INTEGER KernelTime;
+        UNICODE_STRING ImageName;
+        LONG BasePriority;
+        HANDLE UniqueProcessId;
+        HANDLE InheritedFromUniqueProcessId;
+    };
+
+    constexpr NTSTATUS STATUS_INFO_LENGTH_MISMATCH_CODE = static_cast<NTSTATUS>(0xC0000004L);
+}
+
+bool SystemProcessSource::Snapshot(std::vector<ProcessSnapshotEntry> &processes)
+{
+    if (m_buffer.empty())
+    {
+        m_buffer.resize(256 * 1024);
+    }
+
+    NTSTATUS status;
+    ULONG needed = 0;
+    while ((status = NtQuerySystemInformation(SystemProcessInformation, m_buffer.data(),
+                                              static_cast<ULONG>(m_buffer.size()), &needed)) == STATUS_INFO_LENGTH_MISMATCH_CODE)
+    {
+        // Processes may start between the two calls, so leave some headroom
+        m_buffer.resize((needed > m_buffer.size() ? needed : m_buffer.size()) + 64 * 1024);
+    }
+    if (!NT_SUCCESS(status))
+    {
+        std::cerr << "NtQuerySystemInformation(SystemProcessInformation) failed: " << std::hex << status << std::dec << std::endl;
+        return false;
+    }
+
+    processes.clear();
+    const unsigned char *entry = m_buffer.data();
+    while (true)
+    {
+        const auto *info = reinterpret_cast<const ProcessInformation *>(entry);
+        ProcessSnapshotEntry process;
+        process.pid = static_cast<uint32_t>(reinterpret_cast<ULONG_PTR>(info->UniqueProcessId));
+        process.parentPid = static_cast<uint32_t>(reinterpret_cast<ULONG_PTR>(info->InheritedFromUniqueProcessId));
+        process.createTime = static_cast<uint64_t>(info->CreateTime.QuadPart);
+        if (info->ImageName.Buffer)
+        {
+            process.exeName.assign(info->ImageName.Buffer, info->ImageName.Length / sizeof(WCHAR));
+        }
+        processes.push_back(std::move(process));
+
+        if (info->NextEntryOffset == 0)
+        {
+            break;
+        }
+        entry += info->NextEntryOffset;
+    }
+    return true;
+}
+#endif
+
+ProcessCache::ProcessCache(IProcessSource &source)
+    : m_source(source)
+{
+}
+
+bool ProcessCache::Refresh()
+{
+    ++m_snapshots;
+    if (!m_source.Snapshot(m_snapshot))
+    {
+        return false;
+    }
+
+    std::unordered_map<uint32_t, ProcessInfo> processes;
+    processes.reserve(m_snapshot.size());
+    for (auto &entry : m_snapshot)
+    {
+        auto cached = m_processes.find(entry.pid);
+        if (cached != m_processes.end() && cached->second.createTime == entry.createTime)
+        {
+            // Same process as last time: keep its interned name and display name
+            processes.emplace(entry.pid, std::move(cached->second));
+            continue;
+        }
+
+        // New process, or a new owner of a reused pid
+        ProcessInfo info;
+        info.pid = entry.pid;
+        info.parentPid = entry.parentPid;
+        info.createTime = entry.createTime;
+        info.exeName = std::move(entry.exeName);
+        info.exeId = AppNames().Intern(info.exeName);
+        processes.emplace(entry.pid, std::move(info));
+    }
+
+    // Whatever is not in the snapshot has exited
+    m_processes = std::move(processes);
+    return true;
+}
+
+const ProcessInfo *ProcessCache::Find(uint32_t pid) const
+{
+    auto found = m_processes.find(pid);
+    return found == m_processes.end() ? nullptr : &found->second;
+}
+
+const ProcessInfo *ProcessCache::Resolve(uint32_t pid)
+{
+    const ProcessInfo *info = Find(pid);
+    if (!info && Refresh())
+    {
+        info = Find(pid);
+    }
+    return info;
+}
+
+void ProcessCache::SetDisplayName(uint32_t pid, const std::wstring &displayName)
+{
+    auto found = m_processes.find(pid);
+    if (found != m_processes.end())
+    {
+        found->second.displayName = displayName;
+    }
+}
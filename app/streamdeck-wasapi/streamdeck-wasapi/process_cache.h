@@ -0,0 +1,118 @@
+#ifndef PROCESS_CACHE_H
+#define PROCESS_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "name_table.h"
+
+// Process metadata for audio sessions.
+//
+// One system-wide snapshot lists every process with its image name, parent and
+// creation time; no process is opened. Entries are keyed by (pid, creation time), so a reused pid never inherits the
+// previous owner's metadata, and they are evicted once the process is gone.
+
+struct ProcessSnapshotEntry
+{
+    uint32_t pid = 0;
+    uint32_t parentPid = 0;
+    uint64_t createTime = 0; // FILETIME ticks; with pid identifies a process uniquely
+    std::wstring exeName;    // Image file name ("Spotify.exe")
+};
+
+struct ProcessInfo
+{
+    uint32_t pid = 0;
+    uint32_t parentPid = 0;
+    uint64_t createTime = 0;
+    std::wstring exeName;
+    NameId exeId = NO_NAME;   // exeName interned once, when the process is first seen
+    std::wstring displayName; // Audio session display name, if the app sets one
+};
+
+class IProcessSource
+{
+public:
+    virtual ~IProcessSource() = default;
+
+    /**
+     * @brief Lists every running process in one call.
+     * @return False if the snapshot failed (the cache is left unchanged).
+     */
+    virtual bool Snapshot(std::vector<ProcessSnapshotEntry> &processes) = 0;
+};
+
+/**
+ * @brief Fake process table, edited by hand.
+ */
+class FakeProcessSource : public IProcessSource
+{
+public:
+    std::vector<ProcessSnapshotEntry> processes;
+    unsigned int snapshots = 0;
+
+    bool Snapshot(std::vector<ProcessSnapshotEntry> &out) override
+    {
+        ++snapshots;
+        out = processes;
+        return true;
+    }
+};
+
+#ifdef _WIN32
+/**
+ * @brief NtQuerySystemInformation(SystemProcessInformation) snapshot.
+ */
+class SystemProcessSource : public IProcessSource
+{
+public:
+    bool Snapshot(std::vector<ProcessSnapshotEntry> &processes) override;
+
+private:
+    std::vector<unsigned char> m_buffer; // Reused between snapshots
+};
+#endif
+
+/**
+ * @brief Cache of process metadata. Not thread-safe: owned by the audio worker.
+ */
+class ProcessCache
+{
+public:
+    explicit ProcessCache(IProcessSource &source);
+
+    /**
+     * @brief Takes one snapshot: new processes are added, exited ones evicted, reused
+     * pids replaced.
+     * @return False if the snapshot failed.
+     */
+    bool Refresh();
+
+    /**
+     * @brief Metadata of a process as of the last snapshot, or nullptr.
+     */
+    const ProcessInfo *Find(uint32_t pid) const;
+
+    /**
+     * @brief Like Find, but takes a new snapshot once if the pid is unknown (a process
+     * that started after the last snapshot).
+     */
+    const ProcessInfo *Resolve(uint32_t pid);
+
+    /**
+     * @brief Remembers the display name an audio session of this process reported.
+     */
+    void SetDisplayName(uint32_t pid, const std::wstring &displayName);
+
+    size_t Size() const { return m_processes.size(); }
+    uint64_t Snapshots() const { return m_snapshots; }
+
+private:
+    IProcessSource &m_source;
+    std::unordered_map<uint32_t, ProcessInfo> m_processes;
+    std::vector<ProcessSnapshotEntry> m_snapshot; // Reused between refreshes
+    uint64_t m_snapshots = 0;
+};
+
+#endif // PROCESS_CACHE_H
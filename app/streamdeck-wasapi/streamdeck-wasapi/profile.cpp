@@ -0,0 +1,155 @@
+#include "profile.h"
+
+#include <algorithm>
+#include <cctype>
+#include "control_model.h"
+
+namespace
+{
+    void Report(std::vector<std::string> *problems, const std::string &message)
+    {
+        if (problems)
+        {
+            problems->push_back(message);
+        }
+    }
+
+    std::vector<std::string> ReadSliderGroups(const std::string &profile_name, const json &profile,
+                                              const json &config_data, std::vector<std::string> *problems)
+    {
+        if (!profile.contains("sliders"))
+        {
+            return GetSliderGroupNames(config_data);
+        }
+
+        std::vector<std::string> sliderGroups;
+        const json &sliders = profile["sliders"];
+        if (!sliders.is_array())
+        {
+            Report(problems, "Profile '" + profile_name + "': \"sliders\" must be an array of group names");
+            return sliderGroups;
+        }
+
+        for (const auto &group : sliders)
+        {
+            std::string name = group.is_string() ? group.get<std::string>() : std::string();
+            if (!name.empty() && name != FOCUSED_APP_TARGET && FindGroupApps(config_data, name) == nullptr)
+            {
+                Report(problems, "Profile '" + profile_name + "': unknown group '" + name + "'");
+                name.clear();
+            }
+            sliderGroups.push_back(std::move(name));
+        }
+        return sliderGroups;
+    }
+}
+
+int ProfileSet::Find(const std::string &name) const
+{
+    for (size_t i = 0; i < profiles.size(); ++i)
+    {
+        if (profiles[i]->name == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int ProfileSet::FindForApp(NameId exe) const
+{
+    if (autoSwitch.empty())
+    {
+        return -1;
+    }
+    auto found = autoSwitch.find(exe);
+    return found == autoSwitch.end() ? -1 : static_cast<int>(found->second);
+}
+
+std::shared_ptr<const ProfileSet> CompileProfiles(const json &config_data, const json &binds_data,
+                                                  std::vector<std::string> *problems, uint64_t generation)
+{
+    auto set = std::make_shared<ProfileSet>();
+    set->generation = generation;
+    const json empty = json::object();
+    const json &config = config_data.is_object() ? config_data : empty;
+
+    const GestureTiming timing = ReadGestureTiming(config);
+    const json &defaultBindings = config.contains("buttonBindings") ? config["buttonBindings"] : empty;
+
+    // Names first, so profile switch bindings can refer to any profile by index
+    std::vector<std::string> names;
+    if (config.contains("profiles") && config["profiles"].is_object())
+    {
+        for (auto &[name, profile] : config["profiles"].items())
+        {
+            if (!profile.is_object())
+            {
+                Report(problems, "Profile '" + name + "' must be an object");
+                continue;
+            }
+            if (names.size() == MAX_PROFILES)
+            {
+                Report(problems, "Too many profiles (at most " + std::to_string(MAX_PROFILES) + "), ignoring '" + name + "'");
+                continue;
+            }
+            names.push_back(name);
+        }
+    }
+
+    if (names.empty())
+    {
+        auto profile = std::make_shared<ControlProfile>();
+        profile->name = "Default";
+        profile->sliderGroups = GetSliderGroupNames(config);
+        profile->buttons = CompileButtonActions(defaultBindings, timing, binds_data, {"Default"}, problems);
+        set->profiles.push_back(std::move(profile));
+        return set;
+    }
+
+    for (const auto &name : names)
+    {
+        const json &source = config["profiles"][name];
+        auto profile = std::make_shared<ControlProfile>();
+        profile->name = name;
+        profile->sliderGroups = ReadSliderGroups(name, source, config, problems);
+
+        std::vector<std::string> buttonProblems;
+        profile->buttons = CompileButtonActions(source.contains("buttonBindings") ? source["buttonBindings"] : defaultBindings,
+                                                timing, binds_data, names, &buttonProblems);
+        for (const auto &problem : buttonProblems)
+        {
+            Report(problems, "Profile '" + name + "': " + problem);
+        }
+        set->profiles.push_back(std::move(profile));
+    }
+
+    if (config.contains("autoSwitch") && config["autoSwitch"].is_object())
+    {
+        for (auto &[exe, target] : config["autoSwitch"].items())
+        {
+            const int index = target.is_string() ? set->Find(target.get<std::string>()) : -1;
+            if (index < 0)
+            {
+                Report(problems, "autoSwitch: '" + exe + "' refers to unknown profile " + target.dump());
+                continue;
+            }
+            set->autoSwitch[AppNames().Intern(exe)] = static_cast<size_t>(index);
+        }
+    }
+
+    if (config.contains("activeProfile") && config["activeProfile"].is_string())
+    {
+        const int index = set->Find(config["activeProfile"].get<std::string>());
+        if (index < 0)
+        {
+            Report(problems, "activeProfile: unknown profile '" + config["activeProfile"].get<std::string>() + "'");
+        }
+        else
+        {
+            set->initial = static_cast<size_t>(index);
+        }
+    }
+
+    return set;
+}
@@ -0,0 +1,73 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "json.hpp"
+#include "button_actions.h"
+#include "name_table.h"
+
+// Named control profiles ("layers"), each with its own slider and button maps.
+//
+//   "profiles": {
+//     "Gaming":  {"sliders": ["Game", "Voice", "Music"], "buttonBindings": {"button0": "Mute mic"}},
+//     "Meeting": {"sliders": ["Meeting", "", "Music"]}
+//   },
+//   "activeProfile": "Gaming",
+//   "autoSwitch": {"cs2.exe": "Gaming", "zoom.exe": "Meeting"}
+//
+// "sliders" lists the group of each slider ("" leaves a slider unused, "__focused__"
+// follows the foreground app); without it a profile uses the group order of "groups".
+// A profile without "buttonBindings" uses the top-level bindings. A config without
+// "profiles" is a single profile named "Default" built from the top-level maps.
+//
+// Every profile is compiled when the config is loaded, so switching is a single
+// atomic pointer store and the next frame already uses the new maps.
+
+using json = nlohmann::json;
+
+constexpr size_t MAX_PROFILES = 32;
+constexpr const char *FOCUSED_APP_TARGET = "__focused__"; // Slider target: the foreground application
+
+struct ControlProfile
+{
+    std::string name;
+    std::vector<std::string> sliderGroups;            // Slider i -> group name ("" = unused)
+    std::shared_ptr<const ButtonActionTable> buttons; // Never null
+};
+
+struct ProfileSet
+{
+    std::vector<std::shared_ptr<const ControlProfile>> profiles; // Never empty
+    std::unordered_map<NameId, size_t> autoSwitch;                // Interned executable name -> profile index
+    size_t initial = 0;                                           // "activeProfile", else the first profile
+    uint64_t generation = 0;                                      // Config generation compiled from (see config_store.h)
+
+    /**
+     * @brief Index of the profile with the given name, or -1.
+     */
+    int Find(const std::string &name) const;
+
+    /**
+     * @brief Index of the profile "autoSwitch" selects for a foreground executable, or -1.
+     * @param exe Interned executable name ("Zoom.exe", "zoom" and "ZOOM.EXE" share one ID).
+     */
+    int FindForApp(NameId exe) const;
+};
+
+/**
+ * @brief Compiles every profile of config.json against binds.json.
+ * @param config_data Parsed config.json object.
+ * @param binds_data Parsed binds.json array.
+ * @param problems Optional; receives one message per entry that could not be compiled.
+ * @param generation Config generation the documents belong to, recorded in the result.
+ * @return The compiled profiles (never null, at least one profile).
+ */
+std::shared_ptr<const ProfileSet> CompileProfiles(const json &config_data, const json &binds_data,
+                                                  std::vector<std::string> *problems = nullptr,
+                                                  uint64_t generation = 0);
+
+#endif // PROFILE_H
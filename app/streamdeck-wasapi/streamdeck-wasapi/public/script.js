@@ -50,14 +50,17 @@ document.addEventListener('DOMContentLoaded', () => {
     // --- Backend API URLs ---
     // IMPORTANT: Replace these with your actual C++ backend server URLs!
     const API_URLS = {
+        bootstrap: 'http://localhost:8080/api/bootstrap',    // GET: all initial state at once
         loadConfig: 'http://localhost:8080/api/load-config', // GET
         saveConfig: 'http://localhost:8080/api/save-config', // POST
+        patchConfig: 'http://localhost:8080/api/config',     // PATCH
         loadBinds: 'http://localhost:8080/api/load-binds',   // GET
         saveBinds: 'http://localhost:8080/api/save-binds',   // POST
-        fetchApps: 'http://localhost:8080/api/get-apps',     // POST or GET
+        fetchApps: 'http://localhost:8080/api/get-apps',     // GET (?refresh=1, ?since=&wait= long poll)
         getControllerState: 'http://localhost:8080/api/get-controller-state', // GET
         getComPorts: 'http://localhost:8080/api/get-com-ports', // GET
-        setComPort: 'http://localhost:8080/api/set-com-port'  // POST
+        setComPort: 'http://localhost:8080/api/set-com-port',  // POST
+        meters: 'ws://localhost:8080/api/meters'              // WebSocket: peak levels, one message per tick
     };
 
     // --- DOM Element References --- (Ensure these IDs match your HTML)
@@ -87,6 +90,7 @@ document.addEventListener('DOMContentLoaded', () => {
 
     // --- Drag & Drop State ---
     let draggedApp = null;
+    let sessionsVersion = null; // X-Sessions-Version of the app list on screen
 
     // --- Initialization ---
     async function initializeApp() {
@@ -101,18 +105,24 @@ document.addEventListener('DOMContentLoaded', () => {
         applyTheme();
         initialGroupCount = config.numContainers; // Set initial count based on prefs/defaults
 
-        // 3. Attempt to load data from backend, letting catch blocks overwrite defaults if successful
-        try {
-            console.log("Attempting to load config and bindings...");
-            await Promise.all([
-                loadConfigFromServer(), // Will try to overwrite config.groups/settings
-                loadBindsFromServer(),   // Will try to overwrite currentBindings
-                loadComPorts()          // Load available COM ports
-            ]);
-            console.log("Finished loading config and bindings attempts.");
-        } catch (error) {
-            console.error("Error during initial data loading phase (Promise.all):", error);
-            // Errors inside load functions are handled there, this catches issues with Promise.all itself
+        // 3. Load everything in one go: inlined in the page by the server, else one /api/bootstrap request
+        const bootstrap = await loadBootstrap();
+        if (bootstrap) {
+            applyBootstrap(bootstrap);
+        } else {
+            // Older server or failed request: load piece by piece, letting catch blocks overwrite defaults if successful
+            try {
+                console.log("Attempting to load config and bindings...");
+                await Promise.all([
+                    loadConfigFromServer(), // Will try to overwrite config.groups/settings
+                    loadBindsFromServer(),   // Will try to overwrite currentBindings
+                    loadComPorts()          // Load available COM ports
+                ]);
+                console.log("Finished loading config and bindings attempts.");
+            } catch (error) {
+                console.error("Error during initial data loading phase (Promise.all):", error);
+                // Errors inside load functions are handled there, this catches issues with Promise.all itself
+            }
         }
 
         // 4. Always initialize UI structure and add listeners using the current state (loaded or default)
@@ -125,23 +135,31 @@ document.addEventListener('DOMContentLoaded', () => {
             return; // Stop if basic UI/listeners fail
         }
 
-        // 5. Attempt to fetch initial app list
-        try {
-            await fetchApplicationsFromServer();
-        } catch (error) {
-            console.error("Error fetching initial applications:", error);
-            // Error display handled within fetchApplicationsFromServer's catch
+        // 5. Initial app list (already in the bootstrap state if there was one)
+        if (bootstrap && Array.isArray(bootstrap.apps)) {
+            displayApplications(bootstrap.apps, false, availableAppsListDiv);
+        } else {
+            try {
+                await fetchApplicationsFromServer();
+            } catch (error) {
+                console.error("Error fetching initial applications:", error);
+                // Error display handled within fetchApplicationsFromServer's catch
+            }
         }
-
-        // 6. Get initial controller state
-        try {
-            await fetchControllerState();
-        } catch (error) {
-            console.error("Error fetching controller state:", error);
+        watchApplications(); // Runs for the life of the page
+
+        // 6. Get initial controller state (likewise)
+        if (!bootstrap || !bootstrap.controllerState) {
+            try {
+                await fetchControllerState();
+            } catch (error) {
+                console.error("Error fetching controller state:", error);
+            }
         }
 
         // 7. Start controller state update interval
         startControllerStateUpdates();
+        watchMeters(); // Live peak level per group
 
         hideLoadingState();
         console.log("App Initialization attempt complete.");
@@ -165,7 +183,7 @@ document.addEventListener('DOMContentLoaded', () => {
     function addEventListeners() {
         console.log("Adding event listeners...");
         // Add checks to prevent errors if elements somehow aren't found
-        if (fetchAppsBtn) fetchAppsBtn.addEventListener('click', fetchApplicationsFromServer); else console.error("#fetch-apps-btn not found");
+        if (fetchAppsBtn) fetchAppsBtn.addEventListener('click', () => fetchApplicationsFromServer(true)); else console.error("#fetch-apps-btn not found");
         if (settingsBtn) settingsBtn.addEventListener('click', openSettingsModal); else console.error("#settings-btn not found");
         if (closeModalBtn) closeModalBtn.addEventListener('click', closeSettingsModal); else console.error("#modal-close-btn not found");
         if (settingsModal) settingsModal.addEventListener('click', (event) => { if (event.target === settingsModal) closeSettingsModal(); }); else console.error("#settings-modal not found");
@@ -288,18 +306,7 @@ document.addEventListener('DOMContentLoaded', () => {
                 }
             }
             else {
-                const loadedData = await response.json();
-                config.groups = (typeof loadedData.groups === 'object' && loadedData.groups !== null) ? loadedData.groups : {};
-                config.settings = (typeof loadedData.settings === 'object' && loadedData.settings !== null) ? loadedData.settings : {};
-                // Load group_names from the server response
-                config.group_names = (typeof loadedData.group_names === 'object' && loadedData.group_names !== null) ? loadedData.group_names : {};
-                config.buttonBindings = (typeof loadedData.buttonBindings === 'object' && loadedData.buttonBindings !== null) ? loadedData.buttonBindings : {};
-                // Add other fields that might be in config
-                if (loadedData.numContainers) config.numContainers = loadedData.numContainers;
-                if (loadedData.numDropdowns) config.numDropdowns = loadedData.numDropdowns;
-                if (loadedData.theme) config.theme = loadedData.theme;
-                if (loadedData.designSystem) config.designSystem = loadedData.designSystem;
-                console.log("Config loaded and applied:", config);
+                applyLoadedConfig(await response.json());
             }
         } catch (error) {
             console.error("Error loading config:", error);
@@ -307,6 +314,44 @@ document.addEventListener('DOMContentLoaded', () => {
             /* Defaults already set */
         }
     }
+    function applyLoadedConfig(loadedData) {
+        config.groups = (typeof loadedData.groups === 'object' && loadedData.groups !== null) ? loadedData.groups : {};
+        config.settings = (typeof loadedData.settings === 'object' && loadedData.settings !== null) ? loadedData.settings : {};
+        // Load group_names from the server response
+        config.group_names = (typeof loadedData.group_names === 'object' && loadedData.group_names !== null) ? loadedData.group_names : {};
+        config.buttonBindings = (typeof loadedData.buttonBindings === 'object' && loadedData.buttonBindings !== null) ? loadedData.buttonBindings : {};
+        // Add other fields that might be in config
+        if (loadedData.numContainers) config.numContainers = loadedData.numContainers;
+        if (loadedData.numDropdowns) config.numDropdowns = loadedData.numDropdowns;
+        if (loadedData.theme) config.theme = loadedData.theme;
+        if (loadedData.designSystem) config.designSystem = loadedData.designSystem;
+        console.log("Config loaded and applied:", config);
+    }
+
+    // Initial state: inlined into index.html by the server, or fetched with one request
+    async function loadBootstrap() {
+        if (window.__BOOTSTRAP__) {
+            const state = window.__BOOTSTRAP__;
+            delete window.__BOOTSTRAP__; // Stale after this; later loads go to the server
+            return state;
+        }
+        try {
+            const response = await fetch(API_URLS.bootstrap);
+            if (!response.ok) throw new Error(`HTTP error ${response.status}`);
+            return await response.json();
+        } catch (error) {
+            console.warn("Bootstrap request failed, loading state piece by piece:", error);
+            return null;
+        }
+    }
+    function applyBootstrap(state) {
+        if (state.config && typeof state.config === 'object') applyLoadedConfig(state.config);
+        currentBindings = Array.isArray(state.binds) ? state.binds : [];
+        comPorts = Array.isArray(state.comPorts) ? state.comPorts : [];
+        if (state.controllerState) controllerState = state.controllerState;
+        if (state.sessionsVersion !== undefined) sessionsVersion = String(state.sessionsVersion);
+        console.log(`Bootstrap state applied (config generation ${state.configGeneration})`);
+    }
     const saveConfigToServer = debounce(async () => {
         console.log("Saving config to server...");
         showLoadingState("Saving...");
@@ -384,6 +429,25 @@ document.addEventListener('DOMContentLoaded', () => {
             showError("Failed to save configuration.");
         }
     }, 500);
+
+    // Sends just the edit (see config_patch.h for the ops); falls back to a full save if the server refuses it
+    async function patchConfig(ops) {
+        try {
+            const response = await fetch(API_URLS.patchConfig, {
+                method: 'PATCH',
+                headers: {
+                    'Content-Type': 'application/json'
+                },
+                body: JSON.stringify(ops)
+            });
+            if (!response.ok) {
+                throw new Error(`HTTP error ${response.status}`);
+            }
+        } catch (error) {
+            console.warn("Config patch failed, saving the whole config:", error);
+            saveConfigToServer();
+        }
+    }
     function updateCurrentConfigFromUI() {
         if (!config) return;
 
@@ -618,7 +682,8 @@ document.addEventListener('DOMContentLoaded', () => {
     // --- Key Binding Functions ---
     function handleAddBinding() { const combo = keyComboInput.value; const action = keyActionInput.value.trim(); if (!capturedKeys || !combo || combo.includes("Recording")) { showError("Record shortcut first."); return; } if (!action) { showError("Enter action name."); return; } if (currentBindings.some(b => b.action.toLowerCase() === action.toLowerCase())) { showError(`Action name "${action}" exists.`); return; } if (currentBindings.some(b => b.combo === combo)) { showError(`Shortcut "${combo}" exists.`); return; } const newBinding = { id: `bind-${Date.now()}-${Math.random().toString(36).substr(2, 5)}`, combo: combo, action: action, }; currentBindings.push(newBinding); updateBindingsList(); saveBindsToServer(); updateDropdownOptions(); keyComboInput.value = ''; keyActionInput.value = ''; capturedKeys = null; stopKeyRecording(); }
     function handleDeleteBinding(bindingIdToDelete) { console.log(`Deleting binding: ${bindingIdToDelete}`); const bindingToDelete = currentBindings.find(b => b.id === bindingIdToDelete); if (!bindingToDelete) return; currentBindings = currentBindings.filter(binding => binding.id !== bindingIdToDelete); updateBindingsList(); saveBindsToServer(); let configChanged = false; Object.keys(config.settings).forEach(key => { if (config.settings[key] === bindingIdToDelete) { config.settings[key] = ""; configChanged = true; } }); updateDropdownOptions(); if (configChanged) saveConfigToServer(); }
-    function updateBindingsList() { if (!bindingsListUl) return; bindingsListUl.innerHTML = ''; if (!currentBindings || currentBindings.length === 0) { bindingsListUl.innerHTML = '<li>No bindings defined.</li>'; return; } currentBindings.forEach(binding => { const li = document.createElement('li'); li.dataset.bindingId = binding.id; const textSpan = document.createElement('span'); textSpan.classList.add('binding-text'); const comboSpan = document.createElement('span'); comboSpan.classList.add('binding-combo'); comboSpan.textContent = binding.combo; textSpan.appendChild(comboSpan); textSpan.append(" : "); const actionSpan = document.createElement('span'); actionSpan.classList.add('binding-action'); actionSpan.textContent = binding.action; textSpan.appendChild(actionSpan); li.appendChild(textSpan); const deleteBtn = document.createElement('button'); deleteBtn.textContent = 'Delete'; deleteBtn.classList.add('delete-btn'); deleteBtn.addEventListener('click', () => handleDeleteBinding(binding.id)); li.appendChild(deleteBtn); bindingsListUl.appendChild(li); }); }
+    function describeBinding(binding) { if (typeof binding.profile === 'string') return `Profile: ${binding.profile}`; if (Array.isArray(binding.macro)) return `Macro, ${binding.macro.length} step${binding.macro.length === 1 ? '' : 's'}`; return binding.combo || ''; }
+    function updateBindingsList() { if (!bindingsListUl) return; bindingsListUl.innerHTML = ''; if (!currentBindings || currentBindings.length === 0) { bindingsListUl.innerHTML = '<li>No bindings defined.</li>'; return; } currentBindings.forEach(binding => { const li = document.createElement('li'); li.dataset.bindingId = binding.id; const textSpan = document.createElement('span'); textSpan.classList.add('binding-text'); const comboSpan = document.createElement('span'); comboSpan.classList.add('binding-combo'); comboSpan.textContent = describeBinding(binding); textSpan.appendChild(comboSpan); textSpan.append(" : "); const actionSpan = document.createElement('span'); actionSpan.classList.add('binding-action'); actionSpan.textContent = binding.action; textSpan.appendChild(actionSpan); li.appendChild(textSpan); const deleteBtn = document.createElement('button'); deleteBtn.textContent = 'Delete'; deleteBtn.classList.add('delete-btn'); deleteBtn.addEventListener('click', () => handleDeleteBinding(binding.id)); li.appendChild(deleteBtn); bindingsListUl.appendChild(li); }); }
 
     // --- Key Recording Logic ---
     function toggleKeyRecording() { if (!recordKeyBtn || !keyComboInput) return; if (isRecordingKey) stopKeyRecording(); else startKeyRecording(); }
@@ -698,6 +763,13 @@ document.addEventListener('DOMContentLoaded', () => {
             title.addEventListener('dblclick', handleRenameGroupStart);
             container.appendChild(title);
 
+            const meter = document.createElement('div');
+            meter.classList.add('group-meter');
+            const meterFill = document.createElement('div');
+            meterFill.classList.add('group-meter-fill');
+            meter.appendChild(meterFill);
+            container.appendChild(meter);
+
             const appsInGroup = config.groups[groupName] || [];
             displayApplications(appsInGroup, false, container);
             addDragDropListeners(container);
@@ -767,7 +839,7 @@ document.addEventListener('DOMContentLoaded', () => {
         revertRename(input, finalDisplayName, groupKey);
 
         if (nameChanged) {
-            saveConfigToServer();
+            patchConfig({ op: 'renameGroup', group: groupKey, name: finalDisplayName });
         }
     }
     function revertRename(inputElement, nameToShow, groupKey) {
@@ -810,10 +882,58 @@ document.addEventListener('DOMContentLoaded', () => {
         }
         // Options are populated by updateDropdownOptions right after this runs
     }
-    function updateDropdownOptions() { console.log("Updating dropdown options..."); const selects = dropdownGridDiv.querySelectorAll('select'); const savedSelections = config.settings || {}; selects.forEach(select => { const settingKey = select.dataset.settingId; const previouslySelectedId = savedSelections[settingKey] || ""; const currentSelectedValue = select.value; select.innerHTML = `<option value="">-- Select Action --</option>`; currentBindings.forEach(binding => { const option = document.createElement('option'); option.value = binding.id; option.textContent = `${binding.action} (${binding.combo})`; select.appendChild(option); }); if (previouslySelectedId && currentBindings.some(b => b.id === previouslySelectedId)) select.value = previouslySelectedId; else if (currentSelectedValue && currentBindings.some(b => b.id === currentSelectedValue)) select.value = currentSelectedValue; else select.value = ""; }); console.log("Dropdown options updated."); }
+    function updateDropdownOptions() { console.log("Updating dropdown options..."); const selects = dropdownGridDiv.querySelectorAll('select'); const savedSelections = config.settings || {}; selects.forEach(select => { const settingKey = select.dataset.settingId; const previouslySelectedId = savedSelections[settingKey] || ""; const currentSelectedValue = select.value; select.innerHTML = `<option value="">-- Select Action --</option>`; currentBindings.forEach(binding => { const option = document.createElement('option'); option.value = binding.id; option.textContent = `${binding.action} (${describeBinding(binding)})`; select.appendChild(option); }); if (previouslySelectedId && currentBindings.some(b => b.id === previouslySelectedId)) select.value = previouslySelectedId; else if (currentSelectedValue && currentBindings.some(b => b.id === currentSelectedValue)) select.value = currentSelectedValue; else select.value = ""; }); console.log("Dropdown options updated."); }
 
     // --- Application Loading & Display ---
-    async function fetchApplicationsFromServer() { console.log(`Workspaceing apps from ${API_URLS.fetchApps}...`); availableAppsListDiv.innerHTML = '<p><i>Loading apps...</i></p>'; try { const response = await fetch(API_URLS.fetchApps, { method: 'POST' }); if (!response.ok) throw new Error(`HTTP error ${response.status}`); const appNames = await response.json(); if (!Array.isArray(appNames)) throw new Error("Invalid app list format"); console.log("Fetched apps:", appNames); displayApplications(appNames, false, availableAppsListDiv); } catch (error) { console.error('Error fetching apps:', error); availableAppsListDiv.innerHTML = `<p style="color: red;">Error loading apps.</p>`; } }
+    async function fetchApplicationsFromServer(refresh = false) { console.log(`Fetching apps from ${API_URLS.fetchApps}...`); availableAppsListDiv.innerHTML = '<p><i>Loading apps...</i></p>'; try { const response = await fetch(refresh ? `${API_URLS.fetchApps}?refresh=1` : API_URLS.fetchApps); if (!response.ok) throw new Error(`HTTP error ${response.status}`); const appNames = await response.json(); if (!Array.isArray(appNames)) throw new Error("Invalid app list format"); console.log("Fetched apps:", appNames); sessionsVersion = response.headers.get('X-Sessions-Version') || sessionsVersion; displayApplications(appNames, false, availableAppsListDiv); } catch (error) { console.error('Error fetching apps:', error); availableAppsListDiv.innerHTML = `<p style="color: red;">Error loading apps.</p>`; } }
+
+    // Peak levels pushed by the server. Group levels come in the server's group order,
+    // which is the sorted order of the config's group keys.
+    function watchMeters() {
+        const socket = new WebSocket(API_URLS.meters);
+        socket.onmessage = (event) => {
+            let frame;
+            try { frame = JSON.parse(event.data); } catch (error) { return; }
+            if (!Array.isArray(frame.groups)) return;
+            const groupKeys = Object.keys(config.groups || {}).sort();
+            groupKeys.forEach((groupKey, index) => {
+                const fill = groupBoxesWrapperDiv.querySelector(`.group-box[data-group-key="${CSS.escape(groupKey)}"] .group-meter-fill`);
+                if (!fill) return;
+                // Peak amplitude shown on a 60 dB scale, so quiet sources still move the bar
+                const peak = frame.groups[index] || 0;
+                const level = peak > 0 ? Math.max(0, 1 + Math.log10(peak) / 3) : 0;
+                fill.style.width = `${(level * 100).toFixed(1)}%`;
+            });
+        };
+        socket.onclose = () => {
+            groupBoxesWrapperDiv.querySelectorAll('.group-meter-fill').forEach(fill => { fill.style.width = '0%'; });
+            setTimeout(watchMeters, 5000); // Server restarted or not reachable yet
+        };
+    }
+
+    // Long poll: the server answers when the session list changes (or after ~25 s with the same list)
+    async function watchApplications() {
+        while (true) {
+            try {
+                if (sessionsVersion === null) {
+                    await new Promise(resolve => setTimeout(resolve, 2000));
+                    continue;
+                }
+                const response = await fetch(`${API_URLS.fetchApps}?since=${sessionsVersion}&wait=25000`);
+                if (!response.ok) throw new Error(`HTTP error ${response.status}`);
+                const version = response.headers.get('X-Sessions-Version');
+                const appNames = await response.json();
+                if (version !== null && version !== sessionsVersion && Array.isArray(appNames)) {
+                    console.log(`Audio sessions changed (version ${version})`);
+                    sessionsVersion = version;
+                    if (!draggedApp) displayApplications(appNames, false, availableAppsListDiv);
+                }
+            } catch (error) {
+                console.warn('Session watch failed, retrying:', error);
+                await new Promise(resolve => setTimeout(resolve, 5000));
+            }
+        }
+    }
     function displayApplications(appNames, isTestData = false, targetContainer) {
         if (!targetContainer) {
             console.error("Target container missing");
@@ -905,7 +1025,7 @@ document.addEventListener('DOMContentLoaded', () => {
                 draggedApp.remove();
 
                 // Save changes to server
-                saveConfigToServer();
+                patchConfig({ op: 'addApp', group: targetGroupName, app: appName });
 
                 // Refresh available apps list to hide this app
                 fetchApplicationsFromServer();
@@ -926,7 +1046,7 @@ document.addEventListener('DOMContentLoaded', () => {
             displayApplications([appName], false, availableAppsListDiv);
 
             // Save changes to server
-            saveConfigToServer();
+            patchConfig({ op: 'removeApp', group: sourceGroupName, app: appName });
         }
         // Moving from one group to another
         else if (sourceContainer.classList.contains('group-box') && dropZone.classList.contains('group-box') && sourceContainer !== dropZone) {
@@ -948,7 +1068,7 @@ document.addEventListener('DOMContentLoaded', () => {
                 draggedApp.remove();
 
                 // Save changes to server
-                saveConfigToServer();
+                patchConfig({ op: 'moveApp', from: sourceGroupName, to: targetGroupName, app: appName });
             }
         }
     }
@@ -0,0 +1,95 @@
+#include "response_cache.h"
+
+#include <cstdio>
+
+std::shared_ptr<const CachedResponse> ResponseCache::Get(uint64_t version, const Render &render, bool *rendered)
+{
+    if (rendered)
+    {
+        *rendered = false;
+    }
+    std::shared_ptr<const CachedResponse> cached = std::atomic_load(&m_current);
+    if (cached && cached->version == version)
+    {
+        return cached;
+    }
+
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+
+    // Someone else may have rendered this version while we waited
+    cached = std::atomic_load(&m_current);
+    if (cached && cached->version == version)
+    {
+        return cached;
+    }
+
+    auto response = std::make_shared<CachedResponse>();
+    response->version = version;
+    response->body = render();
+    response->etag = MakeEtag(response->body);
+    if (rendered)
+    {
+        *rendered = true;
+    }
+
+    std::shared_ptr<const CachedResponse> result = response;
+    if (!cached || cached->version < version)
+    {
+        std::atomic_store(&m_current, result);
+    }
+    return result;
+}
+
+void ResponseCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    std::atomic_store(&m_current, std::shared_ptr<const CachedResponse>());
+}
+
+std::string MakeEtag(const std::string &body)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : body)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    char etag[24];
+    std::snprintf(etag, sizeof(etag), "\"%016llx\"", static_cast<unsigned long long>(hash));
+    return etag;
+}
+
+bool EtagMatches(const std::string &ifNoneMatch, const std::string &etag)
+{
+    size_t pos = 0;
+    while (pos < ifNoneMatch.size())
+    {
+        size_t end = ifNoneMatch.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = ifNoneMatch.size();
+        }
+
+        // Trim, and compare weakly: W/"x" matches "x" for GET
+        size_t first = ifNoneMatch.find_first_not_of(" \t", pos);
+        size_t last = ifNoneMatch.find_last_not_of(" \t", end - 1);
+        if (first != std::string::npos && first < end && last >= first)
+        {
+            std::string candidate = ifNoneMatch.substr(first, last - first + 1);
+            if (candidate == "*")
+            {
+                return true;
+            }
+            if (candidate.compare(0, 2, "W/") == 0)
+            {
+                candidate.erase(0, 2);
+            }
+            if (candidate == etag)
+            {
+                return true;
+            }
+        }
+        pos = end + 1;
+    }
+    return false;
+}
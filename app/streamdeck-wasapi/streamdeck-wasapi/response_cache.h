@@ -0,0 +1,62 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Serialize-once HTTP responses.
+//
+// A body is rendered the first time it is asked for at a given version (the config
+// generation, the session table version) and kept as an immutable buffer together
+// with its ETag. Every later request at that version gets the same buffer back with
+// no parsing or serialization. The ETag is a hash of the body rather than the
+// version, so it stays valid across restarts (where generations start over) and a
+// client that already holds the body gets 304 Not Modified.
+
+struct CachedResponse
+{
+    uint64_t version = 0;
+    std::string body;
+    std::string etag; // Quoted strong validator, e.g. "\"5f1c0e3a9b2d4c11\""
+};
+
+class ResponseCache
+{
+public:
+    using Render = std::function<std::string()>;
+
+    /**
+     * @brief The body for a version, rendered at most once per version.
+     * @param version Must not decrease for newer content; an older version than the
+     * cached one is rendered but not cached (a reader holding an older snapshot).
+     * @param render Produces the body; called without any lock readers take.
+     * @param rendered Optional; set to whether this call rendered the body.
+     * @return Never null; immutable, so it can be shared between requests.
+     */
+    std::shared_ptr<const CachedResponse> Get(uint64_t version, const Render &render, bool *rendered = nullptr);
+
+    /**
+     * @brief Drops the cached body (the next Get renders).
+     */
+    void Clear();
+
+private:
+    std::mutex m_renderMutex;                  // One render at a time, so a miss renders once
+    std::shared_ptr<const CachedResponse> m_current; // Swapped with std::atomic_load/atomic_store
+};
+
+/**
+ * @brief Strong ETag of a body (64-bit FNV-1a, quoted).
+ */
+std::string MakeEtag(const std::string &body);
+
+/**
+ * @brief Whether an If-None-Match header value ("*", one ETag or a comma-separated
+ * list, weak or strong) matches the ETag.
+ */
+bool EtagMatches(const std::string &ifNoneMatch, const std::string &etag);
+
+#endif // RESPONSE_CACHE_H
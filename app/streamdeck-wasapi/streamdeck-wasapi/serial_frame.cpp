@@ -0,0 +1,75 @@
+#include "serial_frame.h"
+
+#include <climits>
+
+bool ParseControllerFrame(const std::string &line, ControllerFrame &frame)
+{
+    constexpr int EXPECTED_VALUES = EXPECTED_SLIDERS + EXPECTED_BUTTONS;
+    int values[EXPECTED_VALUES];
+    int count = 0;
+
+    size_t length = line.size();
+    if (length > 0 && line[length - 1] == '\r')
+    {
+        --length;
+    }
+
+    // Hand-rolled scan instead of stringstream + stoi: no allocation, one pass
+    size_t pos = 0;
+    while (pos <= length)
+    {
+        // Skip leading whitespace like std::stoi does
+        while (pos < length && (line[pos] == ' ' || line[pos] == '\t'))
+        {
+            ++pos;
+        }
+
+        bool negative = false;
+        if (pos < length && (line[pos] == '-' || line[pos] == '+'))
+        {
+            negative = line[pos] == '-';
+            ++pos;
+        }
+
+        long long value = 0;
+        size_t digits = 0;
+        while (pos < length && line[pos] >= '0' && line[pos] <= '9')
+        {
+            value = value * 10 + (line[pos] - '0');
+            if (value > INT_MAX)
+            {
+                return false;
+            }
+            ++pos;
+            ++digits;
+        }
+
+        if (digits == 0 || count == EXPECTED_VALUES)
+        {
+            return false;
+        }
+        values[count++] = static_cast<int>(negative ? -value : value);
+
+        // Ignore anything trailing the number up to the separator (matches stoi)
+        while (pos < length && line[pos] != ',')
+        {
+            ++pos;
+        }
+        ++pos; // Step over ',' (or past the end)
+    }
+
+    if (count != EXPECTED_VALUES)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < EXPECTED_SLIDERS; ++i)
+    {
+        frame.sliders[i] = values[i];
+    }
+    for (int i = 0; i < EXPECTED_BUTTONS; ++i)
+    {
+        frame.buttons[i] = values[EXPECTED_SLIDERS + i];
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <array>
+#include <string>
+
+// Portable (no Windows/Asio dependencies) decoding of the Arduino's serial frames.
+// A frame is one line of comma-separated integers: the slider readings (0-1023)
+// followed by the button states (0/1), e.g. "512,1023,0,77,0,0,1,0,0,0,0,0".
+
+// --- Configuration Constants ---
+// These define the expected number of inputs from the Arduino.
+// Ensure these match NUM_SLIDERS / NUM_BUTTONS in the Arduino sketch.
+constexpr int EXPECTED_SLIDERS = 4;
+constexpr int EXPECTED_BUTTONS = 8;
+
+// Maximum raw slider reading (10-bit ADC)
+constexpr int SLIDER_MAX_VALUE = 1023;
+
+struct ControllerFrame
+{
+    std::array<int, EXPECTED_SLIDERS> sliders{};
+    std::array<int, EXPECTED_BUTTONS> buttons{};
+};
+
+/**
+ * @brief Parses one serial line into a frame. A trailing '\r' is ignored.
+ * @param line The received line without the '\n' delimiter.
+ * @param frame Receives the decoded values; left untouched on failure.
+ * @return True if the line held exactly EXPECTED_SLIDERS + EXPECTED_BUTTONS integers.
+ */
+bool ParseControllerFrame(const std::string &line, ControllerFrame &frame);
+
+/**
+ * @brief Returns true if a slider moved by more than the noise threshold.
+ */
+inline bool SliderChanged(int previous, int current, int threshold)
+{
+    const int delta = current > previous ? current - previous : previous - current;
+    return delta > threshold;
+}
+
+/**
+ * @brief Maps a raw slider reading to a volume scalar in [0.0, 1.0].
+ */
+inline float SliderToVolume(int raw)
+{
+    const float volume = static_cast<float>(raw) / static_cast<float>(SLIDER_MAX_VALUE);
+    return volume < 0.0f ? 0.0f : (volume > 1.0f ? 1.0f : volume);
+}
+
+#endif // SERIAL_FRAME_H
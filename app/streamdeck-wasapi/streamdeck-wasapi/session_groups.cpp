@@ -0,0 +1,82 @@
+#include "session_groups.h"
+
+#include <algorithm>
+
+void SessionGroups::Rematch(std::shared_ptr<const AppMatcher> matcher, const Identify &identify)
+{
+    m_matcher = std::move(matcher);
+    m_groupSessions.assign(m_matcher ? m_matcher->Groups().size() : 0, std::vector<uint32_t>());
+    for (size_t session = 0; session < m_primary.size(); ++session)
+    {
+        Match(session, identify ? identify(session) : SessionIdentity());
+    }
+}
+
+size_t SessionGroups::Add(const SessionIdentity &identity)
+{
+    const size_t session = m_primary.size();
+    m_primary.push_back(-1);
+    m_members.push_back(GroupMask());
+    Match(session, identity);
+    return session;
+}
+
+void SessionGroups::Remove(size_t session)
+{
+    if (session >= m_primary.size())
+    {
+        return;
+    }
+    m_primary.erase(m_primary.begin() + static_cast<std::ptrdiff_t>(session));
+    m_members.erase(m_members.begin() + static_cast<std::ptrdiff_t>(session));
+
+    const uint32_t removed = static_cast<uint32_t>(session);
+    for (auto &sessions : m_groupSessions)
+    {
+        sessions.erase(std::remove(sessions.begin(), sessions.end(), removed), sessions.end());
+        for (uint32_t &index : sessions)
+        {
+            if (index > removed)
+            {
+                --index;
+            }
+        }
+    }
+}
+
+void SessionGroups::Clear()
+{
+    m_primary.clear();
+    m_members.clear();
+    for (auto &sessions : m_groupSessions)
+    {
+        sessions.clear();
+    }
+}
+
+void SessionGroups::Reserve(size_t sessions)
+{
+    m_primary.reserve(sessions);
+    m_members.reserve(sessions);
+}
+
+const std::vector<uint32_t> &SessionGroups::Sessions(int group) const
+{
+    static const std::vector<uint32_t> none;
+    return group >= 0 && static_cast<size_t>(group) < m_groupSessions.size() ? m_groupSessions[group] : none;
+}
+
+void SessionGroups::Match(size_t session, const SessionIdentity &identity)
+{
+    m_members[session].reset();
+    m_primary[session] = m_matcher ? m_matcher->Match(identity, &m_members[session]) : -1;
+
+    // Sessions are matched in ascending order, so appending keeps every list sorted
+    for (size_t group = 0; group < m_groupSessions.size(); ++group)
+    {
+        if (m_members[session].test(group))
+        {
+            m_groupSessions[group].push_back(static_cast<uint32_t>(session));
+        }
+    }
+}
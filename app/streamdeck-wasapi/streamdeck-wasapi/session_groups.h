@@ -0,0 +1,81 @@
+#ifndef SESSION_GROUPS_H
+#define SESSION_GROUPS_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "app_matcher.h"
+
+// Group membership of the audio session table.
+//
+// Rows are parallel to the session table: each session has its primary group and the
+// mask of every group it is in, and each group keeps the dense, ascending list of its
+// sessions, so a fader walks only its own sessions instead of testing every row.
+// Sessions are matched once when they are added; removing a row shifts the indices
+// after it in every list; new rules re-match every row. Kept free of COM so the
+// bookkeeping runs against hand-made session identities. Not thread-safe: owned by
+// the audio worker.
+
+class SessionGroups
+{
+public:
+    using Identify = std::function<SessionIdentity(size_t session)>;
+
+    /**
+     * @brief Uses new rules and re-matches every session with them.
+     * @param identify Gives the identity of a session (e.g. with a fresh process tree).
+     */
+    void Rematch(std::shared_ptr<const AppMatcher> matcher, const Identify &identify);
+
+    /**
+     * @brief Appends a session and matches it against the current rules.
+     * @return Its index.
+     */
+    size_t Add(const SessionIdentity &identity);
+
+    /**
+     * @brief Removes a session; sessions after it move up by one.
+     */
+    void Remove(size_t session);
+
+    /**
+     * @brief Removes every session; the rules and their (now empty) groups stay.
+     */
+    void Clear();
+
+    void Reserve(size_t sessions);
+
+    /**
+     * @brief The rules the sessions were matched with; may be null.
+     */
+    const std::shared_ptr<const AppMatcher> &Matcher() const { return m_matcher; }
+
+    size_t SessionCount() const { return m_primary.size(); }
+    size_t GroupCount() const { return m_groupSessions.size(); }
+
+    /**
+     * @brief Index (in Matcher()->Groups()) of the session's primary group, or -1.
+     */
+    int Primary(size_t session) const { return m_primary[session]; }
+
+    /**
+     * @brief Every group the session is in.
+     */
+    const GroupMask &Members(size_t session) const { return m_members[session]; }
+
+    /**
+     * @brief The sessions of a group in ascending order; empty for an unknown group.
+     */
+    const std::vector<uint32_t> &Sessions(int group) const;
+
+private:
+    void Match(size_t session, const SessionIdentity &identity);
+
+    std::shared_ptr<const AppMatcher> m_matcher;
+    std::vector<int> m_primary;                        // Per session
+    std::vector<GroupMask> m_members;                  // Per session
+    std::vector<std::vector<uint32_t>> m_groupSessions; // Per group of m_matcher
+};
+
+#endif // SESSION_GROUPS_H
@@ -0,0 +1,88 @@
+#ifndef SESSION_MATCH_H
+#define SESSION_MATCH_H
+
+#include <algorithm>
+#include <cwctype>
+#include <string>
+#include <vector>
+
+// Portable app-name -> audio session resolution used by SetApplicationVolume.
+// Kept free of COM so it can be exercised with fake session tables.
+
+enum class SessionMatchKind
+{
+    None,
+    Exact,   // Names equal (case-insensitive)
+    Partial, // App name found inside the session name
+    Reverse  // Session name found inside the app name
+};
+
+/**
+ * @brief Lowercases a wide string for case-insensitive comparison.
+ */
+inline std::wstring ToLowerW(const std::wstring &value)
+{
+    std::wstring lower = value;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](wchar_t c)
+                   { return static_cast<wchar_t>(std::towlower(c)); });
+    return lower;
+}
+
+/**
+ * @brief Finds the session an application name refers to.
+ * Tries an exact match first, then a partial match (app name inside the session name),
+ * then a reverse match (session name inside the app name). All comparisons are
+ * case-insensitive. Sessions rejected by isUsable (e.g. no volume interface) are skipped.
+ * @param sessionNames Executable names of the current sessions, indexed like the session table.
+ * @param appName The application name from the config.
+ * @param isUsable Predicate taking a session index.
+ * @param kind Receives how the session was matched.
+ * @return The session index, or -1 if nothing matched.
+ */
+template <typename UsablePredicate>
+int FindSessionForApp(const std::vector<std::wstring> &sessionNames, const std::wstring &appName,
+                      UsablePredicate isUsable, SessionMatchKind &kind)
+{
+    const std::wstring lowerAppName = ToLowerW(appName);
+
+    std::vector<std::wstring> lowerSessionNames;
+    lowerSessionNames.reserve(sessionNames.size());
+    for (const auto &name : sessionNames)
+    {
+        lowerSessionNames.push_back(ToLowerW(name));
+    }
+
+    for (size_t i = 0; i < lowerSessionNames.size(); ++i)
+    {
+        if (lowerSessionNames[i] == lowerAppName && isUsable(i))
+        {
+            kind = SessionMatchKind::Exact;
+            return static_cast<int>(i);
+        }
+    }
+
+    for (size_t i = 0; i < lowerSessionNames.size(); ++i)
+    {
+        if (lowerSessionNames[i].find(lowerAppName) != std::wstring::npos && isUsable(i))
+        {
+            kind = SessionMatchKind::Partial;
+            return static_cast<int>(i);
+        }
+    }
+
+    for (size_t i = 0; i < lowerSessionNames.size(); ++i)
+    {
+        if (!lowerSessionNames[i].empty() &&
+            lowerAppName.find(lowerSessionNames[i]) != std::wstring::npos && isUsable(i))
+        {
+            kind = SessionMatchKind::Reverse;
+            return static_cast<int>(i);
+        }
+    }
+
+    kind = SessionMatchKind::None;
+    return -1;
+}
+
+#endif // SESSION_MATCH_H
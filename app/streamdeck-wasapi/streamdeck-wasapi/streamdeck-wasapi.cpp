@@ -11,7 +11,20 @@
 #include <memory>
 #include "backend_logic.hpp"
 #include "arduino_bridge.h"
+#include "latency_trace.h"
+#include "control_model.h"
+#include "profile.h"
+#include "foreground_tracker.h"
+#include "group_volumes.h"
+#include "app_matcher.h"
+#include "config_store.h"
+#include "config_patch.h"
+#include "macro_scheduler.h"
+#include "audio_worker.h"
+#include "wasapi_controller.h"
+#include "wire_format.h"
 #include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 namespace fs = std::filesystem;
 
@@ -48,7 +61,7 @@ WCHAR szTitle[MAX_LOADSTRING] = {0};
 WCHAR szWindowClass[MAX_LOADSTRING] = {0};
 
 // Server-related globals
-crow::SimpleApp g_crow_app;
+crow::App<HttpMetricsMiddleware> g_crow_app;
 std::unique_ptr<std::thread> g_server_thread;
 std::atomic<bool> g_server_running(false);
 
@@ -58,6 +71,43 @@ std::atomic<bool> g_arduino_running(false);
 std::mutex arduino_data_mutex;
 std::vector<int> g_slider_values(EXPECTED_SLIDERS, 0);
 std::vector<int> g_button_states(EXPECTED_BUTTONS, 0);
+TraceSpan g_last_frame_span; // Trace span of the latest decoded frame (guarded by arduino_data_mutex)
+uint64_t g_frame_sequence = 0; // Number of decoded frames (guarded by arduino_data_mutex)
+
+// Profiles compiled from config.json + binds.json, and the one in use
+// (both swapped with std::atomic_load/atomic_store, so switching never touches a file)
+std::shared_ptr<const ProfileSet> g_profiles = CompileProfiles(json::object(), json::array());
+std::shared_ptr<const ControlProfile> g_active_profile = g_profiles->profiles[0];
+std::atomic<int> g_profile_before_auto(-1); // Profile to return to when the auto-switched app loses focus
+
+// Compiled config parts are published under this lock, and only from a generation at
+// least as new as the one in use, so two saves racing never leave the older one live
+std::mutex g_recompileMutex;
+uint64_t g_groupsGeneration = 0; // Generation of the matcher in use (guarded by g_recompileMutex)
+uint64_t g_metersGeneration = 0; // Generation of the meter and ducking settings in use (guarded by g_recompileMutex)
+
+// Serialized API responses, rebuilt only when what they show changes (see response_cache.h),
+// one cache per encoding a client can ask for (see wire_format.h)
+ResponseCache g_configResponse[WIRE_FORMAT_COUNT]; // By config generation
+ResponseCache g_bindsResponse[WIRE_FORMAT_COUNT];  // By config generation
+ResponseCache g_appsResponse[WIRE_FORMAT_COUNT];   // By session table version
+
+// COM ports found by the last enumeration (swapped with std::atomic_load/atomic_store)
+std::shared_ptr<const std::vector<std::string>> g_comPorts;
+
+// Browsers watching /api/meters. They share one peak meter listener, which encodes each
+// tick once for all of them; the meters are only sampled while this list is non-empty.
+std::mutex g_meterClientsMutex; // Guards the three below
+std::vector<crow::websocket::connection *> g_meterClients;
+uint64_t g_meterSubscription = 0;
+std::string g_meterMessage; // Reused for every tick
+
+// Longest a get-apps long poll is held before it is answered with the unchanged list
+const std::chrono::milliseconds MAX_APPS_WAIT(30000);
+
+// Foreground app, reported by a WinEvent hook (no per-frame GetForegroundWindow/OpenProcess)
+WinEventForegroundSource g_foreground_source;
+ForegroundTracker g_foreground(g_foreground_source);
 
 // ASIO globals (replace the external declarations)
 std::unique_ptr<boost::asio::io_context> io_ctx;
@@ -70,11 +120,16 @@ extern void RemoveTrayIcon(HWND hwnd);
 extern void HandleTrayIconClick(HWND hwnd, LPARAM lParam);
 extern bool InitializeWasapi();
 extern void SetApplicationVolume(const std::wstring &appName, float volume);
-extern std::vector<std::wstring> GetApplicationNames();
+extern void SetApplicationVolume(NameId app, float volume);
+extern void SetGroupVolume(const std::string &groupName, float volume);
+extern void SetAppMatcher(std::shared_ptr<const AppMatcher> matcher);
 extern void ToggleMuteApplication(const std::wstring &appName);
 extern void RefreshAudioSessions();
+extern void RequestAudioSessionRefresh();
+extern GroupVolumes g_groupVolumes;
 extern void ShowTrayBalloonTip(const wchar_t *title, const wchar_t *message, DWORD infoFlags);
-extern bool g_wasapiInitialized;
+extern std::atomic<bool> g_wasapiInitialized;
+extern void StopWasapi();
 extern std::string ws2s(const std::wstring &wstr);
 
 // Forward declarations
@@ -86,7 +141,33 @@ void StartWebServer();
 void StartArduinoMonitor();
 void ProcessArduinoData();
 void ApplyVolumeToGroup(const std::string &group_name, float volume);
-void HandleButtonPress(int button_index);
+void HandleGesture(const GestureEvent &event);
+void DispatchButtonEdges(const std::array<int, EXPECTED_BUTTONS> &buttons, std::chrono::steady_clock::time_point at);
+void ReloadProfiles(bool keepActive);
+void ReloadConfigParts(bool groups, bool profiles, bool meters);
+void WriteAppsResponse(const crow::request *req, crow::response &res, WireFormat format);
+std::shared_ptr<const ConfigSnapshot> CurrentConfigWithDefaults();
+std::shared_ptr<const CachedResponse> ConfigBody(const std::shared_ptr<const ConfigSnapshot> &snapshot, WireFormat format = WireFormat::Json);
+std::shared_ptr<const CachedResponse> BindsBody(const std::shared_ptr<const ConfigSnapshot> &snapshot, WireFormat format = WireFormat::Json);
+std::shared_ptr<const CachedResponse> AppsBody(const std::shared_ptr<const SessionList> &sessions, WireFormat format = WireFormat::Json);
+json BuildProfilesJson();
+std::string RenderBootstrap();
+void AddMeterClient(crow::websocket::connection &conn);
+void RemoveMeterClient(crow::websocket::connection &conn);
+bool ActivateProfile(int index, const char *reason);
+void OnForegroundChanged(const ForegroundApp &app);
+void ApplyVolumeToFocusedApp(float volume);
+void ApplyMacroVolume(const std::string &group_name, float volume);
+
+// Runs multi-step macros on its own timer thread
+MacroScheduler g_macroScheduler(systemInputInjector(), ApplyMacroVolume);
+
+// Button gestures, recognized on the serial (Asio) thread from timestamped edges;
+// only that thread touches these
+GestureRecognizer g_gestures(HandleGesture);
+std::unique_ptr<boost::asio::steady_timer> g_gesture_timer;
+std::array<int, EXPECTED_BUTTONS> g_gesture_buttons{};        // Button states last fed to the recognizer
+std::shared_ptr<const ButtonActionTable> g_gesture_table;     // Table the recognizer is configured for
 
 // Add this constant near other constants at the top
 const std::string SHADCN_UI_PATH = "./shadcn-ui/.next/static";
@@ -170,6 +251,7 @@ void StartWebServer()
     };
 
     // Static file routes
+    // The page comes with its initial state inlined, so first paint needs no API round trip
     CROW_ROUTE(g_crow_app, "/")([]()
                                 {
         auto result = readFileContent("public/index.html");
@@ -177,7 +259,8 @@ void StartWebServer()
             crow::response res;
             addCorsHeaders(res);
             res.add_header("Content-Type", getMimeType("public/index.html"));
-            res.write(result.value());
+            res.add_header("Cache-Control", "no-store"); // The inlined state is only current now
+            res.write(inlineInitialState(result.value(), RenderBootstrap()));
             return res;
         }
         return crow::response(404, "Not Found: index.html"); });
@@ -220,69 +303,48 @@ void StartWebServer()
 
     // Define OPTIONS routes
     CROW_ROUTE(g_crow_app, "/api/save-config").methods("OPTIONS"_method)(options_handler);
+    CROW_ROUTE(g_crow_app, "/api/config").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/save-binds").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/get-apps").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/load-config").methods("OPTIONS"_method)(options_handler);
+    CROW_ROUTE(g_crow_app, "/api/bootstrap").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/load-binds").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/get-controller-state").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/get-com-ports").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/set-com-port").methods("OPTIONS"_method)(options_handler);
     CROW_ROUTE(g_crow_app, "/api/test-volume").methods("OPTIONS"_method)(options_handler);
+    CROW_ROUTE(g_crow_app, "/api/latency").methods("OPTIONS"_method)(options_handler);
+    CROW_ROUTE(g_crow_app, "/api/get-profiles").methods("OPTIONS"_method)(options_handler);
+    CROW_ROUTE(g_crow_app, "/api/set-profile").methods("OPTIONS"_method)(options_handler);
+
+    // GET /metrics - Prometheus text exposition of the runtime counters
+    CROW_ROUTE(g_crow_app, "/metrics").methods("GET"_method)([](const crow::request & /*req*/, crow::response &res)
+                                                             {
+        res.add_header("Content-Type", "text/plain; version=0.0.4");
+        res.write(RenderPrometheusMetrics());
+        res.end(); });
+
+    // GET /api/bootstrap: config, binds, apps, COM ports, profiles and controller state in one response
+    CROW_ROUTE(g_crow_app, "/api/bootstrap").methods("GET"_method)([](const crow::request & /*req*/, crow::response &res)
+                                                                   {
+        std::cout << "API: GET /api/bootstrap" << std::endl;
+        addCorsHeaders(res);
+        res.add_header("Content-Type", "application/json");
+        res.add_header("Cache-Control", "no-store");
+        res.write(RenderBootstrap());
+        res.end(); });
 
     // GET /api/load-config
-    CROW_ROUTE(g_crow_app, "/api/load-config").methods("GET"_method)([](const crow::request & /*req*/, crow::response &res)
+    CROW_ROUTE(g_crow_app, "/api/load-config").methods("GET"_method)([](const crow::request &req, crow::response &res)
                                                                      {
         std::cout << "API: GET /api/load-config" << std::endl;
-        json config_data = readJsonFile(CONFIG_FILE, config_mutex);
-        
-        // Debug output the loaded config
-        std::cout << "Loaded config from file: " << std::endl;
-        if (config_data.contains("groups")) {
-            std::cout << "  - Contains 'groups' with " << config_data["groups"].size() << " entries" << std::endl;
-        } else {
-            std::cout << "  - Missing 'groups' field" << std::endl;
-        }
-        
-        if (config_data.contains("group_names")) {
-            std::cout << "  - Contains 'group_names' with " << config_data["group_names"].size() << " entries:" << std::endl;
-            // Print each group name mapping
-            for (auto& [key, value] : config_data["group_names"].items()) {
-                std::cout << "    * '" << key << "' -> '" << value << "'" << std::endl;
-            }
-        } else {
-            std::cout << "  - Missing 'group_names' field, will initialize it" << std::endl;
-        }
-        
-        // Ensure group_names is present in the config
-        if (!config_data.contains("group_names")) {
-            config_data["group_names"] = json::object();
-            
-            // Initialize with default names based on existing groups
-            if (config_data.contains("groups") && config_data["groups"].is_object()) {
-                for (auto& [name, group] : config_data["groups"].items()) {
-                    if (!config_data["group_names"].contains(name)) {
-                        config_data["group_names"][name] = name;
-                        std::cout << "    - Created default name mapping: '" << name << "' -> '" << name << "'" << std::endl;
-                    }
-                }
-            }
-            
-            // Save the updated config with group_names
-            std::cout << "  - Saving updated config with new group_names field" << std::endl;
-            writeJsonFile(CONFIG_FILE, config_data, config_mutex);
-        }
+        std::shared_ptr<const ConfigSnapshot> snapshot = CurrentConfigWithDefaults();
 
-        // Ensure buttonBindings is present in the config
-        if (!config_data.contains("buttonBindings"))
-        {
-            std::cout << "  - Missing 'buttonBindings' field, will initialize it" << std::endl;
-            config_data["buttonBindings"] = json::object();
-            writeJsonFile(CONFIG_FILE, config_data, config_mutex);
-        }
-
-        addCorsHeaders(res);
-        res.add_header("Content-Type", "application/json");
-        res.write(config_data.dump());
+        // Serialized once per generation; an unchanged config is a 304
+        WireFormat format = requestWireFormat(req);
+        std::shared_ptr<const CachedResponse> cached = ConfigBody(snapshot, format);
+        res.add_header("X-Config-Generation", std::to_string(snapshot->generation));
+        writeCachedResponse(req, res, *cached, WireContentType(format));
         res.end(); });
 
     // POST /api/save-config
@@ -356,27 +418,65 @@ void StartWebServer()
             config_data["group_names"].erase(key);
         }
         
-        if (writeJsonFile(CONFIG_FILE, config_data, config_mutex)) {
-            res.code = 200;
-            res.write("{\"message\":\"Config saved\"}");
+        // Applied now; the file is written behind, once the UI stops saving
+        g_configStore.Commit([&config_data](ConfigEdit &edit)
+                             {
+            edit.ReplaceConfig(std::move(config_data));
+            return true; });
+        ReloadProfiles(true);
+        res.code = 200;
+        res.write("{\"message\":\"Config saved\"}");
+        res.end(); });
+
+    // PATCH /api/config: one small edit instead of the whole document (see config_patch.h)
+    CROW_ROUTE(g_crow_app, "/api/config").methods("PATCH"_method)([](const crow::request &req, crow::response &res)
+                                                                  {
+        std::cout << "API: PATCH /api/config" << std::endl;
+        addCorsHeaders(res);
+        res.add_header("Content-Type", "application/json");
+        json patch;
+        try {
+            patch = json::parse(req.body);
+        }
+        catch (...) {
+            res.code = 400;
+            res.write("{\"error\":\"Invalid JSON\"}");
+            res.end();
+            return;
         }
-        else {
-            res.code = 500;
-            res.write("{\"error\":\"Failed write config\"}");
+
+        // Applied to a copy of the current config; a failed operation abandons the whole patch
+        ConfigPatchResult result;
+        std::shared_ptr<const ConfigSnapshot> committed = g_configStore.Commit([&](ConfigEdit &edit)
+                                                                               {
+            result = ApplyConfigPatch(patch, edit);
+            return result.ok; });
+        if (!result.ok) {
+            res.code = result.conflict ? 409 : 400;
+            res.write(json{{"error", result.error}}.dump());
+            res.end();
+            return;
         }
+
+        // Only what was compiled from the touched parts is rebuilt
+        if (committed) {
+            ReloadConfigParts(result.NeedsMatcher(), result.NeedsProfiles(), result.NeedsMeters());
+        }
+        const uint64_t generation = committed ? committed->generation : g_configStore.Generation();
+        res.add_header("X-Config-Generation", std::to_string(generation));
+        res.code = 200;
+        res.write(json{{"message", committed ? "Config patched" : "Nothing to change"}, {"generation", generation}}.dump());
         res.end(); });
 
     // GET /api/load-binds
-    CROW_ROUTE(g_crow_app, "/api/load-binds").methods("GET"_method)([](const crow::request & /*req*/, crow::response &res)
+    CROW_ROUTE(g_crow_app, "/api/load-binds").methods("GET"_method)([](const crow::request &req, crow::response &res)
                                                                     {
         std::cout << "API: GET /api/load-binds" << std::endl;
-        json binds_data = readJsonFile(BINDS_FILE, binds_mutex);
-        if (!binds_data.is_array()) {
-            binds_data = json::array();
-        }
-        addCorsHeaders(res);
-        res.add_header("Content-Type", "application/json");
-        res.write(binds_data.dump());
+        std::shared_ptr<const ConfigSnapshot> snapshot = g_configStore.Current();
+        WireFormat format = requestWireFormat(req);
+        std::shared_ptr<const CachedResponse> cached = BindsBody(snapshot, format);
+        res.add_header("X-Config-Generation", std::to_string(snapshot->generation));
+        writeCachedResponse(req, res, *cached, WireContentType(format));
         res.end(); });
 
     // POST /api/save-binds
@@ -398,87 +498,147 @@ void StartWebServer()
             return;
         }
 
-        if (writeJsonFile(BINDS_FILE, binds_data, binds_mutex)) {
-            res.code = 200;
-            res.write("{\"message\":\"Bindings saved\"}");
-        }
-        else {
-            res.code = 500;
-            res.write("{\"error\":\"Failed write bindings\"}");
-        }
+        g_configStore.Commit([&binds_data](ConfigEdit &edit)
+                             {
+            edit.ReplaceBinds(std::move(binds_data));
+            return true; });
+        ReloadProfiles(true);
+        res.code = 200;
+        res.write("{\"message\":\"Bindings saved\"}");
         res.end(); });
 
-    // POST /api/get-apps
-    CROW_ROUTE(g_crow_app, "/api/get-apps").methods("POST"_method)([](const crow::request & /*req*/, crow::response &res)
-                                                                   {
-        std::cout << "API: POST /api/get-apps" << std::endl;
-
-        RefreshAudioSessions();
-        std::vector<std::wstring> appNamesW = GetApplicationNames();
-        std::vector<std::string> appNamesA;
-
-        appNamesA.reserve(appNamesW.size()); // Pre-allocate memory
-
-        for (const auto& wname : appNamesW) {
-            if (wname.empty()) continue;
-
-            int len = WideCharToMultiByte(CP_UTF8, 0, wname.c_str(), -1, nullptr, 0, nullptr, nullptr);
-            if (len <= 0) continue;
-
-            std::string name(len - 1, 0);
-            if (WideCharToMultiByte(CP_UTF8, 0, wname.c_str(), -1, &name[0], len, nullptr, nullptr) <= 0) {
-                continue;
+    // GET or POST /api/get-apps[?refresh=1][&since=<version>&wait=<ms>]
+    // Sessions are tracked as they appear, so this reads the live table. ?refresh=1 queues
+    // a re-enumeration (concurrent refreshes share one) and answers without waiting for it;
+    // clients pick up the result with ?since= (the request is held until the session list
+    // moves past that version, long poll).
+    CROW_ROUTE(g_crow_app, "/api/get-apps").methods("GET"_method, "POST"_method)([](const crow::request &req, crow::response &res)
+                                                                                 {
+        std::cout << "API: " << crow::method_name(req.method) << " /api/get-apps" << std::endl;
+
+        if (req.url_params.get("refresh")) {
+            RequestAudioSessionRefresh(); // Never blocks this Crow worker on the enumeration
+        }
+
+        WireFormat format = requestWireFormat(req);
+        const char *since = req.url_params.get("since");
+        if (since) {
+            const char *wait = req.url_params.get("wait");
+            std::chrono::milliseconds timeout = wait ? std::chrono::milliseconds(std::strtoll(wait, nullptr, 10)) : MAX_APPS_WAIT;
+            timeout = (std::max)(std::chrono::milliseconds(0), (std::min)(timeout, MAX_APPS_WAIT));
+
+            // Answered on the waiter thread, which owns only the reply; the connection
+            // closes it if the client disconnects first, and then res is never touched
+            auto reply = std::make_shared<ParkedReply>([&res, format](bool /*changed*/)
+                                                       {
+                WriteAppsResponse(nullptr, res, format);
+                res.end(); });
+            g_crow_app.get_context<HttpMetricsMiddleware>(req).parked = reply;
+            VersionWaiters::ParkResult parked = g_sessionWaiters.Park(
+                std::strtoull(since, nullptr, 10), std::chrono::steady_clock::now() + timeout, reply);
+            if (parked == VersionWaiters::ParkResult::Parked) {
+                return;
             }
-
-            appNamesA.push_back(name);
+            reply->Close(); // Answered below, on this thread
         }
 
-        json app_list = appNamesA;
-        addCorsHeaders(res);
-        res.add_header("Content-Type", "application/json");
-        res.write(app_list.dump());
+        WriteAppsResponse(&req, res, format);
         res.end(); });
 
     // GET /api/get-controller-state - Update to match the new UI's expected format
-    CROW_ROUTE(g_crow_app, "/api/get-controller-state").methods("GET"_method)([](const crow::request & /*req*/, crow::response &res)
+    // (MessagePack/CBOR clients get the compact schema of wire_format.h instead)
+    CROW_ROUTE(g_crow_app, "/api/get-controller-state").methods("GET"_method)([](const crow::request &req, crow::response &res)
                                                                               {
         // std::cout << "API: GET /api/get-controller-state" << std::endl;
-        
-        json state_data = json::object();
-        
-        // Get the current Arduino slider and button values
+        WireFormat format = requestWireFormat(req);
+        addCorsHeaders(res);
+        res.add_header("Content-Type", WireContentType(format));
+        res.add_header("Vary", "Accept");
+
+        if (format != WireFormat::Json) {
+            std::lock_guard<std::mutex> lock(arduino_data_mutex);
+            EncodeControllerStateCompact(g_slider_values, g_button_states, g_arduino_connected, SERIAL_PORT_NAME, format, res.body);
+            res.end();
+            return;
+        }
+
+        json state_data;
         {
             std::lock_guard<std::mutex> lock(arduino_data_mutex);
-            json sliders = json::array();
-            json buttons = json::array();
-            
-            // Format sliders for the shadcn UI
-            for (size_t i = 0; i < g_slider_values.size(); i++) {
-                sliders.push_back({
-                    {"id", static_cast<int>(i) + 1},
-                    {"value", g_slider_values[i]},
-                    {"label", "Slider " + std::to_string(i + 1)}
-                });
-            }
-            
-            // Format buttons for the shadcn UI
-            for (size_t i = 0; i < g_button_states.size(); i++) {
-                buttons.push_back({
-                    {"id", static_cast<int>(i) + 1},
-                    {"pressed", g_button_states[i] > 0},
-                    {"label", "Button " + std::to_string(i + 1)}
-                });
-            }
-            
-            state_data["sliders"] = sliders;
-            state_data["buttons"] = buttons;
-            state_data["connected"] = g_arduino_connected;
-            state_data["port"] = SERIAL_PORT_NAME;
+            state_data = BuildControllerStateJson(g_slider_values, g_button_states, g_arduino_connected, SERIAL_PORT_NAME);
         }
         
+        res.write(state_data.dump());
+        res.end(); });
+
+    // WebSocket /api/meters - Session and group peak levels, one text message per meter tick
+    // (see EncodeMeterFrame in peak_meters.h); the rate is config.json "meters": {"rateHz"}
+    CROW_WEBSOCKET_ROUTE(g_crow_app, "/api/meters")
+        .onopen([](crow::websocket::connection &conn)
+                { AddMeterClient(conn); })
+        .onclose([](crow::websocket::connection &conn, const std::string & /*reason*/, uint16_t /*code*/)
+                 { RemoveMeterClient(conn); });
+
+    // GET /api/latency - Per-stage control path latency percentiles (?reset=1 clears them after reading)
+    CROW_ROUTE(g_crow_app, "/api/latency").methods("GET"_method)([](const crow::request &req, crow::response &res)
+                                                                 {
+        json report = GetLatencyReport();
+        if (req.url_params.get("reset") != nullptr) {
+            ResetLatencyStats();
+        }
+
         addCorsHeaders(res);
         res.add_header("Content-Type", "application/json");
-        res.write(state_data.dump());
+        res.write(report.dump());
+        res.end(); });
+
+    // GET /api/get-profiles - Compiled profile names and the active one
+    CROW_ROUTE(g_crow_app, "/api/get-profiles").methods("GET"_method)([](const crow::request & /*req*/, crow::response &res)
+                                                                      {
+        json result = BuildProfilesJson();
+
+        addCorsHeaders(res);
+        res.add_header("Content-Type", "application/json");
+        res.write(result.dump());
+        res.end(); });
+
+    // POST /api/set-profile - Switch the active profile ({"profile": "Gaming"}); not persisted
+    CROW_ROUTE(g_crow_app, "/api/set-profile").methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                                                      {
+        std::cout << "API: POST /api/set-profile" << std::endl;
+        addCorsHeaders(res);
+        res.add_header("Content-Type", "application/json");
+
+        json request_data;
+        try {
+            request_data = json::parse(req.body);
+        }
+        catch (...) {
+            res.code = 400;
+            res.write("{\"error\":\"Invalid JSON\"}");
+            res.end();
+            return;
+        }
+
+        if (!request_data.contains("profile") || !request_data["profile"].is_string()) {
+            res.code = 400;
+            res.write("{\"error\":\"Missing or invalid profile parameter\"}");
+            res.end();
+            return;
+        }
+
+        const std::string name = request_data["profile"].get<std::string>();
+        const int index = std::atomic_load(&g_profiles)->Find(name);
+        g_profile_before_auto = -1; // A manual choice sticks
+        if (!ActivateProfile(index, "API")) {
+            res.code = 404;
+            res.write(json({{"error", "Unknown profile '" + name + "'"}}).dump());
+            res.end();
+            return;
+        }
+
+        res.code = 200;
+        res.write(json({{"message", "Profile set"}, {"active", name}}).dump());
         res.end(); });
 
     // GET /api/get-com-ports - Update to match the new UI's expected format
@@ -486,8 +646,9 @@ void StartWebServer()
                                                                        {
         std::cout << "API: GET /api/get-com-ports" << std::endl;
         
-        // Get list of available COM ports
+        // Get list of available COM ports (kept for /api/bootstrap)
         std::vector<std::string> comPorts = GetAvailableCOMPorts();
+        std::atomic_store(&g_comPorts, std::make_shared<const std::vector<std::string>>(comPorts));
         
         addCorsHeaders(res);
         res.add_header("Content-Type", "application/json");
@@ -641,6 +802,13 @@ void StartWebServer()
         res.write("{\"message\":\"COM port set to " + SERIAL_PORT_NAME + "\", \"connected\": " + (g_arduino_connected ? "true" : "false") + "}");
         res.end(); });
 
+    // Per-route HTTP metrics (the table is read-only once the server runs)
+    RegisterHttpRoutes({"/", "/style.css", "/material-you.css", "/script.js", "/metrics",
+                        "/api/save-config", "/api/config", "/api/save-binds", "/api/get-apps", "/api/bootstrap", "/api/load-config",
+                        "/api/load-binds", "/api/get-controller-state", "/api/get-com-ports",
+                        "/api/set-com-port", "/api/test-volume", "/api/latency", "/api/get-profiles",
+                        "/api/set-profile", "/api/meters"});
+
     std::cout << "Starting Crow server on port " << SERVER_PORT << " in background thread..." << std::endl;
 
     // Set server timeout for better responsiveness during shutdown
@@ -668,6 +836,9 @@ void StartArduinoMonitor()
 
     try
     {
+        // The gesture timer belongs to the previous IO context
+        g_gesture_timer.reset();
+
         // Create fresh IO context and serial port objects
         if (io_ctx)
         {
@@ -730,7 +901,20 @@ void StartArduinoMonitor()
         serial->set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none));
 
         std::cout << "Serial port " << SERIAL_PORT_NAME << " opened successfully at " << BAUD_RATE << " baud." << std::endl;
+
+        // Fresh gesture state: nothing is held on a new connection
+        g_gesture_timer = std::make_unique<boost::asio::steady_timer>(*io_ctx);
+        g_gestures.Reset();
+        g_gesture_buttons.fill(0);
         g_arduino_connected = true;
+        Metrics().serialConnected.Set(1);
+
+        static bool hasConnectedBefore = false;
+        if (hasConnectedBefore)
+        {
+            Metrics().serialReconnects.Increment();
+        }
+        hasConnectedBefore = true;
 
         // Start Reading
         try
@@ -798,26 +982,28 @@ void StartArduinoMonitor()
 
     // Make sure to reset just the connection state flag
     g_arduino_connected = false;
+    Metrics().serialConnected.Set(0);
     // Note: We're NOT setting g_arduino_running to false here anymore
     std::cout << "Arduino monitor thread finished, but will remain ready for future connections." << std::endl;
 }
 
 void ProcessArduinoData()
 {
-    // Store previous states to detect changes
-    std::vector<int> prevButtonStates(EXPECTED_BUTTONS, 0);
+    // Store previous states to detect changes (buttons are handled on the serial thread)
     std::vector<int> prevSliderValues(EXPECTED_SLIDERS, 0);
 
     // Track if we've ever received data
     bool hasInitialData = false;
 
+    // Frame sequence seen on the previous iteration, to count superseded frames
+    uint64_t lastFrameSequence = 0;
+
+    // Profile the sliders were last applied with; a switch re-applies every slider
+    std::shared_ptr<const ControlProfile> lastProfile;
+
     // Counter for "still alive" messages
     int stillAliveCounter = 0;
 
-    // Periodically refresh audio sessions
-    int refreshCounter = 0;
-    const int REFRESH_INTERVAL = 100; // Refresh every ~5 seconds (100 * 50ms)
-
     // Output header
     std::cerr << "\n\n==================================================" << std::endl;
     std::cerr << "       ProcessArduinoData Thread Started           " << std::endl;
@@ -861,18 +1047,10 @@ void ProcessArduinoData()
             stillAliveCounter = 0;
         }
 
-        // Increment refresh counter and check if we need to refresh audio sessions
-        refreshCounter++;
-        if (refreshCounter >= REFRESH_INTERVAL)
-        {
-            std::cerr << "Periodic audio session refresh..." << std::endl;
-            RefreshAudioSessions();
-            refreshCounter = 0;
-        }
-
         // Copy latest values with mutex protection
         std::vector<int> sliderValues;
-        std::vector<int> buttonStates;
+        TraceSpan frameSpan;
+        uint64_t frameSequence = 0;
         bool dataAvailable = false;
 
         {
@@ -880,11 +1058,19 @@ void ProcessArduinoData()
             if (!g_slider_values.empty() && !g_button_states.empty())
             {
                 sliderValues = g_slider_values;
-                buttonStates = g_button_states;
+                frameSpan = g_last_frame_span;
+                frameSequence = g_frame_sequence;
                 dataAvailable = true;
             }
         }
 
+        // Frames decoded since the last iteration but never looked at were dropped
+        if (frameSequence > lastFrameSequence + 1)
+        {
+            Metrics().framesDropped.Increment(frameSequence - lastFrameSequence - 1);
+        }
+        lastFrameSequence = frameSequence;
+
         // Skip processing if no data is available yet
         if (!dataAvailable)
         {
@@ -915,14 +1101,18 @@ void ProcessArduinoData()
         try
         {
             // Process slider values (map 0-1023 to 0.0-1.0 float for volume)
-            // Only process if this is our first data or sliders have changed
-            bool slidersChanged = !hasInitialData;
+            // On the first data or after a profile switch every slider is applied (a recompiled
+            // copy of the same profile is not a switch)
+            std::shared_ptr<const ControlProfile> profile = std::atomic_load(&g_active_profile);
+            const bool switched = profile != lastProfile && (!lastProfile || profile->name != lastProfile->name);
+            const bool applyAll = !hasInitialData || switched;
+            bool slidersChanged = applyAll;
 
             // Check if any slider value has changed significantly (more than noise threshold)
             const int SLIDER_CHANGE_THRESHOLD = 0; // To filter out noise in potentiometer readings
             for (size_t i = 0; i < sliderValues.size() && i < prevSliderValues.size(); i++)
             {
-                if (std::abs(sliderValues[i] - prevSliderValues[i]) > SLIDER_CHANGE_THRESHOLD)
+                if (SliderChanged(prevSliderValues[i], sliderValues[i], SLIDER_CHANGE_THRESHOLD))
                 {
                     slidersChanged = true;
                     std::cerr << "Slider " << i << " changed significantly: " << prevSliderValues[i] << " -> " << sliderValues[i] << std::endl;
@@ -940,130 +1130,53 @@ void ProcessArduinoData()
             // Only process slider changes if values have changed
             if (slidersChanged)
             {
-                std::cerr << "Sliders changed, reading config file..." << std::endl;
-                json config_data = readJsonFile(CONFIG_FILE, config_mutex);
-                std::cerr << "Config file read." << std::endl;
-
-                // Dump config to debug
-                std::cerr << "Config contents (abbreviated): " << std::endl;
-                std::cerr << "Has 'groups': " << (config_data.contains("groups") ? "YES" : "NO") << std::endl;
-                if (config_data.contains("groups"))
-                {
-                    std::cerr << "Groups is object: " << (config_data["groups"].is_object() ? "YES" : "NO") << std::endl;
+                TRACE_MARK(frameSpan, TraceStage::Filtered);
 
-                    // List all groups
-                    std::cerr << "Groups in config: ";
-                    for (auto &[name, _] : config_data["groups"].items())
-                    {
-                        std::cerr << "\"" << name << "\" ";
-                    }
-                    std::cerr << std::endl;
-                }
+                // Slider -> group map of the active profile, compiled at config load
+                const std::vector<std::string> &groupNames = profile->sliderGroups;
+                std::cerr << "Profile \"" << profile->name << "\" maps " << groupNames.size() << " sliders" << std::endl;
 
-                // Check if config contains the groups mapping
-                if (config_data.contains("groups") && config_data["groups"].is_object())
+                // For each slider, map it to a group
+                for (size_t i = 0; i < sliderValues.size() && i < groupNames.size(); i++)
                 {
-                    // Get a list of group names to map to sliders
-                    std::vector<std::string> groupNames;
-
-                    // Instead of looking for specifically named groups, get all groups
-                    // and map them to sliders in the order they appear in the config
-                    for (auto &[name, group] : config_data["groups"].items())
+                    try
                     {
-                        // Only add non-empty groups or groups that actually exist
-                        if (group.is_array())
+                        // Only apply if this slider has changed significantly (or the map changed)
+                        if (!groupNames[i].empty() &&
+                            (applyAll || SliderChanged(prevSliderValues[i], sliderValues[i], SLIDER_CHANGE_THRESHOLD)))
                         {
-                            groupNames.push_back(name);
-                            std::cerr << "Mapping slider to group: \"" << name << "\" with "
-                                      << group.size() << " apps" << std::endl;
+                            float normalized_value = SliderToVolume(sliderValues[i]);
 
-                            // Enhanced debugging: Show apps in the group
-                            std::cerr << "   Apps in group: ";
-                            for (const auto &app : group)
-                            {
-                                if (app.is_string())
-                                {
-                                    std::cerr << "\"" << app.get<std::string>() << "\" ";
-                                }
-                            }
-                            std::cerr << std::endl;
-                        }
-                    }
+                            const std::string &group_name = groupNames[i];
 
-                    std::cerr << "Total mapped groups: " << groupNames.size() << std::endl;
+                            // Debug output
+                            std::cerr << "---> Calling ApplyVolumeToGroup for group " << group_name
+                                      << " with volume " << normalized_value << std::endl;
 
-                    // For each slider, map it to a group
-                    for (size_t i = 0; i < sliderValues.size() && i < groupNames.size(); i++)
-                    {
-                        try
-                        {
-                            // Only apply if this slider has changed significantly
-                            if (std::abs(sliderValues[i] - prevSliderValues[i]) > SLIDER_CHANGE_THRESHOLD || !hasInitialData)
+                            // Apply volume to all apps in this group (or to the focused app)
+                            TRACE_MARK(frameSpan, TraceStage::Dispatched);
+                            TRACE_SCOPE(frameSpan);
+                            if (group_name == FOCUSED_APP_TARGET)
+                            {
+                                ApplyVolumeToFocusedApp(normalized_value);
+                            }
+                            else
                             {
-                                float normalized_value = static_cast<float>(sliderValues[i]) / 1023.0f;
-
-                                // Clamp value between a small minimum (to avoid complete silence) and 1.0
-                                normalized_value = clamp(normalized_value, 0.0f, 1.0f);
-
-                                const std::string &group_name = groupNames[i];
-
-                                // Debug output
-                                std::cerr << "---> Calling ApplyVolumeToGroup for group " << group_name
-                                          << " with volume " << normalized_value << std::endl;
-
-                                // Apply volume to all apps in this group
                                 ApplyVolumeToGroup(group_name, normalized_value);
-
-                                std::cerr << "<--- Returned from ApplyVolumeToGroup" << std::endl;
                             }
-                        }
-                        catch (const std::exception &e)
-                        {
-                            std::cerr << "Error processing slider " << i << ": " << e.what() << std::endl;
+
+                            std::cerr << "<--- Returned from ApplyVolumeToGroup" << std::endl;
                         }
                     }
-                }
-                else
-                {
-                    std::cerr << "Config does not contain properly formatted groups" << std::endl;
-                }
-
-                // Save the current slider values for change detection next time
-                prevSliderValues = sliderValues;
-            }
-
-            // Process button states (0 or 1) - only on rising edge (0->1)
-            if (buttonStates.size() == prevButtonStates.size())
-            {
-                json binds_data = readJsonFile(BINDS_FILE, binds_mutex);
-
-                if (binds_data.is_array())
-                {
-                    for (size_t i = 0; i < buttonStates.size(); i++)
+                    catch (const std::exception &e)
                     {
-                        try
-                        {
-                            // Only trigger on button press (rising edge: 0->1)
-                            if (buttonStates[i] == 1 && prevButtonStates[i] == 0)
-                            {
-                                std::cerr << "Button " << i << " pressed, calling HandleButtonPress" << std::endl;
-                                HandleButtonPress(i);
-                            }
-                        }
-                        catch (const std::exception &e)
-                        {
-                            std::cerr << "Error processing button " << i << ": " << e.what() << std::endl;
-                        }
+                        std::cerr << "Error processing slider " << i << ": " << e.what() << std::endl;
                     }
                 }
 
-                // Update previous button states for next iteration
-                prevButtonStates = buttonStates;
-            }
-            else
-            {
-                // Button state array size changed, just copy the new size
-                prevButtonStates = buttonStates;
+                // Save the current slider values for change detection next time
+                prevSliderValues = sliderValues;
+                lastProfile = profile;
             }
         }
         catch (const std::exception &e)
@@ -1078,243 +1191,442 @@ void ProcessArduinoData()
     std::cerr << "ProcessArduinoData thread exiting. g_arduino_running = " << g_arduino_running << std::endl;
 }
 
-void ApplyVolumeToGroup(const std::string &group_name, float volume)
+// Configs from older versions lack these fields: they are added once, so later loads
+// are served from the cache. Nothing is committed if someone committed meanwhile.
+std::shared_ptr<const ConfigSnapshot> CurrentConfigWithDefaults()
 {
-    try
+    std::shared_ptr<const ConfigSnapshot> snapshot = g_configStore.Current();
+    const json &current = *snapshot->config;
+    if (current.contains("group_names") && current.contains("buttonBindings"))
     {
-        std::cerr << "\n==================================================" << std::endl;
-        std::cerr << "  ApplyVolumeToGroup: " << group_name << " -> " << volume << std::endl;
-        std::cerr << "==================================================\n"
-                  << std::endl;
+        return snapshot;
+    }
 
-        json config_data = readJsonFile(CONFIG_FILE, config_mutex);
+    json config_data = current;
+    if (!config_data.contains("group_names"))
+    {
+        std::cout << "  - Missing 'group_names' field, initializing it" << std::endl;
+        config_data["group_names"] = json::object();
 
-        // Check if the group exists in our config
-        if (config_data.contains("groups") && config_data["groups"].contains(group_name))
+        // Default names are the group keys
+        if (config_data.contains("groups") && config_data["groups"].is_object())
         {
-            // Get the apps in this group
-            auto &apps = config_data["groups"][group_name];
+            for (auto &[name, group] : config_data["groups"].items())
+            {
+                config_data["group_names"][name] = name;
+            }
+        }
+    }
+    if (!config_data.contains("buttonBindings"))
+    {
+        std::cout << "  - Missing 'buttonBindings' field, initializing it" << std::endl;
+        config_data["buttonBindings"] = json::object();
+    }
 
-            std::cout << "Group \"" << group_name << "\" found with "
-                      << (apps.is_array() ? apps.size() : 0) << " apps" << std::endl;
+    std::shared_ptr<const ConfigSnapshot> committed = g_configStore.CommitIfCurrent(snapshot->generation, [&](ConfigEdit &edit)
+                                                                                    {
+        edit.ReplaceConfig(std::move(config_data));
+        return true; });
+    return committed ? committed : g_configStore.Current();
+}
 
-            if (apps.is_array())
+std::shared_ptr<const CachedResponse> ConfigBody(const std::shared_ptr<const ConfigSnapshot> &snapshot, WireFormat format)
+{
+    return getCachedResponse(g_configResponse[static_cast<size_t>(format)], snapshot->generation, [&snapshot, format]()
+                             { return EncodeWire(*snapshot->config, format); });
+}
+
+std::shared_ptr<const CachedResponse> BindsBody(const std::shared_ptr<const ConfigSnapshot> &snapshot, WireFormat format)
+{
+    return getCachedResponse(g_bindsResponse[static_cast<size_t>(format)], snapshot->generation, [&snapshot, format]()
+                             { return EncodeWire(*snapshot->binds, format); });
+}
+
+// The get-apps body: the published session list, serialized once per version
+std::shared_ptr<const CachedResponse> AppsBody(const std::shared_ptr<const SessionList> &sessions, WireFormat format)
+{
+    return getCachedResponse(g_appsResponse[static_cast<size_t>(format)], sessions->version, [&sessions, format]()
+                             {
+        json app_list = json::array();
+        for (const auto &wname : sessions->names)
+        {
+            if (!wname.empty())
             {
-                if (apps.empty())
-                {
-                    std::cout << "Group is empty, no apps to adjust volume for" << std::endl;
-                    return;
-                }
+                app_list.push_back(WideToUtf8(wname));
+            }
+        }
+        return EncodeWire(app_list, format); });
+}
 
-                // Check if we need to refresh sessions
-                if (!g_wasapiInitialized)
-                {
-                    std::cerr << "WASAPI not initialized in ApplyVolumeToGroup, initializing..." << std::endl;
-                    InitializeWasapi();
-                }
+void WriteAppsResponse(const crow::request *req, crow::response &res, WireFormat format)
+{
+    std::shared_ptr<const SessionList> sessions = CurrentSessionList();
+    std::shared_ptr<const CachedResponse> cached = AppsBody(sessions, format);
 
-                // Debug output of current audio sessions
-                std::cerr << "Current audio sessions:" << std::endl;
-                RefreshAudioSessions();
-                std::vector<std::wstring>
-                    appNames = GetApplicationNames();
-                for (size_t i = 0; i < appNames.size(); ++i)
-                {
-                    std::cerr << "  " << i << ": \"" << ws2s(appNames[i]) << "\"" << std::endl;
-                }
+    res.add_header("X-Sessions-Version", std::to_string(sessions->version));
+    if (req)
+    {
+        writeCachedResponse(*req, res, *cached, WireContentType(format));
+    }
+    else
+    {
+        writeCachedResponse(std::string(), res, *cached, WireContentType(format));
+    }
+}
 
-                // For each app in the group
-                for (const auto &app : apps)
-                {
-                    if (app.is_string())
-                    {
-                        std::string app_name = app.get<std::string>();
-                        std::cout << "Processing app: \"" << app_name << "\"" << std::endl;
+json BuildProfilesJson()
+{
+    std::shared_ptr<const ProfileSet> set = std::atomic_load(&g_profiles);
+    json names = json::array();
+    for (const auto &profile : set->profiles)
+    {
+        names.push_back(profile->name);
+    }
+    return {{"profiles", names}, {"active", std::atomic_load(&g_active_profile)->name}};
+}
 
-                        // Convert to wide string for WASAPI controller using proper conversion
-                        std::wstring w_app_name;
-                        try
-                        {
-                            int size_needed = MultiByteToWideChar(CP_UTF8, 0, app_name.c_str(), -1, NULL, 0);
-                            if (size_needed > 0)
-                            {
-                                w_app_name.resize(size_needed - 1); // Exclude null terminator
-                                MultiByteToWideChar(CP_UTF8, 0, app_name.c_str(), -1, &w_app_name[0], size_needed);
+// Everything the UI loads at startup, in one body. Config, binds and apps are the cached
+// bodies spliced in as they are, so nothing already serialized is serialized again.
+std::string RenderBootstrap()
+{
+    std::shared_ptr<const ConfigSnapshot> snapshot = CurrentConfigWithDefaults();
+    std::shared_ptr<const SessionList> sessions = CurrentSessionList();
+    std::shared_ptr<const CachedResponse> config = ConfigBody(snapshot);
+    std::shared_ptr<const CachedResponse> binds = BindsBody(snapshot);
+    std::shared_ptr<const CachedResponse> apps = AppsBody(sessions);
+
+    std::shared_ptr<const std::vector<std::string>> comPorts = std::atomic_load(&g_comPorts);
+    if (!comPorts)
+    {
+        comPorts = std::make_shared<const std::vector<std::string>>(GetAvailableCOMPorts());
+        std::atomic_store(&g_comPorts, comPorts);
+    }
 
-                                std::cout << "Converting \"" << app_name << "\" to wide string, calling SetApplicationVolume" << std::endl;
+    json state_data;
+    {
+        std::lock_guard<std::mutex> lock(arduino_data_mutex);
+        state_data = BuildControllerStateJson(g_slider_values, g_button_states, g_arduino_connected, SERIAL_PORT_NAME);
+    }
 
-                                // Apply volume to this app
-                                SetApplicationVolume(w_app_name, volume);
-                            }
-                            else
-                            {
-                                std::cerr << "Error: MultiByteToWideChar returned invalid size for app name: " << app_name << std::endl;
-                            }
-                        }
-                        catch (const std::exception &e)
-                        {
-                            std::cerr << "Error: Converting app name '" << app_name << "': " << e.what() << std::endl;
-                        }
-                    }
-                    else
-                    {
-                        std::cerr << "Error: App entry is not a string" << std::endl;
-                    }
-                }
-            }
-            else
-            {
-                std::cerr << "Error: Group's 'apps' property is not an array" << std::endl;
-            }
-        }
-        else
-        {
-            std::cerr << "Error: Group \"" << group_name << "\" not found in config" << std::endl;
+    std::string body;
+    body.reserve(config->body.size() + binds->body.size() + apps->body.size() + 1024);
+    body += "{\"configGeneration\":" + std::to_string(snapshot->generation);
+    body += ",\"sessionsVersion\":" + std::to_string(sessions->version);
+    body += ",\"config\":" + config->body;
+    body += ",\"binds\":" + binds->body;
+    body += ",\"apps\":" + apps->body;
+    body += ",\"comPorts\":" + json(*comPorts).dump();
+    body += ",\"profiles\":" + BuildProfilesJson().dump();
+    body += ",\"controllerState\":" + state_data.dump();
+    body += "}";
+    return body;
+}
 
-            // Debug output all available groups
-            std::cerr << "Available groups in config:" << std::endl;
-            if (config_data.contains("groups") && config_data["groups"].is_object())
-            {
-                for (auto &[name, group] : config_data["groups"].items())
-                {
-                    std::cerr << "  - \"" << name << "\" with "
-                              << (group.is_array() ? group.size() : 0) << " apps" << std::endl;
-                }
-            }
-            else
-            {
-                std::cerr << "  No groups found in config" << std::endl;
-            }
-        }
+// One message per meter tick for every client; runs on the audio worker
+static void BroadcastMeterFrame(const MeterFrame &frame)
+{
+    std::lock_guard<std::mutex> lock(g_meterClientsMutex);
+    if (g_meterClients.empty())
+    {
+        return;
     }
-    catch (const std::exception &e)
+    EncodeMeterFrame(frame, g_meterMessage);
+    for (crow::websocket::connection *client : g_meterClients)
     {
-        std::cerr << "Exception in ApplyVolumeToGroup: " << e.what() << std::endl;
+        client->send_text(g_meterMessage);
     }
 }
 
-void HandleButtonPress(int button_index)
+void AddMeterClient(crow::websocket::connection &conn)
 {
-    try
+    std::lock_guard<std::mutex> lock(g_meterClientsMutex);
+    g_meterClients.push_back(&conn);
+    if (g_meterSubscription == 0)
     {
-        std::cout << "Button " << button_index << " pressed, checking for action..." << std::endl;
+        g_meterSubscription = g_peakMeters.Subscribe(BroadcastMeterFrame);
+    }
+    std::cout << "Meters: client connected (" << g_meterClients.size() << " watching)" << std::endl;
+}
 
-        // Load config to get button -> action mapping
-        json config_data = readJsonFile(CONFIG_FILE, config_mutex);
+void RemoveMeterClient(crow::websocket::connection &conn)
+{
+    std::lock_guard<std::mutex> lock(g_meterClientsMutex);
+    g_meterClients.erase(std::remove(g_meterClients.begin(), g_meterClients.end(), &conn), g_meterClients.end());
+    if (g_meterClients.empty() && g_meterSubscription != 0)
+    {
+        g_peakMeters.Unsubscribe(g_meterSubscription);
+        g_meterSubscription = 0;
+    }
+    std::cout << "Meters: client disconnected (" << g_meterClients.size() << " watching)" << std::endl;
+}
 
-        // Check if configuration has buttonBindings defined
-        if (!config_data.contains("buttonBindings") || !config_data["buttonBindings"].is_object())
-        {
-            std::cerr << "No buttonBindings defined in config or invalid format" << std::endl;
-            return;
-        }
+void ApplyVolumeToGroup(const std::string &group_name, float volume)
+{
+    std::cerr << "  ApplyVolumeToGroup: " << group_name << " -> " << volume << std::endl;
 
-        // Find the action for this button
-        std::string buttonKey = "button" + std::to_string(button_index);
-        if (!config_data["buttonBindings"].contains(buttonKey))
-        {
-            std::cerr << "No action defined for button " << button_index << std::endl;
-            return;
-        }
+    // Sessions of this group created later start at this level
+    g_groupVolumes.SetTarget(group_name, volume);
 
-        // Get the action name assigned to this button
-        std::string actionName = config_data["buttonBindings"][buttonKey];
-        std::cout << "Button " << button_index << " has action: " << actionName << std::endl;
+    // Membership was matched when each session appeared, so there is no config read or
+    // name lookup here; the worker coalesces writes that pile up for the same group
+    SetGroupVolume(group_name, volume);
+}
 
-        // Empty action name or special "__none__" value means no action
-        if (actionName.empty() || actionName == "__none__")
-        {
-            std::cerr << "Button " << button_index << " has empty or disabled action" << std::endl;
-            return;
-        }
+// Volume steps of macros: group writes are queued, so the macro thread never waits on WASAPI
+void ApplyMacroVolume(const std::string &group_name, float volume)
+{
+    ApplyVolumeToGroup(group_name, volume);
+}
 
-        // Load bindings to find the key combo for this action
-        json binds_data = readJsonFile(BINDS_FILE, binds_mutex);
+// Button tables and slider maps of every profile
+void RecompileProfiles(const ConfigSnapshot &snapshot, bool keepActive)
+{
+    std::vector<std::string> problems;
+    std::shared_ptr<const ProfileSet> set = CompileProfiles(*snapshot.config, *snapshot.binds, &problems, snapshot.generation);
+    for (const auto &problem : problems)
+    {
+        std::cerr << "Profiles: " << problem << std::endl;
+    }
 
-        if (!binds_data.is_array())
-        {
-            std::cerr << "Invalid bindings file format" << std::endl;
-            return;
-        }
+    std::lock_guard<std::mutex> lock(g_recompileMutex);
+    std::shared_ptr<const ProfileSet> previous = std::atomic_load(&g_profiles);
+    if (set->generation < previous->generation)
+    {
+        return; // A newer save was published meanwhile
+    }
 
-        // Find the binding with the matching action name
-        bool found = false;
-        for (const auto &binding : binds_data)
-        {
-            if (binding.contains("action") && binding["action"] == actionName)
-            {
-                // Found the binding - extract key combo
-                if (binding.contains("combo") && binding["combo"].is_string())
-                {
-                    std::string combo = binding["combo"];
-                    std::cout << "Found binding for action '" << actionName
-                              << "': combo = '" << combo << "'" << std::endl;
+    // Stay on the current profile across edits if it still exists
+    int index = keepActive ? set->Find(std::atomic_load(&g_active_profile)->name) : -1;
+    if (index < 0)
+    {
+        index = static_cast<int>(set->initial);
+    }
 
-                    // Parse the combo string (e.g., "Ctrl+Alt+S")
-                    int modifiers = 0;
-                    std::string mainKey;
+    // The profile to return to after an auto-switch is kept by name; indices may have moved
+    const int before = g_profile_before_auto.load();
+    const int beforeAuto = keepActive && before >= 0 && static_cast<size_t>(before) < previous->profiles.size()
+                               ? set->Find(previous->profiles[before]->name)
+                               : -1;
 
-                    if (combo.find("Ctrl+") != std::string::npos)
-                    {
-                        modifiers |= 1;
-                        combo.replace(combo.find("Ctrl+"), 5, "");
-                    }
+    std::atomic_store(&g_profiles, set);
+    g_profile_before_auto = beforeAuto;
+    ActivateProfile(index, "config loaded");
+    std::cout << "Profiles compiled: " << set->profiles.size() << std::endl;
 
-                    if (combo.find("Shift+") != std::string::npos)
-                    {
-                        modifiers |= 2;
-                        combo.replace(combo.find("Shift+"), 6, "");
-                    }
+    // New autoSwitch rules apply to the app that already has focus
+    OnForegroundChanged(*g_foreground.Current());
+}
 
-                    if (combo.find("Alt+") != std::string::npos)
-                    {
-                        modifiers |= 4;
-                        combo.replace(combo.find("Alt+"), 4, "");
-                    }
+// Group rules are compiled once here; sessions are matched against them as they appear
+void RecompileGroups(const ConfigSnapshot &snapshot)
+{
+    std::vector<std::string> problems;
+    std::shared_ptr<const AppMatcher> matcher = AppMatcher::Compile(*snapshot.config, &problems);
+    for (const auto &problem : problems)
+    {
+        std::cerr << "Groups: " << problem << std::endl;
+    }
 
-                    // The remaining string is the main key
-                    mainKey = combo;
+    std::lock_guard<std::mutex> lock(g_recompileMutex);
+    if (snapshot.generation < g_groupsGeneration)
+    {
+        return; // A newer save was published meanwhile
+    }
+    g_groupsGeneration = snapshot.generation;
+    g_groupVolumes.Rebuild(matcher->Groups());
+    SetAppMatcher(matcher);
+}
 
-                    // Get the virtual key code
-                    int keyCode = getVirtualKeyCode(mainKey);
-                    if (keyCode == 0)
-                    {
-                        std::cerr << "Unknown key: " << mainKey << std::endl;
-                        return;
-                    }
+void RecompileMeters(const ConfigSnapshot &snapshot)
+{
+    std::vector<std::string> problems;
+    std::shared_ptr<const DuckingRules> ducking = CompileDuckingRules(*snapshot.config, &problems);
+    for (const auto &problem : problems)
+    {
+        std::cerr << "Ducking: " << problem << std::endl;
+    }
 
-                    std::cout << "Executing parsed hotkey: keyCode=" << keyCode
-                              << " with modifiers=" << modifiers << std::endl;
+    std::lock_guard<std::mutex> lock(g_recompileMutex);
+    if (snapshot.generation < g_metersGeneration)
+    {
+        return; // A newer save was published meanwhile
+    }
+    g_metersGeneration = snapshot.generation;
+    SetMeterSettings(ReadMeterSettings(*snapshot.config));
+    SetDuckingRules(ducking);
+}
 
-                    // Check if this is a multimedia key
-                    bool isMediaKey = false;
-                    if (mainKey.find("Media_") == 0)
-                    {
-                        // This is a media key - use the specialized function
-                        std::cout << "Detected multimedia key - using simulateMediaKey" << std::endl;
-                        simulateMediaKey(keyCode);
-                        isMediaKey = true;
-                    }
-                    else
-                    {
-                        // This is a standard key - use the regular function
-                        simulateHotkey(keyCode, modifiers);
-                    }
+void ReloadProfiles(bool keepActive)
+{
+    // Config and binds from the same commit, so actions never resolve against stale binds
+    std::shared_ptr<const ConfigSnapshot> snapshot = g_configStore.Current();
+    if (keepActive && std::atomic_load(&g_profiles)->generation == snapshot->generation)
+    {
+        return; // Already compiled from this generation
+    }
+    RecompileProfiles(*snapshot, keepActive);
+    RecompileGroups(*snapshot);
+    RecompileMeters(*snapshot);
+}
 
-                    found = true;
-                    break;
-                }
-            }
+void ReloadConfigParts(bool groups, bool profiles, bool meters)
+{
+    std::shared_ptr<const ConfigSnapshot> snapshot = g_configStore.Current();
+    if (profiles)
+    {
+        RecompileProfiles(*snapshot, true);
+    }
+    if (groups)
+    {
+        RecompileGroups(*snapshot);
+    }
+    if (meters)
+    {
+        RecompileMeters(*snapshot);
+    }
+}
+
+bool ActivateProfile(int index, const char *reason)
+{
+    std::shared_ptr<const ProfileSet> set = std::atomic_load(&g_profiles);
+    if (index < 0 || static_cast<size_t>(index) >= set->profiles.size())
+    {
+        return false;
+    }
+
+    // The whole control map changes with this one store; sliders and buttons pick it up on their next frame.
+    // A recompile hands in the same profile as a new object, which is not a switch.
+    std::shared_ptr<const ControlProfile> previous = std::atomic_exchange(&g_active_profile, set->profiles[index]);
+    if (previous->name != set->profiles[index]->name)
+    {
+        Metrics().profileSwitches.Increment();
+        std::cout << "Profile: " << previous->name << " -> " << set->profiles[index]->name
+                  << " (" << reason << ")" << std::endl;
+    }
+    return true;
+}
+
+// Automatic profile switching, called from the foreground hook once per change of foreground app
+void OnForegroundChanged(const ForegroundApp &app)
+{
+    std::shared_ptr<const ProfileSet> set = std::atomic_load(&g_profiles);
+    const int index = app.exeId == NO_NAME ? -1 : set->FindForApp(app.exeId);
+    if (index >= 0)
+    {
+        // Remember the profile to come back to, unless we are already on an auto-selected one
+        const int current = set->Find(std::atomic_load(&g_active_profile)->name);
+        int expected = -1;
+        g_profile_before_auto.compare_exchange_strong(expected, current);
+        ActivateProfile(index, "foreground app");
+    }
+    else
+    {
+        const int previous = g_profile_before_auto.exchange(-1);
+        if (previous >= 0)
+        {
+            ActivateProfile(previous, "foreground app changed");
         }
+    }
+}
+
+// "Focused application" slider target: whatever app the foreground hook last reported
+void ApplyVolumeToFocusedApp(float volume)
+{
+    std::shared_ptr<const ForegroundApp> app = g_foreground.Current();
+    if (app->exeId == NO_NAME)
+    {
+        std::cerr << "No focused application to set the volume of" << std::endl;
+        return;
+    }
+
+    std::cerr << "Focused app \"" << app->exeName << "\" (pid " << app->pid << ") -> " << volume << std::endl;
+    SetApplicationVolume(app->exeId, volume);
+}
 
-        if (!found)
+void HandleGesture(const GestureEvent &event)
+{
+    // Resolved at config load: no file reads, JSON or string compares here
+    const ButtonAction &action = g_gesture_table->Lookup(event);
+
+    switch (action.type)
+    {
+    case ButtonActionType::Hotkey:
+        injectKeyChord(action.chord, false);
+        break;
+    case ButtonActionType::MediaKey:
+        injectKeyChord(action.chord, true);
+        break;
+    case ButtonActionType::Macro:
+        Metrics().macroTriggers.Increment();
+        if (!g_macroScheduler.Trigger(action.macro))
         {
-            std::cerr << "No binding found for action: " << actionName << std::endl;
+            std::cerr << "Macro queue full, gesture dropped" << std::endl;
         }
+        break;
+    case ButtonActionType::ProfileSwitch:
+        g_profile_before_auto = -1; // A manual choice sticks
+        ActivateProfile(action.profile, "button");
+        break;
+    case ButtonActionType::None:
+        if (event.type == GestureType::Tap)
+        {
+            std::cerr << "No action bound to button " << static_cast<int>(event.index) << std::endl;
+        }
+        break;
     }
-    catch (const std::exception &e)
+}
+
+// Arms the gesture timer for the recognizer's next deadline (serial thread only)
+void ScheduleGestureTimer()
+{
+    if (!g_gesture_timer)
     {
-        std::cerr << "Exception in HandleButtonPress: " << e.what() << std::endl;
+        return;
+    }
+
+    const auto deadline = g_gestures.NextDeadline();
+    if (deadline == std::chrono::steady_clock::time_point::max())
+    {
+        g_gesture_timer->cancel();
+        return;
+    }
+
+    g_gesture_timer->expires_at(deadline); // Cancels any earlier wait
+    g_gesture_timer->async_wait([](const boost::system::error_code &ec)
+                                {
+        if (ec)
+        {
+            return; // Rescheduled or shut down
+        }
+        g_gestures.OnTimer(std::chrono::steady_clock::now());
+        ScheduleGestureTimer(); });
+}
+
+void DispatchButtonEdges(const std::array<int, EXPECTED_BUTTONS> &buttons, std::chrono::steady_clock::time_point at)
+{
+    // Pick up recompiled bindings on the first frame after a reload
+    std::shared_ptr<const ButtonActionTable> table = std::atomic_load(&g_active_profile)->buttons;
+    if (table != g_gesture_table)
+    {
+        g_gesture_table = table;
+        g_gestures.Configure(table->gestures);
+    }
+
+    bool changed = false;
+    for (int i = 0; i < EXPECTED_BUTTONS; ++i)
+    {
+        const int state = buttons[i] != 0 ? 1 : 0;
+        if (state != g_gesture_buttons[i])
+        {
+            g_gesture_buttons[i] = state;
+            g_gestures.OnEdge(i, state == 1, at);
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        ScheduleGestureTimer();
     }
 }
 
@@ -1352,6 +1664,10 @@ void handle_receive(const boost::system::error_code &ec, std::size_t bytes_trans
 
         if (bytes_transferred > 0)
         {
+            TraceSpan frameSpan;
+            TRACE_BEGIN(frameSpan);
+            const auto receivedAt = std::chrono::steady_clock::now();
+
             // Convert the received data in the buffer to a string
             std::istream is(&read_buffer);
             std::string line;
@@ -1359,7 +1675,7 @@ void handle_receive(const boost::system::error_code &ec, std::size_t bytes_trans
             try
             {
                 std::getline(is, line); // Reads up to the delimiter '\n'
-                std::cout << "Received data: " << line << std::endl;
+
             }
             catch (const std::exception &e)
             {
@@ -1368,84 +1684,32 @@ void handle_receive(const boost::system::error_code &ec, std::size_t bytes_trans
                 line = "";
             }
 
-            // Remove potential carriage return '\r' sent by Arduino's println
-            if (!line.empty() && line.back() == '\r')
-            {
-                line.pop_back();
-            }
-
             if (!line.empty())
             {
-                std::stringstream ss(line);
-                std::string segment;
-                std::vector<int> received_values;
+                Metrics().framesReceived.Increment();
 
-                try
+                ControllerFrame frame;
+                if (ParseControllerFrame(line, frame))
                 {
-                    // Parse comma-separated values
-                    while (std::getline(ss, segment, ','))
-                    {
-                        try
-                        {
-                            received_values.push_back(std::stoi(segment));
-                        }
-                        catch (const std::exception &e)
-                        {
-                            std::cerr << "Error parsing segment '" << segment << "': " << e.what() << std::endl;
-                        }
-                    }
-
-                    // Enhanced debugging: Always print values when received
-                    std::cout << "DEBUG: Parsed " << received_values.size() << " values from Arduino: ";
-                    for (const auto &val : received_values)
-                    {
-                        std::cout << val << " ";
-                    }
-                    std::cout << std::endl;
+                    TRACE_MARK(frameSpan, TraceStage::FrameDecoded);
 
-                    if (received_values.size() == (EXPECTED_SLIDERS + EXPECTED_BUTTONS))
                     {
                         // Lock and update global state
-                        try
-                        {
-                            std::lock_guard<std::mutex> lock(arduino_data_mutex);
-                            for (int i = 0; i < EXPECTED_SLIDERS && i < static_cast<int>(received_values.size()); ++i)
-                            {
-                                g_slider_values[i] = received_values[i];
-                            }
-                            for (int i = 0; i < EXPECTED_BUTTONS && i + EXPECTED_SLIDERS < static_cast<int>(received_values.size()); ++i)
-                            {
-                                g_button_states[i] = received_values[EXPECTED_SLIDERS + i];
-                            }
-
-                            // Enhanced debugging: Always print updated global state
-                            std::cout << "DEBUG: Updated global state - Sliders: ";
-                            for (const auto &val : g_slider_values)
-                            {
-                                std::cout << val << " ";
-                            }
-                            std::cout << " | Buttons: ";
-                            for (const auto &val : g_button_states)
-                            {
-                                std::cout << val << " ";
-                            }
-                            std::cout << std::endl;
-                        }
-                        catch (const std::exception &e)
-                        {
-                            std::cerr << "Exception updating slider/button values: " << e.what() << std::endl;
-                        }
-                    }
-                    else
-                    {
-                        std::cerr << "Warning: Received line with incorrect number of values: "
-                                  << received_values.size() << " (expected "
-                                  << (EXPECTED_SLIDERS + EXPECTED_BUTTONS) << ")" << std::endl;
+                        std::lock_guard<std::mutex> lock(arduino_data_mutex);
+                        g_last_frame_span = frameSpan;
+                        ++g_frame_sequence;
+                        std::copy(frame.sliders.begin(), frame.sliders.end(), g_slider_values.begin());
+                        std::copy(frame.buttons.begin(), frame.buttons.end(), g_button_states.begin());
                     }
+
+                    // Button edges go straight to the gesture recognizer, not through the polling loop
+                    DispatchButtonEdges(frame.buttons, receivedAt);
                 }
-                catch (const std::exception &e)
+                else
                 {
-                    std::cerr << "Warning: Error parsing Arduino data: " << e.what() << std::endl;
+                    Metrics().framesMalformed.Increment();
+                    std::cerr << "Warning: Received malformed line (expected "
+                              << (EXPECTED_SLIDERS + EXPECTED_BUTTONS) << " values): " << line << std::endl;
                 }
             }
         }
@@ -1573,6 +1837,28 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
         // Handle initialization failure if needed
     }
 
+    // Start the key injection thread (hotkeys and media keys never block the callers)
+    g_inputExecutor.Start();
+
+    // Start the macro timer thread
+    g_macroScheduler.Start();
+
+    // Settings are read from disk once; saves go through the write-behind documents
+    g_configStore.Load(readJsonFile(CONFIG_FILE, config_mutex), readJsonFile(BINDS_FILE, binds_mutex));
+    g_configStore.Start();
+
+    // Answers get-apps long polls when the session list changes
+    g_sessionWaiters.Start();
+
+    // Resolve button bindings before the first frame arrives
+    ReloadProfiles(false);
+
+    // Track the foreground app for auto profile switching and the focused-app slider
+    if (!g_foreground.Start(OnForegroundChanged))
+    {
+        std::cerr << "Foreground tracking unavailable; auto profile switching is disabled" << std::endl;
+    }
+
     // Start the web server in a background thread
     g_server_thread = std::make_unique<std::thread>(StartWebServer);
 
@@ -1618,6 +1904,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             ShowTrayBalloonTip(L"Sessions Refreshed", L"Audio sessions have been refreshed.", NIIF_INFO);
             break;
 
+        case IDM_DUMP_LATENCY:
+            std::cerr << FormatLatencyReport() << std::endl;
+            ShowTrayBalloonTip(L"Latency Stats", L"Control path latency percentiles were written to the console.", NIIF_INFO);
+            break;
+
         case IDM_OPEN_FRONTEND:
             ShellExecute(NULL, L"open", L"http://localhost:8080", NULL, NULL, SW_SHOWNORMAL);
             break;
@@ -1682,6 +1973,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             }
         }
 
+        // Answer parked long polls while their connections still exist
+        g_sessionWaiters.Stop();
+
         // Properly shut down the server
         if (g_server_running)
         {
@@ -1696,6 +1990,19 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             }
         }
 
+        // No more saves can arrive: write out anything still debounced
+        g_configStore.Stop();
+
+        // Release WASAPI and COM on the audio worker
+        StopWasapi();
+
+        // Stop the foreground hook before anything it switches profiles for
+        g_foreground.Stop();
+
+        // Release any held keys and stop the key injection and macro threads
+        g_macroScheduler.Stop();
+        g_inputExecutor.Stop();
+
         // Remove tray icon and close
         RemoveTrayIcon(hWnd);
         PostQuitMessage(0);
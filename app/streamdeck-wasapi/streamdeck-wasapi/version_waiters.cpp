@@ -0,0 +1,202 @@
+#include "version_waiters.h"
+
+#include <algorithm>
+
+VersionWaiters::VersionWaiters(size_t maxWaiters)
+    : m_maxWaiters(maxWaiters)
+{
+}
+
+VersionWaiters::~VersionWaiters()
+{
+    Stop();
+}
+
+ParkedReply::ParkedReply(Send send)
+    : m_send(std::move(send))
+{
+}
+
+bool ParkedReply::Answer(bool changed)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if (!m_send)
+    {
+        return false;
+    }
+    Send send = std::move(m_send);
+    m_send = nullptr;
+    send(changed); // Under the lock, so Close() cannot return while the response is in use
+    return true;
+}
+
+void ParkedReply::Close()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    m_send = nullptr;
+}
+
+bool ParkedReply::Open() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return static_cast<bool>(m_send);
+}
+
+VersionWaiters::ParkResult VersionWaiters::Park(uint64_t since, Clock::time_point deadline, Complete complete)
+{
+    return ParkWaiter({since, deadline, std::move(complete), nullptr});
+}
+
+VersionWaiters::ParkResult VersionWaiters::Park(uint64_t since, Clock::time_point deadline, std::shared_ptr<ParkedReply> reply)
+{
+    // The completion owns the reply and nothing else
+    Complete complete = [reply](bool changed)
+    { reply->Answer(changed); };
+    return ParkWaiter({since, deadline, std::move(complete), std::move(reply)});
+}
+
+VersionWaiters::ParkResult VersionWaiters::ParkWaiter(Waiter waiter)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_version != waiter.since)
+        {
+            return ParkResult::Changed;
+        }
+        if (!m_stopped && m_waiters.size() >= m_maxWaiters)
+        {
+            // Clients that disconnected while parked give up their slots; their replies send nothing
+            m_waiters.erase(std::remove_if(m_waiters.begin(), m_waiters.end(), [](const Waiter &parked)
+                                           { return parked.reply && !parked.reply->Open(); }),
+                            m_waiters.end());
+        }
+        if (m_stopped || m_waiters.size() >= m_maxWaiters)
+        {
+            return ParkResult::Full;
+        }
+        m_waiters.push_back(std::move(waiter));
+        ++m_parks;
+    }
+    m_wake.notify_one();
+    return ParkResult::Parked;
+}
+
+void VersionWaiters::Publish(uint64_t version)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (version == m_version)
+        {
+            return;
+        }
+        m_version = version;
+    }
+    m_wake.notify_one();
+}
+
+uint64_t VersionWaiters::Version() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version;
+}
+
+size_t VersionWaiters::Waiting() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_waiters.size();
+}
+
+VersionWaiters::Clock::time_point VersionWaiters::ProcessDue(Clock::time_point now)
+{
+    std::vector<Waiter> due;
+    std::vector<bool> changed;
+    Clock::time_point next = Clock::time_point::max();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto keep = std::partition(m_waiters.begin(), m_waiters.end(), [this, now](const Waiter &waiter)
+                                   { return waiter.since == m_version && now < waiter.deadline; });
+        for (auto it = keep; it != m_waiters.end(); ++it)
+        {
+            changed.push_back(it->since != m_version);
+            due.push_back(std::move(*it));
+        }
+        m_waiters.erase(keep, m_waiters.end());
+        for (const auto &waiter : m_waiters)
+        {
+            next = (std::min)(next, waiter.deadline);
+        }
+    }
+
+    // Outside the lock: a completion may park the next request of the same client
+    for (size_t i = 0; i < due.size(); ++i)
+    {
+        due[i].complete(changed[i]);
+    }
+    return next;
+}
+
+void VersionWaiters::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running)
+    {
+        return;
+    }
+    m_running = true;
+    m_thread = std::thread(&VersionWaiters::Run, this);
+}
+
+void VersionWaiters::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_stopped = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    // Nobody would answer them otherwise
+    std::vector<Waiter> parked;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        parked.swap(m_waiters);
+    }
+    for (auto &waiter : parked)
+    {
+        waiter.complete(false);
+    }
+}
+
+void VersionWaiters::Run()
+{
+    uint64_t seenVersion = 0;
+    uint64_t seenParks = 0;
+    Clock::time_point next = Clock::time_point::max();
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto woken = [this, &seenVersion, &seenParks]
+            { return !m_running || m_version != seenVersion || m_parks != seenParks; };
+            if (next == Clock::time_point::max())
+            {
+                m_wake.wait(lock, woken);
+            }
+            else
+            {
+                m_wake.wait_until(lock, next, woken);
+            }
+            if (!m_running)
+            {
+                return;
+            }
+            seenVersion = m_version;
+            seenParks = m_parks;
+        }
+        next = ProcessDue(Clock::now());
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef VERSION_WAITERS_H
+#define VERSION_WAITERS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Long-poll support: requests parked until a version number moves.
+//
+// A client that already has version N parks its request here instead of asking
+// again and again; it is answered as soon as the version moves past N, or with the
+// unchanged state when its wait runs out. Publishing only records the new version
+// and wakes the waiter thread, so the thread that publishes (the audio worker) never
+// runs a completion or touches a socket. ProcessDue() is the whole step and takes
+// the time as an argument, so it can be driven without the thread.
+
+/**
+ * @brief The way back to a parked request's client. The completion owns it; the
+ * connection holds it too and closes it when it goes away, after which the answer is
+ * never sent, so nothing parked can write to a response that no longer exists.
+ */
+class ParkedReply
+{
+public:
+    using Send = std::function<void(bool changed)>;
+
+    explicit ParkedReply(Send send);
+
+    /**
+     * @brief Sends the answer, at most once, unless the reply was closed.
+     * @return True if it was sent by this call.
+     */
+    bool Answer(bool changed);
+
+    /**
+     * @brief The client is gone: never send. Waits for a send in progress on another
+     * thread, so the response may be destroyed as soon as this returns.
+     */
+    void Close();
+
+    /**
+     * @brief Neither answered nor closed yet.
+     */
+    bool Open() const;
+
+private:
+    // Recursive: ending the response inside Send may drop the connection, which closes its reply
+    mutable std::recursive_mutex m_mutex;
+    Send m_send; // Cleared once sent or closed
+};
+
+class VersionWaiters
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Complete = std::function<void(bool changed)>; // Answers one parked request
+
+    enum class ParkResult
+    {
+        Parked,  // complete will be called later, on the waiter thread
+        Changed, // Already past `since`: answer now (complete is not kept)
+        Full,    // Too many parked requests, or stopped: answer now
+    };
+
+    /**
+     * @param maxWaiters Parked requests hold a server connection each; beyond this callers answer at once.
+     */
+    explicit VersionWaiters(size_t maxWaiters = 16);
+    ~VersionWaiters();
+
+    VersionWaiters(const VersionWaiters &) = delete;
+    VersionWaiters &operator=(const VersionWaiters &) = delete;
+
+    /**
+     * @brief Parks a request until the version is past since, or until the deadline.
+     */
+    ParkResult Park(uint64_t since, Clock::time_point deadline, Complete complete);
+
+    /**
+     * @brief As above, answering through reply. A reply closed while parked (its client
+     * disconnected) gets no answer, and its slot is given to the next request that finds
+     * the waiters full.
+     */
+    ParkResult Park(uint64_t since, Clock::time_point deadline, std::shared_ptr<ParkedReply> reply);
+
+    /**
+     * @brief Records a new version. Never runs a completion on the calling thread.
+     */
+    void Publish(uint64_t version);
+
+    uint64_t Version() const;
+    size_t Waiting() const;
+
+    /**
+     * @brief Completes the requests whose version moved or whose deadline passed.
+     * @return The earliest remaining deadline, or Clock::time_point::max() if none is parked.
+     */
+    Clock::time_point ProcessDue(Clock::time_point now);
+
+    void Start();
+
+    /**
+     * @brief Answers every parked request (unchanged) and joins the thread.
+     */
+    void Stop();
+
+private:
+    struct Waiter
+    {
+        uint64_t since;
+        Clock::time_point deadline;
+        Complete complete;
+        std::shared_ptr<ParkedReply> reply; // Null for a plain completion
+    };
+
+    ParkResult ParkWaiter(Waiter waiter);
+
+    void Run();
+
+    const size_t m_maxWaiters;
+
+    mutable std::mutex m_mutex; // Guards everything below
+    std::condition_variable m_wake;
+    std::vector<Waiter> m_waiters;
+    uint64_t m_version = 0;
+    uint64_t m_parks = 0; // Requests ever parked, so the thread notices new deadlines
+    bool m_running = false;
+    bool m_stopped = false; // After Stop() nothing is parked any more
+    std::thread m_thread;
+};
+
+#endif // VERSION_WAITERS_H
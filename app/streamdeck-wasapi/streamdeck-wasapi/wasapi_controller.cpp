@@ -15,12 +15,21 @@
 #include <algorithm> // For std::transform
 #include <memory>    // For smart pointers
 #include "Resource.h"
+#include "latency_trace.h"
+#include "session_match.h"
+#include "metrics.h"
+#include "audio_worker.h"
+#include "group_volumes.h"
+#include "process_cache.h"
+#include "app_matcher.h"
+#include "session_groups.h"
+#include "version_waiters.h"
 #include <cwctype>
 
 // Global variables
 extern HINSTANCE hInst; // Get the instance from main
 extern HWND g_hwnd;
-extern bool g_wasapiInitialized; // Explicitly declare this is external
+std::atomic<bool> g_wasapiInitialized(false);
 
 NOTIFYICONDATAW g_nid;
 
@@ -49,12 +58,83 @@ std::string ws2s(const std::wstring &wstr)
     return result;
 }
 
-// WASAPI Global Variables
+// WASAPI Global Variables - only touched on the audio worker thread
 IMMDeviceEnumerator *g_pEnumerator = nullptr;
 IMMDevice *g_pDevice = nullptr;
 IAudioSessionManager2 *g_pSessionManager = nullptr;
 std::vector<ISimpleAudioVolume *> g_sessionVolumes;
 std::vector<std::wstring> g_sessionNames;
+std::vector<std::wstring> g_sessionDisplayNames; // Parallel to g_sessionNames, empty if the app sets none
+std::vector<uint32_t> g_sessionPids;             // Parallel to g_sessionNames, 0 if unknown
+std::vector<NameId> g_sessionNameIds;            // Parallel to g_sessionNames, interned exe name or NO_NAME
+SessionGroups g_sessionGroups;                   // Parallel to g_sessionNames, the groups of each session and the sessions of each group
+std::vector<IAudioMeterInformation *> g_sessionMeters; // Parallel to g_sessionNames, NULL if the session has no meter
+std::vector<IAudioSessionControl *> g_sessionControls; // Parallel to g_sessionNames, NULL for a slot GetSession failed on
+std::vector<IAudioSessionEvents *> g_sessionEvents;    // Parallel to g_sessionNames, the registered expiry sink or NULL
+std::vector<uint64_t> g_sessionIds;                    // Parallel to g_sessionNames, never reused, so a late expiry finds nothing
+uint64_t g_nextSessionId = 1;
+IAudioSessionNotification *g_sessionNotifier = nullptr;
+
+// The session names for readers on other threads, with a version bumped whenever they change
+// (swapped with std::atomic_load/atomic_store; written by the audio worker only)
+std::shared_ptr<const SessionList> g_sessionList = std::make_shared<const SessionList>();
+
+// Long-polling get-apps requests, answered when g_sessionList's version moves
+VersionWaiters g_sessionWaiters;
+
+// One refresh at a time; callers arriving while one runs share its result
+std::mutex g_refreshMutex;
+std::shared_future<void> g_refreshInFlight;
+
+// Process metadata, refreshed with one snapshot per session enumeration (audio worker only)
+SystemProcessSource g_processSource;
+ProcessCache g_processCache(g_processSource);
+
+// Latest compiled group rules, published from any thread with atomic_store; the rules the
+// sessions were matched with are g_sessionGroups.Matcher() (audio worker only)
+std::shared_ptr<const AppMatcher> g_appMatcher;
+
+// Per-group target volumes, for sessions created after the fader moved
+GroupVolumes g_groupVolumes;
+
+// The session table as a meter source (audio worker only, like the table)
+class SessionMeterSource : public MeterSource
+{
+public:
+    uint64_t SessionsVersion() const override { return std::atomic_load(&g_sessionList)->version; }
+    size_t SessionCount() const override { return g_sessionMeters.size(); }
+    size_t GroupCount() const override { return g_sessionGroups.GroupCount(); }
+
+    float Peak(size_t session) override
+    {
+        float peak = 0.0f;
+        if (!g_sessionMeters[session] || FAILED(g_sessionMeters[session]->GetPeakValue(&peak)))
+        {
+            return 0.0f;
+        }
+        return peak;
+    }
+
+    const GroupMask &Groups(size_t session) const override { return g_sessionGroups.Members(session); }
+};
+
+SessionMeterSource g_sessionMeterSource;
+PeakMeters g_peakMeters(g_sessionMeterSource);
+
+// Sampling period of the meter tick, read when the tick is (re)installed
+std::atomic<int64_t> g_meterPeriodMs(MeterSettings().period.count());
+
+// Latest compiled ducking rules, published from any thread with atomic_store
+std::shared_ptr<const DuckingRules> g_duckingRules;
+// Ducking envelopes, and the meter listener feeding them while there are rules (audio worker only)
+static void ApplyDuckOnWorker(size_t group, float volume);
+static void RemoveSessionOnWorker(uint64_t id);
+static void ApplyDuckingRulesOnWorker();
+DuckingEngine g_ducking(ApplyDuckOnWorker);
+uint64_t g_duckingSubscription = 0;
+
+// How far up the process tree "child:" rules look
+const int MAX_ANCESTOR_DEPTH = 8;
 
 // Helper function to safely release COM objects
 template <typename T>
@@ -145,6 +225,7 @@ void ShowTrayIconMenu(HWND hwnd, POINT pt)
     AppendMenuW(hMenu, MF_STRING, IDM_REFRESH, L"Refresh Audio Sessions");
     AppendMenuW(hMenu, MF_STRING, IDM_SETTINGS, L"Settings");
     AppendMenuW(hMenu, MF_STRING, IDM_OPEN_FRONTEND, L"Open Frontend");
+    AppendMenuW(hMenu, MF_STRING, IDM_DUMP_LATENCY, L"Dump Latency Stats");
     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
     AppendMenuW(hMenu, MF_STRING, IDM_ABOUT, L"About");
     AppendMenuW(hMenu, MF_STRING, IDM_EXIT, L"Exit");
@@ -182,17 +263,45 @@ void HandleTrayIconClick(HWND hwnd, LPARAM lParam)
 }
 
 // Clean up WASAPI resources
+// Drops every interface session i holds and stops its expiry notifications. Audio worker only.
+static void ReleaseSessionSlot(size_t i)
+{
+    if (g_sessionEvents[i] && g_sessionControls[i])
+    {
+        g_sessionControls[i]->UnregisterAudioSessionNotification(g_sessionEvents[i]);
+    }
+    SafeRelease(g_sessionEvents[i]);
+    SafeRelease(g_sessionControls[i]);
+    SafeRelease(g_sessionVolumes[i]);
+    SafeRelease(g_sessionMeters[i]);
+}
+
 void CleanupWasapi()
 {
     std::cerr << "Cleaning up WASAPI resources..." << std::endl;
 
-    // Clean up existing session volumes
-    for (auto &volume : g_sessionVolumes)
+    // Stop new-session notifications before the session manager goes away
+    if (g_sessionNotifier && g_pSessionManager)
+    {
+        g_pSessionManager->UnregisterSessionNotification(g_sessionNotifier);
+    }
+    SafeRelease(g_sessionNotifier);
+
+    // Clean up existing sessions
+    for (size_t i = 0; i < g_sessionNames.size(); ++i)
     {
-        SafeRelease(volume);
+        ReleaseSessionSlot(i);
     }
     g_sessionVolumes.clear();
+    g_sessionMeters.clear();
+    g_sessionControls.clear();
+    g_sessionEvents.clear();
+    g_sessionIds.clear();
     g_sessionNames.clear();
+    g_sessionDisplayNames.clear();
+    g_sessionPids.clear();
+    g_sessionNameIds.clear();
+    g_sessionGroups.Clear();
 
     // Release other resources
     SafeRelease(g_pSessionManager);
@@ -203,8 +312,333 @@ void CleanupWasapi()
     std::cerr << "WASAPI cleanup complete" << std::endl;
 }
 
-// Function to initialize WASAPI
-bool InitializeWasapi()
+// What the group rules see of session i (process may be null if it could not be
+// resolved). The process tree is only walked when a "child:" rule exists; a parent
+// created after its child is a reused pid, not the parent.
+static SessionIdentity IdentifySession(size_t i, const ProcessInfo *process)
+{
+    SessionIdentity identity;
+    const std::shared_ptr<const AppMatcher> &matcher = g_sessionGroups.Matcher();
+    if (!matcher)
+    {
+        return identity;
+    }
+
+    identity.exe = g_sessionNameIds[i];
+    identity.exeName = identity.exe != NO_NAME ? ws2s(g_sessionNames[i]) : std::string();
+    identity.displayName = ws2s(g_sessionDisplayNames[i]);
+    if (process && matcher->NeedsAncestors())
+    {
+        const ProcessInfo *child = process;
+        for (int depth = 0; depth < MAX_ANCESTOR_DEPTH && child->parentPid != 0; ++depth)
+        {
+            const ProcessInfo *parent = g_processCache.Find(child->parentPid);
+            if (!parent || parent->createTime > child->createTime)
+            {
+                break;
+            }
+            identity.ancestors.push_back(parent->exeId);
+            child = parent;
+        }
+    }
+    return identity;
+}
+
+// Bumps the session table version if the names changed; a refresh that finds the same
+// sessions keeps the version (and every cached response built from it). Audio worker only.
+static void PublishSessionTable()
+{
+    std::shared_ptr<const SessionList> published = std::atomic_load(&g_sessionList);
+    if (g_sessionNames == published->names)
+    {
+        return;
+    }
+
+    auto list = std::make_shared<SessionList>();
+    list->version = published->version + 1;
+    list->names = g_sessionNames;
+    std::atomic_store(&g_sessionList, std::shared_ptr<const SessionList>(list));
+    g_sessionWaiters.Publish(list->version);
+}
+
+// Per-session IAudioSessionEvents sink. WASAPI calls it on one of its own threads; when
+// the session expires (its app closed it or exited) or is disconnected (device removed,
+// format changed) it hands the session's id to the audio worker, which drops the row.
+class SessionEvents : public IAudioSessionEvents
+{
+public:
+    explicit SessionEvents(uint64_t id)
+        : m_id(id)
+    {
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return InterlockedIncrement(&m_refs);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG refs = InterlockedDecrement(&m_refs);
+        if (refs == 0)
+        {
+            delete this;
+        }
+        return refs;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IAudioSessionEvents))
+        {
+            *ppv = static_cast<IAudioSessionEvents *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDisplayNameChanged(LPCWSTR, LPCGUID) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnIconPathChanged(LPCWSTR, LPCGUID) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnSimpleVolumeChanged(float, BOOL, LPCGUID) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnChannelVolumeChanged(DWORD, float[], DWORD, LPCGUID) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE OnGroupingParamChanged(LPCGUID, LPCGUID) override { return S_OK; }
+
+    HRESULT STDMETHODCALLTYPE OnStateChanged(AudioSessionState newState) override
+    {
+        if (newState == AudioSessionStateExpired)
+        {
+            Expire();
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnSessionDisconnected(AudioSessionDisconnectReason) override
+    {
+        Expire();
+        return S_OK;
+    }
+
+private:
+    void Expire()
+    {
+        const uint64_t id = m_id;
+        g_audioWorker.Submit([id]()
+                             { RemoveSessionOnWorker(id); });
+    }
+
+    const uint64_t m_id;
+    LONG m_refs = 1;
+};
+
+// Adds one session to the table (volume interface may be NULL) and returns its index. Audio worker only.
+// Process names come from the process cache; only a pid it has not seen yet costs a new snapshot.
+static size_t AppendSession(IAudioSessionControl *pSessionControl)
+{
+    const size_t i = g_sessionNames.size();
+    const uint64_t id = g_nextSessionId++;
+    ISimpleAudioVolume *pVolume = NULL;
+    IAudioMeterInformation *pMeter = NULL;
+    std::wstring appName = L"Unknown Session";
+    std::wstring displayName;
+    DWORD processId = 0;
+    const ProcessInfo *process = nullptr;
+
+    HRESULT hr = pSessionControl->QueryInterface(__uuidof(ISimpleAudioVolume), (void **)&pVolume);
+    if (SUCCEEDED(hr))
+    {
+        IAudioSessionControl2 *pSessionControl2 = NULL;
+        hr = pSessionControl->QueryInterface(__uuidof(IAudioSessionControl2), (void **)&pSessionControl2);
+        if (SUCCEEDED(hr))
+        {
+            if (FAILED(pSessionControl2->GetProcessId(&processId)))
+            {
+                processId = 0;
+            }
+
+            LPWSTR sessionDisplayName = NULL;
+            if (SUCCEEDED(pSessionControl2->GetDisplayName(&sessionDisplayName)) && sessionDisplayName)
+            {
+                displayName = sessionDisplayName;
+                CoTaskMemFree(sessionDisplayName);
+            }
+
+            process = processId != 0 ? g_processCache.Resolve(processId) : nullptr;
+            if (process && !process->exeName.empty())
+            {
+                appName = process->exeName;
+                if (!displayName.empty())
+                {
+                    g_processCache.SetDisplayName(processId, displayName);
+                }
+                std::cerr << "Session " << i << " process name: " << ws2s(appName) << " (pid " << processId
+                          << ", parent " << process->parentPid << ")" << std::endl;
+            }
+            SafeRelease(pSessionControl2);
+        }
+    }
+    else
+    {
+        pVolume = NULL; // Set to NULL explicitly on failure
+    }
+    if (FAILED(pSessionControl->QueryInterface(__uuidof(IAudioMeterInformation), (void **)&pMeter)))
+    {
+        pMeter = NULL;
+    }
+
+    IAudioSessionEvents *pEvents = new SessionEvents(id);
+    if (FAILED(pSessionControl->RegisterAudioSessionNotification(pEvents)))
+    {
+        SafeRelease(pEvents); // Stays in the table until the next enumeration
+    }
+    pSessionControl->AddRef();
+
+    g_sessionVolumes.push_back(pVolume);
+    g_sessionMeters.push_back(pMeter);
+    g_sessionControls.push_back(pSessionControl);
+    g_sessionEvents.push_back(pEvents);
+    g_sessionIds.push_back(id);
+    g_sessionNames.push_back(appName);
+    g_sessionDisplayNames.push_back(displayName);
+    g_sessionPids.push_back(processId);
+    g_sessionNameIds.push_back(process ? process->exeId : NO_NAME);
+    g_sessionGroups.Add(IdentifySession(i, process));
+    return i;
+}
+
+// A session appeared after enumeration: add it and give it its group's current level,
+// so an app joining the mix does not play at 100% until the fader moves. Audio worker only.
+static void AddSessionOnWorker(IAudioSessionControl *pSessionControl)
+{
+    if (!g_wasapiInitialized)
+    {
+        return; // The next initialization enumerates it
+    }
+    if (std::find(g_sessionControls.begin(), g_sessionControls.end(), pSessionControl) != g_sessionControls.end())
+    {
+        return; // Reported while the enumeration that already added it was running
+    }
+
+    const uint64_t snapshotsBefore = g_processCache.Snapshots();
+    const size_t index = AppendSession(pSessionControl);
+    Metrics().processLookups.Increment(g_processCache.Snapshots() - snapshotsBefore);
+    Metrics().audioSessions.Set(static_cast<int64_t>(g_sessionNames.size()));
+    std::cerr << "New audio session " << index << ": " << ws2s(g_sessionNames[index]) << std::endl;
+    PublishSessionTable();
+
+    const int groupIndex = g_sessionGroups.Primary(index);
+    if (!g_sessionVolumes[index] || groupIndex < 0)
+    {
+        return;
+    }
+
+    float volume = 0.0f;
+    const std::string &group = g_sessionGroups.Matcher()->Groups()[groupIndex];
+    if (!g_groupVolumes.Target(group, volume))
+    {
+        return;
+    }
+    volume *= g_ducking.Gain(static_cast<size_t>(groupIndex)); // Joins a ducked group turned down like the rest of it
+
+    Metrics().volumeWritesIssued.Increment();
+    Metrics().newSessionVolumes.Increment();
+    const int64_t comStartNs = TraceNowNs();
+    HRESULT hr = g_sessionVolumes[index]->SetMasterVolume(volume, NULL);
+    Metrics().comCallDuration.ObserveNs(static_cast<uint64_t>(TraceNowNs() - comStartNs));
+    if (SUCCEEDED(hr))
+    {
+        std::cerr << "  Applied group \"" << group << "\" volume " << volume << " to new session" << std::endl;
+    }
+    else
+    {
+        std::cerr << "  ERROR: Failed to set volume of new session, hr=" << std::hex << hr << std::dec << std::endl;
+    }
+}
+
+// A session expired or was disconnected: drop its row, so the table follows the live
+// sessions without re-enumerating. Rows after it move up by one. Audio worker only.
+static void RemoveSessionOnWorker(uint64_t id)
+{
+    const auto found = std::find(g_sessionIds.begin(), g_sessionIds.end(), id);
+    if (found == g_sessionIds.end())
+    {
+        return; // Already gone with a cleanup or re-enumeration
+    }
+
+    const size_t index = static_cast<size_t>(found - g_sessionIds.begin());
+    std::cerr << "Audio session " << index << " expired: " << ws2s(g_sessionNames[index]) << std::endl;
+    ReleaseSessionSlot(index);
+    g_sessionVolumes.erase(g_sessionVolumes.begin() + index);
+    g_sessionMeters.erase(g_sessionMeters.begin() + index);
+    g_sessionControls.erase(g_sessionControls.begin() + index);
+    g_sessionEvents.erase(g_sessionEvents.begin() + index);
+    g_sessionIds.erase(g_sessionIds.begin() + index);
+    g_sessionNames.erase(g_sessionNames.begin() + index);
+    g_sessionDisplayNames.erase(g_sessionDisplayNames.begin() + index);
+    g_sessionPids.erase(g_sessionPids.begin() + index);
+    g_sessionNameIds.erase(g_sessionNameIds.begin() + index);
+    g_sessionGroups.Remove(index);
+
+    Metrics().expiredSessions.Increment();
+    Metrics().audioSessions.Set(static_cast<int64_t>(g_sessionNames.size()));
+    PublishSessionTable();
+}
+
+// IAudioSessionNotification sink. WASAPI calls it on one of its own threads, so it only
+// hands the new session to the audio worker, which owns the session table.
+class SessionNotifier : public IAudioSessionNotification
+{
+public:
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        return InterlockedIncrement(&m_refs);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        const ULONG refs = InterlockedDecrement(&m_refs);
+        if (refs == 0)
+        {
+            delete this;
+        }
+        return refs;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv) override
+    {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IAudioSessionNotification))
+        {
+            *ppv = static_cast<IAudioSessionNotification *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnSessionCreated(IAudioSessionControl *pNewSession) override
+    {
+        if (!pNewSession)
+        {
+            return S_OK;
+        }
+
+        // Released when the task is done, or dropped if the worker is stopping
+        pNewSession->AddRef();
+        std::shared_ptr<IAudioSessionControl> session(pNewSession, [](IAudioSessionControl *control)
+                                                      { control->Release(); });
+        g_audioWorker.Submit([session]()
+                             { AddSessionOnWorker(session.get()); });
+        return S_OK;
+    }
+
+private:
+    LONG m_refs = 1;
+};
+
+// Builds the session table. Runs on the audio worker, which owns the COM apartment.
+static bool InitializeWasapiOnWorker()
 {
     std::cerr << "\n\n*** Initializing WASAPI ***\n\n"
               << std::endl;
@@ -216,18 +650,10 @@ bool InitializeWasapi()
         CleanupWasapi();
     }
 
-    HRESULT hr = CoInitialize(NULL);
-    if (FAILED(hr))
-    {
-        std::cerr << "CoInitialize failed: " << std::hex << hr << std::endl;
-        return false;
-    }
-
-    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (void **)&g_pEnumerator);
+    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (void **)&g_pEnumerator);
     if (FAILED(hr))
     {
         std::cerr << "CoCreateInstance(MMDeviceEnumerator) failed: " << std::hex << hr << std::endl;
-        CoUninitialize();
         return false;
     }
 
@@ -236,7 +662,6 @@ bool InitializeWasapi()
     {
         std::cerr << "GetDefaultAudioEndpoint failed: " << std::hex << hr << std::endl;
         SafeRelease(g_pEnumerator);
-        CoUninitialize();
         return false;
     }
 
@@ -246,7 +671,6 @@ bool InitializeWasapi()
         std::cerr << "Activate(IAudioSessionManager2) failed: " << std::hex << hr << std::endl;
         SafeRelease(g_pDevice);
         SafeRelease(g_pEnumerator);
-        CoUninitialize();
         return false;
     }
 
@@ -258,7 +682,6 @@ bool InitializeWasapi()
         SafeRelease(g_pSessionManager);
         SafeRelease(g_pDevice);
         SafeRelease(g_pEnumerator);
-        CoUninitialize();
         return false;
     }
 
@@ -271,13 +694,35 @@ bool InitializeWasapi()
         SafeRelease(g_pSessionManager);
         SafeRelease(g_pDevice);
         SafeRelease(g_pEnumerator);
-        CoUninitialize();
         return false;
     }
 
     std::cerr << "Found " << sessionCount << " audio sessions" << std::endl;
-    g_sessionVolumes.resize(sessionCount);
-    g_sessionNames.resize(sessionCount);
+    g_sessionVolumes.reserve(sessionCount);
+    g_sessionMeters.reserve(sessionCount);
+    g_sessionControls.reserve(sessionCount);
+    g_sessionEvents.reserve(sessionCount);
+    g_sessionIds.reserve(sessionCount);
+    g_sessionNames.reserve(sessionCount);
+    g_sessionDisplayNames.reserve(sessionCount);
+    g_sessionPids.reserve(sessionCount);
+    g_sessionNameIds.reserve(sessionCount);
+    g_sessionGroups.Reserve(sessionCount);
+    g_sessionGroups.Rematch(std::atomic_load(&g_appMatcher), nullptr); // The table is empty here
+
+    // Sessions created from now on are reported. Registered before the walk, so none is
+    // missed in between; one reported that the walk also finds is added only once.
+    g_sessionNotifier = new SessionNotifier();
+    hr = g_pSessionManager->RegisterSessionNotification(g_sessionNotifier);
+    if (FAILED(hr))
+    {
+        std::cerr << "RegisterSessionNotification failed: " << std::hex << hr << std::dec << std::endl;
+        SafeRelease(g_sessionNotifier);
+    }
+
+    // One snapshot for all sessions; new processes are resolved, exited ones evicted
+    const uint64_t snapshotsBefore = g_processCache.Snapshots();
+    g_processCache.Refresh();
 
     for (int i = 0; i < sessionCount; ++i)
     {
@@ -285,71 +730,29 @@ bool InitializeWasapi()
         hr = pSessionEnumerator->GetSession(i, &pSessionControl);
         if (FAILED(hr))
         {
-            g_sessionVolumes[i] = NULL; // Set this slot to NULL since we're skipping it
-            g_sessionNames[i] = L"Unknown Session";
-            continue;
-        }
-
-        hr = pSessionControl->QueryInterface(__uuidof(ISimpleAudioVolume), (void **)&g_sessionVolumes[i]);
-        if (FAILED(hr))
-        {
-            g_sessionVolumes[i] = NULL; // Set to NULL explicitly on failure
-            SafeRelease(pSessionControl);
-            g_sessionNames[i] = L"Unknown Session";
+            g_sessionVolumes.push_back(NULL); // Keep a slot since we're skipping it
+            g_sessionMeters.push_back(NULL);
+            g_sessionControls.push_back(NULL);
+            g_sessionEvents.push_back(NULL);
+            g_sessionIds.push_back(g_nextSessionId++);
+            g_sessionNames.push_back(L"Unknown Session");
+            g_sessionDisplayNames.push_back(std::wstring());
+            g_sessionPids.push_back(0);
+            g_sessionNameIds.push_back(NO_NAME);
+            g_sessionGroups.Add(SessionIdentity());
             continue;
         }
 
-        IAudioSessionControl2 *pSessionControl2 = NULL;
-        hr = pSessionControl->QueryInterface(__uuidof(IAudioSessionControl2), (void **)&pSessionControl2);
-        if (SUCCEEDED(hr))
-        {
-            DWORD processId = 0;
-            hr = pSessionControl2->GetProcessId(&processId);
-
-            LPWSTR sessionDisplayName = NULL;
-            if (SUCCEEDED(pSessionControl2->GetDisplayName(&sessionDisplayName)))
-            {
-                std::cerr << "Session " << i << " display name: " << ws2s(sessionDisplayName) << std::endl;
-                CoTaskMemFree(sessionDisplayName);
-            }
-
-            std::wstring appName = L"Unknown Session";
-            if (SUCCEEDED(hr) && processId != 0)
-            {
-                HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
-                if (hProcess != NULL)
-                {
-                    WCHAR processName[MAX_PATH];
-                    DWORD size = MAX_PATH;
-                    if (QueryFullProcessImageNameW(hProcess, 0, processName, &size))
-                    {
-                        WCHAR *fileName = wcsrchr(processName, L'\\');
-                        if (fileName)
-                        {
-                            appName = fileName + 1;
-                        }
-                        else
-                        {
-                            appName = processName;
-                        }
-                        std::cerr << "Session " << i << " process name: " << ws2s(appName) << std::endl;
-                    }
-                    CloseHandle(hProcess);
-                }
-            }
-            g_sessionNames[i] = appName;
-            SafeRelease(pSessionControl2);
-        }
-        else
-        {
-            g_sessionNames[i] = L"Unknown Session";
-        }
-
+        AppendSession(pSessionControl);
         SafeRelease(pSessionControl);
     }
 
     SafeRelease(pSessionEnumerator);
     g_wasapiInitialized = true;
+    PublishSessionTable();
+    ApplyDuckingRulesOnWorker();
+    Metrics().audioSessions.Set(sessionCount);
+    Metrics().processLookups.Increment(g_processCache.Snapshots() - snapshotsBefore);
 
     // Debug output of session names
     std::cerr << "Audio session names:" << std::endl;
@@ -361,16 +764,22 @@ bool InitializeWasapi()
     return true;
 }
 
-void RefreshAudioSessions()
+static void RefreshAudioSessionsOnWorker()
 {
     std::cerr << "\n\n*** Refreshing audio sessions... ***\n\n"
               << std::endl;
 
+    const int64_t refreshStartNs = TraceNowNs();
+    Metrics().sessionRefreshes.Increment();
+
     // Clean up and re-initialize
     CleanupWasapi();
 
     // Re-initialize the sessions
-    if (!InitializeWasapi())
+    bool refreshed = InitializeWasapiOnWorker();
+    Metrics().sessionRefreshDuration.ObserveNs(static_cast<uint64_t>(TraceNowNs() - refreshStartNs));
+
+    if (!refreshed)
     {
         std::cerr << "Failed to reinitialize WASAPI during refresh." << std::endl;
     }
@@ -387,14 +796,15 @@ void RefreshAudioSessions()
     }
 }
 
-void SetApplicationVolume(const std::wstring &appName, float volume)
+static void SetApplicationVolumeOnWorker(NameId app, float volume)
 {
+    const std::wstring &appName = AppNames().Wide(app);
     std::wcout << L"\n======= Setting volume for app: \"" << appName << L"\" to " << volume << L" ========" << std::endl;
 
     if (!g_wasapiInitialized)
     {
         std::cerr << "WASAPI not initialized, initializing now..." << std::endl;
-        if (!InitializeWasapi())
+        if (!InitializeWasapiOnWorker())
         {
             std::cerr << "Failed to initialize WASAPI for volume control" << std::endl;
             return;
@@ -404,144 +814,156 @@ void SetApplicationVolume(const std::wstring &appName, float volume)
     // Clamp volume to valid range
     volume = (std::max)(0.0f, (std::min)(1.0f, volume));
 
-    // Debug: print current audio sessions
-    std::wcout << L"Current audio sessions (" << g_sessionNames.size() << L"):" << std::endl;
-    for (size_t i = 0; i < g_sessionNames.size(); ++i)
+    // Exact match is an ID compare; the partial and reverse string matches (all
+    // case-insensitive) only run for names that are not a session's executable
+    SessionMatchKind kind = SessionMatchKind::None;
+    int index = -1;
+    for (size_t i = 0; i < g_sessionNameIds.size(); ++i)
+    {
+        if (g_sessionNameIds[i] == app && app != NO_NAME && g_sessionVolumes[i])
+        {
+            kind = SessionMatchKind::Exact;
+            index = static_cast<int>(i);
+            break;
+        }
+    }
+    if (index < 0)
     {
-        std::wcout << L"  " << i << L": \"" << g_sessionNames[i] << L"\" (volume control: "
-                   << (g_sessionVolumes[i] ? L"available" : L"NULL") << L")" << std::endl;
+        index = FindSessionForApp(g_sessionNames, appName, [](size_t i)
+                                  { return g_sessionVolumes[i] != nullptr; },
+                                  kind);
+    }
+    if (index < 0)
+    {
+        Metrics().volumeWritesSkipped.Increment();
+        std::wcout << L"⚠️ NO MATCH FOUND for \"" << appName << L"\"" << std::endl;
+        return;
     }
 
-    // Convert appName to lowercase for case-insensitive comparison
-    std::wstring lowerAppName = appName;
-    std::transform(lowerAppName.begin(), lowerAppName.end(), lowerAppName.begin(),
-                   [](wchar_t c)
-                   { return std::towlower(c); });
+    const wchar_t *kindName = kind == SessionMatchKind::Exact     ? L"EXACT"
+                              : kind == SessionMatchKind::Partial ? L"PARTIAL"
+                                                                  : L"REVERSE";
+    std::wcout << L"  " << kindName << L" MATCH found with session " << index << L": \""
+               << g_sessionNames[index] << L"\"" << std::endl;
+
+    TRACE_MARK_CURRENT(TraceStage::SessionResolved);
+    Metrics().volumeWritesIssued.Increment();
+    const int64_t comStartNs = TraceNowNs();
+    HRESULT hr = g_sessionVolumes[index]->SetMasterVolume(volume, NULL);
+    Metrics().comCallDuration.ObserveNs(static_cast<uint64_t>(TraceNowNs() - comStartNs));
+    if (SUCCEEDED(hr))
+    {
+        TRACE_MARK_CURRENT(TraceStage::VolumeApplied);
+        std::wcout << L"  Volume of " << g_sessionNames[index] << L" set to " << volume << std::endl;
+    }
+    else
+    {
+        std::wcout << L"  ERROR: Failed to set volume, hr=" << std::hex << hr << std::endl;
+    }
+}
 
-    // Try exact match first (case-insensitive)
-    std::wcout << L"Looking for exact match (case-insensitive)..." << std::endl;
-    for (size_t i = 0; i < g_sessionNames.size(); ++i)
+// Writes a volume to every session matched into a group and returns how many took it.
+// Audio worker only.
+static size_t WriteGroupVolumeOnWorker(int groupIndex, float volume)
+{
+    size_t applied = 0;
+    for (uint32_t i : g_sessionGroups.Sessions(groupIndex))
     {
-        // Convert session name to lowercase for case-insensitive comparison
-        std::wstring lowerSessionName = g_sessionNames[i];
-        std::transform(lowerSessionName.begin(), lowerSessionName.end(), lowerSessionName.begin(),
-                       [](wchar_t c)
-                       { return std::towlower(c); });
+        if (!g_sessionVolumes[i])
+        {
+            continue;
+        }
 
-        if (lowerSessionName == lowerAppName)
+        if (applied == 0)
         {
-            std::wcout << L"  EXACT MATCH found with session " << i << L": \"" << g_sessionNames[i] << L"\"" << std::endl;
-            if (g_sessionVolumes[i])
-            {
-                HRESULT hr = g_sessionVolumes[i]->SetMasterVolume(volume, NULL);
-                if (SUCCEEDED(hr))
-                {
-                    std::wcout << L"  Volume of " << g_sessionNames[i] << L" set to " << volume << std::endl;
-                }
-                else
-                {
-                    std::wcout << L"  ERROR: Failed to set volume, hr=" << std::hex << hr << std::endl;
-                }
-                return;
-            }
-            else
-            {
-                std::wcout << L"  ERROR: Volume interface is NULL for this session" << std::endl;
-            }
+            TRACE_MARK_CURRENT(TraceStage::SessionResolved);
         }
+        Metrics().volumeWritesIssued.Increment();
+        const int64_t comStartNs = TraceNowNs();
+        HRESULT hr = g_sessionVolumes[i]->SetMasterVolume(volume, NULL);
+        Metrics().comCallDuration.ObserveNs(static_cast<uint64_t>(TraceNowNs() - comStartNs));
+        if (FAILED(hr))
+        {
+            std::cerr << "  ERROR: Failed to set volume of " << ws2s(g_sessionNames[i]) << ", hr=" << std::hex << hr << std::dec << std::endl;
+            continue;
+        }
+        ++applied;
     }
+    return applied;
+}
 
-    // If no exact match, try partial matches (case-insensitive)
-    std::wcout << L"No exact match found, trying partial matches (case-insensitive)..." << std::endl;
-
-    // First try normal partial match (app name in session name)
-    for (size_t i = 0; i < g_sessionNames.size(); ++i)
+// Applies a group fader to every session matched into that group, times the group's
+// duck gain while a ducking rule holds it down. Audio worker only.
+static void SetGroupVolumeOnWorker(const std::string &groupName, float volume)
+{
+    if (!g_wasapiInitialized)
     {
-        // Convert session name to lowercase for case-insensitive comparison
-        std::wstring lowerSessionName = g_sessionNames[i];
-        std::transform(lowerSessionName.begin(), lowerSessionName.end(), lowerSessionName.begin(),
-                       [](wchar_t c)
-                       { return std::towlower(c); });
-
-        // Check if app name is found within session name (case-insensitive)
-        bool partialMatch = lowerSessionName.find(lowerAppName) != std::wstring::npos;
-        if (partialMatch)
+        std::cerr << "WASAPI not initialized, initializing now..." << std::endl;
+        if (!InitializeWasapiOnWorker())
         {
-            std::wcout << L"  PARTIAL MATCH found: \"" << appName << L"\" is part of \"" << g_sessionNames[i] << L"\"" << std::endl;
-            if (g_sessionVolumes[i])
-            {
-                HRESULT hr = g_sessionVolumes[i]->SetMasterVolume(volume, NULL);
-                if (SUCCEEDED(hr))
-                {
-                    std::wcout << L"  Volume of " << g_sessionNames[i] << L" set to " << volume << std::endl;
-                }
-                else
-                {
-                    std::wcout << L"  ERROR: Failed to set volume, hr=" << std::hex << hr << std::endl;
-                }
-                return;
-            }
-            else
-            {
-                std::wcout << L"  ERROR: Volume interface is NULL for this session" << std::endl;
-            }
+            std::cerr << "Failed to initialize WASAPI for volume control" << std::endl;
+            return;
         }
     }
 
-    // Then try reverse partial match (session name in app name)
-    for (size_t i = 0; i < g_sessionNames.size(); ++i)
+    const int groupIndex = g_sessionGroups.Matcher() ? g_sessionGroups.Matcher()->FindGroup(groupName) : -1;
+    volume = (std::max)(0.0f, (std::min)(1.0f, volume));
+    if (groupIndex >= 0)
     {
-        if (!g_sessionNames[i].empty())
-        {
-            // Convert session name to lowercase for case-insensitive comparison
-            std::wstring lowerSessionName = g_sessionNames[i];
-            std::transform(lowerSessionName.begin(), lowerSessionName.end(), lowerSessionName.begin(),
-                           [](wchar_t c)
-                           { return std::towlower(c); });
-
-            bool reverseMatch = lowerAppName.find(lowerSessionName) != std::wstring::npos;
-            if (reverseMatch)
-            {
-                std::wcout << L"  REVERSE MATCH found: \"" << g_sessionNames[i] << L"\" is part of \"" << appName << L"\"" << std::endl;
-                if (g_sessionVolumes[i])
-                {
-                    HRESULT hr = g_sessionVolumes[i]->SetMasterVolume(volume, NULL);
-                    if (SUCCEEDED(hr))
-                    {
-                        std::wcout << L"  Volume of " << g_sessionNames[i] << L" set to " << volume << std::endl;
-                    }
-                    else
-                    {
-                        std::wcout << L"  ERROR: Failed to set volume, hr=" << std::hex << hr << std::endl;
-                    }
-                    return;
-                }
-                else
-                {
-                    std::wcout << L"  ERROR: Volume interface is NULL for this session" << std::endl;
-                }
-            }
-        }
+        volume = g_ducking.SetFader(static_cast<size_t>(groupIndex), volume);
     }
 
-    // No match found
-    std::wcout << L"⚠️ NO MATCH FOUND for \"" << appName << L"\"" << std::endl;
+    const size_t applied = WriteGroupVolumeOnWorker(groupIndex, volume);
+    if (applied == 0)
+    {
+        Metrics().volumeWritesSkipped.Increment();
+        return;
+    }
+    TRACE_MARK_CURRENT(TraceStage::VolumeApplied);
+    std::cerr << "Group \"" << groupName << "\" set to " << volume << " on " << applied << " session(s)" << std::endl;
 }
 
-std::vector<std::wstring> GetApplicationNames()
+// A ducking envelope moved a group's output (fader x duck gain). Audio worker only.
+static void ApplyDuckOnWorker(size_t group, float volume)
 {
-    if (!g_wasapiInitialized)
+    if (group < g_sessionGroups.GroupCount() && WriteGroupVolumeOnWorker(static_cast<int>(group), volume) > 0)
     {
-        InitializeWasapi();
+        Metrics().duckWrites.Increment();
     }
-    return g_sessionNames;
 }
 
-void ToggleMuteApplication(const std::wstring &appName)
+// Resolves the ducking rules against the current groups, and feeds the engine meter
+// frames only while it has a rule to run. Audio worker only.
+static void ApplyDuckingRulesOnWorker()
+{
+    g_ducking.SetRules(std::atomic_load(&g_duckingRules), g_sessionGroups.Matcher());
+    if (g_ducking.Active() && g_duckingSubscription == 0)
+    {
+        g_duckingSubscription = g_peakMeters.Subscribe([](const MeterFrame &frame)
+                                                       { g_ducking.Process(frame, std::chrono::steady_clock::now()); });
+    }
+    else if (!g_ducking.Active() && g_duckingSubscription != 0)
+    {
+        g_peakMeters.Unsubscribe(g_duckingSubscription);
+        g_duckingSubscription = 0;
+    }
+}
+
+// Picks up the latest group rules and re-matches the sessions already in the table. Audio worker only.
+static void RematchSessionsOnWorker()
+{
+    g_sessionGroups.Rematch(std::atomic_load(&g_appMatcher), [](size_t i)
+                            {
+        const ProcessInfo *process = g_sessionPids[i] != 0 ? g_processCache.Find(g_sessionPids[i]) : nullptr;
+        return IdentifySession(i, process); });
+    ApplyDuckingRulesOnWorker(); // Group indices may have moved
+}
+
+static void ToggleMuteApplicationOnWorker(const std::wstring &appName)
 {
     if (!g_wasapiInitialized)
     {
-        InitializeWasapi();
+        InitializeWasapiOnWorker();
     }
 
     // Convert appName to lowercase for case-insensitive comparison
@@ -606,3 +1028,154 @@ void ToggleMuteApplication(const std::wstring &appName)
 
     std::wcout << L"No matching application found for: " << appName << std::endl;
 }
+
+// One meter tick: a pass over every session's meter, then the listeners. Audio worker only.
+static void SampleMetersOnWorker()
+{
+    if (g_wasapiInitialized && g_peakMeters.Sample())
+    {
+        Metrics().meterSamples.Increment();
+    }
+}
+
+// Installs or removes the meter tick as the first listener arrives or the last one leaves
+static void ActivateMeters(bool sampling)
+{
+    if (sampling)
+    {
+        g_audioWorker.SetTick(std::chrono::milliseconds(g_meterPeriodMs.load()), SampleMetersOnWorker);
+    }
+    else
+    {
+        g_audioWorker.SetTick(std::chrono::milliseconds(0), nullptr);
+    }
+}
+
+// --- Public API: forwards to the audio worker ---
+
+bool InitializeWasapi()
+{
+    if (g_audioWorker.IsRunning())
+    {
+        if (g_wasapiInitialized)
+        {
+            return true;
+        }
+        // A previous attempt failed (e.g. no audio endpoint yet), retry on the worker
+        return g_audioWorker.Submit(InitializeWasapiOnWorker).get();
+    }
+    const bool started = g_audioWorker.Start(InitializeWasapiOnWorker, SetApplicationVolumeOnWorker, SetGroupVolumeOnWorker, CleanupWasapi);
+    // After the start, so listeners that arrived before it get their tick now
+    g_peakMeters.SetActivation(ActivateMeters);
+    return started;
+}
+
+void StopWasapi()
+{
+    g_audioWorker.Stop();
+}
+
+std::shared_future<void> RefreshAudioSessionsShared()
+{
+    std::lock_guard<std::mutex> lock(g_refreshMutex);
+    if (g_refreshInFlight.valid() &&
+        g_refreshInFlight.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        Metrics().sessionRefreshesShared.Increment();
+        return g_refreshInFlight; // Join the enumeration that is already running
+    }
+    g_refreshInFlight = g_audioWorker.Submit(RefreshAudioSessionsOnWorker).share();
+    return g_refreshInFlight;
+}
+
+void RefreshAudioSessions()
+{
+    try
+    {
+        RefreshAudioSessionsShared().get();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "RefreshAudioSessions failed: " << e.what() << std::endl;
+    }
+}
+
+void RequestAudioSessionRefresh()
+{
+    // Nobody waits on the future: a changed table bumps the session list version
+    RefreshAudioSessionsShared();
+}
+
+void SetApplicationVolume(const std::wstring &appName, float volume)
+{
+    SetApplicationVolume(AppNames().Intern(appName), volume);
+}
+
+void SetApplicationVolume(NameId app, float volume)
+{
+    // Fire and forget: the worker coalesces writes that pile up for the same app
+    g_audioWorker.SetVolume(app, volume);
+}
+
+void SetGroupVolume(const std::string &groupName, float volume)
+{
+    // Fire and forget: coalesced per group like SetApplicationVolume
+    g_audioWorker.SetGroupVolume(groupName, volume);
+}
+
+void SetMeterSettings(const MeterSettings &settings)
+{
+    if (g_meterPeriodMs.exchange(settings.period.count()) != settings.period.count() && g_audioWorker.IsRunning())
+    {
+        g_peakMeters.SetActivation(ActivateMeters); // Reinstalls a running tick with the new period
+    }
+}
+
+void SetDuckingRules(std::shared_ptr<const DuckingRules> rules)
+{
+    std::atomic_store(&g_duckingRules, std::move(rules));
+    // If the worker is not running yet, its initialization picks the rules up
+    g_audioWorker.Submit(ApplyDuckingRulesOnWorker);
+}
+
+void SetAppMatcher(std::shared_ptr<const AppMatcher> matcher)
+{
+    std::atomic_store(&g_appMatcher, std::move(matcher));
+    // If the worker is not running yet, the next initialization picks the rules up
+    g_audioWorker.Submit(RematchSessionsOnWorker);
+}
+
+std::shared_ptr<const SessionList> CurrentSessionList()
+{
+    return std::atomic_load(&g_sessionList);
+}
+
+std::vector<std::wstring> GetApplicationNames(uint64_t *version)
+{
+    try
+    {
+        return g_audioWorker.Submit([version]()
+                                    {
+            if (!g_wasapiInitialized)
+            {
+                InitializeWasapiOnWorker();
+            }
+            if (version)
+            {
+                *version = std::atomic_load(&g_sessionList)->version;
+            }
+            return g_sessionNames; })
+            .get();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "GetApplicationNames failed: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+void ToggleMuteApplication(const std::wstring &appName)
+{
+    g_audioWorker.Submit([appName]()
+                         { ToggleMuteApplicationOnWorker(appName); });
+}
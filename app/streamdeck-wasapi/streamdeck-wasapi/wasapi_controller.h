@@ -2,8 +2,16 @@
 #define WASAPI_CONTROLLER_H
 
 #include <windows.h>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <memory>
+#include "group_volumes.h"
+#include "app_matcher.h"
+#include "version_waiters.h"
+#include "peak_meters.h"
+#include "ducking.h"
 
 //moved these globals to .cpp
 //extern HINSTANCE hInst;
@@ -18,15 +26,41 @@ void RemoveTrayIcon(HWND hwnd);
 void HandleTrayIconClick(HWND hwnd, LPARAM lParam);
 std::string ws2s(const std::wstring& wstr);
 
+// Session names as last published by the audio worker
+struct SessionList
+{
+    uint64_t version = 0;              // Bumped whenever the names change
+    std::vector<std::wstring> names;
+};
+
 // WASAPI Functions
+// All WASAPI state is owned by the audio worker thread (see audio_worker.h);
+// these functions forward to it and are safe to call from any thread.
+void StopWasapi();
 bool InitializeWasapi();
 void SetApplicationVolume(const std::wstring& appName, float volume);
-std::vector<std::wstring> GetApplicationNames();
+void SetApplicationVolume(NameId app, float volume); // No string work per call
+void SetGroupVolume(const std::string& groupName, float volume);
+void SetAppMatcher(std::shared_ptr<const AppMatcher> matcher); // Re-matches existing sessions
+std::vector<std::wstring> GetApplicationNames(uint64_t* version = nullptr); // version: the session table version they belong to
+std::shared_ptr<const SessionList> CurrentSessionList(); // Lock-free; does not wait for the audio worker
 void ToggleMuteApplication(const std::wstring& appName);
 void ShowTrayBalloonTip(const wchar_t* title, const wchar_t* message, DWORD infoFlags);
-extern void RefreshAudioSessions();
+extern void RefreshAudioSessions(); // Waits; concurrent callers share one enumeration
+void RequestAudioSessionRefresh(); // Returns at once; the new table is announced through g_sessionWaiters
+void SetMeterSettings(const MeterSettings& settings); // Sampling rate; a running tick picks it up at once
+void SetDuckingRules(std::shared_ptr<const DuckingRules> rules); // Group names are resolved on the audio worker
+
+extern std::atomic<bool> g_wasapiInitialized;
+
+// Parked get-apps long polls, completed when the session list version changes
+extern VersionWaiters g_sessionWaiters;
+
+// Session and group peak levels, sampled on the audio worker while anyone listens
+extern PeakMeters g_peakMeters;
 
-bool g_wasapiInitialized = false;
+// The level each group's fader last set; new sessions start at that level
+extern GroupVolumes g_groupVolumes;
 
 
 #endif // WASAPI_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,347 @@
+#include "wire_format.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+    std::string Trim(const std::string &text, size_t begin, size_t end)
+    {
+        while (begin < end && std::isspace(static_cast<unsigned char>(text[begin])))
+        {
+            ++begin;
+        }
+        while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1])))
+        {
+            --end;
+        }
+        std::string result = text.substr(begin, end - begin);
+        for (char &c : result)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return result;
+    }
+
+    // q-value of one media range's parameters ("; q=0.5"); 1 when absent
+    double QualityOf(const std::string &params)
+    {
+        size_t pos = 0;
+        while (pos < params.size())
+        {
+            size_t end = params.find(';', pos);
+            if (end == std::string::npos)
+            {
+                end = params.size();
+            }
+            std::string param = Trim(params, pos, end);
+            if (param.size() > 2 && param[0] == 'q' && param[1] == '=')
+            {
+                return std::strtod(param.c_str() + 2, nullptr);
+            }
+            pos = end + 1;
+        }
+        return 1.0;
+    }
+
+    // MessagePack writers (https://github.com/msgpack/msgpack/blob/master/spec.md)
+    void MsgPackUint(std::string &out, uint32_t value)
+    {
+        if (value < 0x80)
+        {
+            out += static_cast<char>(value);
+        }
+        else if (value <= 0xFF)
+        {
+            out += static_cast<char>(0xCC);
+            out += static_cast<char>(value);
+        }
+        else if (value <= 0xFFFF)
+        {
+            out += static_cast<char>(0xCD);
+            out += static_cast<char>(value >> 8);
+            out += static_cast<char>(value);
+        }
+        else
+        {
+            out += static_cast<char>(0xCE);
+            out += static_cast<char>(value >> 24);
+            out += static_cast<char>(value >> 16);
+            out += static_cast<char>(value >> 8);
+            out += static_cast<char>(value);
+        }
+    }
+
+    void MsgPackInt(std::string &out, int value)
+    {
+        if (value >= 0)
+        {
+            MsgPackUint(out, static_cast<uint32_t>(value));
+        }
+        else if (value >= -32)
+        {
+            out += static_cast<char>(value); // Negative fixint
+        }
+        else
+        {
+            uint32_t bits = static_cast<uint32_t>(value);
+            out += static_cast<char>(0xD2);
+            out += static_cast<char>(bits >> 24);
+            out += static_cast<char>(bits >> 16);
+            out += static_cast<char>(bits >> 8);
+            out += static_cast<char>(bits);
+        }
+    }
+
+    void MsgPackArray(std::string &out, size_t size)
+    {
+        if (size < 16)
+        {
+            out += static_cast<char>(0x90 | size);
+        }
+        else
+        {
+            out += static_cast<char>(0xDC);
+            out += static_cast<char>(size >> 8);
+            out += static_cast<char>(size);
+        }
+    }
+
+    void MsgPackString(std::string &out, const std::string &text)
+    {
+        size_t size = text.size();
+        if (size < 32)
+        {
+            out += static_cast<char>(0xA0 | size);
+        }
+        else if (size <= 0xFF)
+        {
+            out += static_cast<char>(0xD9);
+            out += static_cast<char>(size);
+        }
+        else
+        {
+            out += static_cast<char>(0xDA);
+            out += static_cast<char>(size >> 8);
+            out += static_cast<char>(size);
+        }
+        out += text;
+    }
+
+    // CBOR writers (RFC 8949): a major type and its argument
+    void CborHead(std::string &out, uint8_t major, uint32_t argument)
+    {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (argument < 24)
+        {
+            out += static_cast<char>(type | argument);
+        }
+        else if (argument <= 0xFF)
+        {
+            out += static_cast<char>(type | 24);
+            out += static_cast<char>(argument);
+        }
+        else if (argument <= 0xFFFF)
+        {
+            out += static_cast<char>(type | 25);
+            out += static_cast<char>(argument >> 8);
+            out += static_cast<char>(argument);
+        }
+        else
+        {
+            out += static_cast<char>(type | 26);
+            out += static_cast<char>(argument >> 24);
+            out += static_cast<char>(argument >> 16);
+            out += static_cast<char>(argument >> 8);
+            out += static_cast<char>(argument);
+        }
+    }
+
+    void CborInt(std::string &out, int value)
+    {
+        if (value >= 0)
+        {
+            CborHead(out, 0, static_cast<uint32_t>(value));
+        }
+        else
+        {
+            CborHead(out, 1, static_cast<uint32_t>(-1 - static_cast<int64_t>(value)));
+        }
+    }
+
+    void CborString(std::string &out, const std::string &text)
+    {
+        CborHead(out, 3, static_cast<uint32_t>(text.size()));
+        out += text;
+    }
+
+    // Keeps the two encodings of the compact schema in one place
+    struct CompactWriter
+    {
+        WireFormat format;
+        std::string &out;
+
+        void Map(size_t size)
+        {
+            if (format == WireFormat::MsgPack)
+            {
+                out += static_cast<char>(0x80 | size); // fixmap, size < 16
+            }
+            else
+            {
+                CborHead(out, 5, static_cast<uint32_t>(size));
+            }
+        }
+
+        void Array(size_t size)
+        {
+            if (format == WireFormat::MsgPack)
+            {
+                MsgPackArray(out, size);
+            }
+            else
+            {
+                CborHead(out, 4, static_cast<uint32_t>(size));
+            }
+        }
+
+        void String(const std::string &text)
+        {
+            if (format == WireFormat::MsgPack)
+            {
+                MsgPackString(out, text);
+            }
+            else
+            {
+                CborString(out, text);
+            }
+        }
+
+        void Int(int value)
+        {
+            if (format == WireFormat::MsgPack)
+            {
+                MsgPackInt(out, value);
+            }
+            else
+            {
+                CborInt(out, value);
+            }
+        }
+
+        void Bool(bool value)
+        {
+            if (format == WireFormat::MsgPack)
+            {
+                out += static_cast<char>(value ? 0xC3 : 0xC2);
+            }
+            else
+            {
+                out += static_cast<char>(value ? 0xF5 : 0xF4);
+            }
+        }
+    };
+}
+
+WireFormat NegotiateWireFormat(const std::string &accept)
+{
+    double jsonQuality = 0.0;
+    double bestQuality = 0.0;
+    WireFormat best = WireFormat::Json;
+
+    size_t pos = 0;
+    while (pos < accept.size())
+    {
+        size_t end = accept.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = accept.size();
+        }
+        size_t semicolon = accept.find(';', pos);
+        size_t typeEnd = (semicolon != std::string::npos && semicolon < end) ? semicolon : end;
+        std::string type = Trim(accept, pos, typeEnd);
+        double quality = typeEnd < end ? QualityOf(accept.substr(typeEnd + 1, end - typeEnd - 1)) : 1.0;
+
+        WireFormat format = WireFormat::Json;
+        if (type == "application/msgpack" || type == "application/x-msgpack" || type == "application/vnd.msgpack")
+        {
+            format = WireFormat::MsgPack;
+        }
+        else if (type == "application/cbor")
+        {
+            format = WireFormat::Cbor;
+        }
+        else if (type == "application/json")
+        {
+            jsonQuality = (std::max)(jsonQuality, quality);
+        }
+
+        if (format != WireFormat::Json && quality > bestQuality)
+        {
+            bestQuality = quality;
+            best = format;
+        }
+        pos = end + 1;
+    }
+
+    // A binary type named at least as strongly as JSON wins; "*/*" alone keeps JSON
+    return bestQuality > 0.0 && bestQuality >= jsonQuality ? best : WireFormat::Json;
+}
+
+const char *WireContentType(WireFormat format)
+{
+    switch (format)
+    {
+    case WireFormat::MsgPack:
+        return "application/msgpack";
+    case WireFormat::Cbor:
+        return "application/cbor";
+    default:
+        return "application/json";
+    }
+}
+
+std::string EncodeWire(const json &value, WireFormat format)
+{
+    std::string body;
+    switch (format)
+    {
+    case WireFormat::MsgPack:
+        json::to_msgpack(value, nlohmann::detail::output_adapter<char>(body));
+        break;
+    case WireFormat::Cbor:
+        json::to_cbor(value, nlohmann::detail::output_adapter<char>(body));
+        break;
+    default:
+        body = value.dump();
+        break;
+    }
+    return body;
+}
+
+void EncodeControllerStateCompact(const std::vector<int> &sliders, const std::vector<int> &buttons,
+                                  bool connected, const std::string &port, WireFormat format, std::string &out)
+{
+    out.clear();
+    CompactWriter writer{format, out};
+
+    writer.Map(4);
+    writer.String("sliders");
+    writer.Array(sliders.size());
+    for (int value : sliders)
+    {
+        writer.Int(value);
+    }
+    writer.String("buttons");
+    writer.Array(buttons.size());
+    for (int state : buttons)
+    {
+        writer.Bool(state != 0);
+    }
+    writer.String("connected");
+    writer.Bool(connected);
+    writer.String("port");
+    writer.String(port);
+}
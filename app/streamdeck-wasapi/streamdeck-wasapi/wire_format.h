@@ -0,0 +1,56 @@
+#ifndef WIRE_FORMAT_H
+#define WIRE_FORMAT_H
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+// Response encodings chosen by the Accept header.
+//
+// JSON stays the default. A client that asks for application/msgpack (also
+// application/x-msgpack, application/vnd.msgpack) or application/cbor gets the same
+// document in that binary encoding. The controller state, which dashboards poll many
+// times a second, is written straight to bytes by a hand-written encoder in a compact
+// schema without the per-control "id"/"label" objects:
+//
+//   {"sliders": [512, 0, ...], "buttons": [false, true, ...], "connected": true, "port": "COM3"}
+//
+// Slider i is "Slider i+1" and button i is "Button i+1"; clients derive the labels.
+
+using json = nlohmann::json;
+
+enum class WireFormat
+{
+    Json,
+    MsgPack,
+    Cbor,
+};
+
+constexpr size_t WIRE_FORMAT_COUNT = 3;
+
+/**
+ * @brief Picks the encoding for an Accept header: the binary type with the highest
+ * q-value, if it is not ranked below application/json; else JSON. Wildcards select JSON.
+ */
+WireFormat NegotiateWireFormat(const std::string &accept);
+
+/**
+ * @brief MIME type of an encoding ("application/json", "application/msgpack", "application/cbor").
+ */
+const char *WireContentType(WireFormat format);
+
+/**
+ * @brief Encodes a document (nlohmann's binary encoders for MessagePack and CBOR).
+ */
+std::string EncodeWire(const json &value, WireFormat format);
+
+/**
+ * @brief The controller state in the compact schema above, encoded without building a
+ * JSON tree. For WireFormat::Json use BuildControllerStateJson (control_model.h), whose
+ * schema existing clients read.
+ * @param out Receives the bytes; cleared first, its capacity is reused.
+ */
+void EncodeControllerStateCompact(const std::vector<int> &sliders, const std::vector<int> &buttons,
+                                  bool connected, const std::string &port, WireFormat format, std::string &out);
+
+#endif // WIRE_FORMAT_H
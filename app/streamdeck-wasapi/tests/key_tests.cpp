@@ -0,0 +1,219 @@
+// The key name table, hotkey combo parsing and the chords combos expand into.
+
+#include <cstdio>
+#include <string>
+#include "test_harness.h"
+#include "hotkey_combo.h"
+#include "key_table.h"
+
+namespace
+{
+    // Virtual keys of a chord in press order, "+e" marking extended keys: "11 10 31"
+    std::string Keys(const KeyChord &chord)
+    {
+        std::string text;
+        for (size_t i = 0; i < chord.count && i < MAX_CHORD_KEYS; ++i)
+        {
+            char key[16];
+            std::snprintf(key, sizeof(key), "%s%x%s", i > 0 ? " " : "", chord.keys[i],
+                          (chord.extendedMask >> i) & 1 ? "+e" : "");
+            text += key;
+        }
+        return text;
+    }
+
+    std::string ComboKeys(const char *combo)
+    {
+        HotkeyCombo parsed;
+        return ParseHotkeyCombo(combo, parsed) ? Keys(BuildKeyChord(parsed)) : std::string("invalid");
+    }
+}
+
+// --- Key table ---
+
+TEST(key_table_names_are_case_insensitive)
+{
+    for (const char *name : {"Escape", "escape", "ESCAPE", "eScApE", "Esc", "esc"})
+    {
+        const KeyInfo *key = LookupKey(name);
+        CHECK(key && key->vk == 0x1B);
+    }
+    const KeyInfo *key = LookupKey("pagedown");
+    CHECK(key && key->vk == 0x22 && std::string(key->name) == "PageDown");
+}
+
+TEST(key_table_function_and_numpad_keys)
+{
+    for (int i = 1; i <= 24; ++i)
+    {
+        const std::string name = "F" + std::to_string(i);
+        const KeyInfo *key = LookupKey(name);
+        CHECK(key && key->vk == 0x70 + i - 1 && key->flags == 0 && key->modifier == 0);
+    }
+    CHECK(!LookupKey("F25") && !LookupKey("F0"));
+
+    for (int i = 0; i <= 9; ++i)
+    {
+        const KeyInfo *key = LookupKey("Numpad" + std::to_string(i));
+        CHECK(key && key->vk == 0x60 + i && key->flags == 0);
+    }
+    struct Row
+    {
+        const char *name;
+        uint16_t vk;
+        uint8_t flags;
+    };
+    const Row rows[] = {
+        {"NumpadMultiply", 0x6A, 0},
+        {"NumpadAdd", 0x6B, 0},
+        {"NumpadSubtract", 0x6D, 0},
+        {"NumpadDecimal", 0x6E, 0},
+        {"NumpadDivide", 0x6F, KEY_FLAG_EXTENDED},
+        {"NumpadEnter", 0x0D, KEY_FLAG_EXTENDED}, // Same vk as Enter, told apart by the flag
+        {"Enter", 0x0D, 0},
+        {"NumLock", 0x90, KEY_FLAG_EXTENDED},
+    };
+    for (const Row &row : rows)
+    {
+        const KeyInfo *key = LookupKey(row.name);
+        CHECK(key && key->vk == row.vk && key->flags == row.flags);
+    }
+}
+
+TEST(key_table_media_and_extended_flags)
+{
+    struct Row
+    {
+        const char *name;
+        uint16_t vk;
+        uint8_t flags;
+    };
+    const Row rows[] = {
+        {"Media_PlayPause", 0xB3, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED},
+        {"MediaPlayPause", 0xB3, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED},
+        {"Media_NextTrack", 0xB0, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED},
+        {"AudioVolumeMute", 0xAD, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED},
+        {"BrowserBack", 0xA6, KEY_FLAG_MEDIA | KEY_FLAG_EXTENDED},
+        {"ArrowUp", 0x26, KEY_FLAG_EXTENDED},
+        {"Delete", 0x2E, KEY_FLAG_EXTENDED},
+        {"RCtrl", 0xA3, KEY_FLAG_EXTENDED},
+        {"LCtrl", 0xA2, 0},
+        {"Space", 0x20, 0},
+        {";", 0xBA, 0},
+        {"Semicolon", 0xBA, 0},
+        {"?", 0xBF, KEY_FLAG_SHIFTED},
+    };
+    for (const Row &row : rows)
+    {
+        const KeyInfo *key = LookupKey(row.name);
+        CHECK(key && key->vk == row.vk && key->flags == row.flags);
+    }
+}
+
+TEST(key_table_modifiers)
+{
+    struct Row
+    {
+        const char *name;
+        uint16_t vk;
+        uint8_t modifier;
+    };
+    const Row rows[] = {
+        {"Ctrl", 0x11, KEY_MOD_CTRL},
+        {"Control", 0x11, KEY_MOD_CTRL},
+        {"Shift", 0x10, KEY_MOD_SHIFT},
+        {"Alt", 0x12, KEY_MOD_ALT},
+        {"Win", 0x5B, KEY_MOD_WIN},
+        {"Meta", 0x5B, KEY_MOD_WIN},
+        {"LWin", 0x5B, KEY_MOD_WIN},
+        {"RWin", 0x5C, KEY_MOD_RWIN},
+        {"LShift", 0xA0, 0}, // Sided keys are plain keys, not modifiers
+    };
+    for (const Row &row : rows)
+    {
+        const KeyInfo *key = LookupKey(row.name);
+        CHECK(key && key->vk == row.vk && key->modifier == row.modifier);
+    }
+
+    for (uint8_t bit : {KEY_MOD_CTRL, KEY_MOD_SHIFT, KEY_MOD_ALT, KEY_MOD_WIN, KEY_MOD_RWIN})
+    {
+        const KeyInfo *key = ModifierKey(bit);
+        CHECK(key && key->modifier == bit);
+    }
+    CHECK(ModifierKey(KEY_MOD_WIN)->vk == 0x5B && ModifierKey(KEY_MOD_RWIN)->vk == 0x5C);
+    CHECK((ModifierKey(KEY_MOD_RWIN)->flags & KEY_FLAG_EXTENDED) != 0);
+    CHECK(!ModifierKey(0) && !ModifierKey(32) && !ModifierKey(KEY_MOD_CTRL | KEY_MOD_ALT));
+}
+
+TEST(key_table_unknown_names)
+{
+    for (const char *name : {"", "NoSuchKey", "FF", "Ctrl ", " Ctrl", "Numpad10", "Media_", "Back slash", "ß"})
+    {
+        CHECK(LookupKey(name) == nullptr);
+    }
+}
+
+// --- Hotkey combos ---
+
+TEST(hotkey_combo_parses_and_expands)
+{
+    struct Row
+    {
+        const char *combo;
+        const char *keys; // Chord in press order, or "invalid"
+    };
+    const Row rows[] = {
+        {"Ctrl+Alt+S", "11 12 53"},
+        {"ctrl+ALT+s", "11 12 53"},
+        {"Meta+Shift+F13", "10 5b+e 7c"}, // Modifiers go in a fixed order, not as written
+        {"RWin+L", "5c+e 4c"},
+        {"Win+RWin+D", "5b+e 5c+e 44"},
+        {"Ctrl+Ctrl+C", "11 43"},
+        {"Ctrl+ArrowUp", "11 26+e"},
+        {"Ctrl+Shift+Media_PlayPause", "b3+e"}, // Media keys go alone
+        {"Numpad5", "65"},
+        {"Ctrl++", "11 10 bb"}, // The '+' key itself
+        {"+", "10 bb"},
+        {"Ctrl+Shift", "11 10"}, // A modifier can be the main key
+        {"", "invalid"},
+        {"Ctrl+", "invalid"},
+        {"Ctrl+++", "invalid"},
+        {"A+Ctrl", "invalid"},
+        {"A+B", "invalid"},
+        {"Ctrl+NoSuchKey", "invalid"},
+        {"Ctrl + S", "invalid"},
+        {"+Ctrl", "invalid"},
+    };
+    for (const Row &row : rows)
+    {
+        CHECK_EQ(ComboKeys(row.combo), std::string(row.keys));
+    }
+}
+
+TEST(hotkey_combo_failure_leaves_output_untouched)
+{
+    HotkeyCombo combo;
+    CHECK(ParseHotkeyCombo("Ctrl+Alt+Delete", combo));
+    CHECK_EQ(combo.modifiers, uint8_t(HOTKEY_MOD_CTRL | HOTKEY_MOD_ALT));
+    CHECK_EQ(combo.keyCode, uint16_t(0x2E));
+    CHECK_EQ(combo.keyFlags, uint8_t(KEY_FLAG_EXTENDED));
+
+    CHECK(!ParseHotkeyCombo("Ctrl+", combo));
+    CHECK(!ParseHotkeyCombo("A+Ctrl", combo));
+    CHECK_EQ(combo.keyCode, uint16_t(0x2E));
+    CHECK_EQ(combo.modifiers, uint8_t(HOTKEY_MOD_CTRL | HOTKEY_MOD_ALT));
+}
+
+TEST(hotkey_combo_shifted_symbols_hold_shift)
+{
+    CHECK_EQ(ComboKeys("Ctrl+!"), std::string("11 10 31"));
+    CHECK_EQ(ComboKeys("Ctrl+?"), std::string("11 10 bf"));
+    CHECK_EQ(ComboKeys("Ctrl++"), std::string("11 10 bb"));
+    CHECK_EQ(ComboKeys(":"), std::string("10 ba"));
+    // Named as well: Shift is still pressed once
+    CHECK_EQ(ComboKeys("Ctrl+Shift+!"), std::string("11 10 31"));
+    // Their base keys stay unshifted
+    CHECK_EQ(ComboKeys("Ctrl+1"), std::string("11 31"));
+    CHECK_EQ(ComboKeys("Ctrl+/"), std::string("11 bf"));
+    CHECK_EQ(ComboKeys("Ctrl+="), std::string("11 bb"));
+}
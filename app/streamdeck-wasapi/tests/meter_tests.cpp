@@ -0,0 +1,349 @@
+// PeakMeters against FakeMeterSource, the frame encoding and settings around it,
+// DuckingEngine fed by those frames on a simulated clock, and the control path
+// latency trace.
+
+#include <string>
+#include <utility>
+#include "test_harness.h"
+#include "ducking.h"
+#include "latency_trace.h"
+#include "peak_meters.h"
+
+namespace
+{
+    GroupMask Groups(std::initializer_list<size_t> indices)
+    {
+        GroupMask mask;
+        for (size_t index : indices)
+        {
+            mask.set(index);
+        }
+        return mask;
+    }
+}
+
+// --- PeakMeters ---
+
+TEST(peak_meters_sample_only_with_listeners)
+{
+    FakeMeterSource source;
+    source.peaks = {0.5f};
+    source.groups = {Groups({0})};
+    source.groupCount = 1;
+    PeakMeters meters(source);
+    std::vector<bool> activations;
+    meters.SetActivation([&activations](bool sampling)
+                         { activations.push_back(sampling); });
+
+    CHECK(!meters.Sample());
+    CHECK_EQ(source.reads, uint64_t(0));
+
+    int frames = 0;
+    const uint64_t first = meters.Subscribe([&frames](const MeterFrame &)
+                                            { ++frames; });
+    const uint64_t second = meters.Subscribe([&frames](const MeterFrame &)
+                                             { ++frames; });
+    CHECK(activations == std::vector<bool>{true});
+    CHECK_EQ(meters.Subscribers(), size_t(2));
+    CHECK(meters.Sample());
+    CHECK_EQ(frames, 2);
+    CHECK_EQ(source.reads, uint64_t(1));
+
+    meters.Unsubscribe(first);
+    meters.Unsubscribe(first);
+    CHECK(activations == std::vector<bool>{true});
+    meters.Unsubscribe(second);
+    CHECK(activations == (std::vector<bool>{true, false}));
+    CHECK(!meters.Sample());
+    CHECK_EQ(source.reads, uint64_t(1));
+
+    // Set again while someone listens (a new rate): restarts at once
+    meters.Subscribe([](const MeterFrame &) {});
+    meters.SetActivation([&activations](bool sampling)
+                         { activations.push_back(sampling); });
+    CHECK(activations == (std::vector<bool>{true, false, true, true}));
+}
+
+TEST(peak_meters_group_level_is_loudest_member)
+{
+    FakeMeterSource source;
+    source.peaks = {0.2f, 0.7f, 1.5f, -0.1f, 0.9f};
+    source.groups = {Groups({0}), Groups({0, 1}), Groups({2}), Groups({1}), GroupMask()};
+    source.groupCount = 3;
+    source.version = 42;
+    PeakMeters meters(source);
+    meters.Subscribe([](const MeterFrame &) {});
+
+    CHECK(meters.Sample());
+    const MeterFrame &frame = meters.Frame();
+    CHECK_EQ(frame.tick, uint64_t(1));
+    CHECK_EQ(frame.sessionsVersion, uint64_t(42));
+    CHECK_EQ(frame.sessionCount, uint32_t(5));
+    CHECK_EQ(frame.groupCount, uint32_t(3));
+    CHECK_NEAR(frame.groups[0], 0.7, 1e-6);
+    CHECK_NEAR(frame.groups[1], 0.7, 1e-6);
+    // Out-of-range readings are clamped to 0..1
+    CHECK_NEAR(frame.sessions[2], 1.0, 1e-6);
+    CHECK_NEAR(frame.sessions[3], 0.0, 1e-6);
+    CHECK_NEAR(frame.groups[2], 1.0, 1e-6);
+
+    // Levels fall with the sessions; nothing is kept from the previous frame
+    source.peaks = {0.0f, 0.1f, 0.3f, 0.0f, 0.0f};
+    meters.Sample();
+    CHECK_EQ(meters.Frame().tick, uint64_t(2));
+    CHECK_NEAR(meters.Frame().groups[0], 0.1, 1e-6);
+    CHECK_NEAR(meters.Frame().groups[2], 0.3, 1e-6);
+}
+
+TEST(peak_meters_caps_session_count)
+{
+    FakeMeterSource source;
+    source.peaks.assign(MAX_METER_SESSIONS + 10, 0.5f);
+    source.groups.assign(MAX_METER_SESSIONS + 10, GroupMask());
+    PeakMeters meters(source);
+    meters.Subscribe([](const MeterFrame &) {});
+
+    meters.Sample();
+    CHECK_EQ(meters.Frame().sessionCount, uint32_t(MAX_METER_SESSIONS));
+    CHECK_EQ(source.reads, uint64_t(MAX_METER_SESSIONS));
+}
+
+TEST(peak_meters_encode_frame)
+{
+    MeterFrame frame;
+    frame.tick = 12;
+    frame.sessionsVersion = 3;
+    frame.sessionCount = 2;
+    frame.groupCount = 1;
+    frame.sessions[0] = 0.41249f;
+    frame.sessions[1] = 1.0f;
+    frame.groups[0] = 1.0f;
+
+    std::string out = "left over";
+    EncodeMeterFrame(frame, out);
+    CHECK_EQ(out, std::string(R"({"tick":12,"sessionsVersion":3,"sessions":[0.412,1.000],"groups":[1.000]})"));
+    CHECK(json::parse(out)["sessions"].size() == 2);
+
+    frame.sessionCount = 0;
+    frame.groupCount = 0;
+    EncodeMeterFrame(frame, out);
+    CHECK_EQ(out, std::string(R"({"tick":12,"sessionsVersion":3,"sessions":[],"groups":[]})"));
+}
+
+TEST(peak_meters_read_settings)
+{
+    CHECK(ReadMeterSettings(json::object()).period == std::chrono::milliseconds(50));
+    CHECK(ReadMeterSettings(json::parse(R"({"meters": {"rateHz": 30}})")).period == std::chrono::milliseconds(33));
+    CHECK(ReadMeterSettings(json::parse(R"({"meters": {"rateHz": 1}})")).period == std::chrono::milliseconds(1000));
+    CHECK(ReadMeterSettings(json::parse(R"({"meters": {"rateHz": 0}})")).period == std::chrono::milliseconds(50));
+    CHECK(ReadMeterSettings(json::parse(R"({"meters": {"rateHz": 61}})")).period == std::chrono::milliseconds(50));
+    CHECK(ReadMeterSettings(json::parse(R"({"meters": {"rateHz": "fast"}})")).period == std::chrono::milliseconds(50));
+}
+
+// --- DuckingEngine ---
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using ms = std::chrono::milliseconds;
+
+    // Meters and engine wired as on the audio worker, with the time of each frame set by the test
+    struct DuckingRig
+    {
+        FakeMeterSource source;
+        PeakMeters meters{source};
+        std::vector<std::pair<size_t, float>> writes;
+        DuckingEngine engine{[this](size_t group, float volume)
+                             { writes.push_back({group, volume}); }};
+        Clock::time_point now = Clock::now();
+
+        DuckingRig()
+        {
+            meters.Subscribe([this](const MeterFrame &frame)
+                             { engine.Process(frame, now); });
+        }
+
+        void Use(const char *config)
+        {
+            const json config_data = json::parse(config);
+            engine.SetRules(CompileDuckingRules(config_data), AppMatcher::Compile(config_data));
+        }
+
+        // One session per group, at the given peaks
+        void Levels(std::vector<float> peaks)
+        {
+            source.groups.clear();
+            for (size_t i = 0; i < peaks.size(); ++i)
+            {
+                source.groups.push_back(Groups({i}));
+            }
+            source.peaks = std::move(peaks);
+            source.groupCount = source.peaks.size();
+        }
+
+        void Step(ms elapsed)
+        {
+            now += elapsed;
+            meters.Sample();
+        }
+    };
+
+    const float MINUS_6_DB = 0.50119f;
+    const float MINUS_12_DB = 0.25119f;
+}
+
+TEST(ducking_attack_and_release_envelopes)
+{
+    DuckingRig rig;
+    rig.Use(R"({"groups": {"Chat": ["discord.exe"], "Games": ["game.exe"]},
+                "ducking": [{"trigger": "Chat", "target": "Games"}]})");
+    CHECK_NEAR(rig.engine.SetFader(1, 0.8f), 0.8, 1e-6);
+    rig.Levels({0.5f, 0.3f});
+
+    rig.Step(ms(0)); // First frame only starts the clock
+    CHECK(rig.writes.empty());
+    rig.Step(ms(25));
+    CHECK_EQ(rig.writes.size(), size_t(1));
+    CHECK_NEAR(rig.writes.back().second, 0.8 * MINUS_6_DB, 1e-4);
+    rig.Step(ms(25));
+    CHECK_NEAR(rig.writes.back().second, 0.8 * MINUS_12_DB, 1e-4);
+    CHECK_NEAR(rig.engine.Gain(1), MINUS_12_DB, 1e-4);
+    CHECK_NEAR(rig.engine.Gain(0), 1.0, 1e-6);
+    rig.Step(ms(10));
+    CHECK_EQ(rig.writes.size(), size_t(2));
+
+    // A fader move while ducked composes with the duck gain
+    CHECK_NEAR(rig.engine.SetFader(1, 0.4f), 0.4 * MINUS_12_DB, 1e-4);
+
+    // Chat goes quiet: back up over releaseMs, and a long gap moves it at most a second's worth
+    rig.Levels({0.0f, 0.3f});
+    rig.Step(ms(300));
+    CHECK_NEAR(rig.writes.back().second, 0.4 * MINUS_6_DB, 1e-4);
+    rig.Step(ms(5000));
+    CHECK_NEAR(rig.writes.back().second, 0.4, 1e-6);
+    CHECK(rig.writes.back().first == 1);
+}
+
+TEST(ducking_deepest_rule_wins_and_quiet_trigger_is_ignored)
+{
+    DuckingRig rig;
+    rig.Use(R"({"groups": {"Chat": [], "Games": [], "Music": []},
+                "group_names": {"Chat": "Voice"},
+                "ducking": [{"trigger": "Voice", "target": "Games", "depthDb": 6, "attackMs": 0},
+                            {"trigger": "Music", "target": "Games", "depthDb": 12, "attackMs": 0,
+                             "thresholdDb": -20}]})");
+    rig.engine.SetFader(1, 1.0f);
+    rig.Levels({0.5f, 0.0f, 0.05f}); // Music is under its -20 dB threshold
+
+    rig.Step(ms(0));
+    CHECK_NEAR(rig.engine.Gain(1), MINUS_6_DB, 1e-4);
+    rig.Levels({0.5f, 0.0f, 0.5f});
+    rig.Step(ms(10));
+    CHECK_NEAR(rig.engine.Gain(1), MINUS_12_DB, 1e-4);
+    CHECK_NEAR(rig.writes.back().second, MINUS_12_DB, 1e-4);
+}
+
+TEST(ducking_compile_reports_bad_rules)
+{
+    std::vector<std::string> problems;
+    const auto rules = CompileDuckingRules(json::parse(R"({
+        "groups": {"Chat": [], "Games": []},
+        "ducking": [{"trigger": "Chat", "target": "Chat"},
+                    {"trigger": "Chat", "target": "Nowhere"},
+                    {"trigger": "Chat", "target": "Games", "depthDb": 200},
+                    {"trigger": "Chat"},
+                    {"trigger": "Chat", "target": "Games", "releaseMs": 0}]
+    })"), &problems);
+    CHECK_EQ(rules->rules.size(), size_t(1));
+    CHECK_EQ(problems.size(), size_t(4));
+    CHECK(CompileDuckingRules(json::object())->rules.empty());
+}
+
+TEST(ducking_rebuilt_matcher_moves_state_with_the_group)
+{
+    DuckingRig rig;
+    rig.Use(R"({"groups": {"A": [], "C": []},
+                "ducking": [{"trigger": "A", "target": "C", "attackMs": 0, "releaseMs": 0}]})");
+    rig.engine.SetFader(1, 0.8f);
+    rig.Levels({0.5f, 0.3f});
+    rig.Step(ms(0));
+    CHECK_EQ(rig.writes.size(), size_t(1));
+    CHECK_NEAR(rig.writes.back().second, 0.8 * MINUS_12_DB, 1e-4);
+
+    // Group B is added: C moves from index 1 to 2, and so must its fader and duck state
+    rig.writes.clear();
+    rig.Use(R"({"groups": {"A": [], "B": [], "C": []},
+                "ducking": [{"trigger": "A", "target": "C", "attackMs": 0, "releaseMs": 0}]})");
+    CHECK_EQ(rig.writes.size(), size_t(1));
+    CHECK(rig.writes.size() == 1 && rig.writes[0].first == 2);
+    CHECK_NEAR(rig.writes.back().second, 0.8, 1e-6);
+
+    rig.Levels({0.5f, 0.3f, 0.3f});
+    rig.Step(ms(10));
+    CHECK_NEAR(rig.engine.Gain(2), MINUS_12_DB, 1e-4);
+    CHECK_NEAR(rig.engine.Gain(1), 1.0, 1e-6);
+    for (const auto &write : rig.writes)
+    {
+        CHECK(write.first == 2); // B never sees C's old fader or gain
+    }
+    CHECK_NEAR(rig.writes.back().second, 0.8 * MINUS_12_DB, 1e-4);
+}
+
+TEST(ducking_rule_removed_with_rebuilt_matcher_restores_new_index)
+{
+    DuckingRig rig;
+    rig.Use(R"({"groups": {"A": [], "C": []},
+                "ducking": [{"trigger": "A", "target": "C", "attackMs": 0}]})");
+    rig.engine.SetFader(1, 0.6f);
+    rig.Levels({0.5f, 0.3f});
+    rig.Step(ms(0));
+    CHECK_NEAR(rig.writes.back().second, 0.6 * MINUS_12_DB, 1e-4);
+
+    rig.writes.clear();
+    rig.Use(R"({"groups": {"A": [], "B": [], "C": []}})");
+    CHECK_EQ(rig.writes.size(), size_t(1));
+    CHECK(rig.writes.size() == 1 && rig.writes[0].first == 2);
+    CHECK_NEAR(rig.writes.back().second, 0.6, 1e-6);
+    CHECK(!rig.engine.Active());
+
+    // A group that is gone takes its state with it; nothing is written for it
+    rig.writes.clear();
+    rig.Use(R"({"groups": {"A": [], "B": []},
+                "ducking": [{"trigger": "A", "target": "B", "attackMs": 0}]})");
+    rig.Step(ms(10));
+    CHECK(rig.writes.empty()); // B's fader was never set
+}
+
+// --- Latency trace ---
+
+TEST(latency_trace_one_end_to_end_sample_per_frame)
+{
+    ResetLatencyStats();
+    auto samples = []()
+    {
+        const json report = GetLatencyReport();
+        const json &applied = report["stages"][static_cast<int>(TraceStage::VolumeApplied) - 1];
+        return std::make_pair(applied["count"].get<uint64_t>(), report["end_to_end"]["count"].get<uint64_t>());
+    };
+
+    // A frame that moved three sliders: each volume command carries a copy of its span
+    TraceSpan frame;
+    frame.Begin();
+    TraceSpan sliders[3] = {frame, frame, frame};
+    for (TraceSpan &slider : sliders)
+    {
+        slider.Mark(TraceStage::VolumeApplied);
+    }
+    CHECK(samples() == std::make_pair(uint64_t(3), uint64_t(1)));
+
+    while (TraceNowNs() <= frame.startNs)
+    {
+    }
+    TraceSpan next;
+    next.Begin();
+    TraceSpan late = frame; // A write of the older frame finishing after the new one started
+    next.Mark(TraceStage::VolumeApplied);
+    late.Mark(TraceStage::VolumeApplied);
+    CHECK(samples() == std::make_pair(uint64_t(5), uint64_t(2)));
+    ResetLatencyStats();
+}
@@ -0,0 +1,370 @@
+// WriteBehindDocument driven through ProcessDue against FakeFileWriter, the
+// ConfigStore commits on top of it, and ApplyConfigPatch on a ConfigEdit of an
+// in-memory snapshot.
+
+#include <memory>
+#include <thread>
+#include "test_harness.h"
+#include "config_patch.h"
+#include "config_store.h"
+#include "json_persistence.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using ms = std::chrono::milliseconds;
+}
+
+// --- WriteBehindDocument ---
+
+TEST(write_behind_debounces_a_burst_into_one_write)
+{
+    FakeFileWriter writer;
+    WriteBehindDocument document("config.json", writer, ms(300), ms(2000));
+    const Clock::time_point t0 = Clock::now();
+
+    document.Set(json{{"volume", 1}}, t0);
+    document.Set(json{{"volume", 2}}, t0 + ms(100));
+    CHECK_EQ((*document.Get())["volume"].get<int>(), 2);
+    CHECK(document.ProcessDue(t0 + ms(200)) == t0 + ms(400));
+    CHECK_EQ(writer.attempts, 0);
+
+    CHECK(document.ProcessDue(t0 + ms(400)) == Clock::time_point::max());
+    CHECK_EQ(writer.attempts, 1);
+    CHECK_EQ(writer.files["config.json"], (json{{"volume", 2}}.dump(4)));
+    CHECK(!document.Dirty());
+    CHECK_EQ(document.Writes(), uint64_t(1));
+}
+
+TEST(write_behind_max_delay_bounds_a_stream_of_saves)
+{
+    FakeFileWriter writer;
+    WriteBehindDocument document("config.json", writer, ms(300), ms(2000));
+    const Clock::time_point t0 = Clock::now();
+
+    // A save every 200 ms never leaves 300 ms of quiet; the write still happens at 2 s
+    for (int i = 0; i < 10; ++i)
+    {
+        document.Set(json{{"step", i}}, t0 + ms(200 * i));
+        document.ProcessDue(t0 + ms(200 * i));
+    }
+    CHECK_EQ(writer.attempts, 0);
+    document.Set(json{{"step", 10}}, t0 + ms(2000));
+    CHECK(document.ProcessDue(t0 + ms(2000)) == Clock::time_point::max());
+    CHECK_EQ(writer.attempts, 1);
+    CHECK_EQ(writer.files["config.json"], (json{{"step", 10}}.dump(4)));
+}
+
+TEST(write_behind_retries_a_failed_write)
+{
+    FakeFileWriter writer;
+    std::vector<bool> results;
+    WriteBehindDocument document("binds.json", writer, ms(300), ms(2000), [&results](bool ok)
+                                 { results.push_back(ok); });
+    const Clock::time_point t0 = Clock::now();
+
+    writer.fail = true;
+    document.Set(json::array({"a"}), t0);
+    const Clock::time_point retry = document.ProcessDue(t0 + ms(300));
+    CHECK(document.Dirty());
+    CHECK(retry > t0 + ms(300) && retry != Clock::time_point::max());
+    CHECK(writer.files.empty());
+
+    writer.fail = false;
+    CHECK(document.ProcessDue(retry) == Clock::time_point::max());
+    CHECK_EQ(writer.attempts, 2);
+    CHECK_EQ(writer.files["binds.json"], json::array({"a"}).dump(4));
+    CHECK(results == (std::vector<bool>{false, true}));
+}
+
+TEST(write_behind_flush_and_reset)
+{
+    FakeFileWriter writer;
+    WriteBehindDocument document("config.json", writer);
+    document.Reset(json{{"loaded", true}});
+    CHECK(!document.Dirty());
+    CHECK(document.Flush());
+    CHECK_EQ(writer.attempts, 0);
+
+    document.Set(json{{"loaded", false}});
+    CHECK(document.Flush());
+    CHECK_EQ(writer.attempts, 1);
+    CHECK(document.ProcessDue(Clock::now()) == Clock::time_point::max());
+}
+
+// --- ConfigStore ---
+
+namespace
+{
+    struct StoreRig
+    {
+        FakeFileWriter writer;
+        WriteBehindDocument configFile{"config.json", writer};
+        WriteBehindDocument bindsFile{"binds.json", writer};
+        ConfigStore store{configFile, bindsFile};
+
+        StoreRig() { store.Load(json{{"theme", "dark"}}, json::array({"bind"})); }
+
+        // Runs the debounce out, as the writer thread would
+        void WriteBehind()
+        {
+            const Clock::time_point later = Clock::now() + ms(10000);
+            configFile.ProcessDue(later);
+            bindsFile.ProcessDue(later);
+        }
+    };
+}
+
+TEST(config_store_load_is_a_generation_without_writes)
+{
+    StoreRig rig;
+    CHECK_EQ(rig.store.Generation(), uint64_t(1));
+    CHECK_EQ((*rig.store.Current()->config)["theme"].get<std::string>(), std::string("dark"));
+    CHECK(rig.configFile.Get() == rig.store.Current()->config);
+    rig.WriteBehind();
+    CHECK_EQ(rig.writer.attempts, 0);
+
+    // Documents of the wrong shape are replaced by empty ones
+    rig.store.Load(json::array(), json::object());
+    CHECK(rig.store.Current()->config->is_object() && rig.store.Current()->binds->is_array());
+    CHECK_EQ(rig.store.Generation(), uint64_t(2));
+}
+
+TEST(config_store_commit_publishes_both_documents_once)
+{
+    StoreRig rig;
+    const std::shared_ptr<const ConfigSnapshot> before = rig.store.Current();
+
+    const auto committed = rig.store.Commit([](ConfigEdit &edit)
+                                            {
+        edit.MutableConfig()["theme"] = "light";
+        edit.MutableConfig()["volume"] = 3;
+        edit.MutableBinds().push_back("second");
+        return true; });
+    CHECK(committed != nullptr);
+    CHECK(committed == rig.store.Current());
+    CHECK_EQ(committed->generation, uint64_t(2));
+    CHECK_EQ((*committed->config)["theme"].get<std::string>(), std::string("light"));
+    CHECK_EQ(committed->binds->size(), size_t(2));
+
+    // A reader still holding the old snapshot sees the old pair, untouched
+    CHECK_EQ((*before->config)["theme"].get<std::string>(), std::string("dark"));
+    CHECK_EQ(before->binds->size(), size_t(1));
+
+    rig.WriteBehind();
+    CHECK_EQ(rig.writer.attempts, 2);
+    CHECK_EQ(rig.writer.files["config.json"], committed->config->dump(4));
+    CHECK_EQ(rig.writer.files["binds.json"], committed->binds->dump(4));
+}
+
+TEST(config_store_unchanged_document_is_shared_and_not_written)
+{
+    StoreRig rig;
+    const std::shared_ptr<const ConfigSnapshot> before = rig.store.Current();
+    const auto committed = rig.store.Commit([](ConfigEdit &edit)
+                                            {
+        edit.MutableBinds().push_back("only binds");
+        return true; });
+    CHECK(committed && committed->config == before->config);
+    CHECK(!rig.configFile.Dirty() && rig.bindsFile.Dirty());
+}
+
+TEST(config_store_abandoned_or_empty_commit_keeps_generation)
+{
+    StoreRig rig;
+    bool called = false;
+    CHECK(rig.store.Commit([&called](ConfigEdit &edit)
+                           {
+        called = true;
+        edit.MutableConfig()["theme"] = "light";
+        return false; }) == nullptr);
+    CHECK(called);
+    CHECK(rig.store.Commit([](ConfigEdit &edit)
+                           {
+        edit.Config(); // Read only
+        return true; }) == nullptr);
+    CHECK_EQ(rig.store.Generation(), uint64_t(1));
+    CHECK_EQ((*rig.store.Current()->config)["theme"].get<std::string>(), std::string("dark"));
+    CHECK(!rig.configFile.Dirty());
+}
+
+TEST(config_store_refuses_stale_generation)
+{
+    StoreRig rig;
+    const uint64_t read = rig.store.Generation();
+    rig.store.Commit([](ConfigEdit &edit)
+                     {
+        edit.MutableConfig()["theme"] = "light";
+        return true; });
+
+    // Derived from generation 1, but 2 is current: not applied, change never called
+    bool called = false;
+    CHECK(rig.store.CommitIfCurrent(read, [&called](ConfigEdit &edit)
+                                    {
+        called = true;
+        edit.MutableConfig()["theme"] = "stale";
+        return true; }) == nullptr);
+    CHECK(!called);
+    CHECK_EQ(rig.store.Generation(), uint64_t(2));
+    CHECK_EQ((*rig.store.Current()->config)["theme"].get<std::string>(), std::string("light"));
+
+    const auto committed = rig.store.CommitIfCurrent(rig.store.Generation(), [](ConfigEdit &edit)
+                                                     {
+        edit.MutableConfig()["theme"] = "fresh";
+        return true; });
+    CHECK(committed && committed->generation == 3);
+}
+
+TEST(config_store_concurrent_commits_lose_nothing)
+{
+    StoreRig rig;
+    const int THREADS = 4;
+    const int COMMITS = 200;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        threads.emplace_back([&rig]()
+                             {
+            for (int i = 0; i < COMMITS; ++i)
+            {
+                rig.store.Commit([](ConfigEdit &edit)
+                                 {
+                    json &config = edit.MutableConfig();
+                    config["count"] = config.value("count", 0) + 1;
+                    return true; });
+            } });
+    }
+
+    // Generations only grow, one per commit, while commits are running
+    uint64_t last = 0;
+    bool monotonic = true;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const uint64_t generation = rig.store.Generation();
+        monotonic = monotonic && generation >= last;
+        last = generation;
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(monotonic);
+    CHECK_EQ(rig.store.Generation(), uint64_t(1 + THREADS * COMMITS));
+    CHECK_EQ((*rig.store.Current()->config)["count"].get<int>(), THREADS * COMMITS);
+    CHECK(rig.configFile.Get() == rig.store.Current()->config);
+}
+
+// --- ApplyConfigPatch ---
+
+namespace
+{
+    ConfigSnapshot Snapshot()
+    {
+        ConfigSnapshot snapshot;
+        snapshot.generation = 7;
+        snapshot.config = std::make_shared<const json>(json::parse(R"({
+            "groups": {"Group 1": ["spotify.exe"], "Group 2": ["discord.exe"]},
+            "group_names": {"Group 1": "Music", "Group 2": "Chat"},
+            "buttonBindings": {"button0": "Mute mic"},
+            "profiles": {"Games": {"buttonBindings": {}}},
+            "theme": "dark"
+        })"));
+        snapshot.binds = std::make_shared<const json>(json::array());
+        return snapshot;
+    }
+}
+
+TEST(config_patch_move_app_touches_members_only)
+{
+    const ConfigSnapshot snapshot = Snapshot();
+    ConfigEdit edit(snapshot);
+    const ConfigPatchResult result = ApplyConfigPatch(
+        json::parse(R"({"op": "moveApp", "from": "Group 1", "to": "Group 2", "app": "spotify.exe", "index": 0})"), edit);
+
+    CHECK(result.ok);
+    CHECK_EQ(result.touched, uint32_t(CONFIG_AREA_GROUP_MEMBERS));
+    CHECK(result.NeedsMatcher() && !result.NeedsProfiles() && !result.NeedsMeters());
+    CHECK(edit.Config()["groups"]["Group 1"] == json::array());
+    CHECK(edit.Config()["groups"]["Group 2"] == json::array({"spotify.exe", "discord.exe"}));
+    // The snapshot other readers hold is not touched
+    CHECK((*snapshot.config)["groups"]["Group 1"] == json::array({"spotify.exe"}));
+}
+
+TEST(config_patch_no_op_does_not_copy)
+{
+    const ConfigSnapshot snapshot = Snapshot();
+    ConfigEdit edit(snapshot);
+    const ConfigPatchResult result = ApplyConfigPatch(json::parse(R"([
+        {"op": "addApp", "group": "Group 1", "app": "spotify.exe"},
+        {"op": "renameGroup", "group": "Group 2", "name": "Chat"},
+        {"op": "bindButton", "button": "button0", "action": "Mute mic"},
+        {"op": "test", "path": "/theme", "value": "dark"}
+    ])"), edit);
+
+    CHECK(result.ok);
+    CHECK_EQ(result.touched, uint32_t(CONFIG_AREA_NONE));
+    CHECK(!edit.ConfigChanged());
+}
+
+TEST(config_patch_rename_and_bind)
+{
+    const ConfigSnapshot snapshot = Snapshot();
+    ConfigEdit edit(snapshot);
+    const ConfigPatchResult result = ApplyConfigPatch(json::parse(R"([
+        {"op": "renameGroup", "group": "Group 1", "name": "Tunes"},
+        {"op": "bindButton", "button": "button1", "action": "Next track", "profile": "Games"},
+        {"op": "bindButton", "button": "button0", "action": null}
+    ])"), edit);
+
+    CHECK(result.ok);
+    CHECK_EQ(result.touched, uint32_t(CONFIG_AREA_GROUP_NAMES | CONFIG_AREA_PROFILES));
+    CHECK(!result.NeedsMatcher() && result.NeedsProfiles() && result.NeedsMeters());
+    CHECK_EQ(edit.Config()["group_names"]["Group 1"].get<std::string>(), std::string("Tunes"));
+    CHECK_EQ(edit.Config()["profiles"]["Games"]["buttonBindings"]["button1"].get<std::string>(), std::string("Next track"));
+    CHECK(!edit.Config()["buttonBindings"].contains("button0"));
+}
+
+TEST(config_patch_json_patch_keeps_group_names_in_step)
+{
+    const ConfigSnapshot snapshot = Snapshot();
+    ConfigEdit edit(snapshot);
+    const ConfigPatchResult result = ApplyConfigPatch(json::parse(R"([
+        {"op": "add", "path": "/groups/Group 3", "value": ["obs64.exe"]},
+        {"op": "remove", "path": "/groups/Group 2"}
+    ])"), edit);
+
+    CHECK(result.ok);
+    CHECK(result.touched & CONFIG_AREA_GROUP_LIST);
+    CHECK(result.NeedsMatcher() && result.NeedsProfiles());
+    CHECK(edit.Config()["group_names"] == json::parse(R"({"Group 1": "Music", "Group 3": "Group 3"})"));
+}
+
+TEST(config_patch_conflicts_and_errors)
+{
+    const ConfigSnapshot snapshot = Snapshot();
+    {
+        ConfigEdit edit(snapshot);
+        const ConfigPatchResult result = ApplyConfigPatch(
+            json::parse(R"({"op": "addApp", "group": "Group 9", "app": "x.exe"})"), edit);
+        CHECK(!result.ok && result.conflict);
+    }
+    {
+        ConfigEdit edit(snapshot);
+        const ConfigPatchResult result = ApplyConfigPatch(
+            json::parse(R"({"op": "test", "path": "/theme", "value": "light"})"), edit);
+        CHECK(!result.ok && result.conflict);
+    }
+    {
+        ConfigEdit edit(snapshot);
+        const ConfigPatchResult result = ApplyConfigPatch(
+            json::parse(R"({"op": "replace", "path": "/groups/Group 1", "value": 5})"), edit);
+        CHECK(!result.ok && !result.conflict);
+        CHECK(!result.error.empty());
+    }
+    {
+        ConfigEdit edit(snapshot);
+        const ConfigPatchResult result = ApplyConfigPatch(json::parse(R"({"op": "frobnicate"})"), edit);
+        CHECK(!result.ok && !result.conflict);
+    }
+}
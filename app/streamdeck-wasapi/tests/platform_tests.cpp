@@ -0,0 +1,399 @@
+// ProcessCache and ForegroundTracker against FakeProcessSource and
+// FakeForegroundSource, with the process table and the foreground edited by hand,
+// the AppMatcher rules that sort their processes into groups, and the SessionGroups
+// bookkeeping that keeps each group's session list.
+
+#include <cstdio>
+#include "test_harness.h"
+#include "app_matcher.h"
+#include "foreground_tracker.h"
+#include "process_cache.h"
+#include "session_groups.h"
+
+namespace
+{
+    ProcessSnapshotEntry Process(uint32_t pid, uint64_t createTime, const wchar_t *exeName, uint32_t parentPid = 4)
+    {
+        ProcessSnapshotEntry entry;
+        entry.pid = pid;
+        entry.parentPid = parentPid;
+        entry.createTime = createTime;
+        entry.exeName = exeName;
+        return entry;
+    }
+}
+
+// --- ProcessCache ---
+
+TEST(process_cache_refresh_adds_and_evicts)
+{
+    FakeProcessSource source;
+    ProcessCache cache(source);
+    source.processes = {Process(100, 1, L"Spotify.exe"), Process(200, 2, L"Discord.exe", 100)};
+
+    CHECK(cache.Refresh());
+    CHECK_EQ(cache.Size(), size_t(2));
+    const ProcessInfo *discord = cache.Find(200);
+    CHECK(discord && discord->parentPid == 100 && discord->exeName == L"Discord.exe");
+    CHECK(discord && discord->exeId == AppNames().Find("Discord.exe"));
+    CHECK(discord && discord->exeId != NO_NAME);
+
+    source.processes.erase(source.processes.begin());
+    CHECK(cache.Refresh());
+    CHECK(cache.Find(100) == nullptr);
+    CHECK_EQ(cache.Size(), size_t(1));
+    CHECK_EQ(cache.Snapshots(), uint64_t(2));
+}
+
+TEST(process_cache_reused_pid_is_a_new_process)
+{
+    FakeProcessSource source;
+    ProcessCache cache(source);
+    source.processes = {Process(300, 10, L"game.exe")};
+    cache.Refresh();
+    cache.SetDisplayName(300, L"The Game");
+    CHECK(cache.Find(300)->displayName == L"The Game");
+
+    // Same process on the next snapshot: display name kept
+    cache.Refresh();
+    CHECK(cache.Find(300)->displayName == L"The Game");
+
+    // The pid now belongs to another process: nothing of the old owner carries over
+    source.processes = {Process(300, 11, L"notepad.exe")};
+    cache.Refresh();
+    const ProcessInfo *info = cache.Find(300);
+    CHECK(info && info->exeName == L"notepad.exe" && info->displayName.empty() && info->createTime == 11);
+}
+
+TEST(process_cache_resolve_snapshots_only_for_unknown_pids)
+{
+    FakeProcessSource source;
+    ProcessCache cache(source);
+    source.processes = {Process(100, 1, L"Spotify.exe")};
+    cache.Refresh();
+
+    CHECK(cache.Resolve(100) != nullptr);
+    CHECK_EQ(source.snapshots, 1u);
+
+    // Started after the last snapshot: one new snapshot finds it
+    source.processes.push_back(Process(500, 5, L"obs64.exe"));
+    const ProcessInfo *obs = cache.Resolve(500);
+    CHECK(obs && obs->exeName == L"obs64.exe");
+    CHECK_EQ(source.snapshots, 2u);
+
+    CHECK(cache.Resolve(999) == nullptr);
+    CHECK_EQ(source.snapshots, 3u);
+}
+
+// --- ForegroundTracker ---
+
+TEST(foreground_tracker_caches_changes)
+{
+    FakeForegroundSource source;
+    ForegroundTracker tracker(source);
+    std::vector<uint32_t> seen;
+    CHECK(tracker.Current()->pid == 0);
+
+    CHECK(tracker.Start([&seen](const ForegroundApp &app)
+                        { seen.push_back(app.pid); }));
+    source.Activate(100, "Spotify.exe");
+    const auto current = tracker.Current();
+    CHECK(current->pid == 100 && current->exeName == "Spotify.exe" && current->exeNameW == L"Spotify.exe");
+    CHECK(current->exeId != NO_NAME && current->exeId == AppNames().Find("Spotify.exe"));
+
+    // Focus moving between windows of the same process is not a change
+    source.Activate(100, "Spotify.exe");
+    source.Activate(200, "Discord.exe");
+    CHECK(seen == (std::vector<uint32_t>{100, 200}));
+    CHECK_EQ(tracker.Changes(), uint64_t(2));
+    CHECK(tracker.Current()->exeName == "Discord.exe");
+    // Snapshots already handed out stay as they were
+    CHECK(current->pid == 100);
+}
+
+TEST(foreground_tracker_ignores_source_after_stop)
+{
+    FakeForegroundSource source;
+    ForegroundTracker tracker(source);
+    tracker.Start(nullptr);
+    source.Activate(100, "game.exe");
+    tracker.Stop();
+    source.Activate(200, "notepad.exe");
+    CHECK(tracker.Current()->pid == 100);
+    CHECK_EQ(tracker.Changes(), uint64_t(1));
+}
+
+// --- AppMatcher ---
+
+namespace
+{
+    SessionIdentity Session(const std::string &exeName, const std::string &displayName = std::string(),
+                            std::vector<std::string> ancestors = {})
+    {
+        SessionIdentity session;
+        session.exe = AppNames().Intern(exeName);
+        session.exeName = exeName;
+        session.displayName = displayName;
+        for (const auto &ancestor : ancestors)
+        {
+            session.ancestors.push_back(AppNames().Intern(ancestor));
+        }
+        return session;
+    }
+}
+
+TEST(app_matcher_patterns_see_the_sessions_own_spelling)
+{
+    // "r6" is interned by the exact rule first, so the table's spelling of R6.exe is "r6"
+    const auto matcher = AppMatcher::Compile(json::parse(R"({"groups": {
+        "Exact": ["r6"], "Glob": ["*.exe"], "Regex": ["re:^r6.*\\.exe$"]}})"));
+    CHECK_EQ(AppNames().Utf8(AppNames().Intern("R6.exe")), std::string("r6"));
+
+    GroupMask members;
+    CHECK_EQ(matcher->Match(Session("R6.exe"), &members), 0);
+    CHECK(members == GroupMask(0x7));
+
+    const auto patternsOnly = AppMatcher::Compile(json::parse(R"({"groups": {
+        "Glob": ["*.exe"], "Regex": ["re:^r6.*\\.exe$"]}})"));
+    CHECK_EQ(patternsOnly->Match(Session("R6.exe"), &members), 0);
+    CHECK(members == GroupMask(0x3));
+}
+
+TEST(app_matcher_rule_kind_precedence)
+{
+    // Group order is the reverse of rule precedence, so only the kind can pick the primary group
+    const auto matcher = AppMatcher::Compile(json::parse(R"({"groups": {
+        "A child": ["child:launcher.exe"],
+        "B display": ["display:*game*"],
+        "C regex": ["re:^game"],
+        "D glob": ["gam?.exe"],
+        "E exact": ["game.exe"]}})"));
+
+    struct Row
+    {
+        const char *exeName;
+        const char *displayName;
+        std::vector<std::string> ancestors;
+        int primary;
+        unsigned long members;
+    };
+    const Row rows[] = {
+        {"game.exe", "My Game", {"launcher.exe"}, 4, 0x1F},
+        {"GAME.exe", "", {}, 4, 0x1C},
+        {"gamx.exe", "My Game", {"launcher.exe"}, 3, 0x0B},
+        {"gamer.exe", "My Game", {"launcher.exe"}, 2, 0x07},
+        {"other.exe", "My GAME", {"launcher.exe"}, 1, 0x03},
+        {"other.exe", "", {"explorer.exe", "launcher.exe"}, 0, 0x01},
+        {"other.exe", "Music", {"explorer.exe"}, -1, 0x00},
+    };
+    for (const Row &row : rows)
+    {
+        const SessionIdentity session = Session(row.exeName, row.displayName, row.ancestors);
+        GroupMask members;
+        CHECK_EQ(matcher->Match(session, &members), row.primary);
+        CHECK_EQ(members.to_ulong(), row.members);
+        CHECK_EQ(matcher->Match(session), row.primary);
+    }
+}
+
+TEST(app_matcher_exact_names_are_whole_names)
+{
+    const auto matcher = AppMatcher::Compile(json::parse(R"({"groups": {
+        "Games": ["steam.exe"], "Media": ["Spotify.exe"], "Stream": ["spotify"]}})"));
+
+    CHECK_EQ(matcher->Match(Session("steam.exe")), 0);
+    CHECK_EQ(matcher->Match(Session("Steam")), 0);
+    CHECK_EQ(matcher->Match(Session("steamwebhelper.exe")), -1);
+    CHECK_EQ(matcher->Match(Session("steam.exe.bak")), -1);
+
+    // Listed in two groups: primary in the first, member of both
+    GroupMask members;
+    CHECK_EQ(matcher->Match(Session("SPOTIFY.EXE"), &members), 1);
+    CHECK(members == GroupMask(0x6));
+    CHECK(!matcher->NeedsAncestors());
+}
+
+TEST(app_matcher_nearest_ancestor_is_primary)
+{
+    const auto matcher = AppMatcher::Compile(json::parse(R"({"groups": {
+        "Desktop": ["child:explorer.exe"], "Steam": ["child:steam.exe"]}})"));
+    CHECK(matcher->NeedsAncestors());
+
+    GroupMask members;
+    CHECK_EQ(matcher->Match(Session("cs2.exe", "", {"steam.exe", "explorer.exe"}), &members), 1);
+    CHECK(members == GroupMask(0x3));
+    CHECK_EQ(matcher->Match(Session("notepad.exe", "", {"explorer.exe"})), 0);
+    // The executable itself is not its own ancestor
+    CHECK_EQ(matcher->Match(Session("steam.exe")), -1);
+}
+
+TEST(app_matcher_glob_set_agrees_with_glob_match)
+{
+    // Overlapping literals exercise the automaton's failure links; "*" and "??" have none
+    const std::vector<std::string> patterns = {"abcd", "*bc*", "*cde*", "a?c*", "x*y*z", "*ab*abc*",
+                                               "??", "*", "steam*", "*helper.exe", "*web*"};
+    const std::vector<std::string> texts = {"abcde", "xbcdy", "abcabc", "ab", "XYZ", "xaybzc", "ababc",
+                                            "", "a", "steamwebhelper.exe", "Steam.exe", "ABCD", "bcbcd"};
+
+    GlobSet set;
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        set.Add(patterns[i], static_cast<int>(i));
+    }
+    set.Build();
+
+    for (const auto &text : texts)
+    {
+        int first = -1;
+        GroupMask all;
+        for (size_t i = 0; i < patterns.size(); ++i)
+        {
+            if (GlobMatch(patterns[i], text))
+            {
+                first = first < 0 ? static_cast<int>(i) : first;
+                all.set(i);
+            }
+        }
+        CHECK_EQ(set.Match(text), first);
+        CHECK_EQ(set.MatchAll(text).to_ulong(), all.to_ulong());
+    }
+
+    CHECK(GlobMatch("r?-*.exe", "R6-Siege.exe"));
+    CHECK(!GlobMatch("r?-*.exe", "R6Siege.exe"));
+    CHECK(GlobMatch("*", ""));
+    CHECK(!GlobMatch("?", ""));
+}
+
+TEST(app_matcher_reports_bad_rules_and_caps_groups)
+{
+    std::vector<std::string> problems;
+    const auto matcher = AppMatcher::Compile(json::parse(R"({"groups": {
+        "Broken": ["re:([a-", 5, "", "ok.exe"], "Explicit": ["glob:Game?"], "NotAList": "x.exe"}})"), &problems);
+    CHECK_EQ(problems.size(), size_t(3));
+    CHECK(!problems.empty() && problems[0].find("invalid regex") != std::string::npos);
+    CHECK_EQ(matcher->Groups().size(), size_t(2));
+    CHECK_EQ(matcher->Match(Session("ok.exe")), 0);
+    CHECK_EQ(matcher->Match(Session("Game1")), 1);
+    CHECK_EQ(matcher->FindGroup("NotAList"), -1);
+
+    json groups = json::object();
+    for (int i = 0; i < 70; ++i)
+    {
+        char name[8];
+        std::snprintf(name, sizeof(name), "G%02d", i);
+        groups[name] = json::array({std::string(name) + ".exe"});
+    }
+    problems.clear();
+    const auto capped = AppMatcher::Compile(json{{"groups", groups}}, &problems);
+    CHECK_EQ(capped->Groups().size(), MAX_GROUPS);
+    CHECK_EQ(problems.size(), size_t(70) - MAX_GROUPS);
+    CHECK_EQ(capped->FindGroup("G63"), 63);
+    CHECK_EQ(capped->FindGroup("G64"), -1);
+    CHECK_EQ(capped->Match(Session("G63.exe")), 63);
+    CHECK_EQ(capped->Match(Session("G64.exe")), -1);
+
+    const auto empty = AppMatcher::Compile(json::object());
+    CHECK(empty->Groups().empty());
+    CHECK_EQ(empty->Match(Session("G00.exe")), -1);
+}
+
+// --- SessionGroups ---
+
+namespace
+{
+    std::vector<uint32_t> List(std::initializer_list<uint32_t> sessions) { return sessions; }
+}
+
+TEST(session_groups_session_in_two_groups_follows_both_faders)
+{
+    SessionGroups groups;
+    groups.Rematch(AppMatcher::Compile(json::parse(R"({"groups": {
+        "Chat": ["discord.exe"], "Loud": ["discord.exe", "game.exe"]}})")), nullptr);
+    CHECK_EQ(groups.GroupCount(), size_t(2));
+
+    CHECK_EQ(groups.Add(Session("game.exe")), size_t(0));
+    CHECK_EQ(groups.Add(Session("discord.exe")), size_t(1));
+    CHECK_EQ(groups.Add(Session("other.exe")), size_t(2));
+    CHECK_EQ(groups.Add(SessionIdentity()), size_t(3)); // A slot GetSession failed on
+
+    CHECK_EQ(groups.Primary(0), 1);
+    CHECK_EQ(groups.Primary(1), 0);
+    CHECK_EQ(groups.Primary(2), -1);
+    CHECK_EQ(groups.Primary(3), -1);
+    CHECK_EQ(groups.Members(1).to_ulong(), 0x3ul);
+    CHECK(groups.Sessions(0) == List({1}));
+    CHECK(groups.Sessions(1) == List({0, 1}));
+    CHECK(groups.Sessions(-1).empty());
+    CHECK(groups.Sessions(2).empty());
+}
+
+TEST(session_groups_remove_shifts_later_sessions)
+{
+    SessionGroups groups;
+    groups.Rematch(AppMatcher::Compile(json::parse(R"({"groups": {
+        "A": ["a.exe", "ab.exe"], "B": ["b.exe", "ab.exe"]}})")), nullptr);
+    for (const char *exe : {"a.exe", "ab.exe", "b.exe", "a.exe", "ab.exe"})
+    {
+        groups.Add(Session(exe));
+    }
+    CHECK(groups.Sessions(0) == List({0, 1, 3, 4}));
+    CHECK(groups.Sessions(1) == List({1, 2, 4}));
+
+    groups.Remove(1);
+    CHECK_EQ(groups.SessionCount(), size_t(4));
+    CHECK(groups.Sessions(0) == List({0, 2, 3}));
+    CHECK(groups.Sessions(1) == List({1, 3}));
+    CHECK_EQ(groups.Primary(1), 1);
+    CHECK_EQ(groups.Members(3).to_ulong(), 0x3ul);
+
+    groups.Remove(9); // Out of range: nothing to do
+    CHECK_EQ(groups.SessionCount(), size_t(4));
+
+    groups.Clear();
+    CHECK_EQ(groups.SessionCount(), size_t(0));
+    CHECK_EQ(groups.GroupCount(), size_t(2));
+    CHECK(groups.Sessions(0).empty());
+    CHECK_EQ(groups.Add(Session("b.exe")), size_t(0));
+    CHECK(groups.Sessions(1) == List({0}));
+}
+
+TEST(session_groups_rematch_moves_sessions_between_lists)
+{
+    const std::vector<std::string> exes = {"game.exe", "chat.exe", "music.exe", "browser.exe"};
+    auto identify = [&exes](size_t session)
+    { return Session(exes[session]); };
+
+    SessionGroups groups;
+    groups.Rematch(AppMatcher::Compile(json::parse(R"({"groups": {
+        "Chat": ["chat.exe", "browser.exe"], "Games": ["game.exe"]}})")), nullptr);
+    for (const auto &exe : exes)
+    {
+        groups.Add(Session(exe));
+    }
+    CHECK(groups.Sessions(0) == List({1, 3}));
+    CHECK(groups.Sessions(1) == List({0}));
+
+    // Group indices shifted, chat.exe moved to Games, a new group picked up music.exe
+    // and the browser, which now leads its own group
+    groups.Rematch(AppMatcher::Compile(json::parse(R"({"groups": {
+        "Browser": ["browser.exe"], "Games": ["game.exe", "chat.exe"], "Media": ["music.exe", "browser.exe"]}})")), identify);
+    CHECK_EQ(groups.GroupCount(), size_t(3));
+    CHECK_EQ(groups.Matcher()->FindGroup("Games"), 1);
+    CHECK(groups.Sessions(0) == List({3}));
+    CHECK(groups.Sessions(1) == List({0, 1}));
+    CHECK(groups.Sessions(2) == List({2, 3}));
+    CHECK_EQ(groups.Primary(0), 1);
+    CHECK_EQ(groups.Primary(1), 1);
+    CHECK_EQ(groups.Primary(2), 2);
+    CHECK_EQ(groups.Primary(3), 0);
+    CHECK_EQ(groups.Members(3).to_ulong(), 0x5ul);
+
+    // Without rules nothing is in a group, but the rows stay
+    groups.Rematch(nullptr, identify);
+    CHECK(!groups.Matcher());
+    CHECK_EQ(groups.GroupCount(), size_t(0));
+    CHECK_EQ(groups.SessionCount(), exes.size());
+    CHECK_EQ(groups.Primary(0), -1);
+    CHECK(groups.Members(3).none());
+    CHECK(groups.Sessions(0).empty());
+}
@@ -0,0 +1,388 @@
+// MacroScheduler, InputExecutor, GestureRecognizer and VersionWaiters, each driven
+// through its step function with a simulated clock; no thread is started.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include "test_harness.h"
+#include "gesture_recognizer.h"
+#include "hotkey_combo.h"
+#include "input_executor.h"
+#include "input_injector.h"
+#include "macro.h"
+#include "macro_scheduler.h"
+#include "version_waiters.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using ms = std::chrono::milliseconds;
+
+    // "11dn 43dn | 43up 11up": one group per Send call, virtual keys in hex, "u" for unicode
+    std::string Describe(const RecordingInputInjector &injector)
+    {
+        std::string text;
+        for (const auto &batch : injector.Batches())
+        {
+            if (!text.empty())
+            {
+                text += " | ";
+            }
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                char key[16];
+                std::snprintf(key, sizeof(key), "%s%x%s%s", i > 0 ? " " : "", batch[i].keyCode,
+                              batch[i].unicode ? "u" : "", batch[i].keyUp ? "up" : "dn");
+                text += key;
+            }
+        }
+        return text;
+    }
+
+    KeyChord Chord(const char *combo, uint16_t holdMs = 0)
+    {
+        HotkeyCombo parsed;
+        ParseHotkeyCombo(combo, parsed);
+        KeyChord chord = BuildKeyChord(parsed);
+        chord.holdMs = holdMs;
+        return chord;
+    }
+
+    std::shared_ptr<const MacroProgram> Macro(const char *steps)
+    {
+        auto program = std::make_shared<MacroProgram>();
+        std::string error;
+        const bool ok = CompileMacro(json::parse(steps), *program, error);
+        CHECK(ok);
+        return program;
+    }
+}
+
+// --- MacroScheduler ---
+
+TEST(macro_scheduler_runs_steps_at_their_deadlines)
+{
+    RecordingInputInjector injector;
+    std::vector<std::pair<std::string, float>> volumes;
+    MacroScheduler scheduler(injector, [&volumes](const std::string &group, float level)
+                             { volumes.push_back({group, level}); });
+    const auto program = Macro(R"([{"chord": "Ctrl+C", "holdMs": 30}, {"delay": 250}, {"text": "hi"},
+                                   {"volume": 0.35, "group": "Group 1"}])");
+    const Clock::time_point t0 = Clock::now();
+
+    CHECK(scheduler.Trigger(program));
+    CHECK(scheduler.RunDue(t0) == t0 + ms(30));
+    CHECK_EQ(Describe(injector), std::string("11dn 43dn"));
+
+    CHECK(scheduler.RunDue(t0 + ms(29)) == t0 + ms(30));
+    CHECK_EQ(injector.Batches().size(), size_t(1));
+
+    // Released at its deadline; the delay counts from the deadline, not from the late wakeup
+    CHECK(scheduler.RunDue(t0 + ms(33)) == t0 + ms(280));
+    CHECK_EQ(Describe(injector), std::string("11dn 43dn | 43up 11up"));
+    CHECK(volumes.empty());
+
+    CHECK(scheduler.RunDue(t0 + ms(280)) == Clock::time_point::max());
+    CHECK_EQ(Describe(injector), std::string("11dn 43dn | 43up 11up | 68udn 68uup 69udn 69uup"));
+    CHECK_EQ(volumes.size(), size_t(1));
+    CHECK(volumes.size() == 1 && volumes[0].first == "Group 1" && volumes[0].second == 0.35f);
+    CHECK_EQ(scheduler.RunningCount(), size_t(0));
+}
+
+TEST(macro_scheduler_interleaves_macros_and_ignores_retrigger)
+{
+    RecordingInputInjector injector;
+    MacroScheduler scheduler(injector, nullptr);
+    const auto slow = Macro(R"([{"delay": 100}, {"chord": "A", "holdMs": 10}])");
+    const auto fast = Macro(R"([{"chord": "B", "holdMs": 10}])");
+    const Clock::time_point t0 = Clock::now();
+
+    scheduler.Trigger(slow);
+    scheduler.Trigger(fast);
+    scheduler.Trigger(slow); // Already running once it is started
+    CHECK(scheduler.RunDue(t0) == t0 + ms(10));
+    CHECK_EQ(scheduler.RunningCount(), size_t(2));
+    CHECK_EQ(Describe(injector), std::string("42dn"));
+
+    // The long delay of one macro does not hold up the other
+    CHECK(scheduler.RunDue(t0 + ms(10)) == t0 + ms(100));
+    CHECK_EQ(Describe(injector), std::string("42dn | 42up"));
+    CHECK_EQ(scheduler.RunningCount(), size_t(1));
+
+    CHECK(scheduler.RunDue(t0 + ms(100)) == t0 + ms(110));
+    scheduler.AbortAll();
+    CHECK_EQ(Describe(injector), std::string("42dn | 42up | 41dn | 41up"));
+    CHECK_EQ(scheduler.RunningCount(), size_t(0));
+}
+
+// --- InputExecutor ---
+
+TEST(input_executor_releases_chord_after_hold)
+{
+    RecordingInputInjector injector;
+    InputExecutor executor(injector, ms(50));
+    const Clock::time_point t0 = Clock::now();
+
+    CHECK(executor.Submit(Chord("Ctrl+Shift+S")));
+    CHECK(executor.ProcessDue(t0) == t0 + ms(50));
+    CHECK_EQ(executor.HeldCount(), size_t(1));
+    CHECK(executor.ProcessDue(t0 + ms(49)) == t0 + ms(50));
+    CHECK(executor.ProcessDue(t0 + ms(50)) == Clock::time_point::max());
+    CHECK_EQ(Describe(injector), std::string("11dn 10dn 53dn | 53up 10up 11up"));
+    CHECK_EQ(executor.HeldCount(), size_t(0));
+}
+
+TEST(input_executor_overlapping_chords_share_modifier)
+{
+    RecordingInputInjector injector;
+    InputExecutor executor(injector);
+    const Clock::time_point t0 = Clock::now();
+
+    executor.Submit(Chord("Ctrl+C", 20));
+    executor.ProcessDue(t0);
+    executor.Submit(Chord("Ctrl+V", 200));
+    executor.ProcessDue(t0 + ms(5));
+
+    // Ctrl stays down until the last chord holding it is released, and goes up once
+    executor.ProcessDue(t0 + ms(20));
+    executor.ProcessDue(t0 + ms(205));
+    CHECK_EQ(Describe(injector), std::string("11dn 43dn | 11dn 56dn | 43up | 56up 11up"));
+}
+
+TEST(input_executor_repress_releases_first)
+{
+    RecordingInputInjector injector;
+    InputExecutor executor(injector);
+    const Clock::time_point t0 = Clock::now();
+
+    executor.Submit(Chord("Ctrl+Z"));
+    executor.ProcessDue(t0);
+    executor.Submit(Chord("Ctrl+Z"));
+    CHECK(executor.ProcessDue(t0 + ms(10)) == t0 + ms(60));
+    CHECK_EQ(Describe(injector), std::string("11dn 5adn | 5aup 11up 11dn 5adn"));
+
+    executor.ReleaseAll();
+    CHECK_EQ(Describe(injector), std::string("11dn 5adn | 5aup 11up 11dn 5adn | 5aup 11up"));
+    CHECK_EQ(executor.HeldCount(), size_t(0));
+}
+
+TEST(input_executor_drains_more_chords_than_slots)
+{
+    RecordingInputInjector injector;
+    InputExecutor executor(injector);
+    const Clock::time_point t0 = Clock::now();
+
+    // One wake for 40 chords: all of them go down in this step, 16 at a time
+    const std::string keys = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    for (size_t i = 0; i < 40; ++i)
+    {
+        const std::string combo = i < keys.size() ? keys.substr(i, 1) : "F" + std::to_string(i - keys.size() + 1);
+        CHECK(executor.Submit(Chord(combo.c_str())));
+    }
+    CHECK(executor.ProcessDue(t0) == t0 + ms(50));
+
+    size_t downs = 0, ups = 0;
+    for (const auto &batch : injector.Batches())
+    {
+        for (const KeyInput &input : batch)
+        {
+            ++(input.keyUp ? ups : downs);
+        }
+    }
+    CHECK_EQ(injector.Batches().size(), size_t(3));
+    CHECK_EQ(downs, size_t(40));
+    CHECK_EQ(ups, size_t(24)); // Out of slots: the oldest chords are released early
+    CHECK_EQ(executor.HeldCount(), size_t(16));
+
+    injector.Clear();
+    CHECK(executor.ProcessDue(t0 + ms(1)) == t0 + ms(50));
+    CHECK(injector.Batches().empty());
+}
+
+// --- GestureRecognizer ---
+
+namespace
+{
+    struct GestureLog
+    {
+        std::vector<GestureEvent> events;
+        GestureRecognizer recognizer{[this](const GestureEvent &event)
+                                     { events.push_back(event); }};
+
+        bool Last(GestureType type, int index) const
+        {
+            return !events.empty() && events.back().type == type && events.back().index == index;
+        }
+    };
+}
+
+TEST(gesture_tap_only_fires_on_press)
+{
+    GestureLog log;
+    GestureBindings bindings;
+    bindings.buttonMasks[0] = GestureBit(GestureType::Tap);
+    log.recognizer.Configure(bindings);
+    const Clock::time_point t0 = Clock::now();
+
+    log.recognizer.OnEdge(0, true, t0);
+    CHECK_EQ(log.events.size(), size_t(1));
+    CHECK(log.Last(GestureType::Tap, 0));
+    CHECK(log.recognizer.NextDeadline() == Clock::time_point::max());
+    log.recognizer.OnEdge(0, false, t0 + ms(80));
+    CHECK_EQ(log.events.size(), size_t(1));
+}
+
+TEST(gesture_double_tap_and_late_single_tap)
+{
+    GestureLog log;
+    GestureBindings bindings;
+    bindings.buttonMasks[2] = GestureBit(GestureType::Tap) | GestureBit(GestureType::DoubleTap);
+    log.recognizer.Configure(bindings);
+    const Clock::time_point t0 = Clock::now();
+
+    log.recognizer.OnEdge(2, true, t0);
+    log.recognizer.OnEdge(2, false, t0 + ms(40));
+    CHECK(log.recognizer.NextDeadline() == t0 + ms(290));
+    log.recognizer.OnEdge(2, true, t0 + ms(120));
+    log.recognizer.OnEdge(2, false, t0 + ms(160));
+    CHECK_EQ(log.events.size(), size_t(1));
+    CHECK(log.Last(GestureType::DoubleTap, 2));
+
+    // No second press within the window: a single tap, reported when the window closes
+    log.recognizer.OnEdge(2, true, t0 + ms(1000));
+    log.recognizer.OnEdge(2, false, t0 + ms(1040));
+    log.recognizer.OnTimer(t0 + ms(1289));
+    CHECK_EQ(log.events.size(), size_t(1));
+    log.recognizer.OnTimer(t0 + ms(1290));
+    CHECK_EQ(log.events.size(), size_t(2));
+    CHECK(log.Last(GestureType::Tap, 2));
+}
+
+TEST(gesture_long_press_and_hold_repeat)
+{
+    GestureLog log;
+    GestureBindings bindings;
+    bindings.buttonMasks[0] = GestureBit(GestureType::Tap) | GestureBit(GestureType::LongPress);
+    bindings.buttonMasks[1] = GestureBit(GestureType::HoldRepeat);
+    log.recognizer.Configure(bindings);
+    const Clock::time_point t0 = Clock::now();
+
+    log.recognizer.OnEdge(0, true, t0);
+    log.recognizer.OnTimer(t0 + ms(499));
+    CHECK(log.events.empty());
+    log.recognizer.OnTimer(t0 + ms(500));
+    CHECK(log.Last(GestureType::LongPress, 0));
+    log.recognizer.OnEdge(0, false, t0 + ms(700));
+    CHECK_EQ(log.events.size(), size_t(1));
+
+    log.recognizer.OnEdge(1, true, t0 + ms(1000));
+    log.recognizer.OnTimer(t0 + ms(1500));
+    log.recognizer.OnTimer(t0 + ms(1600));
+    CHECK_EQ(log.events.size(), size_t(3));
+    // A stalled timer catches up with one repeat, not a burst
+    log.recognizer.OnTimer(t0 + ms(2050));
+    CHECK_EQ(log.events.size(), size_t(4));
+    CHECK(log.recognizer.NextDeadline() == t0 + ms(2150));
+    log.recognizer.OnEdge(1, false, t0 + ms(2100));
+    CHECK(log.recognizer.NextDeadline() == Clock::time_point::max());
+    CHECK(log.Last(GestureType::HoldRepeat, 1));
+}
+
+TEST(gesture_chord_within_window)
+{
+    GestureLog log;
+    GestureBindings bindings;
+    bindings.buttonMasks[0] = GestureBit(GestureType::Tap);
+    bindings.buttonMasks[1] = GestureBit(GestureType::Tap);
+    bindings.chordMasks[0] = 0x3;
+    bindings.chordCount = 1;
+    log.recognizer.Configure(bindings);
+    const Clock::time_point t0 = Clock::now();
+
+    log.recognizer.OnEdge(0, true, t0);
+    log.recognizer.OnEdge(1, true, t0 + ms(30));
+    CHECK_EQ(log.events.size(), size_t(1));
+    CHECK(log.Last(GestureType::Chord, 0));
+    log.recognizer.OnEdge(0, false, t0 + ms(100));
+    log.recognizer.OnEdge(1, false, t0 + ms(100));
+
+    // Alone past the chord window, the button is a plain tap
+    log.recognizer.OnEdge(0, true, t0 + ms(200));
+    log.recognizer.OnTimer(t0 + ms(260));
+    CHECK_EQ(log.events.size(), size_t(2));
+    CHECK(log.Last(GestureType::Tap, 0));
+}
+
+// --- VersionWaiters ---
+
+TEST(version_waiters_answer_on_change_or_deadline)
+{
+    VersionWaiters waiters(2);
+    const Clock::time_point t0 = Clock::now();
+    std::vector<int> answers; // 1 = changed, 0 = timed out
+
+    CHECK(waiters.Park(0, t0 + ms(1000), [&answers](bool changed)
+                       { answers.push_back(changed ? 1 : 0); }) == VersionWaiters::ParkResult::Parked);
+    CHECK(waiters.Park(0, t0 + ms(500), [&answers](bool changed)
+                       { answers.push_back(changed ? 1 : 0); }) == VersionWaiters::ParkResult::Parked);
+    CHECK(waiters.Park(0, t0 + ms(500), [](bool) {}) == VersionWaiters::ParkResult::Full);
+    CHECK(waiters.ProcessDue(t0) == t0 + ms(500));
+
+    CHECK(waiters.ProcessDue(t0 + ms(500)) == t0 + ms(1000));
+    CHECK(answers == std::vector<int>{0});
+
+    // Publishing only records the version; the completion runs in the next step
+    waiters.Publish(1);
+    CHECK(answers.size() == 1);
+    CHECK(waiters.ProcessDue(t0 + ms(600)) == Clock::time_point::max());
+    CHECK(answers == (std::vector<int>{0, 1}));
+    CHECK(waiters.Park(0, t0 + ms(1000), [](bool) {}) == VersionWaiters::ParkResult::Changed);
+}
+
+TEST(version_waiters_disconnected_client_is_never_answered)
+{
+    VersionWaiters waiters(2);
+    const Clock::time_point t0 = Clock::now();
+    std::vector<std::string> sent; // What reached each client's response
+
+    auto reply = [&sent](const char *client)
+    {
+        return std::make_shared<ParkedReply>([&sent, client](bool changed)
+                                             { sent.push_back(std::string(client) + (changed ? " changed" : " unchanged")); });
+    };
+    auto gone = reply("gone");
+    auto stays = reply("stays");
+    CHECK(waiters.Park(0, t0 + ms(1000), gone) == VersionWaiters::ParkResult::Parked);
+    CHECK(waiters.Park(0, t0 + ms(1000), stays) == VersionWaiters::ParkResult::Parked);
+
+    // The connection closes the reply as it goes away; its slot goes to the next request
+    gone->Close();
+    gone.reset();
+    CHECK(waiters.Park(0, t0 + ms(1000), reply("next")) == VersionWaiters::ParkResult::Parked);
+    CHECK_EQ(waiters.Waiting(), size_t(2));
+
+    waiters.Publish(1);
+    waiters.ProcessDue(t0 + ms(10));
+    std::sort(sent.begin(), sent.end());
+    CHECK(sent == (std::vector<std::string>{"next changed", "stays changed"}));
+    CHECK(!stays->Open());
+    CHECK(!stays->Answer(false)); // Answered once only
+
+    // Closed while parked, with no slot pressure: the completion still sends nothing
+    auto late = reply("late");
+    CHECK(waiters.Park(1, t0 + ms(100), late) == VersionWaiters::ParkResult::Parked);
+    late->Close();
+    CHECK(waiters.ProcessDue(t0 + ms(100)) == Clock::time_point::max());
+    CHECK_EQ(sent.size(), size_t(2));
+}
+
+TEST(version_waiters_stop_answers_parked)
+{
+    VersionWaiters waiters;
+    int unchanged = 0;
+    waiters.Park(0, Clock::now() + ms(60000), [&unchanged](bool changed)
+                 { unchanged += changed ? 0 : 1; });
+    waiters.Stop();
+    CHECK_EQ(unchanged, 1);
+    CHECK(waiters.Park(0, Clock::now() + ms(60000), [](bool) {}) == VersionWaiters::ParkResult::Full);
+}
@@ -0,0 +1,89 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Minimal test registry for the portable modules; no framework to fetch or vendor.
+//
+//   TEST(gesture_double_tap) { ... CHECK(cond); CHECK_EQ(actual, expected); CHECK_NEAR(a, b, 1e-4); }
+//
+// A failed check reports the file, line and expression and the test carries on, so
+// one run shows every broken expectation. Names start with the module they cover,
+// which is what ctest filters on.
+
+struct TestCase
+{
+    const char *name;
+    void (*body)();
+};
+
+std::vector<TestCase> &TestCases();
+void ReportFailure(const char *file, int line, const std::string &message);
+
+struct TestRegistration
+{
+    TestRegistration(const char *name, void (*body)()) { TestCases().push_back({name, body}); }
+};
+
+#define TEST(name)                                                                                   \
+    static void name();                                                                              \
+    static const TestRegistration name##_registration(#name, name);                                  \
+    static void name()
+
+#define CHECK(condition)                                                                             \
+    do                                                                                               \
+    {                                                                                                \
+        if (!(condition))                                                                            \
+        {                                                                                            \
+            ReportFailure(__FILE__, __LINE__, #condition);                                           \
+        }                                                                                            \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                                   \
+    do                                                                                               \
+    {                                                                                                \
+        const auto &check_actual_ = (actual);                                                        \
+        const auto &check_expected_ = (expected);                                                    \
+        if (!(check_actual_ == check_expected_))                                                     \
+        {                                                                                            \
+            ReportFailure(__FILE__, __LINE__, std::string(#actual " == " #expected " (got ") +       \
+                                                  TestPrint(check_actual_) + ", want " +             \
+                                                  TestPrint(check_expected_) + ")");                 \
+        }                                                                                            \
+    } while (false)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                      \
+    do                                                                                               \
+    {                                                                                                \
+        const double check_actual_ = (actual);                                                       \
+        const double check_expected_ = (expected);                                                   \
+        if (!(std::fabs(check_actual_ - check_expected_) <= (tolerance)))                            \
+        {                                                                                            \
+            ReportFailure(__FILE__, __LINE__, std::string(#actual " ~= " #expected " (got ") +       \
+                                                  std::to_string(check_actual_) + ", want " +        \
+                                                  std::to_string(check_expected_) + ")");            \
+        }                                                                                            \
+    } while (false)
+
+template <typename T>
+std::string TestPrint(const T &value)
+{
+    if constexpr (std::is_arithmetic_v<T>)
+    {
+        return std::to_string(value);
+    }
+    else if constexpr (std::is_convertible_v<T, std::string>)
+    {
+        return "\"" + std::string(value) + "\"";
+    }
+    else
+    {
+        return "?";
+    }
+}
+
+#endif // TEST_HARNESS_H
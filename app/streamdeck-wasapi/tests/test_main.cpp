@@ -0,0 +1,68 @@
+// Unit tests for the portable modules of the control path, driven by fakes and
+// simulated clocks instead of WASAPI, SendInput and real time.
+//
+// Usage: control_tests [--filter <substring>]
+// Exits non-zero if a check failed or no test matched the filter.
+
+#include <cstring>
+#include "test_harness.h"
+
+namespace
+{
+    int g_failures = 0;
+}
+
+std::vector<TestCase> &TestCases()
+{
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+void ReportFailure(const char *file, int line, const std::string &message)
+{
+    ++g_failures;
+    std::cerr << file << ":" << line << ": check failed: " << message << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>]" << std::endl;
+            return 1;
+        }
+    }
+
+    int run = 0;
+    int failed = 0;
+    for (const auto &test : TestCases())
+    {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        const int failuresBefore = g_failures;
+        test.body();
+        ++run;
+        if (g_failures != failuresBefore)
+        {
+            ++failed;
+            std::cerr << "FAIL " << test.name << std::endl;
+        }
+        else
+        {
+            std::cerr << "ok   " << test.name << std::endl;
+        }
+    }
+
+    std::cerr << run - failed << " of " << run << " tests passed" << std::endl;
+    return run == 0 || failed > 0 ? 1 : 0;
+}